@@ -22,6 +22,7 @@
 #include "misc/math.h"
 #include <functional>
 #include "windows.h"
+#include <tsr.h>
 
 namespace cauldron
 {
@@ -130,39 +131,45 @@ namespace cauldron
     };
 
     /**
-     * @struct CameraComponentData
+     * @struct ShareableCameraData
      *
-     * Shareable camera data structure for the <c><i>CameraComponent</i></c>.
+     * Camera state handed from the renderer to the upscaler through a <c><i>tsr::Channel</i></c>.
+     * Only explicitly sized plain fields (matrices are column major), so both processes agree on the layout byte for byte.
      *
      * @ingroup CauldronComponent
      */
     struct ShareableCameraData
     {
-        CameraComponentData m_Data;
+        uint64_t m_FrameId;  ///< Framework frame the camera was updated in
+
+        uint32_t m_Type;
+        float    m_Znear;
+        float    m_Zfar;
+        float    m_ProjectionParams[2];  ///< Yfov and AspectRatio, or Xmag and Ymag
 
         float m_Distance;
         float m_Yaw;
         float m_Pitch;
 
-        Mat4 m_OwnerTransform;
-        Mat4 m_ViewMatrix;
-        Mat4 m_ProjectionMatrix;
-        Mat4 m_ViewProjectionMatrix;
+        float m_OwnerTransform[16];
+        float m_ViewMatrix[16];
+        float m_ProjectionMatrix[16];
+        float m_ViewProjectionMatrix[16];
 
-        Mat4 m_InvViewMatrix;
-        Mat4 m_InvProjectionMatrix;
-        Mat4 m_InvViewProjectionMatrix;
+        float m_InvViewMatrix[16];
+        float m_InvProjectionMatrix[16];
+        float m_InvViewProjectionMatrix[16];
 
-        Mat4 m_PrevViewMatrix;
-        Mat4 m_PrevViewProjectionMatrix;
+        float m_PrevViewMatrix[16];
+        float m_PrevViewProjectionMatrix[16];
 
-        float m_Speed;
-        bool  m_Dirty;
-        bool  m_ArcBallMode;
+        float    m_Speed;
+        uint32_t m_Dirty;
+        uint32_t m_ArcBallMode;
 
-        Vec2 m_jitterValues;
-        Mat4 m_ProjJittered;
-        Mat4 m_PrevProjJittered;
+        float m_JitterValues[2];
+        float m_ProjJittered[16];
+        float m_PrevProjJittered[16];
     };
 
     typedef std::function<void(Vec2& values)> CameraJitterCallback;
@@ -191,59 +198,29 @@ namespace cauldron
         /**
          * @brief   Gets the shareable camera data.
          */
-        const ShareableCameraData GetShareableData() const
-        {
-            return {
-                *m_pData,
-                m_Distance,
-                m_Yaw,
-                m_Pitch,
-                m_pOwner->GetTransform(),
-                m_ViewMatrix,
-                m_ProjectionMatrix,
-                m_ViewProjectionMatrix,
-                m_InvViewMatrix,
-                m_InvProjectionMatrix,
-                m_InvViewProjectionMatrix,
-                m_PrevViewMatrix,
-                m_PrevViewProjectionMatrix,
-                m_Speed,
-                m_Dirty,
-                m_ArcBallMode,
-                m_jitterValues,
-                m_ProjJittered,
-                m_PrevProjJittered
-            };
-        }
+        const ShareableCameraData GetShareableData() const;
 
         /**
          * @brief   Sets the shareable camera data.
          */
-        void SetShareableData(const ShareableCameraData& data)
-        {
-            // Copy the internal data
-            memcpy(m_pData, &data.m_Data, sizeof(CameraComponentData));
-
-            // Set the rest of the data
-            m_Distance = data.m_Distance;
-            m_Yaw      = data.m_Yaw;
-            m_Pitch    = data.m_Pitch;
-            m_pOwner->SetTransform(data.m_OwnerTransform);
-            m_ViewMatrix               = data.m_ViewMatrix;
-            m_ProjectionMatrix         = data.m_ProjectionMatrix;
-            m_ViewProjectionMatrix     = data.m_ViewProjectionMatrix;
-            m_InvViewMatrix            = data.m_InvViewMatrix;
-            m_InvProjectionMatrix      = data.m_InvProjectionMatrix;
-            m_InvViewProjectionMatrix  = data.m_InvViewProjectionMatrix;
-            m_PrevViewMatrix           = data.m_PrevViewMatrix;
-            m_PrevViewProjectionMatrix = data.m_PrevViewProjectionMatrix;
-            m_Speed                    = data.m_Speed;
-            m_Dirty                    = data.m_Dirty;
-            m_ArcBallMode              = data.m_ArcBallMode;
-            m_jitterValues             = data.m_jitterValues;
-            m_ProjJittered             = data.m_ProjJittered;
-            m_PrevProjJittered         = data.m_PrevProjJittered;
-        }
+        void SetShareableData(const ShareableCameraData& data);
+
+        /**
+         * @brief   Gets the frame ID of the shareable data last set on the camera, UINT64_MAX if none was set.
+         */
+        uint64_t GetSharedFrameID() const { return m_SharedFrameID; }
+
+        /**
+         * @brief   Overrides the frame matrices and jitter (matrices are column major), deriving the view projection and
+         *          inverse matrices from them. Used when the state of the frame reaches the camera another way.
+         */
+        void SetFrameMatrices(const float* pView,
+                              const float* pProjection,
+                              const float* pProjJittered,
+                              const float* pPrevView,
+                              const float* pPrevViewProjection,
+                              const float* pPrevProjJittered,
+                              const Vec2&  jitterValues);
 
         /**
          * @brief   Component update. Update the camera if dirty. Processes input, updates all matrices.
@@ -388,11 +365,10 @@ namespace cauldron
         // Keep a pointer on our initialization data for matrix reconstruction
         CameraComponentData*    m_pData;
 
-        // Shared data handle and view
-        std::string m_SharedDataName;
-        HANDLE      m_hSharedData = nullptr;
-        LPVOID      m_pSharedView = nullptr;
-        ShareableCameraData* m_pSharedData[TSR_SHARED_BUFFER_MAX] = {nullptr};
+        // Camera data shared with the other process, one entry per shared buffer
+        std::string                       m_SharedDataName;
+        tsr::Channel<ShareableCameraData> m_SharedData;
+        uint64_t                          m_SharedFrameID = UINT64_MAX;
 
         const Mat4  m_ResetMatrix = Mat4::identity(); // Used to reset camera to initial state
         float       m_Distance = 1.f;                 // Distance to look at
@@ -425,3 +401,13 @@ namespace cauldron
     };
 
 } // namespace cauldron
+
+// Field by field layout of the shared camera data, so a renderer and an upscaler built from different sources refuse to talk
+namespace tsr
+{
+    template <>
+    struct ChannelLayout<cauldron::ShareableCameraData>
+    {
+        static uint64_t Hash();
+    };
+}  // namespace tsr
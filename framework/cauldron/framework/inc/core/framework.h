@@ -174,9 +174,10 @@ namespace cauldron
         // Streaming
         struct StreamingInfo
         {
-            std::wstring Host = L"localhost";
-            uint32_t     Port = 4443;
-            std::wstring Name = L"live";
+            std::wstring Host          = L"localhost";
+            uint32_t     Port          = 4443;
+            std::wstring Name          = L"live";
+            uint32_t     ReadbackDepth = 4;  // Frames read back at once, frames which find every readback taken are dropped
         } StreamingInfo;
 
         // FPS limiter
@@ -233,6 +234,9 @@ namespace cauldron
         // App identifier
         std::wstring                  AppName = L"";
 
+        // TSR session, distinguishes renderers sharing one upscaler
+        std::wstring                  SessionName = L"";
+
         // Screenshot name (for use with perf output when specified)
         std::experimental::filesystem::path ScreenShotFileName = L"";
 
@@ -320,6 +324,7 @@ namespace cauldron
     class DynamicBufferPool;
     class DynamicResourcePool;
     class FrameworkInternal;
+    class GPUResource;
     class InputManager;
     class Profiler;
     class RasterViewAllocator;
@@ -534,6 +539,20 @@ namespace cauldron
          */
         const Texture* GetRenderTexture(const wchar_t* name) const;
 
+        /**
+         * @brief   Backs a render resource with shared resources it rotates through (i.e. placed in heaps shared with another
+         *          process), see Texture::SetSharedResources. An empty list goes back to the render resource's own resource.
+         *          Flushes the graphics queue and rebinds the resource views, including the views of every shared resource.
+         */
+        void SetRenderResourceSharing(const Texture* pTexture, std::vector<GPUResource*>& resources);
+
+        /**
+         * @brief   Backs the shared render resources with the specified one of their resources. Parameter sets keep views of every
+         *          shared resource and pick the current one when bound, so frames in flight keep theirs and nothing is flushed.
+         *          DirectX 12 only.
+         */
+        void RotateRenderResources(uint32_t index);
+
         /**
          * @brief   Retrieves the requested <c><i>RenderModule</i></c> instance.
          *          Note: This should not be called after application initialization.
@@ -550,6 +569,11 @@ namespace cauldron
          */
         const wchar_t* GetName() const { return m_Name.c_str(); }
 
+        /**
+         * @brief   Retrieves the name the application's shared memory is created under, the application's name followed by the session if there is one.
+         */
+        std::wstring GetSharedName() const { return m_Config.SessionName.empty() ? m_Name : m_Name + L"_" + m_Config.SessionName; }
+
         /**
          * @brief   Retrieves the command line arguments passed to the application.
          */
@@ -634,10 +658,12 @@ namespace cauldron
         }
 
         /**
-         * @brief   Gets the current buffer index. Starts at 0 with mod m_BufferCount.
+         * @brief   Gets the current buffer index. Starts at 0 with mod m_BufferCount, unless overridden with SetBufferIndexFunction.
          */
         uint64_t GetBufferIndex() const
         {
+            if (m_BufferIndexFn)
+                return m_BufferIndexFn();
             return GetBufferIndexMonotonic() % m_BufferCount;
         }
 
@@ -722,6 +748,21 @@ namespace cauldron
          */
         bool CanExecuteMainLoop() { return m_ReadyForNext(); }
 
+        /**
+         * @brief    Set the function that selects the buffer index used by the current MainLoop
+         */
+        void SetBufferIndexFunction(std::function<uint64_t()> fn) { m_BufferIndexFn = fn; }
+
+        /**
+         * @brief    Set the function called once the command lists of the frame were submitted to the graphics queue
+         */
+        void SetPostSubmitFunction(std::function<void()> fn) { m_PostSubmitFn = fn; }
+
+        /**
+         * @brief    Set the function that adds fields to the benchmark telemetry, called each time the telemetry is reported
+         */
+        void SetTelemetryFunction(std::function<void(json&)> fn) { m_TelemetryFn = fn; }
+
         /**
          * @brief    Set the function that determines if the framework can exit or not
          */
@@ -732,6 +773,16 @@ namespace cauldron
          */
         bool CanExit() { return m_CanExit(); }
 
+        /**
+         * @brief    Enable or disable the camera data shared between the renderer and the upscaler, for upscalers that get the camera some other way
+         */
+        void EnableSharedCameraData(bool enabled) { m_SharedCameraData = enabled; }
+
+        /**
+         * @brief    Check if the camera data is shared between the renderer and the upscaler
+         */
+        bool IsSharedCameraDataEnabled() const { return m_SharedCameraData; }
+
         /**
          * @brief    Set the reset flag
          */
@@ -751,6 +802,7 @@ namespace cauldron
         NO_MOVE(Framework);
 
         int CreateRenderResources();
+        void RebindResizableResources();
         void RegisterComponentsAndModules();
         RenderModule* GetRenderModule(uint32_t order);
         bool AreDependeciesPresent(const std::set<std::string>&, const std::set<std::string>&);
@@ -803,6 +855,10 @@ namespace cauldron
         FrameCaptureState     m_PixCaptureState           = FrameCaptureState::None;
         std::function<bool()> m_ReadyForNext              = []() { return true; };
         std::function<bool()> m_CanExit                   = []() { return true; };
+        std::function<uint64_t()> m_BufferIndexFn         = nullptr;
+        bool                      m_SharedCameraData      = true;
+        std::function<void()>     m_PostSubmitFn          = nullptr;
+        std::function<void(json&)> m_TelemetryFn          = nullptr;
 
         // Task Manager for background tasks
         TaskManager*            m_pTaskManager = nullptr;
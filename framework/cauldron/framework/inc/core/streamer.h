@@ -1,5 +1,6 @@
 #pragma once
 #include "core/framework.h"
+#include "stream.h"
 #include <mutex>
 #include <chrono>
 
@@ -20,24 +21,28 @@ namespace cauldron
         Streamer() = default;
 
         /**
-         * @brief   Initialize the encoder. Sets up the encoder and opens Media-over-QUIC publisher process.
+         * @brief   Initialize the encoder. Sets up the encoder, opens the Media-over-QUIC publisher process and
+         *          starts the encode pipeline.
          */
         void Init();
 
         /**
-         * @brief   Shutdown the encoder. Closes the encoder and publisher.
+         * @brief   Shutdown the encoder. Encodes the frames still in the pipeline and closes the encoder and publisher.
          */
         void Shutdown();
 
         /**
-         * @brief   Encode the encoder target. This is the main function that is called to encode the encoder target.
-         * @param backbufferIndex   The index of the back buffer to encode.
-         * @param frameIndex        The index of the frame to encode.
+         * @brief   Hand a frame the GPU finished to the encode pipeline. Called from the task threads in any order,
+         *          never waits for the encoder.
+         * @param renderFrameID     The framework's frame ID of the frame, which orders the frames in the stream and
+         *                          finds its readback slot.
+         * @param frameIndex        The benchmark index of the frame, negative for bootstrapping frames which are not sent.
          */
-        void Encode(uint8_t currentBackBufferIndex, int64_t frameIndex);
+        void Encode(uint64_t renderFrameID, int64_t frameIndex);
 
         /**
-         * @brief   Execute the copy command. This is the main function that is called to copy the encoder target to the swap chain.
+         * @brief   Execute the copy command. Copies the swap chain into a free slot of the readback ring, or drops the
+         *          frame without waiting when the ring or the encode pipeline is full.
          * @param pCmdList  The command list to execute the copy command on.
          */
         void ExecuteCopyCommand(CommandList* pCmdList);
@@ -60,30 +65,40 @@ namespace cauldron
     private:
         /**
          * @brief   Create the encoder and publisher.
-         * This function sets up the encoder and opens the Media-over-QUIC publisher process.
+         * This function sets up the FFmpeg encoder, opens the Media-over-QUIC publisher process
+         * and starts the pipeline feeding the encoder.
          */
         void CreateEncoderAndPublisher();
 
         /**
          * @brief   Terminate the publisher process.
-         * This function is used to terminate the process.
+         * This function drains the pipeline, closes the encoder, gives it a moment to flush and reaps the processes.
          */
-        void Streamer::TerminatePublisher();
+        void TerminatePublisher();
 
         // Timing information
         std::map<int64_t, std::map<uint32_t, std::chrono::microseconds>> m_timingInfo;
 
-        // Encoder/Publisher process
-        HANDLE              m_hPipe = INVALID_HANDLE_VALUE;
-        PROCESS_INFORMATION m_piPublisher;
-        std::atomic<bool>   m_isPipeOpen = false;
-        ResolutionInfo      m_resolutionInfo;
+        // Encoder and publisher, the encoder pipes the frames into ffmpeg. The pipeline reads the frames back, converts
+        // and encodes them on threads of its own.
+        StreamPipeline    m_pipeline;
+        std::atomic<bool> m_isStreaming = false;
+        ResolutionInfo    m_resolutionInfo;
+
+        // Readback ring, each slot holds the ID of the frame copied into it until the pipeline converted the frame
+        std::unique_ptr<std::atomic<uint64_t>[]> m_readbackSlots;
+        uint32_t                                 m_readbackDepth = 0;
+
+        // Occupancy of the readback ring, sampled by the render thread every frame
+        struct ReadbackStats
+        {
+            uint64_t samples      = 0;
+            uint64_t occupancySum = 0;
+            uint64_t occupancyMax = 0;
+            uint64_t ringFull     = 0;  // Frames dropped without a free slot
+        } m_readbackStats;
 
         // Syncronization
-        std::mutex              m_encodeMutex;
-        std::mutex              m_bufferMutex;
-        std::mutex              m_timingMutex;
-        std::atomic<int64_t>    m_frameIndex = 0;
-        std::condition_variable m_bufferCV;
+        std::mutex m_timingMutex;
     };
 }  // namespace cauldron
@@ -99,11 +99,23 @@ namespace cauldron
          */
         const Buffer* CreateBuffer(const BufferDesc* pDesc, ResourceState initialState, BufferResizeFunction fn = nullptr);
 
+        /**
+         * @brief   Backs a <c><i>Texture</i></c> resource with shared resources it rotates through, see Texture::SetSharedResources.
+         *          An empty list goes back to the texture's own resource.
+         */
+        void SetSharedResources(const Texture* pTexture, std::vector<GPUResource*>& resources);
+
+        /**
+         * @brief   Backs every <c><i>Texture</i></c> resource with shared resources with the specified one of them.
+         */
+        void SetSharedResourceIndex(uint32_t index);
+
     private:
         std::vector<std::pair<std::wstring, Texture*>>  m_Textures;
         std::vector<std::pair<std::wstring, Buffer*>>   m_Buffers;
         std::vector<Texture*>                           m_ResizableTextures; 
         std::vector<Buffer*>                            m_ResizableBuffers;
+        std::vector<Texture*>                           m_SharedTextures;
         std::mutex m_CriticalSection;
     };
 
@@ -125,6 +125,12 @@ namespace cauldron
          */
         virtual void OnResourceResized() override;
 
+        /**
+         * @brief   Nothing to rebind: the texture views of every shared resource slot are already in place, and the one of the
+         *          current slot is picked at bind time.
+         */
+        virtual void OnResourceRotated() override {}
+
     private:
         // No copy, No move
         NO_COPY(ParameterSet)
@@ -151,6 +157,10 @@ namespace cauldron
         ResourceViewInfo GetBufferSRV(uint32_t rootParameterIndex, uint32_t slotIndex);
         ResourceViewInfo GetBufferUAV(uint32_t rootParameterIndex, uint32_t slotIndex);
 
+        // Texture views of the current shared resource slot, the bound ones without shared resources
+        ResourceView* GetTextureSRVViews() const;
+        ResourceView* GetTextureUAVViews() const;
+
         void CheckResizable();
 
         const uint32_t m_BufferedSetCount;
@@ -207,6 +217,17 @@ namespace cauldron
         std::vector<BoundResource> m_BoundBufferSRVs;
         std::vector<BoundResource> m_BoundBufferUAVs;
         std::vector<BoundResource> m_BoundSamplers;
+
+        void CreateSharedSlotViews();
+        void DestroySharedSlotViews();
+        void BindSharedSlotViews(std::vector<ResourceView*>& slotViews, const BoundResource& bound, ResourceViewType type, uint32_t index);
+
+        // One copy of the texture views per slot of the bound textures with shared resources, which rotate through them
+        // while frames in flight still read the views of the previous slots
+        uint32_t                   m_SharedSlotCount = 0;
+        const Texture*             m_pSharedTexture  = nullptr;
+        std::vector<ResourceView*> m_SharedTextureSRVResourceViews;
+        std::vector<ResourceView*> m_SharedTextureUAVResourceViews;
     };
 
 } // namespace cauldron
@@ -42,6 +42,10 @@ namespace cauldron
         void MarkAsResizableResourceIndependent();
 
         virtual void OnResourceResized() = 0;
+
+        // Shared render resources moved on to another of their resources, see Framework::RotateRenderResources. Frames
+        // in flight may still use the views, so only views read at record time can be rewritten.
+        virtual void OnResourceRotated() { OnResourceResized(); }
     };
 
 } // namespace cauldron
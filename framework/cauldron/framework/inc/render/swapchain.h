@@ -127,14 +127,16 @@ namespace cauldron
         }
 
         /**
-         * @brief   Copies the swap chain to the readback buffer.
+         * @brief   Copies the swap chain into a slot of a ring of slotCount readback buffers, creating them as needed.
+         *          The caller keeps track of which slots are in use, a slot is only copied into once it was released.
          */
-        virtual void CopySwapChainToReadback(CommandList* pCmdList) = 0;
-        
+        virtual void CopySwapChainToReadback(CommandList* pCmdList, uint32_t slot, uint32_t slotCount) = 0;
+
         /**
-         * @brief   Copies the readback buffer to memory.
+         * @brief   Maps a readback slot once the command list copying into it has completed. Returns the function
+         *          unmapping it again.
          */
-        virtual std::function<void()> CopyReadbackToMemory(uint8_t** ppData, uint8_t at) = 0;
+        virtual std::function<void()> CopyReadbackToMemory(uint8_t** ppData, uint32_t slot) = 0;
 
         /**
          * @brief   Creates a screenshot of the current swap chain.
@@ -183,10 +183,38 @@ namespace cauldron
         virtual bool IsSwapChain() const { return false; }
 
         /**
-         * @brief   Callback invoked by OnResize event.
+         * @brief   Callback invoked by OnResize event. Drops the shared resources, which can't be resized.
          */
         void OnRenderingResolutionResize(uint32_t outputWidth, uint32_t outputHeight, uint32_t renderingWidth, uint32_t renderingHeight);
 
+        /**
+         * @brief   Backs the texture with externally allocated resources (i.e. placed in heaps shared with another process)
+         *          which it rotates through like swap chain back buffers, starting with the first one. The texture takes
+         *          ownership of the resources, an empty list goes back to the texture's own resource. Views of the texture
+         *          have to be rebound when the resources change, parameter sets then keep views of every one of them.
+         */
+        void SetSharedResources(std::vector<GPUResource*>& resources);
+
+        /**
+         * @brief   Backs the texture with the specified shared resource.
+         */
+        void SetSharedResourceIndex(uint32_t index);
+
+        /**
+         * @brief   Returns the number of shared resources backing the texture in turn, 0 if it uses its own resource.
+         */
+        uint32_t GetSharedResourceCount() const { return static_cast<uint32_t>(m_SharedResources.size()); }
+
+        /**
+         * @brief   Returns the specified shared resource, whether it backs the texture or not.
+         */
+        const GPUResource* GetSharedResource(uint32_t index) const { return m_SharedResources[index]; }
+
+        /**
+         * @brief   Returns the index of the shared resource backing the texture.
+         */
+        uint32_t GetSharedResourceIndex() const { return m_SharedResourceIndex; }
+
         /**
          * @brief   Gets the internal implementation for api/platform parameter accessors.
          */
@@ -213,6 +241,11 @@ namespace cauldron
         GPUResource*        m_pResource   = nullptr;
         TextureInternal*    m_pImpl       = nullptr;
         ResizeFunction      m_ResizeFn    = nullptr;
+
+        // Set while the texture is backed by shared resources
+        GPUResource*                m_pOwnResource = nullptr;
+        std::vector<GPUResource*>   m_SharedResources;
+        uint32_t                    m_SharedResourceIndex = 0;
     };
 
     /**
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class StreamPixelFormat : uint32_t
+{
+    RGBA = 0,  // 8 bits per channel, as the swap chain readback has it
+    I420,      // Y plane, U plane, V plane, the chroma planes half size in both directions
+    NV12,      // Y plane, then a plane of interleaved U and V
+};
+
+const char* StreamGetPixelFormatName(StreamPixelFormat format);
+
+// Instruction sets the converter has a path for, in order
+enum class StreamSimd : uint32_t
+{
+    Scalar = 0,
+    SSE41,
+    AVX2,
+};
+
+// The best of them the CPU supports
+StreamSimd StreamGetSupportedSimd();
+
+const char* StreamGetSimdName(StreamSimd simd);
+
+// Where the planes of a YUV frame are. NV12 has two, the third is unused.
+struct StreamYuvPlanes
+{
+    uint8_t* pPlanes[3] = {};
+    size_t   pitches[3] = {};
+};
+
+// Bytes of a width x height frame with tightly packed planes, odd sizes rounding the chroma planes up
+size_t StreamGetFrameSize(StreamPixelFormat format, uint32_t width, uint32_t height);
+
+// The planes of a frame of StreamGetFrameSize bytes
+StreamYuvPlanes StreamGetPackedPlanes(StreamPixelFormat format, uint32_t width, uint32_t height, uint8_t* pFrame);
+
+// Convert rows [rowBegin, rowEnd) of a width x height RGBA frame, rows rowPitch bytes apart, into BT.709 limited range
+// I420 or NV12. rowBegin has to be even, each chroma row comes of the average of two rows of texels (a single one at
+// the bottom of an odd height). All instruction sets give the same values.
+void StreamConvertRows(StreamSimd              simd,
+                       const uint8_t*          pRgba,
+                       size_t                  rowPitch,
+                       uint32_t                width,
+                       uint32_t                height,
+                       uint32_t                rowBegin,
+                       uint32_t                rowEnd,
+                       StreamPixelFormat       format,
+                       const StreamYuvPlanes&  planes);
+
+// Converts frames in bands of rows, on the calling thread and a pool of workers
+class StreamColorConverter
+{
+public:
+    // Workers besides the calling thread, by default one less than there are cores, at least one and up to three
+    explicit StreamColorConverter(uint32_t workerCount = UINT32_MAX);
+    ~StreamColorConverter();
+
+    StreamColorConverter(const StreamColorConverter&)            = delete;
+    StreamColorConverter& operator=(const StreamColorConverter&) = delete;
+
+    // Use another instruction set than the best one, it is clamped to the supported ones
+    void       SetSimd(StreamSimd simd);
+    StreamSimd GetSimd() const { return m_Simd; }
+
+    // Threads converting a frame, the calling one included
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+    // Convert a frame, returning once all bands are done. One frame at a time.
+    void Convert(const uint8_t* pRgba, size_t rowPitch, uint32_t width, uint32_t height, StreamPixelFormat format, const StreamYuvPlanes& planes);
+
+private:
+    struct Job
+    {
+        const uint8_t*    pRgba    = nullptr;
+        size_t            rowPitch = 0;
+        uint32_t          width    = 0;
+        uint32_t          height   = 0;
+        uint32_t          bandRows = 0;  // Even
+        StreamPixelFormat format   = StreamPixelFormat::I420;
+        StreamYuvPlanes   planes;
+    };
+
+    StreamSimd               m_Simd = StreamSimd::Scalar;
+    std::vector<std::thread> m_Workers;
+
+    std::mutex              m_Mutex;
+    std::condition_variable m_WorkCV;
+    std::condition_variable m_DoneCV;
+    Job                     m_Job;
+    uint64_t                m_Generation = 0;  // Bumped for every frame, wakes the workers
+    uint32_t                m_Pending    = 0;  // Workers still converting the frame
+    bool                    m_Quit       = false;
+
+    void RunWorker(uint32_t band);
+
+    void ConvertBand(const Job& job, uint32_t band) const;
+};
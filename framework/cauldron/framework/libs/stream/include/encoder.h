@@ -0,0 +1,86 @@
+#pragma once
+
+#include "convert.h"
+#include "process.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct StreamEncoderParams
+{
+    uint32_t    width  = 0;
+    uint32_t    height = 0;
+    std::string codec  = "libx264";
+    std::string preset = "ultrafast";
+    std::string tune   = "zerolatency";
+
+    // Processes the fragmented MP4 is piped into, the last one writing into outputPath (standard output if empty).
+    // Without any the encoder writes into outputPath itself.
+    std::vector<StreamCommand> publisher;
+    std::string                outputPath;
+
+    uint64_t writeTimeoutUs = 100000;      // Drop a frame ffmpeg does not start reading in time
+    uint32_t convertWorkers = UINT32_MAX;  // Threads converting the frames besides the calling one, see StreamColorConverter
+};
+
+// Encodes frames into fragmented MP4, a fragment per frame, and hands it to the publisher. Frame N is stamped N in a
+// time base of one second, the player paces the frames as they arrive. RGBA8 frames are converted into BT.709 I420 with
+// a StreamColorConverter on the calling thread and its workers, frames converted elsewhere go in as they are.
+class StreamEncoder
+{
+public:
+    virtual ~StreamEncoder() = default;
+
+    // Start encoding, spawning the encoder and publisher processes. Returns false if the encoder could not be set up.
+    virtual bool Open(const StreamEncoderParams& params) = 0;
+
+    // Encode a frame of width x height RGBA8 texels, rows rowPitch bytes apart. Timeout drops the frame, Closed means
+    // the encoder or the publisher is gone and the encoder has to be opened again.
+    virtual StreamWriteStatus Encode(const uint8_t* pRgba, size_t rowPitch) = 0;
+
+    // Encode a frame already converted into I420, its planes packed as StreamGetPackedPlanes has them
+    virtual StreamWriteStatus EncodeI420(const uint8_t* pFrame) = 0;
+
+    // Flush the frames still in flight and end the stream, waiting up to timeoutUs for the processes to finish
+    virtual void Close(uint64_t timeoutUs) = 0;
+
+    virtual bool IsOpen() const = 0;
+
+    // Why Open failed or the encoder closed
+    const std::string& GetError() const { return m_Error; }
+
+protected:
+    std::string m_Error;
+
+    // The converter of the RGBA frames, started with the first of them
+    StreamColorConverter& GetConverter(uint32_t workerCount)
+    {
+        if (!m_pConverter)
+            m_pConverter = std::make_unique<StreamColorConverter>(workerCount);
+        return *m_pConverter;
+    }
+
+private:
+    std::unique_ptr<StreamColorConverter> m_pConverter;
+};
+
+// The ffmpeg process reads the I420 frames from a pipe and encodes them, the publisher reads the MP4 from the next one
+class StreamPipeEncoder : public StreamEncoder
+{
+public:
+    ~StreamPipeEncoder() override { Close(0); }
+
+    bool              Open(const StreamEncoderParams& params) override;
+    StreamWriteStatus Encode(const uint8_t* pRgba, size_t rowPitch) override;
+    StreamWriteStatus EncodeI420(const uint8_t* pFrame) override;
+    void              Close(uint64_t timeoutUs) override;
+    bool              IsOpen() const override { return m_Chain.IsOpen(); }
+
+private:
+    StreamEncoderParams  m_Params;
+    StreamProcessChain   m_Chain;
+    std::vector<uint8_t> m_Frame;  // Converted for ffmpeg's rawvideo demuxer
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "convert.h"
+#include "encoder.h"
+#include "queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A frame on its way through the pipeline
+struct StreamPipelineFrame
+{
+    int64_t  index    = 0;
+    uint32_t slot     = 0;      // Readback the renderer copied the frame into
+    bool     copied   = true;   // False for frames the renderer did not copy, they only keep the order going
+    bool     encode   = true;   // False for frames which are only to be handed back, like warm-up frames
+    int64_t  tag      = 0;      // The renderer's own number for the frame, handed back as is
+    uint64_t submitUs = 0;
+
+    // Set by the readback callback: the mapped texels and how to unmap them and hand the readback back
+    const uint8_t*        pRgba    = nullptr;
+    size_t                rowPitch = 0;
+    std::function<void()> release;
+
+    uint32_t buffer = 0;  // Converted frame in the pool
+};
+
+struct StreamPipelineParams
+{
+    uint32_t width           = 0;
+    uint32_t height          = 0;
+    uint32_t maxInFlight     = 3;   // Frames reserved but not encoded yet, Reserve waits beyond that
+    uint32_t reorderWindow   = 16;  // Frames held back waiting for a missing one before it is given up on
+    uint32_t encoderRestarts = 3;   // Times a closed encoder is opened again for a frame before streaming stops
+
+    // Wait for the copy of frame.slot and map it, setting pRgba, rowPitch and release. Called on the readback thread,
+    // in frame order. False if the frame could not be mapped.
+    std::function<bool(StreamPipelineFrame& frame)> readback;
+
+    // Called on the encode thread once a frame went through the encoder: Written, or Timeout if it was dropped
+    std::function<void(const StreamPipelineFrame& frame, StreamWriteStatus status)> encoded;
+};
+
+struct StreamPipelineStats
+{
+    uint64_t submitted       = 0;  // Frames copied by the renderer and handed over
+    uint64_t encoded         = 0;
+    uint64_t dropped         = 0;  // Frames the encoder was not ready for, or which came after streaming stopped
+    uint64_t released        = 0;  // Frames handed back unencoded as asked
+    uint64_t skipped         = 0;  // Frames the renderer did not copy
+    uint64_t late            = 0;  // Frames which came after a later one went on, handed back unencoded
+    uint64_t gaps            = 0;  // Missing frames the reorder buffer gave up on
+    uint64_t reserveTimeouts = 0;  // Reserve calls which found the pipeline full until the deadline
+    uint64_t restarts        = 0;  // Times the encoder was opened again
+    uint64_t reserveWaitUs   = 0;  // Time the renderer spent in Reserve
+    uint64_t readbackUs      = 0;  // Time spent waiting for and mapping readbacks
+    uint64_t convertUs       = 0;
+    uint64_t encodeUs        = 0;
+    uint64_t latencyUs       = 0;  // From Submit until encoded, summed over the encoded frames
+    uint64_t latencyMaxUs    = 0;
+    uint64_t reorderMax      = 0;  // Most frames the reorder buffer held at once
+};
+
+// Hands frames from the renderer to the encoder on threads of its own: a readback thread puts the frames back in order
+// and waits for their copies, a convert thread turns them into I420 and hands the readbacks back, an encode thread
+// feeds the encoder, which publishes through its processes. The stages pass the frames on through bounded lock-free
+// queues. The renderer reserves a place for a frame before copying it, which is where it waits when the encoder falls
+// behind. Frames are handed over in any order from any thread, without waiting.
+class StreamPipeline
+{
+public:
+    StreamPipeline() = default;
+    ~StreamPipeline() { Stop(0); }
+
+    StreamPipeline(const StreamPipeline&)            = delete;
+    StreamPipeline& operator=(const StreamPipeline&) = delete;
+
+    // Open the encoder and start the threads. Returns false with GetError set if the encoder could not be opened.
+    bool Start(std::unique_ptr<StreamEncoder> pEncoder, const StreamEncoderParams& encoderParams, const StreamPipelineParams& params);
+
+    // Hand the frames still in the pipeline to the encoder and close it, giving its processes up to timeoutUs to finish
+    void Stop(uint64_t timeoutUs);
+
+    // Renderer: wait up to timeoutUs for room for another frame. Only a frame which got room is to be copied and
+    // submitted, false means it is not streamed.
+    bool Reserve(uint64_t timeoutUs);
+
+    // Hand over a frame which got room, copied into the readback slot. encode false only hands the readback back.
+    void Submit(int64_t index, uint32_t slot, bool encode = true, int64_t tag = 0);
+
+    // Hand over a frame the renderer did not copy, so the frames behind it don't wait for it
+    void Skip(int64_t index);
+
+    // True from Start until Stop or until the encoder could not be restarted
+    bool IsStreaming() const { return m_Running && !m_Failed; }
+
+    // Why streaming stopped
+    std::string GetError();
+
+    StreamPipelineStats GetStats() const;
+
+private:
+    struct Counters
+    {
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> encoded{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> released{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> late{0};
+        std::atomic<uint64_t> gaps{0};
+        std::atomic<uint64_t> reserveTimeouts{0};
+        std::atomic<uint64_t> restarts{0};
+        std::atomic<uint64_t> reserveWaitUs{0};
+        std::atomic<uint64_t> readbackUs{0};
+        std::atomic<uint64_t> convertUs{0};
+        std::atomic<uint64_t> encodeUs{0};
+        std::atomic<uint64_t> latencyUs{0};
+        std::atomic<uint64_t> latencyMaxUs{0};
+        std::atomic<uint64_t> reorderMax{0};
+    };
+
+    StreamPipelineParams                  m_Params;
+    StreamEncoderParams                   m_EncoderParams;
+    std::unique_ptr<StreamEncoder>        m_pEncoder;
+    std::unique_ptr<StreamColorConverter> m_pConverter;
+    std::vector<std::vector<uint8_t>>     m_Buffers;  // Converted frames, one per frame in flight
+
+    // Renderer -> readback -> convert -> encode, and the converted frames' buffers back to the convert thread
+    std::unique_ptr<StreamQueue<StreamPipelineFrame>> m_pSubmitted;
+    std::unique_ptr<StreamQueue<StreamPipelineFrame>> m_pMapped;
+    std::unique_ptr<StreamQueue<StreamPipelineFrame>> m_pConverted;
+    std::unique_ptr<StreamQueue<uint32_t>>            m_pFreeBuffers;
+    StreamDoorbell                                    m_SubmittedBell;
+    StreamDoorbell                                    m_MappedBell;
+    StreamDoorbell                                    m_ConvertedBell;
+    StreamDoorbell                                    m_FreeBufferBell;
+
+    std::thread       m_ReadbackThread;
+    std::thread       m_ConvertThread;
+    std::thread       m_EncodeThread;
+    std::atomic<bool> m_Running{false};
+    std::atomic<bool> m_Stopping{false};
+    std::atomic<bool> m_ReadbackDone{false};
+    std::atomic<bool> m_ConvertDone{false};
+    std::atomic<bool> m_Failed{false};
+
+    // Frames between Reserve and the end of the pipeline
+    std::mutex              m_ReserveMutex;
+    std::condition_variable m_ReserveCV;
+    uint32_t                m_InFlight = 0;
+
+    std::mutex  m_ErrorMutex;
+    std::string m_Error;
+
+    Counters m_Counters;  // Since the pipeline was created, over every Start
+
+    void RunReadback();
+    void RunConvert();
+    void RunEncode();
+
+    // Map a frame and pass it on to the convert thread, or hand it back if it is not to be encoded
+    void Forward(StreamPipelineFrame& frame);
+
+    // Encode a converted frame, opening the encoder again if it closed. False if it could not be restarted.
+    bool Encode(const StreamPipelineFrame& frame);
+
+    // A reserved frame left the pipeline
+    void Finish();
+
+    void SetError(const std::string& error);
+};
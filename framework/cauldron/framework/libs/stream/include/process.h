@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+// A child process: the program, looked up in PATH, and its arguments
+struct StreamCommand
+{
+    std::string              program;
+    std::vector<std::string> args;
+};
+
+enum class StreamWriteStatus : uint32_t
+{
+    Written = 0,  // All of the data went into the pipe
+    Timeout,      // The pipe stayed full until the deadline, none of the data was written
+    Closed,       // The chain stopped reading, the children are gone or going
+};
+
+// Processes piped into each other like a shell pipeline. The parent writes into the standard input of the first one,
+// the standard output of every process goes into the standard input of the next, the last one writes into a file or
+// the parent's standard output. Spawned with CreateProcess on Windows and posix_spawn on POSIX.
+class StreamProcessChain
+{
+public:
+    StreamProcessChain() = default;
+    ~StreamProcessChain() { Stop(0); }
+
+    StreamProcessChain(const StreamProcessChain&)            = delete;
+    StreamProcessChain& operator=(const StreamProcessChain&) = delete;
+
+    // Spawn the chain, the last process writing into outputPath if there is one. Returns false if a process could not
+    // be spawned, in which case the ones already spawned are killed again.
+    bool Start(const std::vector<StreamCommand>& commands, const std::string& outputPath = "");
+
+    // Write the data into the pipe, waiting up to timeoutUs for the first process to make room. Once part of the data
+    // is in the pipe the rest has to follow, a torn write would shift every later byte of the stream, so a chain
+    // which stops reading mid-write for longer than the stall timeout is taken for stuck and closed.
+    StreamWriteStatus Write(const void* pData, size_t size, uint64_t timeoutUs);
+
+    void SetStallTimeout(uint64_t timeoutUs) { m_StallTimeoutUs = timeoutUs; }
+
+    // Close the pipe so the chain sees the end of the stream, give the processes up to timeoutUs to finish and kill
+    // the ones which did not. Every process is reaped before returning.
+    void Stop(uint64_t timeoutUs);
+
+    // True from Start until the chain stops reading or is stopped
+    bool IsOpen() const;
+
+    // Reap the processes which exited. True while all of them run.
+    bool IsRunning();
+
+    size_t GetProcessCount() const { return m_Processes.size(); }
+
+    // Exit code of a reaped process, -1 while it runs. On POSIX a process killed by a signal exits with 128 + signal.
+    int GetExitCode(size_t index) const { return m_Processes[index].exitCode; }
+
+    // Why Start failed or the chain stopped
+    const std::string& GetError() const { return m_Error; }
+
+private:
+    struct Process
+    {
+#if defined(_WIN32)
+        HANDLE handle = nullptr;
+#else
+        pid_t pid = -1;
+#endif
+        bool exited   = false;
+        int  exitCode = -1;
+    };
+
+    std::vector<Process> m_Processes;
+    std::string          m_Error;
+    uint64_t             m_StallTimeoutUs = 5000000;
+
+#if defined(_WIN32)
+    HANDLE m_Pipe  = INVALID_HANDLE_VALUE;  // Overlapped write end of a named pipe, anonymous pipes can't time out
+    HANDLE m_Event = nullptr;
+#else
+    int m_Pipe = -1;  // Non-blocking write end
+#endif
+
+    // Reap the process if it exited, waiting up to timeoutUs for it to. Returns true once it is reaped.
+    bool Reap(Process& process, uint64_t timeoutUs);
+
+    void Kill(Process& process);
+
+    void ClosePipe();
+};
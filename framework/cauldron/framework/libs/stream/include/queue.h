@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// Bounded lock-free queue, any number of producers and consumers. Every cell carries a sequence number telling whose
+// turn it is: a producer claims the cell at the tail once its sequence equals the tail, a consumer the one at the head
+// once it is one past the head. Capacity is rounded up to a power of two.
+template<typename T>
+class StreamQueue
+{
+public:
+    explicit StreamQueue(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+
+        m_Mask  = size - 1;
+        m_Cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++)
+            m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    StreamQueue(const StreamQueue&)            = delete;
+    StreamQueue& operator=(const StreamQueue&) = delete;
+
+    size_t GetCapacity() const { return m_Mask + 1; }
+
+    // False if the queue is full
+    bool TryPush(T&& value)
+    {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell&    cell     = m_Cells[tail & m_Mask];
+            size_t   sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t turn     = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+            if (turn == 0)
+            {
+                if (m_Tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (turn < 0)
+                return false;
+            else
+                tail = m_Tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    // False if the queue is empty
+    bool TryPop(T& value)
+    {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell&    cell     = m_Cells[head & m_Mask];
+            size_t   sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t turn     = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(head + 1);
+            if (turn == 0)
+            {
+                if (m_Head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(head + m_Mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (turn < 0)
+                return false;
+            else
+                head = m_Head.load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        T                   value{};
+    };
+
+    std::unique_ptr<Cell[]> m_Cells;
+    size_t                  m_Mask = 0;
+
+    // Apart, so producers and consumers don't share a cache line
+    alignas(64) std::atomic<size_t> m_Tail{0};
+    alignas(64) std::atomic<size_t> m_Head{0};
+};
+
+// Where the thread consuming a StreamQueue sleeps while it is empty, one thread per bell. The producers ring after
+// pushing. The queue itself takes no lock, this one is only taken to go to sleep and to wake the sleeper.
+class StreamDoorbell
+{
+public:
+    void Ring()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Rings++;
+        }
+        m_CV.notify_all();
+    }
+
+    // Wait until the bell rang since the last wait or the timeout passes, true if it rang
+    bool Wait(uint64_t timeoutUs)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        bool rang = m_CV.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] { return m_Rings != m_Seen; });
+        m_Seen    = m_Rings;
+        return rang;
+    }
+
+private:
+    std::mutex              m_Mutex;
+    std::condition_variable m_CV;
+    uint64_t                m_Rings = 0;
+    uint64_t                m_Seen  = 0;
+};
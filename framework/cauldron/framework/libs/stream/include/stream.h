@@ -0,0 +1,7 @@
+#pragma once
+
+#include "process.h"
+#include "encoder.h"
+#include "convert.h"
+#include "queue.h"
+#include "pipeline.h"
@@ -0,0 +1,440 @@
+#include "convert.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STREAM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang only in functions targeting it
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STREAM_TARGET_SSE41
+#define STREAM_TARGET_AVX2
+#else
+#define STREAM_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define STREAM_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // BT.709 in limited range, in 1.15 fixed point: luma scaled to 16..235, chroma to 16..240. The chroma weights sum
+    // to zero so that greys have no colour. Chroma is taken of the sum of four texels, hence two more bits of shift.
+    constexpr int16_t Y_R = 5983;
+    constexpr int16_t Y_G = 20127;
+    constexpr int16_t Y_B = 2032;
+    constexpr int16_t U_R = -3298;
+    constexpr int16_t U_G = -11094;
+    constexpr int16_t U_B = 14392;
+    constexpr int16_t V_R = 14392;
+    constexpr int16_t V_G = -13072;
+    constexpr int16_t V_B = -1320;
+
+    constexpr int32_t Y_BIAS  = (16 << 15) + (1 << 14);
+    constexpr int32_t C_BIAS  = (128 << 17) + (1 << 16);
+    constexpr int     Y_SHIFT = 15;
+    constexpr int     C_SHIFT = 17;
+
+    // Where the rows of a pair of texel rows go. The bottom row of an odd height pairs with itself.
+    struct RowPair
+    {
+        const uint8_t* pRow0;
+        const uint8_t* pRow1;
+        uint8_t*       pY0;
+        uint8_t*       pY1;
+        uint8_t*       pU;  // NV12: the interleaved chroma
+        uint8_t*       pV;
+        bool           nv12;
+    };
+
+    void ConvertScalar(const RowPair& pair, uint32_t x, uint32_t width)
+    {
+        for (; x < width; x += 2)
+        {
+            // The right column of an odd width pairs with itself
+            uint32_t x1 = std::min(x + 1, width - 1);
+
+            const uint8_t* pTexels[4] = {pair.pRow0 + x * 4, pair.pRow0 + x1 * 4, pair.pRow1 + x * 4, pair.pRow1 + x1 * 4};
+            uint8_t*       pLuma[4]   = {pair.pY0 + x, pair.pY0 + x1, pair.pY1 + x, pair.pY1 + x1};
+
+            int32_t r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                const uint8_t* p = pTexels[i];
+                *pLuma[i]        = static_cast<uint8_t>((Y_R * p[0] + Y_G * p[1] + Y_B * p[2] + Y_BIAS) >> Y_SHIFT);
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+
+            uint8_t u = static_cast<uint8_t>((U_R * r + U_G * g + U_B * b + C_BIAS) >> C_SHIFT);
+            uint8_t v = static_cast<uint8_t>((V_R * r + V_G * g + V_B * b + C_BIAS) >> C_SHIFT);
+            if (pair.nv12)
+            {
+                pair.pU[x]     = u;
+                pair.pU[x + 1] = v;
+            }
+            else
+            {
+                pair.pU[x / 2] = u;
+                pair.pV[x / 2] = v;
+            }
+        }
+    }
+
+#if defined(STREAM_X86)
+    // Luma of four texels, 32 bits each
+    STREAM_TARGET_SSE41 inline __m128i Luma4(__m128i texels, __m128i coef)
+    {
+        __m128i lo = _mm_madd_epi16(_mm_cvtepu8_epi16(texels), coef);
+        __m128i hi = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(texels, 8)), coef);
+        return _mm_hadd_epi32(lo, hi);
+    }
+
+    STREAM_TARGET_SSE41 inline __m128i Luma16(const uint8_t* pRow, __m128i coef, __m128i bias)
+    {
+        __m128i l[4];
+        for (int i = 0; i < 4; i++)
+        {
+            l[i] = Luma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i * 16)), coef);
+            l[i] = _mm_srai_epi32(_mm_add_epi32(l[i], bias), Y_SHIFT);
+        }
+        return _mm_packus_epi16(_mm_packs_epi32(l[0], l[1]), _mm_packs_epi32(l[2], l[3]));
+    }
+
+    // Chroma of eight 2x2 blocks from the sums of the two rows, two texels per sum, 16 bits each
+    STREAM_TARGET_SSE41 inline __m128i Chroma8(const __m128i* pSums, __m128i coef, __m128i bias)
+    {
+        __m128i m[8];
+        for (int i = 0; i < 8; i++)
+            m[i] = _mm_madd_epi16(pSums[i], coef);
+
+        __m128i c0 = _mm_hadd_epi32(_mm_hadd_epi32(m[0], m[1]), _mm_hadd_epi32(m[2], m[3]));
+        __m128i c1 = _mm_hadd_epi32(_mm_hadd_epi32(m[4], m[5]), _mm_hadd_epi32(m[6], m[7]));
+        c0         = _mm_srai_epi32(_mm_add_epi32(c0, bias), C_SHIFT);
+        c1         = _mm_srai_epi32(_mm_add_epi32(c1, bias), C_SHIFT);
+        return _mm_packs_epi32(c0, c1);
+    }
+
+    // 16 columns at a time, returns where it stopped
+    STREAM_TARGET_SSE41 uint32_t ConvertSSE41(const RowPair& pair, uint32_t x, uint32_t width)
+    {
+        const __m128i yCoef = _mm_setr_epi16(Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0);
+        const __m128i uCoef = _mm_setr_epi16(U_R, U_G, U_B, 0, U_R, U_G, U_B, 0);
+        const __m128i vCoef = _mm_setr_epi16(V_R, V_G, V_B, 0, V_R, V_G, V_B, 0);
+        const __m128i yBias = _mm_set1_epi32(Y_BIAS);
+        const __m128i cBias = _mm_set1_epi32(C_BIAS);
+
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8_t* pRow0 = pair.pRow0 + x * 4;
+            const uint8_t* pRow1 = pair.pRow1 + x * 4;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pY0 + x), Luma16(pRow0, yCoef, yBias));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pY1 + x), Luma16(pRow1, yCoef, yBias));
+
+            // Both rows added up, two texels per register
+            __m128i sums[8];
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i t0      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + i * 16));
+                __m128i t1      = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + i * 16));
+                sums[i * 2]     = _mm_add_epi16(_mm_cvtepu8_epi16(t0), _mm_cvtepu8_epi16(t1));
+                sums[i * 2 + 1] = _mm_add_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(t0, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(t1, 8)));
+            }
+
+            // U0..U7 V0..V7
+            __m128i uv = _mm_packus_epi16(Chroma8(sums, uCoef, cBias), Chroma8(sums, vCoef, cBias));
+            if (pair.nv12)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pU + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 8)));
+            else
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(pair.pU + x / 2), uv);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(pair.pV + x / 2), _mm_srli_si128(uv, 8));
+            }
+        }
+        return x;
+    }
+
+    // The AVX2 path widens four texels at a time into a register, pixels 0 and 1 in the low lane, 2 and 3 in the high
+    // one. The horizontal adds keep to their lanes, so the results come out of the packs with the lanes interleaved and
+    // are put back in order by unpacking the two lanes against each other.
+
+    STREAM_TARGET_AVX2 inline __m256i Widen4(const uint8_t* pTexels)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pTexels)));
+    }
+
+    STREAM_TARGET_AVX2 inline void Luma32(const uint8_t* pRow, uint8_t* pLuma, __m256i coef, __m256i bias)
+    {
+        // Texels 0 1 4 5 | 2 3 6 7, then on in steps of 8
+        __m256i l[4];
+        for (int i = 0; i < 4; i++)
+        {
+            l[i] = _mm256_hadd_epi32(_mm256_madd_epi16(Widen4(pRow + i * 32), coef), _mm256_madd_epi16(Widen4(pRow + i * 32 + 16), coef));
+            l[i] = _mm256_srai_epi32(_mm256_add_epi32(l[i], bias), Y_SHIFT);
+        }
+
+        // 0 1 4 5 8 9 .. 28 29 | 2 3 6 7 10 11 .. 30 31
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(l[0], l[1]), _mm256_packs_epi32(l[2], l[3]));
+        __m128i lo     = _mm256_castsi256_si128(packed);
+        __m128i hi     = _mm256_extracti128_si256(packed, 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pLuma), _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pLuma + 16), _mm_unpackhi_epi16(lo, hi));
+    }
+
+    // Chroma of sixteen 2x2 blocks from the sums of the two rows, four texels per sum: 0 2 4 .. 14 | 1 3 5 .. 15
+    STREAM_TARGET_AVX2 inline __m256i Chroma16(const __m256i* pSums, __m256i coef, __m256i bias)
+    {
+        __m256i m[8];
+        for (int i = 0; i < 8; i++)
+            m[i] = _mm256_madd_epi16(pSums[i], coef);
+
+        __m256i c0 = _mm256_hadd_epi32(_mm256_hadd_epi32(m[0], m[1]), _mm256_hadd_epi32(m[2], m[3]));
+        __m256i c1 = _mm256_hadd_epi32(_mm256_hadd_epi32(m[4], m[5]), _mm256_hadd_epi32(m[6], m[7]));
+        c0         = _mm256_srai_epi32(_mm256_add_epi32(c0, bias), C_SHIFT);
+        c1         = _mm256_srai_epi32(_mm256_add_epi32(c1, bias), C_SHIFT);
+        return _mm256_packs_epi32(c0, c1);
+    }
+
+    // 32 columns at a time, returns where it stopped
+    STREAM_TARGET_AVX2 uint32_t ConvertAVX2(const RowPair& pair, uint32_t x, uint32_t width)
+    {
+        const __m256i yCoef = _mm256_setr_epi16(Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0, Y_R, Y_G, Y_B, 0);
+        const __m256i uCoef = _mm256_setr_epi16(U_R, U_G, U_B, 0, U_R, U_G, U_B, 0, U_R, U_G, U_B, 0, U_R, U_G, U_B, 0);
+        const __m256i vCoef = _mm256_setr_epi16(V_R, V_G, V_B, 0, V_R, V_G, V_B, 0, V_R, V_G, V_B, 0, V_R, V_G, V_B, 0);
+        const __m256i yBias = _mm256_set1_epi32(Y_BIAS);
+        const __m256i cBias = _mm256_set1_epi32(C_BIAS);
+
+        for (; x + 32 <= width; x += 32)
+        {
+            const uint8_t* pRow0 = pair.pRow0 + x * 4;
+            const uint8_t* pRow1 = pair.pRow1 + x * 4;
+            Luma32(pRow0, pair.pY0 + x, yCoef, yBias);
+            Luma32(pRow1, pair.pY1 + x, yCoef, yBias);
+
+            __m256i sums[8];
+            for (int i = 0; i < 8; i++)
+                sums[i] = _mm256_add_epi16(Widen4(pRow0 + i * 16), Widen4(pRow1 + i * 16));
+
+            // U0 U2 .. U14 V0 V2 .. V14 | U1 U3 .. U15 V1 V3 .. V15
+            __m256i uv = _mm256_packus_epi16(Chroma16(sums, uCoef, cBias), Chroma16(sums, vCoef, cBias));
+            __m128i lo = _mm256_castsi256_si128(uv);
+            __m128i hi = _mm256_extracti128_si256(uv, 1);
+            __m128i u  = _mm_unpacklo_epi8(lo, hi);
+            __m128i v  = _mm_unpackhi_epi8(lo, hi);
+            if (pair.nv12)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pU + x), _mm_unpacklo_epi8(u, v));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pU + x + 16), _mm_unpackhi_epi8(u, v));
+            }
+            else
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pU + x / 2), u);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pair.pV + x / 2), v);
+            }
+        }
+        return x;
+    }
+#endif  // STREAM_X86
+}  // namespace
+
+const char* StreamGetPixelFormatName(StreamPixelFormat format)
+{
+    switch (format)
+    {
+    case StreamPixelFormat::RGBA:
+        return "rgba";
+    case StreamPixelFormat::I420:
+        return "i420";
+    case StreamPixelFormat::NV12:
+        return "nv12";
+    }
+    return "unknown";
+}
+
+StreamSimd StreamGetSupportedSimd()
+{
+#if defined(STREAM_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool avx   = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5)) != 0;
+#else
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2  = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2)
+        return StreamSimd::AVX2;
+    if (sse41)
+        return StreamSimd::SSE41;
+#endif
+    return StreamSimd::Scalar;
+}
+
+const char* StreamGetSimdName(StreamSimd simd)
+{
+    switch (simd)
+    {
+    case StreamSimd::Scalar:
+        return "scalar";
+    case StreamSimd::SSE41:
+        return "sse4.1";
+    case StreamSimd::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+size_t StreamGetFrameSize(StreamPixelFormat format, uint32_t width, uint32_t height)
+{
+    size_t texels = static_cast<size_t>(width) * height;
+    if (format == StreamPixelFormat::RGBA)
+        return texels * 4;
+    return texels + static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2) * 2;
+}
+
+StreamYuvPlanes StreamGetPackedPlanes(StreamPixelFormat format, uint32_t width, uint32_t height, uint8_t* pFrame)
+{
+    StreamYuvPlanes planes;
+    size_t          chromaWidth = (width + 1) / 2;
+    planes.pPlanes[0]           = pFrame;
+    planes.pitches[0]           = width;
+    planes.pPlanes[1]           = pFrame + static_cast<size_t>(width) * height;
+    if (format == StreamPixelFormat::NV12)
+        planes.pitches[1] = chromaWidth * 2;
+    else if (format == StreamPixelFormat::I420)
+    {
+        planes.pitches[1] = chromaWidth;
+        planes.pPlanes[2] = planes.pPlanes[1] + chromaWidth * ((height + 1) / 2);
+        planes.pitches[2] = chromaWidth;
+    }
+    return planes;
+}
+
+void StreamConvertRows(StreamSimd             simd,
+                       const uint8_t*         pRgba,
+                       size_t                 rowPitch,
+                       uint32_t               width,
+                       uint32_t               height,
+                       uint32_t               rowBegin,
+                       uint32_t               rowEnd,
+                       StreamPixelFormat      format,
+                       const StreamYuvPlanes& planes)
+{
+    simd = std::min(simd, StreamGetSupportedSimd());
+    for (uint32_t y = rowBegin & ~1u; y < std::min(rowEnd, height); y += 2)
+    {
+        bool    single = y + 1 >= height;
+        RowPair pair;
+        pair.pRow0 = pRgba + y * rowPitch;
+        pair.pRow1 = single ? pair.pRow0 : pair.pRow0 + rowPitch;
+        pair.pY0   = planes.pPlanes[0] + y * planes.pitches[0];
+        pair.pY1   = single ? pair.pY0 : pair.pY0 + planes.pitches[0];
+        pair.pU    = planes.pPlanes[1] + (y / 2) * planes.pitches[1];
+        pair.pV    = format == StreamPixelFormat::I420 ? planes.pPlanes[2] + (y / 2) * planes.pitches[2] : nullptr;
+        pair.nv12  = format == StreamPixelFormat::NV12;
+
+        uint32_t x = 0;
+#if defined(STREAM_X86)
+        if (simd >= StreamSimd::AVX2)
+            x = ConvertAVX2(pair, x, width);
+        if (simd >= StreamSimd::SSE41)
+            x = ConvertSSE41(pair, x, width);
+#endif
+        ConvertScalar(pair, x, width);
+    }
+}
+
+StreamColorConverter::StreamColorConverter(uint32_t workerCount)
+{
+    if (workerCount == UINT32_MAX)
+        workerCount = std::min(std::max(std::thread::hardware_concurrency(), 2u) - 1, 3u);
+
+    m_Simd = StreamGetSupportedSimd();
+    for (uint32_t i = 0; i < workerCount; i++)
+        m_Workers.emplace_back(&StreamColorConverter::RunWorker, this, i + 1);
+}
+
+StreamColorConverter::~StreamColorConverter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_WorkCV.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+}
+
+void StreamColorConverter::SetSimd(StreamSimd simd)
+{
+    m_Simd = std::min(simd, StreamGetSupportedSimd());
+}
+
+void StreamColorConverter::Convert(const uint8_t* pRgba, size_t rowPitch, uint32_t width, uint32_t height, StreamPixelFormat format, const StreamYuvPlanes& planes)
+{
+    // Bands of an even number of rows, so no chroma row is split between two of them
+    Job job;
+    job.pRgba    = pRgba;
+    job.rowPitch = rowPitch;
+    job.width    = width;
+    job.height   = height;
+    job.bandRows = ((height + GetThreadCount() - 1) / GetThreadCount() + 1) & ~1u;
+    job.format   = format;
+    job.planes   = planes;
+
+    if (!m_Workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Job     = job;
+            m_Pending = static_cast<uint32_t>(m_Workers.size());
+            m_Generation++;
+        }
+        m_WorkCV.notify_all();
+    }
+
+    // The calling thread takes the first band
+    ConvertBand(job, 0);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCV.wait(lock, [this] { return m_Pending == 0; });
+}
+
+void StreamColorConverter::RunWorker(uint32_t band)
+{
+    uint64_t generation = 0;
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCV.wait(lock, [&] { return m_Quit || m_Generation != generation; });
+            if (m_Quit)
+                return;
+            generation = m_Generation;
+            job        = m_Job;
+        }
+
+        ConvertBand(job, band);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_Pending == 0)
+            m_DoneCV.notify_one();
+    }
+}
+
+void StreamColorConverter::ConvertBand(const Job& job, uint32_t band) const
+{
+    uint32_t rowBegin = band * job.bandRows;
+    if (rowBegin >= job.height)
+        return;
+    uint32_t rowEnd = std::min(job.height, rowBegin + job.bandRows);
+    StreamConvertRows(m_Simd, job.pRgba, job.rowPitch, job.width, job.height, rowBegin, rowEnd, job.format, job.planes);
+}
@@ -0,0 +1,54 @@
+#include "encoder.h"
+
+bool StreamPipeEncoder::Open(const StreamEncoderParams& params)
+{
+    Close(0);
+    m_Params = params;
+
+    std::string videoSize = std::to_string(params.width) + "x" + std::to_string(params.height);
+
+    // FFmpeg encodes the converted frames from the pipe into fragmented MP4, on its standard output. They are tagged
+    // BT.709 limited range, which ffmpeg passes on to the stream without touching the frames.
+    StreamCommand ffmpeg;
+    ffmpeg.program = "ffmpeg";
+    ffmpeg.args    = {"-fflags", "nobuffer", "-y",
+                      "-f", "rawvideo", "-pixel_format", "yuv420p", "-video_size", videoSize,
+                      "-colorspace", "bt709", "-color_primaries", "bt709", "-color_trc", "bt709", "-color_range", "tv", "-i", "-",
+                      "-c:v", params.codec, "-preset", params.preset, "-tune", params.tune,
+                      "-vf", "setpts=N", "-video_track_timescale", "1",
+                      "-f", "mp4", "-movflags", "empty_moov+frag_every_frame+separate_moof+omit_tfhd_offset", "-"};
+
+    std::vector<StreamCommand> commands = {ffmpeg};
+    commands.insert(commands.end(), params.publisher.begin(), params.publisher.end());
+    if (!m_Chain.Start(commands, params.outputPath))
+    {
+        m_Error = m_Chain.GetError();
+        return false;
+    }
+
+    m_Frame.resize(StreamGetFrameSize(StreamPixelFormat::I420, params.width, params.height));
+    m_Error.clear();
+    return true;
+}
+
+StreamWriteStatus StreamPipeEncoder::Encode(const uint8_t* pRgba, size_t rowPitch)
+{
+    // A fraction of the RGBA bytes through the pipe, with the rows tightly packed as the rawvideo demuxer takes them
+    StreamYuvPlanes planes = StreamGetPackedPlanes(StreamPixelFormat::I420, m_Params.width, m_Params.height, m_Frame.data());
+    GetConverter(m_Params.convertWorkers).Convert(pRgba, rowPitch, m_Params.width, m_Params.height, StreamPixelFormat::I420, planes);
+    return EncodeI420(m_Frame.data());
+}
+
+StreamWriteStatus StreamPipeEncoder::EncodeI420(const uint8_t* pFrame)
+{
+    StreamWriteStatus status = m_Chain.Write(pFrame, m_Frame.size(), m_Params.writeTimeoutUs);
+    if (status == StreamWriteStatus::Closed)
+        m_Error = m_Chain.GetError();
+    return status;
+}
+
+void StreamPipeEncoder::Close(uint64_t timeoutUs)
+{
+    // Closing the pipe ends the stream, the processes which don't finish in time are killed
+    m_Chain.Stop(timeoutUs);
+}
@@ -0,0 +1,401 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace
+{
+    // How long an idle stage sleeps before it looks at the stop flags again, the bells wake it before that
+    constexpr uint64_t IDLE_WAIT_US = 10000;
+
+    // Renderer -> readback thread, copied frames and skipped ones
+    constexpr size_t SUBMIT_QUEUE_SIZE = 256;
+
+    // A frame this far behind the next one means the renderer numbers its frames from the start again
+    constexpr int64_t RESTART_DISTANCE = 1024;
+
+    uint64_t NowUs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void AtomicMax(std::atomic<uint64_t>& value, uint64_t candidate)
+    {
+        uint64_t current = value.load(std::memory_order_relaxed);
+        while (current < candidate && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Queues between the stages hold every reserved frame, a full one only means the consumer is about to catch up
+    template<typename T>
+    void Push(StreamQueue<T>& queue, T&& value, StreamDoorbell& bell)
+    {
+        while (!queue.TryPush(std::move(value)))
+            std::this_thread::yield();
+        bell.Ring();
+    }
+
+    // Pop the next value, sleeping while the queue is empty. False once the producer is done and the queue drained.
+    template<typename T>
+    bool Pop(StreamQueue<T>& queue, T& value, StreamDoorbell& bell, const std::atomic<bool>& producerDone)
+    {
+        for (;;)
+        {
+            if (queue.TryPop(value))
+                return true;
+
+            // The producer is done after its last push, anything still in the queue shows up now
+            if (producerDone.load())
+                return queue.TryPop(value);
+            bell.Wait(IDLE_WAIT_US);
+        }
+    }
+}  // namespace
+
+bool StreamPipeline::Start(std::unique_ptr<StreamEncoder> pEncoder, const StreamEncoderParams& encoderParams, const StreamPipelineParams& params)
+{
+    Stop(0);
+    m_Params             = params;
+    m_Params.maxInFlight = std::max(params.maxInFlight, 1u);
+    m_EncoderParams      = encoderParams;
+    m_pEncoder           = std::move(pEncoder);
+
+    if (!m_pEncoder->Open(m_EncoderParams))
+    {
+        SetError(m_pEncoder->GetError());
+        return false;
+    }
+
+    m_pConverter   = std::make_unique<StreamColorConverter>(encoderParams.convertWorkers);
+    m_pSubmitted   = std::make_unique<StreamQueue<StreamPipelineFrame>>(SUBMIT_QUEUE_SIZE);
+    m_pMapped      = std::make_unique<StreamQueue<StreamPipelineFrame>>(m_Params.maxInFlight);
+    m_pConverted   = std::make_unique<StreamQueue<StreamPipelineFrame>>(m_Params.maxInFlight);
+    m_pFreeBuffers = std::make_unique<StreamQueue<uint32_t>>(m_Params.maxInFlight);
+
+    size_t frameSize = StreamGetFrameSize(StreamPixelFormat::I420, params.width, params.height);
+    m_Buffers.assign(m_Params.maxInFlight, std::vector<uint8_t>(frameSize));
+    for (uint32_t i = 0; i < m_Params.maxInFlight; i++)
+    {
+        uint32_t buffer = i;
+        m_pFreeBuffers->TryPush(std::move(buffer));
+    }
+
+    m_InFlight     = 0;
+    m_Stopping     = false;
+    m_ReadbackDone = false;
+    m_ConvertDone  = false;
+    m_Failed       = false;
+    SetError("");
+    m_Running = true;
+
+    m_ReadbackThread = std::thread(&StreamPipeline::RunReadback, this);
+    m_ConvertThread  = std::thread(&StreamPipeline::RunConvert, this);
+    m_EncodeThread   = std::thread(&StreamPipeline::RunEncode, this);
+    return true;
+}
+
+void StreamPipeline::Stop(uint64_t timeoutUs)
+{
+    if (!m_Running)
+        return;
+
+    // The stages drain in turn, each one stopping once the one before it is done
+    m_Stopping = true;
+    m_SubmittedBell.Ring();
+    m_ReadbackThread.join();
+    m_ConvertThread.join();
+    m_EncodeThread.join();
+
+    m_pEncoder->Close(timeoutUs);
+    m_pConverter.reset();
+    m_Running = false;
+
+    // Nothing waits for room any more
+    m_ReserveCV.notify_all();
+}
+
+bool StreamPipeline::Reserve(uint64_t timeoutUs)
+{
+    if (!IsStreaming())
+        return false;
+
+    uint64_t startUs = NowUs();
+    bool     room    = false;
+    {
+        std::unique_lock<std::mutex> lock(m_ReserveMutex);
+        room = m_ReserveCV.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] { return m_InFlight < m_Params.maxInFlight || !IsStreaming(); });
+        room = room && IsStreaming();
+        if (room)
+            m_InFlight++;
+    }
+
+    m_Counters.reserveWaitUs += NowUs() - startUs;
+    m_Counters.reserveTimeouts += room ? 0 : 1;
+    return room;
+}
+
+void StreamPipeline::Submit(int64_t index, uint32_t slot, bool encode, int64_t tag)
+{
+    if (!m_Running)
+        return;
+
+    StreamPipelineFrame frame;
+    frame.index    = index;
+    frame.slot     = slot;
+    frame.encode   = encode;
+    frame.tag      = tag;
+    frame.submitUs = NowUs();
+    m_Counters.submitted++;
+    Push(*m_pSubmitted, std::move(frame), m_SubmittedBell);
+}
+
+void StreamPipeline::Skip(int64_t index)
+{
+    if (!m_Running)
+        return;
+
+    // A skipped frame holds nothing, if there is no room the reorder buffer gives up on it in time
+    StreamPipelineFrame frame;
+    frame.index  = index;
+    frame.copied = false;
+    m_Counters.skipped++;
+    if (m_pSubmitted->TryPush(std::move(frame)))
+        m_SubmittedBell.Ring();
+}
+
+std::string StreamPipeline::GetError()
+{
+    std::lock_guard<std::mutex> lock(m_ErrorMutex);
+    return m_Error;
+}
+
+StreamPipelineStats StreamPipeline::GetStats() const
+{
+    StreamPipelineStats stats;
+    stats.submitted       = m_Counters.submitted;
+    stats.encoded         = m_Counters.encoded;
+    stats.dropped         = m_Counters.dropped;
+    stats.released        = m_Counters.released;
+    stats.skipped         = m_Counters.skipped;
+    stats.late            = m_Counters.late;
+    stats.gaps            = m_Counters.gaps;
+    stats.reserveTimeouts = m_Counters.reserveTimeouts;
+    stats.restarts        = m_Counters.restarts;
+    stats.reserveWaitUs   = m_Counters.reserveWaitUs;
+    stats.readbackUs      = m_Counters.readbackUs;
+    stats.convertUs       = m_Counters.convertUs;
+    stats.encodeUs        = m_Counters.encodeUs;
+    stats.latencyUs       = m_Counters.latencyUs;
+    stats.latencyMaxUs    = m_Counters.latencyMaxUs;
+    stats.reorderMax      = m_Counters.reorderMax;
+    return stats;
+}
+
+void StreamPipeline::RunReadback()
+{
+    // The one place the frames are put back in order. The renderer's threads hand them over as the GPU finishes them.
+    std::map<int64_t, StreamPipelineFrame> pending;
+    int64_t                                next    = 0;
+    bool                                   started = false;
+
+    for (;;)
+    {
+        bool                stopping = m_Stopping.load();
+        StreamPipelineFrame frame;
+        while (m_pSubmitted->TryPop(frame))
+        {
+            if (!started)
+            {
+                next    = frame.index;
+                started = true;
+            }
+
+            if (frame.index < next)
+            {
+                // Numbering which starts over, rather than a frame which is late: the frames before go on first
+                if (next - frame.index > RESTART_DISTANCE)
+                {
+                    for (auto& entry : pending)
+                        Forward(entry.second);
+                    pending.clear();
+                    next = frame.index;
+                }
+                else
+                {
+                    m_Counters.late += frame.copied ? 1 : 0;
+                    frame.encode = false;
+                    Forward(frame);
+                    continue;
+                }
+            }
+
+            // The same index twice, the older one goes back unencoded
+            auto existing = pending.find(frame.index);
+            if (existing != pending.end())
+            {
+                existing->second.encode = false;
+                Forward(existing->second);
+                pending.erase(existing);
+            }
+            pending.emplace(frame.index, std::move(frame));
+            AtomicMax(m_Counters.reorderMax, pending.size());
+        }
+
+        // Pass on what is in order. A missing frame is given up on once the window fills up behind it, or on stop.
+        while (!pending.empty())
+        {
+            auto first = pending.begin();
+            if (first->first != next)
+            {
+                if (pending.size() <= m_Params.reorderWindow && !stopping)
+                    break;
+                m_Counters.gaps += static_cast<uint64_t>(first->first - next);
+            }
+
+            next = first->first + 1;
+            Forward(first->second);
+            pending.erase(first);
+        }
+
+        if (stopping)
+            break;
+        m_SubmittedBell.Wait(IDLE_WAIT_US);
+    }
+
+    m_ReadbackDone = true;
+    m_MappedBell.Ring();
+}
+
+void StreamPipeline::Forward(StreamPipelineFrame& frame)
+{
+    if (!frame.copied)
+        return;
+
+    // Waits for the GPU, in frame order
+    uint64_t startUs = NowUs();
+    bool     mapped  = m_Params.readback(frame);
+    m_Counters.readbackUs += NowUs() - startUs;
+    if (!mapped)
+    {
+        m_Counters.dropped++;
+        Finish();
+        return;
+    }
+
+    if (!frame.encode || m_Failed)
+    {
+        frame.release();
+        m_Counters.released += frame.encode ? 0 : 1;
+        m_Counters.dropped += frame.encode ? 1 : 0;
+        Finish();
+        return;
+    }
+
+    Push(*m_pMapped, std::move(frame), m_MappedBell);
+}
+
+void StreamPipeline::RunConvert()
+{
+    StreamPipelineFrame frame;
+    while (Pop(*m_pMapped, frame, m_MappedBell, m_ReadbackDone))
+    {
+        // There is a buffer per frame in flight, the encode thread is about to hand one back if none is free
+        uint32_t buffer = 0;
+        while (!m_pFreeBuffers->TryPop(buffer))
+            m_FreeBufferBell.Wait(IDLE_WAIT_US);
+
+        // The readback goes back to the renderer as soon as it is converted, rather than once it is encoded
+        uint64_t        startUs = NowUs();
+        StreamYuvPlanes planes  = StreamGetPackedPlanes(StreamPixelFormat::I420, m_Params.width, m_Params.height, m_Buffers[buffer].data());
+        m_pConverter->Convert(frame.pRgba, frame.rowPitch, m_Params.width, m_Params.height, StreamPixelFormat::I420, planes);
+        frame.release();
+        frame.release = nullptr;
+        frame.pRgba   = nullptr;
+        frame.buffer  = buffer;
+        m_Counters.convertUs += NowUs() - startUs;
+
+        Push(*m_pConverted, std::move(frame), m_ConvertedBell);
+    }
+
+    m_ConvertDone = true;
+    m_ConvertedBell.Ring();
+}
+
+void StreamPipeline::RunEncode()
+{
+    StreamPipelineFrame frame;
+    while (Pop(*m_pConverted, frame, m_ConvertedBell, m_ConvertDone))
+    {
+        bool encoded = !m_Failed && Encode(frame);
+        if (!encoded)
+            m_Counters.dropped++;
+
+        uint32_t buffer = frame.buffer;
+        m_pFreeBuffers->TryPush(std::move(buffer));
+        m_FreeBufferBell.Ring();
+        Finish();
+    }
+}
+
+bool StreamPipeline::Encode(const StreamPipelineFrame& frame)
+{
+    for (uint32_t tries = 0;; tries++)
+    {
+        uint64_t          startUs = NowUs();
+        StreamWriteStatus status  = m_pEncoder->EncodeI420(m_Buffers[frame.buffer].data());
+        uint64_t          nowUs   = NowUs();
+        m_Counters.encodeUs += nowUs - startUs;
+
+        if (status != StreamWriteStatus::Closed)
+        {
+            if (status == StreamWriteStatus::Written)
+            {
+                m_Counters.encoded++;
+                m_Counters.latencyUs += nowUs - frame.submitUs;
+                AtomicMax(m_Counters.latencyMaxUs, nowUs - frame.submitUs);
+            }
+            else  // The encoder is behind, the frame is dropped rather than holding up the ones behind it
+                m_Counters.dropped++;
+
+            if (m_Params.encoded)
+                m_Params.encoded(frame, status);
+            return true;
+        }
+
+        // The encoder or its publisher is gone, start them again
+        SetError(m_pEncoder->GetError());
+        m_pEncoder->Close(0);
+        if (tries >= m_Params.encoderRestarts || !m_pEncoder->Open(m_EncoderParams))
+        {
+            if (tries < m_Params.encoderRestarts)
+                SetError(m_pEncoder->GetError());
+            break;
+        }
+        m_Counters.restarts++;
+    }
+
+    // Streaming stops, the frames still coming are handed back unencoded
+    m_Failed = true;
+    {
+        std::lock_guard<std::mutex> lock(m_ReserveMutex);
+    }
+    m_ReserveCV.notify_all();
+    return false;
+}
+
+void StreamPipeline::Finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ReserveMutex);
+        m_InFlight--;
+    }
+    m_ReserveCV.notify_one();
+}
+
+void StreamPipeline::SetError(const std::string& error)
+{
+    std::lock_guard<std::mutex> lock(m_ErrorMutex);
+    m_Error = error;
+}
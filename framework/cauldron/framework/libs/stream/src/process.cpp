@@ -0,0 +1,541 @@
+#include "process.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include <atomic>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace
+{
+    constexpr uint64_t REAP_POLL_US = 1000;
+
+    uint64_t NowUs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint64_t GetDeadlineUs(uint64_t timeoutUs)
+    {
+        uint64_t nowUs = NowUs();
+        return timeoutUs > UINT64_MAX - nowUs ? UINT64_MAX : nowUs + timeoutUs;
+    }
+}  // namespace
+
+void StreamProcessChain::Stop(uint64_t timeoutUs)
+{
+    ClosePipe();
+
+    // Without its input the chain winds down by itself, unless it is stuck
+    uint64_t deadlineUs = GetDeadlineUs(timeoutUs);
+    for (Process& process : m_Processes)
+    {
+        uint64_t nowUs = NowUs();
+        if (!Reap(process, deadlineUs > nowUs ? deadlineUs - nowUs : 0))
+            Kill(process);
+    }
+}
+
+bool StreamProcessChain::IsRunning()
+{
+    bool running = !m_Processes.empty();
+    for (Process& process : m_Processes)
+        running &= !Reap(process, 0);
+    return running;
+}
+
+#if defined(_WIN32)
+
+namespace
+{
+    // Quote an argument the way the C runtime of the child splits its command line
+    std::string QuoteArgument(const std::string& argument)
+    {
+        if (!argument.empty() && argument.find_first_of(" \t\n\v\"") == std::string::npos)
+            return argument;
+
+        std::string quoted      = "\"";
+        size_t      backslashes = 0;
+        for (char c : argument)
+        {
+            if (c == '\\')
+            {
+                backslashes++;
+                continue;
+            }
+
+            // Backslashes only escape when a quote follows
+            quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+            quoted.push_back(c);
+            backslashes = 0;
+        }
+        quoted.append(backslashes * 2, '\\');
+        quoted.push_back('"');
+        return quoted;
+    }
+
+    HANDLE DuplicateInheritable(HANDLE handle)
+    {
+        HANDLE duplicate = nullptr;
+        if (handle && handle != INVALID_HANDLE_VALUE)
+            DuplicateHandle(GetCurrentProcess(), handle, GetCurrentProcess(), &duplicate, 0, TRUE, DUPLICATE_SAME_ACCESS);
+        return duplicate;
+    }
+
+    void CloseValidHandle(HANDLE& handle)
+    {
+        if (handle && handle != INVALID_HANDLE_VALUE)
+            CloseHandle(handle);
+        handle = nullptr;
+    }
+
+    // Spawn a process with the given standard handles and no other handle inherited, so no child holds on to the
+    // pipes of the others and every one of them sees the end of its input
+    HANDLE Spawn(const StreamCommand& command, HANDLE input, HANDLE output, HANDLE error)
+    {
+        std::string commandLine = QuoteArgument(command.program);
+        for (const std::string& argument : command.args)
+            commandLine += " " + QuoteArgument(argument);
+
+        HANDLE handles[3]  = {input, output, error};
+        DWORD  handleCount = 0;
+        for (HANDLE handle : handles)
+        {
+            if (handle && std::find(handles, handles + handleCount, handle) == handles + handleCount)
+                handles[handleCount++] = handle;
+        }
+
+        SIZE_T attributeSize = 0;
+        InitializeProcThreadAttributeList(nullptr, 1, 0, &attributeSize);
+        std::vector<uint8_t>         attributeBuffer(attributeSize);
+        LPPROC_THREAD_ATTRIBUTE_LIST pAttributes = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeBuffer.data());
+        if (!InitializeProcThreadAttributeList(pAttributes, 1, 0, &attributeSize))
+            return nullptr;
+
+        HANDLE process = nullptr;
+        if (UpdateProcThreadAttribute(pAttributes, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, handles, handleCount * sizeof(HANDLE), nullptr, nullptr))
+        {
+            STARTUPINFOEXA info         = {};
+            info.StartupInfo.cb         = sizeof(info);
+            info.StartupInfo.dwFlags    = STARTF_USESTDHANDLES;
+            info.StartupInfo.hStdInput  = input;
+            info.StartupInfo.hStdOutput = output;
+            info.StartupInfo.hStdError  = error;
+            info.lpAttributeList        = pAttributes;
+
+            PROCESS_INFORMATION processInfo = {};
+            if (CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, EXTENDED_STARTUPINFO_PRESENT, nullptr, nullptr, &info.StartupInfo, &processInfo))
+            {
+                CloseHandle(processInfo.hThread);
+                process = processInfo.hProcess;
+            }
+        }
+
+        DeleteProcThreadAttributeList(pAttributes);
+        return process;
+    }
+}  // namespace
+
+bool StreamProcessChain::Start(const std::vector<StreamCommand>& commands, const std::string& outputPath)
+{
+    Stop(0);
+    m_Processes.clear();
+    m_Error.clear();
+    if (commands.empty())
+    {
+        m_Error = "nothing to spawn";
+        return false;
+    }
+
+    SECURITY_ATTRIBUTES inheritable = {sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+
+    // Our end is overlapped so writes can time out, the first process reads its end like any other pipe
+    static std::atomic<uint32_t> s_PipeCount{0};
+    std::string pipeName = "\\\\.\\pipe\\StreamProcessChain_" + std::to_string(GetCurrentProcessId()) + "_" + std::to_string(s_PipeCount++);
+    m_Pipe = CreateNamedPipeA(pipeName.c_str(), PIPE_ACCESS_OUTBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE, PIPE_TYPE_BYTE | PIPE_WAIT, 1, 1 << 20, 0, 0, nullptr);
+    m_Event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    HANDLE input = m_Pipe != INVALID_HANDLE_VALUE ? CreateFileA(pipeName.c_str(), GENERIC_READ, 0, &inheritable, OPEN_EXISTING, 0, nullptr) : INVALID_HANDLE_VALUE;
+
+    HANDLE output = nullptr;
+    if (!outputPath.empty())
+        output = CreateFileA(outputPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &inheritable, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    else
+        output = DuplicateInheritable(GetStdHandle(STD_OUTPUT_HANDLE));
+    HANDLE error = DuplicateInheritable(GetStdHandle(STD_ERROR_HANDLE));
+
+    if (!m_Event || input == INVALID_HANDLE_VALUE || output == INVALID_HANDLE_VALUE)
+    {
+        m_Error = outputPath.empty() || output != INVALID_HANDLE_VALUE ? "can't create the pipe" : "can't create " + outputPath;
+        CloseValidHandle(input);
+        CloseValidHandle(output);
+        CloseValidHandle(error);
+        ClosePipe();
+        return false;
+    }
+
+    for (size_t i = 0; i < commands.size() && m_Error.empty(); i++)
+    {
+        // Every process but the last writes into a pipe to the next one
+        HANDLE next   = nullptr;
+        HANDLE target = output;
+        if (i + 1 < commands.size() && !CreatePipe(&next, &target, &inheritable, 0))
+        {
+            m_Error = "can't create the pipe to " + commands[i + 1].program;
+            break;
+        }
+
+        HANDLE process = Spawn(commands[i], input, target, error);
+        if (process)
+            m_Processes.push_back({process});
+        else
+            m_Error = "can't spawn " + commands[i].program + " (error " + std::to_string(GetLastError()) + ")";
+
+        // The children hold their ends now
+        CloseValidHandle(input);
+        if (target != output)
+            CloseValidHandle(target);
+        input = next;
+    }
+    CloseValidHandle(input);
+    CloseValidHandle(output);
+    CloseValidHandle(error);
+
+    if (!m_Error.empty())
+    {
+        Stop(0);
+        return false;
+    }
+    return true;
+}
+
+StreamWriteStatus StreamProcessChain::Write(const void* pData, size_t size, uint64_t timeoutUs)
+{
+    if (m_Pipe == INVALID_HANDLE_VALUE)
+        return StreamWriteStatus::Closed;
+
+    const uint8_t* pBytes     = static_cast<const uint8_t*>(pData);
+    size_t         written    = 0;
+    uint64_t       deadlineUs = GetDeadlineUs(timeoutUs);
+    while (written < size)
+    {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent     = m_Event;
+        ResetEvent(m_Event);
+
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - written, MAXDWORD));
+        if (!WriteFile(m_Pipe, pBytes + written, chunk, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+        {
+            m_Error = "the chain stopped reading";
+            ClosePipe();
+            return StreamWriteStatus::Closed;
+        }
+
+        // Before the first byte the deadline applies, after it the stall timeout
+        uint64_t nowUs    = NowUs();
+        uint64_t waitUs   = written ? m_StallTimeoutUs : (deadlineUs > nowUs ? deadlineUs - nowUs : 0);
+        DWORD    waitMs   = static_cast<DWORD>(std::min<uint64_t>(waitUs / 1000, INFINITE - 1));
+        bool     timedOut = WaitForSingleObject(m_Event, waitMs) == WAIT_TIMEOUT;
+        if (timedOut)
+            CancelIoEx(m_Pipe, &overlapped);
+
+        // A cancelled write may still have put part of the data into the pipe
+        DWORD transferred = 0;
+        if (!GetOverlappedResult(m_Pipe, &overlapped, &transferred, TRUE) && GetLastError() != ERROR_OPERATION_ABORTED)
+        {
+            m_Error = "the chain stopped reading";
+            ClosePipe();
+            return StreamWriteStatus::Closed;
+        }
+
+        bool started = written > 0;
+        written += transferred;
+        if (timedOut && !written)
+            return StreamWriteStatus::Timeout;
+        if (timedOut && started && !transferred)
+        {
+            m_Error = "the chain stalled in the middle of a write";
+            ClosePipe();
+            return StreamWriteStatus::Closed;
+        }
+    }
+    return StreamWriteStatus::Written;
+}
+
+bool StreamProcessChain::IsOpen() const
+{
+    return m_Pipe != INVALID_HANDLE_VALUE;
+}
+
+bool StreamProcessChain::Reap(Process& process, uint64_t timeoutUs)
+{
+    if (process.exited)
+        return true;
+
+    DWORD waitMs = timeoutUs == UINT64_MAX ? INFINITE : static_cast<DWORD>(std::min<uint64_t>(timeoutUs / 1000 + (timeoutUs % 1000 ? 1 : 0), INFINITE - 1));
+    if (WaitForSingleObject(process.handle, waitMs) != WAIT_OBJECT_0)
+        return false;
+
+    DWORD exitCode = 0;
+    GetExitCodeProcess(process.handle, &exitCode);
+    CloseHandle(process.handle);
+    process.handle   = nullptr;
+    process.exited   = true;
+    process.exitCode = static_cast<int>(exitCode);
+    return true;
+}
+
+void StreamProcessChain::Kill(Process& process)
+{
+    TerminateProcess(process.handle, 1);
+    Reap(process, UINT64_MAX);
+}
+
+void StreamProcessChain::ClosePipe()
+{
+    if (m_Pipe != INVALID_HANDLE_VALUE)
+        CloseHandle(m_Pipe);
+    if (m_Event)
+        CloseHandle(m_Event);
+    m_Pipe  = INVALID_HANDLE_VALUE;
+    m_Event = nullptr;
+}
+
+#else
+
+bool StreamProcessChain::Start(const std::vector<StreamCommand>& commands, const std::string& outputPath)
+{
+    Stop(0);
+    m_Processes.clear();
+    m_Error.clear();
+    if (commands.empty())
+    {
+        m_Error = "nothing to spawn";
+        return false;
+    }
+
+    int output = -1;
+    if (!outputPath.empty())
+    {
+        output = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (output < 0)
+        {
+            m_Error = "can't create " + outputPath + ": " + strerror(errno);
+            return false;
+        }
+    }
+
+    // Every pipe is close-on-exec, the children only keep the ends duplicated onto their standard input and output.
+    // Otherwise a process holding on to the write end of its own input would never see the end of the stream.
+    int ends[2];
+    if (pipe2(ends, O_CLOEXEC))
+    {
+        m_Error = std::string("can't create the pipe: ") + strerror(errno);
+        if (output >= 0)
+            close(output);
+        return false;
+    }
+    m_Pipe    = ends[1];
+    int input = ends[0];
+
+    // The children get the default signal handling back, SIGPIPE ends them when the next process goes away as it
+    // would in a shell, and none of the signals blocked on this thread
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t defaults, mask;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigemptyset(&mask);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    posix_spawnattr_setsigmask(&attributes, &mask);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+    for (size_t i = 0; i < commands.size() && m_Error.empty(); i++)
+    {
+        // Every process but the last writes into a pipe to the next one
+        int  next   = -1;
+        int  target = output;
+        bool last   = i + 1 == commands.size();
+        if (!last)
+        {
+            if (pipe2(ends, O_CLOEXEC))
+            {
+                m_Error = std::string("can't create the pipe to ") + commands[i + 1].program + ": " + strerror(errno);
+                break;
+            }
+            next   = ends[0];
+            target = ends[1];
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, input, STDIN_FILENO);
+        if (target >= 0)
+            posix_spawn_file_actions_adddup2(&actions, target, STDOUT_FILENO);
+
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(commands[i].program.c_str()));
+        for (const std::string& argument : commands[i].args)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        argv.push_back(nullptr);
+
+        pid_t pid    = -1;
+        int   result = posix_spawnp(&pid, commands[i].program.c_str(), &actions, &attributes, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (result)
+            m_Error = "can't spawn " + commands[i].program + ": " + strerror(result);
+        else
+            m_Processes.push_back({pid});
+
+        // The children hold their ends now
+        close(input);
+        if (!last)
+            close(target);
+        input = next;
+    }
+    posix_spawnattr_destroy(&attributes);
+
+    if (input >= 0)
+        close(input);
+    if (output >= 0)
+        close(output);
+
+    if (!m_Error.empty())
+    {
+        Stop(0);
+        return false;
+    }
+
+    fcntl(m_Pipe, F_SETFL, fcntl(m_Pipe, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+StreamWriteStatus StreamProcessChain::Write(const void* pData, size_t size, uint64_t timeoutUs)
+{
+    if (m_Pipe < 0)
+        return StreamWriteStatus::Closed;
+
+    // Writing into a pipe nobody reads raises SIGPIPE, which would end us. Hold it back on this thread while writing
+    // and take it out of the pending signals again, unless it was pending already.
+    sigset_t sigpipe, previous, pending;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &previous);
+    sigpending(&pending);
+    bool wasPending = sigismember(&pending, SIGPIPE);
+
+    const uint8_t*    pBytes     = static_cast<const uint8_t*>(pData);
+    size_t            written    = 0;
+    uint64_t          deadlineUs = GetDeadlineUs(timeoutUs);
+    StreamWriteStatus status     = StreamWriteStatus::Written;
+    bool              stalled    = false;
+    while (written < size)
+    {
+        ssize_t result = write(m_Pipe, pBytes + written, size - written);
+        if (result > 0)
+        {
+            written += static_cast<size_t>(result);
+            deadlineUs = GetDeadlineUs(m_StallTimeoutUs);
+            continue;
+        }
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0 && errno != EAGAIN)
+        {
+            status = StreamWriteStatus::Closed;
+            break;
+        }
+
+        // The pipe is full. Before the first byte the deadline applies, after it the stall timeout since the last
+        // progress, giving up then leaves a torn write behind and the chain has to go.
+        uint64_t nowUs = NowUs();
+        if (nowUs >= deadlineUs)
+        {
+            status  = written ? StreamWriteStatus::Closed : StreamWriteStatus::Timeout;
+            stalled = written > 0;
+            break;
+        }
+        int waitMs = static_cast<int>(std::min<uint64_t>((deadlineUs - nowUs + 999) / 1000, INT32_MAX));
+
+        // A closed read end wakes the poll up as well, the next write tells
+        pollfd fd = {m_Pipe, POLLOUT, 0};
+        poll(&fd, 1, waitMs);
+    }
+
+    if (status == StreamWriteStatus::Closed && !wasPending)
+    {
+        timespec noWait = {};
+        sigtimedwait(&sigpipe, nullptr, &noWait);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    if (status == StreamWriteStatus::Closed)
+    {
+        m_Error = stalled ? "the chain stalled in the middle of a write" : "the chain stopped reading";
+        ClosePipe();
+    }
+    return status;
+}
+
+bool StreamProcessChain::IsOpen() const
+{
+    return m_Pipe >= 0;
+}
+
+bool StreamProcessChain::Reap(Process& process, uint64_t timeoutUs)
+{
+    if (process.exited)
+        return true;
+
+    uint64_t deadlineUs = GetDeadlineUs(timeoutUs);
+    for (;;)
+    {
+        int   status = 0;
+        pid_t result = waitpid(process.pid, &status, timeoutUs == UINT64_MAX ? 0 : WNOHANG);
+        if (result == process.pid)
+        {
+            process.exited   = true;
+            process.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+            return true;
+        }
+
+        // Somebody else reaped it, there is nothing left to wait for
+        if (result < 0 && errno != EINTR)
+        {
+            process.exited = true;
+            return true;
+        }
+
+        if (result == 0 && NowUs() >= deadlineUs)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(REAP_POLL_US));
+    }
+}
+
+void StreamProcessChain::Kill(Process& process)
+{
+    kill(process.pid, SIGKILL);
+    Reap(process, UINT64_MAX);
+}
+
+void StreamProcessChain::ClosePipe()
+{
+    if (m_Pipe >= 0)
+        close(m_Pipe);
+    m_Pipe = -1;
+}
+
+#endif
@@ -0,0 +1,283 @@
+// stream-convert-bench: checks the RGBA to YUV converter against a floating point BT.709 reference, every instruction
+// set against the scalar path and the threaded converter against a single band, then measures its throughput
+
+#include "stream.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: stream-convert-bench [options]\n"
+                "  --size <w>x<h>        frame size of the benchmark (1920x1080)\n"
+                "  --frames <n>          frames converted per run, 0 only checks (200)\n"
+                "  --workers <n>         workers of the threaded runs, besides the calling thread (default of the converter)\n");
+        return 2;
+    }
+
+    struct Frame
+    {
+        uint32_t             width    = 0;
+        uint32_t             height   = 0;
+        size_t               rowPitch = 0;
+        std::vector<uint8_t> texels;
+    };
+
+    enum class Pattern
+    {
+        Random,
+        Black,
+        White,
+        Primaries,  // Pure red, green, blue and their mixes, in stripes
+    };
+
+    Frame MakeFrame(uint32_t width, uint32_t height, size_t pad, Pattern pattern, std::mt19937& random)
+    {
+        static const uint8_t primaries[8][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, {0, 255, 255}, {255, 0, 255}, {255, 255, 255}, {0, 0, 0}};
+
+        Frame frame;
+        frame.width    = width;
+        frame.height   = height;
+        frame.rowPitch = static_cast<size_t>(width) * 4 + pad;
+        frame.texels.resize(frame.rowPitch * height);
+        for (size_t i = 0; i < frame.texels.size(); i++)
+        {
+            size_t x = (i % frame.rowPitch) / 4;
+            size_t c = i % 4;
+            switch (pattern)
+            {
+            case Pattern::Random:
+                frame.texels[i] = static_cast<uint8_t>(random());
+                break;
+            case Pattern::Black:
+                frame.texels[i] = c == 3 ? 255 : 0;
+                break;
+            case Pattern::White:
+                frame.texels[i] = 255;
+                break;
+            case Pattern::Primaries:
+                frame.texels[i] = c == 3 ? 255 : primaries[(x / 3) % 8][c];
+                break;
+            }
+        }
+        return frame;
+    }
+
+    // BT.709 limited range in double precision, chroma of the average of each 2x2 block
+    std::vector<uint8_t> Reference(const Frame& frame, StreamPixelFormat format)
+    {
+        const double kr = 0.2126;
+        const double kb = 0.0722;
+        const double kg = 1.0 - kr - kb;
+
+        std::vector<uint8_t> yuv(StreamGetFrameSize(format, frame.width, frame.height));
+        StreamYuvPlanes      planes = StreamGetPackedPlanes(format, frame.width, frame.height, yuv.data());
+
+        auto texel = [&](uint32_t x, uint32_t y, int c) { return static_cast<double>(frame.texels[y * frame.rowPitch + x * 4 + c]); };
+        auto luma  = [&](uint32_t x, uint32_t y) { return kr * texel(x, y, 0) + kg * texel(x, y, 1) + kb * texel(x, y, 2); };
+
+        for (uint32_t y = 0; y < frame.height; y++)
+        {
+            for (uint32_t x = 0; x < frame.width; x++)
+                planes.pPlanes[0][y * planes.pitches[0] + x] = static_cast<uint8_t>(std::lround(16.0 + luma(x, y) * 219.0 / 255.0));
+        }
+
+        for (uint32_t y = 0; y < frame.height; y += 2)
+        {
+            for (uint32_t x = 0; x < frame.width; x += 2)
+            {
+                uint32_t x1 = std::min(x + 1, frame.width - 1);
+                uint32_t y1 = std::min(y + 1, frame.height - 1);
+                double   r  = (texel(x, y, 0) + texel(x1, y, 0) + texel(x, y1, 0) + texel(x1, y1, 0)) / 4.0;
+                double   g  = (texel(x, y, 1) + texel(x1, y, 1) + texel(x, y1, 1) + texel(x1, y1, 1)) / 4.0;
+                double   b  = (texel(x, y, 2) + texel(x1, y, 2) + texel(x, y1, 2) + texel(x1, y1, 2)) / 4.0;
+                double   l  = kr * r + kg * g + kb * b;
+                uint8_t  u  = static_cast<uint8_t>(std::lround(128.0 + (b - l) / (2.0 * (1.0 - kb)) * 224.0 / 255.0));
+                uint8_t  v  = static_cast<uint8_t>(std::lround(128.0 + (r - l) / (2.0 * (1.0 - kr)) * 224.0 / 255.0));
+                if (format == StreamPixelFormat::NV12)
+                {
+                    planes.pPlanes[1][(y / 2) * planes.pitches[1] + x]     = u;
+                    planes.pPlanes[1][(y / 2) * planes.pitches[1] + x + 1] = v;
+                }
+                else
+                {
+                    planes.pPlanes[1][(y / 2) * planes.pitches[1] + x / 2] = u;
+                    planes.pPlanes[2][(y / 2) * planes.pitches[2] + x / 2] = v;
+                }
+            }
+        }
+        return yuv;
+    }
+
+    // Largest difference of two frames, where it is
+    int Compare(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, size_t& where)
+    {
+        int largest = 0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            int difference = std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i]));
+            if (difference > largest)
+            {
+                largest = difference;
+                where   = i;
+            }
+        }
+        return largest;
+    }
+
+    std::vector<uint8_t> Convert(StreamSimd simd, const Frame& frame, StreamPixelFormat format)
+    {
+        std::vector<uint8_t> yuv(StreamGetFrameSize(format, frame.width, frame.height));
+        StreamYuvPlanes      planes = StreamGetPackedPlanes(format, frame.width, frame.height, yuv.data());
+        StreamConvertRows(simd, frame.texels.data(), frame.rowPitch, frame.width, frame.height, 0, frame.height, format, planes);
+        return yuv;
+    }
+
+    // Returns the number of failed checks
+    int Check(const std::vector<StreamSimd>& simds, uint32_t workers)
+    {
+        // Odd sizes and sizes around the vector widths exercise the tails, padded rows a readback's row pitch
+        const uint32_t sizes[][2] = {{1, 1}, {2, 2}, {3, 5}, {15, 3}, {16, 2}, {17, 7}, {31, 4}, {32, 2}, {33, 9}, {47, 11}, {64, 64}, {129, 33}, {640, 360}};
+        const Pattern  patterns[] = {Pattern::Random, Pattern::Black, Pattern::White, Pattern::Primaries};
+
+        std::mt19937         random(1234);
+        StreamColorConverter converter(workers);
+        int                  failures = 0;
+        int                  checks   = 0;
+
+        for (const auto& size : sizes)
+        {
+            for (size_t pad : {0, 20})
+            {
+                for (Pattern pattern : patterns)
+                {
+                    Frame frame = MakeFrame(size[0], size[1], pad, pattern, random);
+                    for (StreamPixelFormat format : {StreamPixelFormat::I420, StreamPixelFormat::NV12})
+                    {
+                        std::vector<uint8_t> reference = Reference(frame, format);
+                        std::vector<uint8_t> scalar    = Convert(StreamSimd::Scalar, frame, format);
+
+                        // Fixed point rounding may land one off the reference, no more
+                        size_t where = 0;
+                        int    error = Compare(scalar, reference, where);
+                        checks++;
+                        if (error > 1)
+                        {
+                            fprintf(stderr, "FAIL scalar %ux%u %s: off the reference by %d at byte %zu\n", frame.width, frame.height, StreamGetPixelFormatName(format), error, where);
+                            failures++;
+                        }
+
+                        // The vector paths and the threaded converter have to match the scalar path exactly
+                        for (StreamSimd simd : simds)
+                        {
+                            std::vector<uint8_t> vector = Convert(simd, frame, format);
+                            checks++;
+                            if ((error = Compare(vector, scalar, where)) != 0)
+                            {
+                                fprintf(stderr, "FAIL %s %ux%u %s: off the scalar path by %d at byte %zu\n", StreamGetSimdName(simd), frame.width, frame.height, StreamGetPixelFormatName(format), error, where);
+                                failures++;
+                            }
+
+                            std::vector<uint8_t> threaded(scalar.size());
+                            converter.SetSimd(simd);
+                            converter.Convert(frame.texels.data(), frame.rowPitch, frame.width, frame.height, format, StreamGetPackedPlanes(format, frame.width, frame.height, threaded.data()));
+                            checks++;
+                            if ((error = Compare(threaded, scalar, where)) != 0)
+                            {
+                                fprintf(stderr, "FAIL %s x%u %ux%u %s: off the scalar path by %d at byte %zu\n", StreamGetSimdName(simd), converter.GetThreadCount(), frame.width, frame.height, StreamGetPixelFormatName(format), error, where);
+                                failures++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        printf("%d of %d checks passed\n", checks - failures, checks);
+        return failures;
+    }
+
+    void Bench(const std::vector<StreamSimd>& simds, uint32_t width, uint32_t height, uint64_t frames, uint32_t workers)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::mt19937         random(5678);
+        Frame                frame = MakeFrame(width, height, 0, Pattern::Random, random);
+        std::vector<uint8_t> yuv(StreamGetFrameSize(StreamPixelFormat::I420, width, height));
+
+        for (uint32_t workerCount : {0u, workers})
+        {
+            StreamColorConverter converter(workerCount);
+            for (StreamPixelFormat format : {StreamPixelFormat::I420, StreamPixelFormat::NV12})
+            {
+                StreamYuvPlanes planes = StreamGetPackedPlanes(format, width, height, yuv.data());
+                for (StreamSimd simd : simds)
+                {
+                    converter.SetSimd(simd);
+                    converter.Convert(frame.texels.data(), frame.rowPitch, width, height, format, planes);
+
+                    auto startTime = Clock::now();
+                    for (uint64_t i = 0; i < frames; i++)
+                        converter.Convert(frame.texels.data(), frame.rowPitch, width, height, format, planes);
+                    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+                    double pixels = static_cast<double>(width) * height * frames;
+                    printf("%-7s %-5s %2u threads  %8.1f Mpix/s  %7.3f ms per frame\n",
+                           StreamGetSimdName(simd),
+                           StreamGetPixelFormatName(format),
+                           converter.GetThreadCount(),
+                           pixels / seconds / 1000000.0,
+                           seconds * 1000.0 / frames);
+                }
+            }
+        }
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t width   = 1920;
+    uint32_t height  = 1080;
+    uint64_t frames  = 200;
+    uint32_t workers = UINT32_MAX;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--size")
+        {
+            if (sscanf(value, "%ux%u", &width, &height) != 2)
+                return Usage();
+        }
+        else if (arg == "--frames")
+            frames = strtoull(value, nullptr, 10);
+        else if (arg == "--workers")
+            workers = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else
+            return Usage();
+    }
+    if (!width || !height)
+        return Usage();
+
+    std::vector<StreamSimd> simds;
+    for (uint32_t simd = 0; simd <= static_cast<uint32_t>(StreamGetSupportedSimd()); simd++)
+        simds.push_back(static_cast<StreamSimd>(simd));
+
+    if (Check(simds, workers))
+        return 1;
+    if (frames)
+        Bench(simds, width, height, frames, workers);
+    return 0;
+}
@@ -0,0 +1,173 @@
+// stream-encode-bench: encodes synthetic frames through ffmpeg and measures what a frame costs the thread calling
+// Encode, and how long the whole stream takes until it is flushed
+
+#include "stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: stream-encode-bench [options] [-- <publisher> [args] ['|' <program> [args]]...]\n"
+                "  --size <w>x<h>        frame size (1280x720)\n"
+                "  --frames <n>          frames to encode (300)\n"
+                "  --pad <bytes>         padding at the end of each row, like a readback's row pitch (0)\n"
+                "  --preset <name>       x264 preset (ultrafast)\n"
+                "  --output <file>       where the stream goes, discarded if not given\n");
+        return 2;
+    }
+
+    // A gradient scrolling one texel per frame, so the encoder has motion to work with
+    void FillFrame(std::vector<uint8_t>& frame, uint32_t width, uint32_t height, size_t rowPitch, uint64_t index)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* pRow = frame.data() + y * rowPitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                pRow[x * 4 + 0] = static_cast<uint8_t>(x + index);
+                pRow[x * 4 + 1] = static_cast<uint8_t>(y + index);
+                pRow[x * 4 + 2] = static_cast<uint8_t>((x ^ y) + index);
+                pRow[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    double Percentile(std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+    }
+
+    // Returns false if the stream could not be encoded
+    bool Run(const StreamEncoderParams& params, uint64_t frames, size_t rowPitch)
+    {
+        std::unique_ptr<StreamEncoder> pEncoder = std::make_unique<StreamPipeEncoder>();
+        if (!pEncoder->Open(params))
+        {
+            fprintf(stderr, "stream-encode-bench: %s\n", pEncoder->GetError().c_str());
+            return false;
+        }
+
+        using Clock = std::chrono::steady_clock;
+        std::vector<uint8_t> frame(rowPitch * params.height);
+        std::vector<double>  latencyMs;
+        uint64_t             dropped   = 0;
+        bool                 closed    = false;
+        auto                 startTime = Clock::now();
+
+        for (uint64_t index = 0; index < frames && !closed; index++)
+        {
+            FillFrame(frame, params.width, params.height, rowPitch, index);
+
+            auto              frameTime = Clock::now();
+            StreamWriteStatus status    = pEncoder->Encode(frame.data(), rowPitch);
+            latencyMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameTime).count());
+            dropped += status == StreamWriteStatus::Timeout ? 1 : 0;
+            closed = status == StreamWriteStatus::Closed;
+        }
+
+        // Encode only hands the frames over, the stream is done once ffmpeg flushed
+        auto flushTime = Clock::now();
+        pEncoder->Close(10000000);
+        double flushSeconds = std::chrono::duration<double>(Clock::now() - flushTime).count();
+        double seconds      = std::chrono::duration<double>(Clock::now() - startTime).count();
+        if (closed)
+        {
+            fprintf(stderr, "stream-encode-bench: %s after %zu frames\n", pEncoder->GetError().c_str(), latencyMs.size() - 1);
+            return false;
+        }
+
+        std::sort(latencyMs.begin(), latencyMs.end());
+        uint64_t encoded = latencyMs.size() - dropped;
+        printf("%6llu frames %4llu dropped  encode ms p50 %6.2f p99 %6.2f max %6.2f  flush %6.2f s  %7.1f frames per second\n",
+               static_cast<unsigned long long>(encoded),
+               static_cast<unsigned long long>(dropped),
+               Percentile(latencyMs, 0.5),
+               Percentile(latencyMs, 0.99),
+               latencyMs.back(),
+               flushSeconds,
+               seconds > 0.0 ? encoded / seconds : 0.0);
+        return true;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    StreamEncoderParams params;
+    params.width          = 1280;
+    params.height         = 720;
+    params.writeTimeoutUs = UINT64_MAX;  // Time every frame, rather than dropping the ones ffmpeg is behind on
+
+    uint64_t frames = 300;
+    size_t   pad    = 0;
+
+    int i = 1;
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--")
+        {
+            i++;
+            break;
+        }
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--size")
+        {
+            if (sscanf(value, "%ux%u", &params.width, &params.height) != 2)
+                return Usage();
+        }
+        else if (arg == "--frames")
+            frames = strtoull(value, nullptr, 10);
+        else if (arg == "--pad")
+            pad = strtoull(value, nullptr, 10);
+        else if (arg == "--preset")
+            params.preset = value;
+        else if (arg == "--output")
+            params.outputPath = value;
+        else
+            return Usage();
+    }
+
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (params.publisher.empty() || arg == "|")
+            params.publisher.emplace_back();
+        if (arg == "|")
+            continue;
+        if (params.publisher.back().program.empty())
+            params.publisher.back().program = arg;
+        else
+            params.publisher.back().args.push_back(arg);
+    }
+    for (const StreamCommand& command : params.publisher)
+    {
+        if (command.program.empty())
+            return Usage();
+    }
+    if (!params.width || !params.height || !frames)
+        return Usage();
+
+#if defined(_WIN32)
+    const char* pNullDevice = "NUL";
+#else
+    const char* pNullDevice = "/dev/null";
+#endif
+    if (params.outputPath.empty())
+        params.outputPath = pNullDevice;
+
+    size_t rowPitch = static_cast<size_t>(params.width) * 4 + pad;
+    return Run(params, frames, rowPitch) ? 0 : 1;
+}
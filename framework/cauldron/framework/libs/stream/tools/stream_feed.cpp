@@ -0,0 +1,153 @@
+// stream-feed: pipes synthetic RGBA frames into a process chain the way the Streamer feeds the encoder, to try an
+// encoder command line (or a stand-in sink) without a renderer
+
+#include "stream.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: stream-feed [options] -- <program> [args] ['|' <program> [args]]...\n"
+                "  --size <w>x<h>        frame size (1280x720)\n"
+                "  --frames <n>          frames to write (300)\n"
+                "  --fps <rate>          frames per second, 0 as fast as the chain reads (0)\n"
+                "  --timeout <ms>        drop a frame the chain does not start reading in time (100)\n"
+                "  --output <file>       where the last program writes, standard output if not given\n"
+                "example: stream-feed --size 640x360 -- ffmpeg -f rawvideo -pixel_format rgba -video_size 640x360 -i - -f null -\n");
+        return 2;
+    }
+
+    // A gradient scrolling one texel per frame, so an encoder has motion to work with
+    void FillFrame(std::vector<uint8_t>& frame, uint32_t width, uint32_t height, uint64_t index)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* pRow = frame.data() + static_cast<size_t>(y) * width * 4;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                pRow[x * 4 + 0] = static_cast<uint8_t>(x + index);
+                pRow[x * 4 + 1] = static_cast<uint8_t>(y + index);
+                pRow[x * 4 + 2] = static_cast<uint8_t>((x ^ y) + index);
+                pRow[x * 4 + 3] = 255;
+            }
+        }
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t    width     = 1280;
+    uint32_t    height    = 720;
+    uint64_t    frames    = 300;
+    double      fps       = 0.0;
+    uint64_t    timeoutUs = 100000;
+    std::string outputPath;
+
+    int i = 1;
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--")
+        {
+            i++;
+            break;
+        }
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--size")
+        {
+            if (sscanf(value, "%ux%u", &width, &height) != 2)
+                return Usage();
+        }
+        else if (arg == "--frames")
+            frames = strtoull(value, nullptr, 10);
+        else if (arg == "--fps")
+            fps = strtod(value, nullptr);
+        else if (arg == "--timeout")
+            timeoutUs = strtoull(value, nullptr, 10) * 1000;
+        else if (arg == "--output")
+            outputPath = value;
+        else
+            return Usage();
+    }
+
+    std::vector<StreamCommand> commands(1);
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "|")
+            commands.emplace_back();
+        else if (commands.back().program.empty())
+            commands.back().program = arg;
+        else
+            commands.back().args.push_back(arg);
+    }
+    for (const StreamCommand& command : commands)
+    {
+        if (command.program.empty())
+            return Usage();
+    }
+    if (!width || !height)
+        return Usage();
+
+    StreamProcessChain chain;
+    if (!chain.Start(commands, outputPath))
+    {
+        fprintf(stderr, "stream-feed: %s\n", chain.GetError().c_str());
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+    uint64_t             written = 0;
+    uint64_t             dropped = 0;
+    auto                 startTime = Clock::now();
+    auto                 period    = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(fps > 0.0 ? 1.0 / fps : 0.0));
+
+    for (uint64_t index = 0; index < frames; index++)
+    {
+        if (fps > 0.0)
+            std::this_thread::sleep_until(startTime + period * index);
+
+        FillFrame(frame, width, height, index);
+        StreamWriteStatus status = chain.Write(frame.data(), frame.size(), timeoutUs);
+        if (status == StreamWriteStatus::Closed)
+            break;
+        written += status == StreamWriteStatus::Written ? 1 : 0;
+        dropped += status == StreamWriteStatus::Timeout ? 1 : 0;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    // Let the chain finish what it got
+    bool closed = !chain.IsOpen();
+    chain.Stop(10000000);
+
+    fprintf(stderr,
+            "stream-feed: %llu frames written, %llu dropped in %.2f s, %.1f frames per second, %.1f MB/s\n",
+            static_cast<unsigned long long>(written),
+            static_cast<unsigned long long>(dropped),
+            seconds,
+            seconds > 0.0 ? written / seconds : 0.0,
+            seconds > 0.0 ? written * frame.size() / seconds / (1024.0 * 1024.0) : 0.0);
+
+    int result = closed ? 1 : 0;
+    for (size_t p = 0; p < chain.GetProcessCount(); p++)
+    {
+        fprintf(stderr, "stream-feed: %s exited with %d\n", commands[p].program.c_str(), chain.GetExitCode(p));
+        result = chain.GetExitCode(p) ? 1 : result;
+    }
+    if (closed)
+        fprintf(stderr, "stream-feed: %s after %llu frames\n", chain.GetError().c_str(), static_cast<unsigned long long>(written));
+    return result;
+}
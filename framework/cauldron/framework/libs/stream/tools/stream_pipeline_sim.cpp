@@ -0,0 +1,398 @@
+// stream-pipeline-sim: drives the encode pipeline the way the renderer does, a render thread reserving and copying
+// frames and task threads handing them over out of order, and checks the encoder gets them in order with no readback
+// lost or handed back twice. Encodes with a checking encoder, or through ffmpeg to see the pipeline keep up.
+
+#include "stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: stream-pipeline-sim [options] [-- <publisher> [args] ['|' <program> [args]]...]\n"
+                "  --encoder <name>      check or pipe (check)\n"
+                "  --size <w>x<h>        frame size, at least 64 wide (256x64)\n"
+                "  --frames <n>          frames rendered (2000)\n"
+                "  --in-flight <n>       frames between Reserve and the encoder (3)\n"
+                "  --reorder <n>         frames the pipeline holds back for a missing one (16)\n"
+                "  --tasks <n>           threads handing the frames over (4)\n"
+                "  --skip <percent>      frames the renderer does not copy (5)\n"
+                "  --encode-us <us>      time the checking encoder spends on a frame (2000)\n"
+                "  --timeout <percent>   frames the checking encoder drops (2)\n"
+                "  --close-every <n>     frames after which the checking encoder closes, 0 never (500)\n");
+        return 2;
+    }
+
+    // The frame index in the first 32 texels, black and white bits which come out of the conversion as they went in
+    void FillFrame(uint8_t* pRgba, size_t rowPitch, uint32_t width, uint32_t height, int64_t index)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* pRow = pRgba + y * rowPitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t value = x < 32 ? ((static_cast<uint64_t>(index) >> x) & 1 ? 255 : 0) : static_cast<uint8_t>(x + y + index);
+                pRow[x * 4 + 0] = value;
+                pRow[x * 4 + 1] = value;
+                pRow[x * 4 + 2] = value;
+                pRow[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    int64_t ReadIndex(const uint8_t* pLuma)
+    {
+        uint64_t index = 0;
+        for (uint32_t x = 0; x < 32; x++)
+            index |= static_cast<uint64_t>(pLuma[x] > 128) << x;
+        return static_cast<int64_t>(index);
+    }
+
+    // Checks the frames come in order and behaves like a slow encoder which now and then falls behind or goes away
+    class CheckingEncoder : public StreamEncoder
+    {
+    public:
+        CheckingEncoder(uint64_t encodeUs, uint32_t timeoutPercent, uint64_t closeEvery)
+            : m_EncodeUs(encodeUs)
+            , m_TimeoutPercent(timeoutPercent)
+            , m_CloseEvery(closeEvery)
+        {
+        }
+
+        bool Open(const StreamEncoderParams& params) override
+        {
+            m_Params = params;
+            m_Open   = true;
+            m_Opened = true;
+            return true;
+        }
+
+        StreamWriteStatus Encode(const uint8_t* pRgba, size_t rowPitch) override
+        {
+            std::vector<uint8_t> frame(StreamGetFrameSize(StreamPixelFormat::I420, m_Params.width, m_Params.height));
+            StreamYuvPlanes      planes = StreamGetPackedPlanes(StreamPixelFormat::I420, m_Params.width, m_Params.height, frame.data());
+            GetConverter(m_Params.convertWorkers).Convert(pRgba, rowPitch, m_Params.width, m_Params.height, StreamPixelFormat::I420, planes);
+            return EncodeI420(frame.data());
+        }
+
+        StreamWriteStatus EncodeI420(const uint8_t* pFrame) override
+        {
+            if (!m_Open)
+                return StreamWriteStatus::Closed;
+
+            // The frame the encoder closed on comes again once it is open again
+            int64_t index = ReadIndex(pFrame);
+            if (index < m_Last || (index == m_Last && !m_Opened))
+            {
+                fprintf(stderr, "FAIL frame %lld encoded after frame %lld\n", static_cast<long long>(index), static_cast<long long>(m_Last));
+                m_OutOfOrder++;
+            }
+            m_Last   = index;
+            m_Opened = false;
+
+            std::this_thread::sleep_for(std::chrono::microseconds(m_EncodeUs));
+            if (m_CloseEvery && ++m_Writes % m_CloseEvery == 0)
+            {
+                m_Error = "simulated publisher exit";
+                m_Open  = false;
+                return StreamWriteStatus::Closed;
+            }
+            if (m_Random() % 100 < m_TimeoutPercent)
+                return StreamWriteStatus::Timeout;
+            return StreamWriteStatus::Written;
+        }
+
+        void Close(uint64_t) override { m_Open = false; }
+        bool IsOpen() const override { return m_Open; }
+
+        uint64_t GetOutOfOrder() const { return m_OutOfOrder; }
+
+    private:
+        StreamEncoderParams m_Params;
+        uint64_t            m_EncodeUs       = 0;
+        uint32_t            m_TimeoutPercent = 0;
+        uint64_t            m_CloseEvery     = 0;
+        std::mt19937        m_Random{42};
+        bool                m_Open       = false;
+        bool                m_Opened     = false;
+        int64_t             m_Last       = -1;
+        uint64_t            m_Writes     = 0;
+        uint64_t            m_OutOfOrder = 0;
+    };
+
+    // The renderer's readbacks, taken by a frame from Reserve until the pipeline hands it back
+    class Readbacks
+    {
+    public:
+        Readbacks(uint32_t count, size_t size)
+            : m_Texels(count, std::vector<uint8_t>(size))
+            , m_Taken(count, false)
+        {
+        }
+
+        // Returns the free slot or UINT32_MAX. Reserve promises there is one.
+        uint32_t Take()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto                        slot = std::find(m_Taken.begin(), m_Taken.end(), false);
+            if (slot == m_Taken.end())
+                return UINT32_MAX;
+            *slot = true;
+            return static_cast<uint32_t>(slot - m_Taken.begin());
+        }
+
+        // False if the slot was not taken
+        bool Give(uint32_t slot)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            bool                        taken = m_Taken[slot];
+            m_Taken[slot]                     = false;
+            return taken;
+        }
+
+        uint32_t GetTaken()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return static_cast<uint32_t>(std::count(m_Taken.begin(), m_Taken.end(), true));
+        }
+
+        uint8_t* GetTexels(uint32_t slot) { return m_Texels[slot].data(); }
+
+    private:
+        std::mutex                        m_Mutex;
+        std::vector<std::vector<uint8_t>> m_Texels;
+        std::vector<bool>                 m_Taken;
+    };
+
+    struct Handover
+    {
+        int64_t  index = 0;
+        uint32_t slot  = UINT32_MAX;  // UINT32_MAX for a skipped frame
+    };
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    StreamEncoderParams  encoderParams;
+    StreamPipelineParams params;
+    std::string          encoderName    = "check";
+    uint64_t             frames         = 2000;
+    uint32_t             tasks          = 4;
+    uint32_t             skipPercent    = 5;
+    uint64_t             encodeUs       = 2000;
+    uint32_t             timeoutPercent = 2;
+    uint64_t             closeEvery     = 500;
+    encoderParams.width  = 256;
+    encoderParams.height = 64;
+
+    int i = 1;
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--")
+        {
+            i++;
+            break;
+        }
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--encoder")
+            encoderName = value;
+        else if (arg == "--size")
+        {
+            if (sscanf(value, "%ux%u", &encoderParams.width, &encoderParams.height) != 2)
+                return Usage();
+        }
+        else if (arg == "--frames")
+            frames = strtoull(value, nullptr, 10);
+        else if (arg == "--in-flight")
+            params.maxInFlight = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--reorder")
+            params.reorderWindow = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--tasks")
+            tasks = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--skip")
+            skipPercent = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--encode-us")
+            encodeUs = strtoull(value, nullptr, 10);
+        else if (arg == "--timeout")
+            timeoutPercent = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--close-every")
+            closeEvery = strtoull(value, nullptr, 10);
+        else
+            return Usage();
+    }
+
+    for (; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (encoderParams.publisher.empty() || arg == "|")
+            encoderParams.publisher.emplace_back();
+        if (arg == "|")
+            continue;
+        if (encoderParams.publisher.back().program.empty())
+            encoderParams.publisher.back().program = arg;
+        else
+            encoderParams.publisher.back().args.push_back(arg);
+    }
+    if (encoderParams.width < 64 || !encoderParams.height || !frames || !tasks || !params.maxInFlight)
+        return Usage();
+
+#if defined(_WIN32)
+    encoderParams.outputPath = "NUL";
+#else
+    encoderParams.outputPath = "/dev/null";
+#endif
+
+    CheckingEncoder*               pChecking = nullptr;
+    std::unique_ptr<StreamEncoder> pEncoder;
+    if (encoderName == "check")
+    {
+        pEncoder  = std::make_unique<CheckingEncoder>(encodeUs, timeoutPercent, closeEvery);
+        pChecking = static_cast<CheckingEncoder*>(pEncoder.get());
+    }
+    else if (encoderName == "pipe")
+        pEncoder = std::make_unique<StreamPipeEncoder>();
+    if (!pEncoder)
+        return Usage();
+
+    size_t    rowPitch = static_cast<size_t>(encoderParams.width) * 4 + 64;
+    Readbacks readbacks(params.maxInFlight, rowPitch * encoderParams.height);
+    std::atomic<uint64_t> doubleRelease{0};
+    uint64_t              written = 0;
+
+    params.width     = encoderParams.width;
+    params.height    = encoderParams.height;
+    params.readback  = [&](StreamPipelineFrame& frame) {
+        if (frame.slot == UINT32_MAX)
+            return false;
+        frame.pRgba    = readbacks.GetTexels(frame.slot);
+        frame.rowPitch = rowPitch;
+        frame.release  = [&readbacks, &doubleRelease, slot = frame.slot] { doubleRelease += readbacks.Give(slot) ? 0 : 1; };
+        return true;
+    };
+    params.encoded = [&](const StreamPipelineFrame&, StreamWriteStatus status) { written += status == StreamWriteStatus::Written ? 1 : 0; };
+
+    StreamPipeline pipeline;
+    if (!pipeline.Start(std::move(pEncoder), encoderParams, params))
+    {
+        fprintf(stderr, "stream-pipeline-sim: %s\n", pipeline.GetError().c_str());
+        return 1;
+    }
+
+    // Task threads take the frames from the render thread and hand them over after a while of their own
+    StreamQueue<Handover>    handovers(1024);
+    std::atomic<bool>        rendered{false};
+    std::vector<std::thread> taskThreads;
+    for (uint32_t t = 0; t < tasks; t++)
+    {
+        taskThreads.emplace_back([&, t] {
+            std::mt19937 random(t);
+            Handover     handover;
+            for (;;)
+            {
+                if (!handovers.TryPop(handover))
+                {
+                    if (rendered && !handovers.TryPop(handover))
+                        break;
+                    if (!rendered)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                        continue;
+                    }
+                }
+
+                std::this_thread::sleep_for(std::chrono::microseconds(random() % 3000));
+                if (handover.slot == UINT32_MAX)
+                    pipeline.Skip(handover.index);
+                else
+                    pipeline.Submit(handover.index, handover.slot);
+            }
+        });
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 random(7);
+    uint64_t     slotLost  = 0;
+    auto         startTime = Clock::now();
+    for (uint64_t index = 0; index < frames && pipeline.IsStreaming(); index++)
+    {
+        Handover handover;
+        handover.index = static_cast<int64_t>(index);
+        if (random() % 100 >= skipPercent && pipeline.Reserve(100000))
+        {
+            handover.slot = readbacks.Take();
+            if (handover.slot == UINT32_MAX)
+            {
+                fprintf(stderr, "FAIL no free readback for frame %llu\n", static_cast<unsigned long long>(index));
+                slotLost++;
+                pipeline.Submit(handover.index, UINT32_MAX, false);
+                continue;
+            }
+            FillFrame(readbacks.GetTexels(handover.slot), rowPitch, encoderParams.width, encoderParams.height, handover.index);
+        }
+
+        while (!handovers.TryPush(std::move(handover)))
+            std::this_thread::yield();
+
+        // A frame every millisecond at most, like a fast renderer
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+    rendered = true;
+    for (std::thread& thread : taskThreads)
+        thread.join();
+
+    pipeline.Stop(1000000);
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    StreamPipelineStats stats = pipeline.GetStats();
+    printf("%llu submitted  %llu encoded  %llu dropped  %llu released  %llu skipped  %llu late  %llu gaps  %llu restarts\n",
+           static_cast<unsigned long long>(stats.submitted),
+           static_cast<unsigned long long>(stats.encoded),
+           static_cast<unsigned long long>(stats.dropped),
+           static_cast<unsigned long long>(stats.released),
+           static_cast<unsigned long long>(stats.skipped),
+           static_cast<unsigned long long>(stats.late),
+           static_cast<unsigned long long>(stats.gaps),
+           static_cast<unsigned long long>(stats.restarts));
+    printf("%llu reserve timeouts  reserve wait %.1f ms  latency avg %.2f ms max %.2f ms  reorder max %llu  %.1f frames per second\n",
+           static_cast<unsigned long long>(stats.reserveTimeouts),
+           stats.reserveWaitUs / 1000.0,
+           stats.encoded ? stats.latencyUs / 1000.0 / stats.encoded : 0.0,
+           stats.latencyMaxUs / 1000.0,
+           static_cast<unsigned long long>(stats.reorderMax),
+           seconds > 0.0 ? stats.encoded / seconds : 0.0);
+
+    // Every reserved frame comes out of the pipeline one way or another, and with its readback handed back
+    uint64_t failures = slotLost + doubleRelease.load();
+    uint64_t left     = stats.submitted - stats.encoded - stats.dropped - stats.released;
+    if (left)
+        fprintf(stderr, "FAIL %llu frames never left the pipeline\n", static_cast<unsigned long long>(left));
+    if (readbacks.GetTaken())
+        fprintf(stderr, "FAIL %u readbacks never handed back\n", readbacks.GetTaken());
+    if (doubleRelease)
+        fprintf(stderr, "FAIL %llu readbacks handed back twice\n", static_cast<unsigned long long>(doubleRelease.load()));
+    if (written != stats.encoded)
+        fprintf(stderr, "FAIL %llu frames reported written, %llu encoded\n", static_cast<unsigned long long>(written), static_cast<unsigned long long>(stats.encoded));
+    failures += left + readbacks.GetTaken() + (written != stats.encoded);
+    if (pChecking)
+        failures += pChecking->GetOutOfOrder();
+    if (!pipeline.GetError().empty())
+        printf("last error: %s\n", pipeline.GetError().c_str());
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "manifest.h"
+#include "metadata.h"
+#include "shm.h"
+#include "transport.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// How a plane is stored in a capture
+enum class TSRCaptureCodec : uint32_t
+{
+    Raw = 0,
+    Zstd,  // Only written and read by builds with TSR_HAS_ZSTD
+};
+
+const char* TSRCaptureCodecName(TSRCaptureCodec codec);
+
+// Whether this build writes and reads zstd planes
+bool TSRCaptureSupportsZstd();
+
+struct TSRCaptureOptions
+{
+    TSRCaptureCodec codec = TSRCaptureCodec::Raw;
+    int             level = 3;  // zstd compression level
+};
+
+// State of a captured frame, the slot header it was captured from plus when
+struct TSRCaptureFrame
+{
+    uint64_t         sequence;       // Ring sequence number of the frame
+    uint64_t         captureTimeNs;  // tsr_now_ns when the frame was written
+    uint64_t         resourceMask;   // Resources stored with the frame
+    uint64_t         deltaMask;      // Resources holding only the tiles set in the tile map, see TSRSlotHeader
+    TSRFrameMetadata metadata;
+};
+
+// Counters kept by the writer
+struct TSRCaptureStats
+{
+    uint64_t frames      = 0;
+    uint64_t rawBytes    = 0;  // Plane bytes before compression
+    uint64_t storedBytes = 0;  // Plane bytes written
+    uint64_t fileBytes   = 0;
+};
+
+// A capture stores the frames of a shared buffer ring on disk, to replay them into an upscaler later. The file holds:
+//   header  the manifest (described like an offer, see TSRDescribeManifest) and its tile size
+//   frames  one page aligned chunk per frame: the chunk header, the plane table and the planes, 64 byte aligned. A plane
+//           is the slot bytes of one resource (rows at the manifest row pitch), or the tile map of a delta frame, each
+//           stored raw or compressed on its own.
+//   index   the chunk offsets and a footer pointing at them, written on close
+// Raw planes are read straight out of a file mapping. A capture that was never closed (the capturing process died) has
+// no index, the reader walks the chunks instead and stops at the first incomplete one.
+//
+// Files are written in host byte order, like the network transport they are expected to stay on little endian hosts.
+class TSRCaptureWriter
+{
+public:
+    TSRCaptureWriter() = default;
+    ~TSRCaptureWriter() { Close(); }
+
+    TSRCaptureWriter(const TSRCaptureWriter&)            = delete;
+    TSRCaptureWriter& operator=(const TSRCaptureWriter&) = delete;
+
+    // Create the file and write the header. Returns false if the file can't be written or the codec is not supported
+    // by this build, see GetError.
+    bool Open(const std::string& path, const TSRManifest& manifest, const TSRCaptureOptions& options = TSRCaptureOptions());
+
+    // Append a frame held in slot memory laid out by the manifest. The resources of frame.resourceMask are stored, and
+    // the tile map if it is a delta frame.
+    bool WriteFrame(const TSRCaptureFrame& frame, const uint8_t* pSlot);
+
+    // Append the frame in a host visible transport slot, with the state of its slot header
+    bool WriteSlot(TSRTransport& transport, uint64_t slotIndex, uint64_t sequence);
+
+    // Write the index and close the file
+    bool Close();
+
+    bool IsOpen() const { return m_pFile != nullptr; }
+
+    const TSRCaptureStats& GetStats() const { return m_Stats; }
+
+    const std::string& GetError() const { return m_Error; }
+
+private:
+    bool Write(const void* pData, uint64_t size);
+    bool Pad(uint64_t alignment);
+    bool Fail(const std::string& error);
+
+    FILE*                             m_pFile = nullptr;
+    TSRManifest                       m_Manifest;
+    TSRCaptureOptions                 m_Options;
+    uint64_t                          m_Offset = 0;
+    std::vector<uint64_t>             m_Index;       // Chunk offsets
+    std::vector<std::vector<uint8_t>> m_Compressed;  // Per plane of the frame being written
+    void*                             m_pCompressor = nullptr;
+    TSRCaptureStats                   m_Stats;
+    std::string                       m_Error;
+};
+
+class TSRCaptureReader
+{
+public:
+    TSRCaptureReader() = default;
+    ~TSRCaptureReader() { Close(); }
+
+    TSRCaptureReader(const TSRCaptureReader&)            = delete;
+    TSRCaptureReader& operator=(const TSRCaptureReader&) = delete;
+
+    // Map the capture and check its chunks. Returns false if it is not a capture this build can read, see GetError.
+    bool Open(const std::string& path);
+
+    void Close();
+
+    bool IsOpen() const { return m_File.IsOpen(); }
+
+    const TSRManifest& GetManifest() const { return m_Manifest; }
+
+    uint64_t GetFrameCount() const { return m_Chunks.size(); }
+
+    // Whether the capture was closed, false if the frames were recovered by walking the chunks
+    bool IsComplete() const { return m_Complete; }
+
+    const TSRCaptureFrame& GetFrame(uint64_t index) const;
+
+    // Decode the frame into slot memory laid out by the manifest (GetManifest().GetTotalSize() bytes). Resources not
+    // stored with the frame are left untouched. Returns false if a plane does not decode.
+    bool ReadFrame(uint64_t index, uint8_t* pSlot);
+
+    // Decode the frame into a host visible transport slot and fill in its slot header
+    bool ReadSlot(uint64_t index, TSRTransport& transport, uint64_t slotIndex);
+
+    const std::string& GetError() const { return m_Error; }
+
+private:
+    bool Fail(const std::string& error);
+
+    // Whether the chunk at the offset is complete and consistent with the manifest
+    bool CheckChunk(uint64_t offset) const;
+
+    TSRMappedFile         m_File;
+    TSRManifest           m_Manifest;
+    std::vector<uint64_t> m_Chunks;
+    bool                  m_Complete      = false;
+    void*                 m_pDecompressor = nullptr;
+    std::string           m_Error;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "shm.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace tsr
+{
+    // Fingerprint of a struct layout, both processes must agree on it before exchanging the struct
+    class LayoutHash
+    {
+    public:
+        LayoutHash(size_t size, size_t alignment)
+        {
+            Add(size);
+            Add(alignment);
+        }
+
+        // Add a field, catches reordered, resized and inserted fields
+        LayoutHash& Field(size_t offset, size_t size)
+        {
+            Add(offset);
+            Add(size);
+            return *this;
+        }
+
+        // Bump when the meaning of the fields changes without their layout changing
+        LayoutHash& Version(uint32_t version)
+        {
+            Add(version);
+            return *this;
+        }
+
+        uint64_t Get() const { return m_Hash; }
+
+    private:
+        // FNV-1a over the value bytes
+        void Add(uint64_t value)
+        {
+            for (uint32_t i = 0; i < sizeof(value); i++)
+            {
+                m_Hash ^= (value >> (i * 8)) & 0xff;
+                m_Hash *= 0x100000001b3ull;
+            }
+        }
+
+        uint64_t m_Hash = 0xcbf29ce484222325ull;
+    };
+
+    // Layout hash of a channel payload. Only covers the size and alignment, specialize it to list the fields.
+    template <typename T>
+    struct ChannelLayout
+    {
+        static uint64_t Hash() { return LayoutHash(sizeof(T), alignof(T)).Get(); }
+    };
+
+    #define TSR_LAYOUT_FIELD(Type, field) Field(offsetof(Type, field), sizeof(Type::field))
+
+    struct ChannelStats
+    {
+        uint64_t writes      = 0;
+        uint64_t reads       = 0;
+        uint64_t retries     = 0;  // Reads repeated because the writer was in the middle of the entry
+        uint64_t failedReads = 0;  // Reads that gave up, or found an entry that was never written
+    };
+
+    // Untyped part of Channel, owns the shared memory and the seqlocks
+    class ChannelBase
+    {
+    public:
+        ChannelBase() = default;
+
+        ChannelBase(const ChannelBase&)            = delete;
+        ChannelBase& operator=(const ChannelBase&) = delete;
+
+        void Close();
+
+        bool IsOpen() const { return m_Memory.IsOpen(); }
+
+        size_t GetEntryCount() const { return m_EntryCount; }
+
+        const ChannelStats& GetStats() const { return m_Stats; }
+
+    protected:
+        bool Open(const std::string& name, size_t entryCount, size_t payloadSize, uint64_t layoutHash, bool shouldCreate);
+
+        void Write(size_t index, const void* pData);
+
+        uint64_t Read(size_t index, void* pData, uint32_t maxRetries);
+
+    private:
+        uint8_t* Entry(size_t index) const { return m_Memory.Data() + m_EntryOffset + index * m_EntryStride; }
+
+        TSRSharedMemory m_Memory;
+        size_t          m_EntryCount  = 0;
+        size_t          m_PayloadSize = 0;
+        size_t          m_EntryOffset = 0;
+        size_t          m_EntryStride = 0;
+        ChannelStats    m_Stats       = {};
+    };
+
+    // Fixed number of T entries in named shared memory, written by one process and read by another.
+    //
+    // Every entry is guarded by a seqlock: the writer makes the entry sequence odd, copies the payload and makes the
+    // sequence even again, a reader retries while the sequence is odd or changed during its copy. Readers never block
+    // the writer and never see a torn payload, and reading copies straight into the caller's T.
+    template <typename T>
+    class Channel : public ChannelBase
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Channel payloads are copied between processes byte by byte");
+
+    public:
+        // Create (or open, if shouldCreate is false) the channel. Opening fails if the creator used another layout of T.
+        bool Open(const std::string& name, size_t entryCount, bool shouldCreate)
+        {
+            return ChannelBase::Open(name, entryCount, sizeof(T), ChannelLayout<T>::Hash(), shouldCreate);
+        }
+
+        void Write(size_t index, const T& value) { ChannelBase::Write(index, &value); }
+
+        // Copy the entry into value. Returns how many times the entry was written, or 0 (leaving value untouched) if it
+        // was never written or the writer kept it busy for maxRetries attempts.
+        uint64_t Read(size_t index, T& value, uint32_t maxRetries = 64)
+        {
+            alignas(T) uint8_t copy[sizeof(T)];
+            uint64_t           writes = ChannelBase::Read(index, copy, maxRetries);
+            if (writes)
+                memcpy(&value, copy, sizeof(T));
+            return writes;
+        }
+    };
+}  // namespace tsr
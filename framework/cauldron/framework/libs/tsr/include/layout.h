@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Row pitch and placement alignment of textures inside a buffer (D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT)
+static constexpr uint64_t TSR_ROW_PITCH_ALIGNMENT = 256;
+static constexpr uint64_t TSR_PLACEMENT_ALIGNMENT = 512;
+
+inline uint64_t TSRAlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Placed footprint of a single-mip 2D texture inside a buffer
+struct TSRFootprint
+{
+    uint64_t offset;    // Placement aligned
+    uint64_t rowPitch;  // Row pitch aligned
+    uint64_t rowBytes;  // Bytes of texel data in a row
+    uint32_t rowCount;
+    uint64_t size;      // Bytes from offset to the end of the last row, which is not padded
+};
+
+// Portable equivalent of ID3D12Device::GetCopyableFootprints for one uncompressed subresource placed at or after baseOffset
+TSRFootprint TSRGetCopyableFootprint(uint64_t baseOffset, uint32_t width, uint32_t height, uint64_t stride);
+
+// Where the bytes of a buffer layout go
+struct TSRLayoutReport
+{
+    uint64_t totalBytes            = 0;
+    uint64_t texelBytes            = 0;  // Actual texel data
+    uint64_t rowPaddingBytes       = 0;  // Spent on row pitch alignment
+    uint64_t tileMapBytes          = 0;  // Tile map of delta transfers
+    uint64_t placementPaddingBytes = 0;  // Spent on placement alignment, including the tail
+
+    uint64_t WastedBytes() const { return rowPaddingBytes + placementPaddingBytes; }
+
+    double WastedRatio() const { return totalBytes ? static_cast<double>(WastedBytes()) / totalBytes : 0.0; }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "logging.h"
+#include "ring.h"
+#include "timing.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class TSRPeerState : uint32_t
+{
+    Unknown = 0,  // The heartbeat never counted while we watched it
+    Alive,
+    Lost,         // The heartbeat stopped counting for longer than the timeout
+};
+
+const char* TSRPeerStateName(TSRPeerState state);
+
+// Tells from the heartbeat counter of a peer process whether it still runs. Only the counter changing matters, not its
+// value, so the peers don't have to agree on a clock. A lost peer whose heartbeat counts again is alive again.
+class TSRPeerMonitor
+{
+public:
+    TSRPeerMonitor(uint64_t timeoutUs = 1000000)
+        : m_TimeoutUs(timeoutUs)
+    {
+    }
+
+    // Feed the current heartbeat of the peer, returns its state
+    TSRPeerState Update(uint64_t heartbeat, uint64_t nowNs = tsr_now_ns());
+
+    TSRPeerState GetState() const { return m_State; }
+
+    // Whether the last Update changed the state
+    bool HasChanged() const { return m_Changed; }
+
+    // Times the peer was lost
+    uint64_t GetLostCount() const { return m_LostCount; }
+
+    // Forget the peer, for a heartbeat that belongs to another process from now on
+    void Reset();
+
+private:
+    uint64_t     m_TimeoutUs;
+    TSRPeerState m_State     = TSRPeerState::Unknown;
+    bool         m_Changed   = false;
+    bool         m_Started   = false;
+    uint64_t     m_Heartbeat = 0;
+    uint64_t     m_ChangeNs  = 0;  // When the heartbeat last counted (or we started watching)
+    uint64_t     m_LostCount = 0;
+};
+
+// Watches the other side of a ring. The producer watches every consumer and reclaims the slots of the ones it lost, so
+// it does not wait for them forever. The consumer watches the producer. Every update also counts up our own heartbeat.
+class TSRLivenessWatch
+{
+public:
+    TSRLivenessWatch(TSRSlotRing* pRing, bool producer, uint64_t timeoutUs);
+
+    // Returns true if a peer changed state
+    bool Update(uint64_t nowNs = tsr_now_ns());
+
+    // Producer: masks of the consumers in each state
+    uint32_t GetConsumers(TSRPeerState state) const;
+
+    uint32_t GetConsumerCount() const { return static_cast<uint32_t>(m_Consumers.size()); }
+
+    const TSRPeerMonitor& GetConsumerMonitor(uint32_t consumer) const { return m_Consumers[consumer]; }
+
+    // Consumer: the producer
+    const TSRPeerMonitor& GetProducerMonitor() const { return m_Producer; }
+
+    // True if we saw a peer go and none is alive, the producer has nobody to send frames to and the consumer nobody
+    // to get them from
+    bool IsPeerLost() const;
+
+private:
+    TSRSlotRing*                m_pRing;
+    bool                        m_IsProducer;
+    TSRPeerMonitor              m_Producer;
+    std::vector<TSRPeerMonitor> m_Consumers;
+};
+
+// What the renderer and the upscaler do about peers coming and going. The renderer falls back to upscaling in process
+// once it lost every upscaler (the watch reclaims their shared buffers) and sends the frames again when one comes back.
+// The upscaler drops the shared buffers of a renderer that stopped responding.
+class TSRPeerSupervisor
+{
+public:
+    // A peer whose heartbeat stops for timeoutUs is taken for dead, 0 to wait for it forever
+    TSRPeerSupervisor(uint64_t timeoutUs, TSRLogFunction log = nullptr)
+        : m_TimeoutUs(timeoutUs)
+        , m_Log(std::move(log))
+    {
+    }
+
+    // Watch the peers of the ring of new shared buffers, ends any fallback
+    void Watch(TSRSlotRing* pRing, bool producer);
+
+    // Stop watching, the shared buffers are going away
+    void Stop();
+
+    // Count up our heartbeat and check the peers. Returns true if the upscaler lost the renderer in this update, its
+    // shared buffers have to go.
+    bool Update(uint64_t nowNs = tsr_now_ns());
+
+    // Renderer: no upscaler is left, the frames have to be upscaled in process
+    bool IsFallbackActive() const { return m_Fallback; }
+
+    // Null while not watching
+    const TSRLivenessWatch* GetWatch() const { return m_Watch.get(); }
+
+private:
+    void Log(TSRLogLevel level, const std::string& message) const;
+
+    uint64_t                          m_TimeoutUs;
+    TSRLogFunction                    m_Log;
+    std::unique_ptr<TSRLivenessWatch> m_Watch;
+    bool                              m_IsProducer = false;
+    bool                              m_Fallback   = false;
+};
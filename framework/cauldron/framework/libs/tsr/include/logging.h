@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class TSRLogLevel : uint32_t
+{
+    Info = 0,
+    Warning,
+    Error,
+};
+
+// Where the state machines of the library (negotiation, liveness) report what they did, the owner's log
+using TSRLogFunction = std::function<void(TSRLogLevel level, const std::string& message)>;
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "layout.h"
+#include "packing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static constexpr uint32_t TSR_MANIFEST_VERSION       = 1;
+static constexpr size_t   TSR_MANIFEST_MAX_RESOURCES = 64;  // Per-frame enable masks are 64 bit
+
+// One named resource carried in every shared buffer slot
+struct TSRResourceDesc
+{
+    std::string name;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    format;        // DXGI_FORMAT on D3D12, opaque to the manifest
+    uint64_t    stride;        // Bytes per texel in the slot, the packed stride if the resource is packed
+    bool        optional;      // May be left out of a frame
+    TSRPacking  packing;       // Applied by host transfers between the plane and the slot
+    float       packingScale;  // Motion vector range of TSRPacking::MotionRG16Snorm
+
+    // Filled in by TSRManifest::Finalize
+    uint64_t rowPitch;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Declarative list of the resources the renderer hands to the upscaler.
+// Both processes build the same manifest, the shared buffer layout is computed once from it and both sides
+// verify they agree through the manifest hash.
+class TSRManifest
+{
+public:
+    static constexpr size_t INVALID_RESOURCE = SIZE_MAX;
+
+    // Add a resource, returns its index. A packed resource takes the packed stride in the slot instead of stride.
+    size_t AddResource(const std::string& name,
+                       uint32_t           width,
+                       uint32_t           height,
+                       uint32_t           format,
+                       uint64_t           stride,
+                       bool               optional     = false,
+                       TSRPacking         packing      = TSRPacking::None,
+                       float              packingScale = 1.0f);
+
+    // Send the resources with the size of the first resource as dirty tiles of tileSize texels when the producer
+    // hands a tile map over (see TSRTileClassifier). Reserves room for the tile map in every slot. Host transports
+    // only: TSROps rejects a tiled manifest and TSRRenderModule never sets a tile size, tsr-tile-delta exercises it.
+    void SetTileSize(uint32_t tileSize);
+
+    // Compute the layout of the resources inside a slot (see TSRGetCopyableFootprint). No resources can be added afterwards.
+    void Finalize();
+
+    bool IsFinalized() const { return m_Finalized; }
+
+    size_t GetResourceCount() const { return m_Resources.size(); }
+
+    const TSRResourceDesc& GetResource(size_t index) const { return m_Resources[index]; }
+
+    size_t FindResource(const std::string& name) const;
+
+    uint32_t GetTileSize() const { return m_TileSize; }
+
+    // Where the tile map goes in a slot
+    uint64_t GetTileMapOffset() const { return m_TileMapOffset; }
+
+    // Resources which can be sent as tiles, they all share the tile grid of the first resource
+    uint64_t GetTiledMask() const;
+
+    // Bytes needed per slot
+    uint64_t GetTotalSize() const { return m_TotalSize; }
+
+    // Mask with a bit set for every resource
+    uint64_t GetAllMask() const { return m_Resources.size() == 64 ? UINT64_MAX : (1ull << m_Resources.size()) - 1; }
+
+    // Padding spent on the alignment rules
+    TSRLayoutReport GetLayoutReport() const;
+
+    // Hash of the version and every resource description, including the layout
+    uint64_t GetHash() const;
+
+private:
+    std::vector<TSRResourceDesc> m_Resources;
+    uint64_t                     m_TotalSize     = 0;
+    uint32_t                     m_TileSize      = 0;
+    uint64_t                     m_TileMapOffset = 0;
+    bool                         m_Finalized     = false;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame state the upscaler needs next to the textures. It travels in the slot header, written by the producer in
+// the same transfer as the textures, so the consumer never pairs the textures of one frame with the state of another.
+// Matrices are column major.
+struct TSRFrameMetadata
+{
+    uint64_t frameId;       // Producer frame counter
+    uint64_t renderTimeNs;  // tsr_now_ns when the producer handed the frame over, 0 if it did not fill the metadata
+    float    jitter[2];     // Projection jitter, in the producer camera's convention
+    uint32_t reset;         // History is invalid (camera cut, resize, ...)
+    float    deltaTimeMs;
+    float    exposure;
+    uint32_t renderWidth;
+    uint32_t renderHeight;
+    float    viewMatrix[16];
+    float    projectionMatrix[16];
+    float    jitteredProjectionMatrix[16];
+    float    prevViewMatrix[16];
+    float    prevViewProjectionMatrix[16];
+    float    prevJitteredProjectionMatrix[16];
+};
+
+// Counters kept by TSRMetadataChecker
+struct TSRMetadataStats
+{
+    uint64_t frames     = 0;
+    uint64_t missing    = 0;  // Slots without metadata
+    uint64_t manifests  = 0;  // Slots laid out with another manifest than the consumer's
+    uint64_t mismatches = 0;  // Side data (camera, ...) belonged to another frame than the slot
+    uint64_t gaps       = 0;  // Frame ids skipped between consecutive slots
+    uint64_t repeats    = 0;  // The same frame id twice in a row
+    uint64_t reversals  = 0;  // A frame id older than the previous one
+};
+
+// Consumer side check of the metadata of every consumed slot
+class TSRMetadataChecker
+{
+public:
+    static constexpr uint64_t NO_SIDE_DATA = UINT64_MAX;
+
+    // Check the metadata of a consumed slot. sideFrameId is the frame id of state that reached the consumer some
+    // other way (NO_SIDE_DATA if there is none), which has to match the slot. Returns false if anything was off.
+    bool Check(const TSRFrameMetadata& metadata, uint64_t sideFrameId = NO_SIDE_DATA);
+
+    // Check the manifest hash in the header of a consumed slot against the one the consumer reads it with, a producer
+    // still on the manifest of an older generation writes another. Returns false if they differ.
+    bool CheckManifest(uint64_t slotManifestHash, uint64_t manifestHash);
+
+    const TSRMetadataStats& GetStats() const { return m_Stats; }
+
+private:
+    uint64_t         m_LastFrameId  = 0;
+    bool             m_HasLastFrame = false;
+    TSRMetadataStats m_Stats        = {};
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "channel.h"
+#include "logging.h"
+#include "manifest.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// One resource of an offer, see TSRResourceDesc
+struct TSROfferResource
+{
+    char     name[32];
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t optional;
+    uint64_t stride;
+    uint32_t packing;
+    float    packingScale;
+};
+
+enum class TSROfferState : uint32_t
+{
+    Proposed = 0,  // Waiting for the answers
+    Committed,     // Every upscaler accepted and the renderer created the shared buffers of the generation
+};
+
+// What the renderer sends: the shared buffers it wants to create for a generation. Every offer starts a new
+// generation, the shared buffers of a generation are named after it so they never collide with the previous ones.
+struct TSROffer
+{
+    uint64_t         generation;
+    TSROfferState    state;
+    uint32_t         renderWidth;
+    uint32_t         renderHeight;
+    uint32_t         resourceCount;
+    uint64_t         slotCount;
+    uint64_t         manifestHash;
+    TSROfferResource resources[TSR_MANIFEST_MAX_RESOURCES];
+};
+
+enum class TSRAnswerStatus : uint32_t
+{
+    Accepted = 0,
+    Counter,   // The upscaler takes at most slotCount shared buffers of renderWidth x renderHeight, offer again
+    Rejected,  // The upscaler cannot read the resources, see the reason
+};
+
+const char* TSRAnswerStatusName(TSRAnswerStatus status);
+
+// What an upscaler answers to an offer
+struct TSRAnswer
+{
+    uint64_t        generation;  // Of the offer answered
+    TSRAnswerStatus status;
+    uint32_t        renderWidth;
+    uint32_t        renderHeight;
+    uint64_t        slotCount;
+    char            reason[96];  // Null terminated
+};
+
+// Limits of an upscaler, checked against every offer
+struct TSRCapabilities
+{
+    uint64_t minSlots        = 1;
+    uint64_t maxSlots        = UINT64_MAX;
+    uint32_t maxRenderWidth  = UINT32_MAX;
+    uint32_t maxRenderHeight = UINT32_MAX;
+};
+
+// Describe the manifest in the offer
+void TSRDescribeManifest(const TSRManifest& manifest, TSROffer& offer);
+
+// Build the manifest the offer describes, with tiles of tileSize texels (see TSRManifest::SetTileSize), which the offer
+// does not carry. Returns false if the resources don't add up to the offered layout.
+bool TSRBuildManifest(const TSROffer& offer, uint32_t tileSize, TSRManifest& manifest);
+
+// First difference between the resources of the offer and the manifest, empty if they describe the same layout
+std::string TSRCompareManifest(const TSROffer& offer, const TSRManifest& manifest);
+
+// Check the offer against the limits of the upscaler. Too many slots or too large a resolution get a counter with the
+// largest the upscaler takes (keeping the aspect ratio), too few slots a rejection. Resources are not checked.
+TSRAnswer TSREvaluateOffer(const TSROffer& offer, const TSRCapabilities& capabilities);
+
+// Mailboxes the renderer and its upscalers agree on the shared buffers through, before creating them. The renderer
+// creates the channel and writes the offer, every upscaler answers in its own entry.
+class TSRControlChannel
+{
+public:
+    // Create (or open, if shouldCreate is false) the channel. Returns false if it does not exist (yet).
+    bool Open(const std::string& sharedName, uint32_t consumerCount, bool shouldCreate);
+
+    void Close();
+
+    bool IsOpen() const { return m_Offers.IsOpen(); }
+
+    // Renderer: propose the offer as the next generation, returns the generation
+    uint64_t Offer(const TSROffer& offer);
+
+    // Renderer: tell the upscalers the shared buffers of the offered generation exist
+    void Commit();
+
+    const TSROffer& GetOffer() const { return m_Offer; }
+
+    // Renderer: the answers of all upscalers to the current offer merged into one, false until all of them answered.
+    // A rejection wins over a counter, which wins over an acceptance, counters take the smallest limits.
+    bool PollAnswers(TSRAnswer& answer);
+
+    // Upscaler: the offer, if it changed (new generation or committed) since the last call
+    bool PollOffer(TSROffer& offer);
+
+    // Upscaler: answer the offer of answer.generation
+    void Answer(uint32_t consumer, const TSRAnswer& answer);
+
+private:
+    tsr::Channel<TSROffer>  m_Offers;
+    tsr::Channel<TSRAnswer> m_Answers;
+    uint32_t                m_ConsumerCount = 0;
+    TSROffer                m_Offer         = {};  // Renderer: the current offer, upscaler: the last one seen
+};
+
+enum class TSRNegotiationState : uint32_t
+{
+    Idle = 0,     // Nothing offered (renderer) or accepted (upscaler) yet
+    Negotiating,  // Waiting for the answers (renderer) or the commit (upscaler)
+    Allocating,   // Creating the shared buffers of the generation
+    Running,
+    Failed,
+};
+
+const char* TSRNegotiationStateName(TSRNegotiationState state);
+
+// What the negotiation needs from the side owning the shared buffers and the render targets
+struct TSRNegotiationHooks
+{
+    // Describe the resources as they are sized now
+    std::function<TSRManifest()> buildManifest;
+
+    // Render at another resolution, before the next buildManifest
+    std::function<void(uint32_t renderWidth, uint32_t renderHeight)> resize;
+
+    // Upscaler: what it can take, checked against every offer
+    std::function<TSRCapabilities()> capabilities;
+
+    // Start creating the shared buffers of the generation, which may finish later
+    std::function<void(uint64_t generation, uint64_t slotCount, const TSRManifest& manifest)> allocate;
+
+    // Switch to the shared buffers allocate created, false while they are not created yet
+    std::function<bool()> install;
+
+    // Drop the shared buffers in use, they are about to be replaced
+    std::function<void()> drop;
+
+    TSRLogFunction log;
+};
+
+// The renderer offers the shared buffers over the control channel and creates them once every upscaler accepted, the
+// upscalers open them once the renderer committed the generation. Counters from the upscalers (fewer shared buffers,
+// a lower resolution) are offered again, resizes start a new generation.
+class TSRNegotiator
+{
+public:
+    // The renderer creates the control channel in Start, the upscalers open it in Update once the renderer runs
+    TSRNegotiator(const std::string& sharedName, uint32_t consumerCount, uint32_t consumerIndex, bool isProducer, TSRNegotiationHooks hooks);
+
+    // Renderer: create the control channel and offer slotCount shared buffers of renderWidth x renderHeight on the first
+    // update, counters get at most maxSlots. Returns false if the channel can't be created.
+    bool Start(uint64_t slotCount, uint64_t maxSlots, uint32_t renderWidth, uint32_t renderHeight);
+
+    // Upscaler: answer offers at this resolution, the renderer's
+    void Start(uint32_t renderWidth, uint32_t renderHeight);
+
+    // Advance the negotiation, returns true while the shared buffers of the current generation are in use
+    bool Update();
+
+    // The render resolution changed. The renderer offers a new generation, the upscaler counters with the resolution.
+    void Resize(uint32_t renderWidth, uint32_t renderHeight);
+
+    // Upscaler: the renderer stopped responding, drop its shared buffers and wait for the next generation
+    void PeerLost();
+
+    TSRNegotiationState GetState() const { return m_State; }
+
+    // Shared buffers of the last generation offered (renderer) or accepted (upscaler)
+    uint64_t GetSlotCount() const { return m_SlotCount; }
+
+    const TSRControlChannel& GetControlChannel() const { return m_Channel; }
+
+private:
+    void Offer();
+    void HandleAnswer(const TSRAnswer& answer);
+    void AnswerOffer(const TSROffer& offer);
+    void Allocate(uint64_t generation);
+    void Fail(const std::string& message);
+    void Log(TSRLogLevel level, const std::string& message) const;
+
+    static constexpr uint32_t MAX_COUNTERS = 4;  // In a row, before giving up on counters that go nowhere
+
+    std::string         m_SharedName;
+    uint32_t            m_ConsumerCount;
+    uint32_t            m_ConsumerIndex;
+    bool                m_IsProducer;
+    TSRNegotiationHooks m_Hooks;
+    TSRControlChannel   m_Channel;
+    TSRNegotiationState m_State              = TSRNegotiationState::Idle;
+    TSRManifest         m_Manifest;                // Of the last offer, or the one we accepted
+    uint64_t            m_SlotCount          = 0;
+    uint64_t            m_MaxSlots           = 0;
+    uint32_t            m_RenderWidth        = 0;
+    uint32_t            m_RenderHeight       = 0;
+    uint64_t            m_AcceptedGeneration = 0;  // Upscaler: generation we accepted
+    uint32_t            m_CounterCount       = 0;  // Renderer: counters in a row
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compact encodings applied to a resource before it goes into a shared buffer slot. Host transports apply every one of
+// them, the D3D12 render module only ColorR11G11B10 (through a compact texture, see TSRRenderModule::InitPackPass).
+enum class TSRPacking : uint32_t
+{
+    None = 0,
+    Depth24Unorm,     // 1 float in [0, 1] -> 3 bytes
+    MotionRG16Snorm,  // 2 floats in [-scale, scale] -> 2 x int16
+    ColorR11G11B10,   // 3 non-negative floats -> R11G11B10_FLOAT, alpha is dropped
+};
+
+const char* TSRGetPackingName(TSRPacking packing);
+
+// Parse a packing name, returns false if the name is unknown
+bool TSRParsePacking(const char* pName, TSRPacking& packing);
+
+// Floats read per texel by the packing
+uint32_t TSRGetPackingComponents(TSRPacking packing);
+
+// Bytes per packed texel
+uint64_t TSRGetPackedStride(TSRPacking packing);
+
+// Pack a row of count texels of srcComponents floats each. scale is the motion vector range.
+void TSRPackRow(TSRPacking packing, const float* pSrc, uint32_t srcComponents, uint8_t* pDst, uint32_t count, float scale);
+
+// Unpack a row into texels of dstComponents floats each, components the packing doesn't carry are set to 0 (alpha to 1)
+void TSRUnpackRow(TSRPacking packing, const uint8_t* pSrc, float* pDst, uint32_t dstComponents, uint32_t count, float scale);
+
+// Round trip error of a packing over a set of texels
+struct TSRPackingError
+{
+    uint64_t count       = 0;    // Components compared
+    double   maxAbsError = 0.0;
+    double   maxRelError = 0.0;  // Relative to the source value, for components above 1e-6
+    double   rmse        = 0.0;
+};
+
+TSRPackingError TSRMeasurePackingError(TSRPacking packing, const float* pSrc, uint32_t srcComponents, uint32_t count, float scale);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Zero-copy transfers: instead of copying the render targets in and out of the shared buffers, every slot gets a heap
+// shared between the processes and the render targets of the slot are placed resources in it. The renderer renders
+// into the placed resources of the slot it acquired, the upscaler reads the same memory through its own placed
+// resources, only the slot changes hands. The render targets rotate through the slots like swap chain back buffers.
+
+// Heap alignment of placed textures (D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+static constexpr uint64_t TSR_HEAP_ALIGNMENT = 65536;
+
+// Render target placed in the heap of every slot
+struct TSRPlacedResourceDesc
+{
+    std::string name;
+    uint32_t    width        = 0;
+    uint32_t    height       = 0;
+    uint32_t    format       = 0;  // DXGI_FORMAT on D3D12, opaque to the layout
+    uint64_t    stride       = 0;  // Bytes per texel, for allocators which can't ask a device
+    bool        depthStencil = false;
+    bool        allowUAV     = false;
+};
+
+struct TSRAllocationInfo
+{
+    uint64_t size      = 0;
+    uint64_t alignment = 0;
+};
+
+// What TSRPlacedSlots needs from the graphics API. Heaps and resources are the API's objects (ID3D12Heap and
+// ID3D12Resource on D3D12), null when they could not be created.
+class TSRResourceAllocator
+{
+public:
+    virtual ~TSRResourceAllocator() = default;
+
+    virtual TSRAllocationInfo GetAllocationInfo(const TSRPlacedResourceDesc& desc) = 0;
+
+    // Create the named heap, or open the one the other process created (which has to be size bytes large)
+    virtual void* CreateHeap(const std::string& name, uint64_t size, bool shouldCreate) = 0;
+
+    virtual void* CreatePlacedResource(void* pHeap, uint64_t offset, const TSRPlacedResourceDesc& desc) = 0;
+
+    virtual void ReleaseResource(void* pResource) = 0;
+
+    // Called once the resources placed in the heap were released
+    virtual void ReleaseHeap(void* pHeap) = 0;
+};
+
+// The heaps of the slots, the render targets placed in them and which slot the render targets currently are
+class TSRPlacedSlots
+{
+public:
+    explicit TSRPlacedSlots(TSRResourceAllocator* pAllocator)
+        : m_pAllocator(pAllocator)
+    {
+    }
+    ~TSRPlacedSlots() { Destroy(); }
+
+    TSRPlacedSlots(const TSRPlacedSlots&)            = delete;
+    TSRPlacedSlots& operator=(const TSRPlacedSlots&) = delete;
+
+    // Place a render target in every slot, in place of the manifest resource manifestIndex. Returns its index.
+    size_t AddResource(size_t manifestIndex, const TSRPlacedResourceDesc& desc);
+
+    // Lay the resources out and create (or open, if shouldCreate is false) the heap of every slot, named after the
+    // shared name and the slot. Both processes have to add the same resources. Returns false if a heap or a resource
+    // could not be created, in which case nothing is left behind.
+    bool Create(const std::string& sharedName, uint64_t slotCount, bool shouldCreate);
+
+    void Destroy();
+
+    bool IsCreated() const { return !m_Heaps.empty(); }
+
+    uint64_t GetSlotCount() const { return m_Heaps.size(); }
+
+    size_t GetResourceCount() const { return m_Descs.size(); }
+
+    const TSRPlacedResourceDesc& GetDesc(size_t resource) const { return m_Descs[resource]; }
+
+    size_t GetManifestIndex(size_t resource) const { return m_ManifestIndices[resource]; }
+
+    // Where the resource is placed in the heap of every slot
+    uint64_t GetOffset(size_t resource) const { return m_Offsets[resource]; }
+
+    // Bytes per slot heap
+    uint64_t GetHeapSize() const { return m_HeapSize; }
+
+    void* GetHeap(uint64_t slot) const { return m_Heaps[slot]; }
+
+    void* GetResource(uint64_t slot, size_t resource) const { return m_Resources[slot * m_Descs.size() + resource]; }
+
+    // Manifest resources which live in the heaps, the transfers leave them out of the shared buffers
+    uint64_t GetAliasedMask() const;
+
+    // Point the render targets at the resources of a slot. Returns true if that's another slot than before, the
+    // render targets have to move on to the slot's resources then.
+    bool SetCurrentSlot(uint64_t slot);
+
+    uint64_t GetCurrentSlot() const { return m_CurrentSlot; }
+
+    // Slot changes so far
+    uint64_t GetRotationCount() const { return m_Rotations; }
+
+private:
+    TSRResourceAllocator*              m_pAllocator = nullptr;
+    std::vector<TSRPlacedResourceDesc> m_Descs;
+    std::vector<size_t>                m_ManifestIndices;
+    std::vector<uint64_t>              m_Offsets;
+    uint64_t                           m_HeapSize    = 0;
+    std::vector<void*>                 m_Heaps;
+    std::vector<void*>                 m_Resources;  // Slot by slot
+    uint64_t                           m_CurrentSlot = UINT64_MAX;
+    uint64_t                           m_Rotations   = 0;
+};
+
+// Allocator without a device, for testing the slot layout and rotation. Heaps are opened by name like shared heaps,
+// so two TSRPlacedSlots on the same allocator stand in for the two processes. Placements overlapping another
+// resource or running past the heap fail, like allocations after FailAfter.
+class TSRMockAllocator : public TSRResourceAllocator
+{
+public:
+    struct Heap;
+
+    struct Resource
+    {
+        Heap*                 pHeap  = nullptr;
+        uint64_t              offset = 0;
+        uint64_t              size   = 0;
+        TSRPlacedResourceDesc desc;
+    };
+
+    struct Heap
+    {
+        std::string            name;
+        uint64_t               size       = 0;
+        uint32_t               references = 0;  // Creator and openers
+        std::vector<Resource*> resources;
+    };
+
+    ~TSRMockAllocator() override;
+
+    TSRAllocationInfo GetAllocationInfo(const TSRPlacedResourceDesc& desc) override;
+
+    void* CreateHeap(const std::string& name, uint64_t size, bool shouldCreate) override;
+
+    void* CreatePlacedResource(void* pHeap, uint64_t offset, const TSRPlacedResourceDesc& desc) override;
+
+    void ReleaseResource(void* pResource) override;
+
+    void ReleaseHeap(void* pHeap) override;
+
+    // Let count more heaps and resources be created, then fail every creation
+    void FailAfter(uint64_t count) { m_Remaining = count; }
+
+    size_t GetHeapCount() const { return m_Heaps.size(); }
+
+    size_t GetResourceCount() const { return m_ResourceCount; }
+
+    static const Resource* Describe(const void* pResource) { return static_cast<const Resource*>(pResource); }
+
+private:
+    std::map<std::string, std::unique_ptr<Heap>> m_Heaps;
+    size_t                                       m_ResourceCount = 0;
+    uint64_t                                     m_Remaining     = UINT64_MAX;
+
+    bool Allocate();
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "placement.h"
+
+#include <d3d12.h>
+#include <map>
+
+// Places the render targets of the slots in shared D3D12 heaps. The heaps only take render targets and depth
+// stencils (which every resource bound to the TSR is), so they work on resource heap tier 1 devices as well.
+class TSRD3D12Allocator : public TSRResourceAllocator
+{
+public:
+    explicit TSRD3D12Allocator(ID3D12Device* pDevice)
+        : m_pDevice(pDevice)
+    {
+    }
+
+    TSRAllocationInfo GetAllocationInfo(const TSRPlacedResourceDesc& desc) override;
+
+    void* CreateHeap(const std::string& name, uint64_t size, bool shouldCreate) override;
+
+    // Placed resources start in the state render targets are in between frames, both shader resource states
+    void* CreatePlacedResource(void* pHeap, uint64_t offset, const TSRPlacedResourceDesc& desc) override;
+
+    void ReleaseResource(void* pResource) override;
+
+    void ReleaseHeap(void* pHeap) override;
+
+private:
+    ID3D12Device*                 m_pDevice = nullptr;
+    std::map<ID3D12Heap*, HANDLE> m_SharedHandles;  // Of the heaps we created, which keep their names alive
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU model of GPU queues synchronized with fences. Every queue runs its commands in order, waits block a queue until
+// the fence reaches the value on another queue. Used to measure how transfer work overlaps rendering without a GPU.
+class TSRQueueSim
+{
+public:
+    struct Interval
+    {
+        double      startUs;
+        double      endUs;
+        std::string label;
+    };
+
+    size_t AddQueue(const std::string& name);
+
+    size_t AddFence();
+
+    // Work taking durationUs on the queue
+    void Execute(size_t queue, double durationUs, const std::string& label = std::string());
+
+    void Signal(size_t queue, size_t fence, uint64_t value);
+
+    void Wait(size_t queue, size_t fence, uint64_t value);
+
+    // Run every queue to completion. Returns false if the queues deadlock.
+    bool Run();
+
+    const std::vector<Interval>& GetTimeline(size_t queue) const { return m_Queues[queue].timeline; }
+
+    // When the queue finished its last command
+    double GetQueueEndUs(size_t queue) const { return m_Queues[queue].timeUs; }
+
+    double GetQueueBusyUs(size_t queue) const;
+
+    // Time both queues were executing work at once
+    double GetOverlapUs(size_t queueA, size_t queueB) const;
+
+private:
+    enum class CommandType
+    {
+        Execute,
+        Signal,
+        Wait,
+    };
+
+    struct Command
+    {
+        CommandType type;
+        double      durationUs;
+        size_t      fence;
+        uint64_t    value;
+        std::string label;
+    };
+
+    struct Queue
+    {
+        std::string           name;
+        std::vector<Command>  commands;
+        size_t                next   = 0;
+        double                timeUs = 0.0;
+        std::vector<Interval> timeline;
+    };
+
+    // Fence values in signal order, with the time they were reached
+    struct FenceSignal
+    {
+        uint64_t value;
+        double   timeUs;
+    };
+
+    std::vector<Queue>                    m_Queues;
+    std::vector<std::vector<FenceSignal>> m_Fences;
+
+    bool FenceReached(size_t fence, uint64_t value, double& timeUs) const;
+};
+
+// Frame loop of a TSR producer, transferring on the graphics queue or on a copy queue
+struct TSRTransferSimParams
+{
+    uint32_t frames        = 100;
+    double   renderUs      = 8000.0;  // Graphics work of a frame
+    double   independentUs = 2000.0;  // Leading part of renderUs which doesn't touch the transferred resources (shadows, sky, ...)
+    double   copyUs        = 1500.0;  // Transfer of a frame
+    double   barrierUs     = 20.0;    // A batched barrier list
+    bool     copyQueue     = false;
+    bool     splitFrame    = false;   // Copy queue only: submit the independent part of the next frame before taking the resources back
+};
+
+struct TSRTransferSimResult
+{
+    double frameUs;         // Average time between frames on the graphics queue
+    double graphicsBusyUs;  // Graphics queue busy time per frame
+    double overlapUs;       // Copy work overlapping graphics work per frame
+};
+
+TSRTransferSimResult TSRSimulateTransfers(const TSRTransferSimParams& params);
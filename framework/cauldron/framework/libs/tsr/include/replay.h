@@ -0,0 +1,70 @@
+#pragma once
+
+#include "capture.h"
+#include "ring.h"
+#include "timing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Capturing and replaying the frames of a renderer on host transports (TSRPosixTransport). Both sides agree on the
+// shared buffers over the control channel (see TSRControlChannel), which is also how the capture learns the manifest:
+// the recorder takes the place of an upscaler, the replay the place of the renderer. The D3D12 renderer has no host
+// transport to record from, tsr-synth-capture writes captures of synthetic frames laid out like its resources instead.
+
+struct TSRCaptureRecordParams
+{
+    std::string       sharedName;
+    std::string       path;
+    TSRCaptureOptions options;
+    uint32_t          consumerCount = 1;         // Upscalers the renderer feeds, the recorder takes the place of one
+    uint32_t          consumer      = 0;
+    uint32_t          tileSize      = 0;         // Of the renderer's manifest, which the offer does not carry
+    uint64_t          frames        = 0;         // Frames to capture, 0 to capture until the renderer goes away
+    uint64_t          timeoutUs     = 10000000;  // For the renderer to offer its shared buffers
+    uint64_t          peerTimeoutUs = 1000000;   // For the renderer to stop responding, see TSRLivenessWatch
+};
+
+struct TSRCaptureRecordResult
+{
+    std::string     error;        // Empty on success
+    uint64_t        dropped = 0;  // Frames the renderer published which never reached us, as counted by the ring
+    TSRCaptureStats stats;
+};
+
+// Capture every frame of the renderer, the renderer waits for each one to be written. Ends after params.frames
+// frames, once the renderer stopped responding or offered a new generation (whose layout may differ), or when pStop
+// is set.
+TSRCaptureRecordResult TSRRecordCapture(const TSRCaptureRecordParams& params, const std::atomic<bool>* pStop = nullptr);
+
+struct TSRReplayParams
+{
+    std::string path;
+    std::string sharedName;
+    uint32_t    consumerCount = 1;
+    uint64_t    slotCount     = 3;
+    double      fps           = 0.0;  // Frames per second, 0 to replay as fast as the upscalers consume them
+    uint32_t    loops         = 1;
+    TSRWaitMode waitMode      = TSRWaitMode::Event;
+    uint64_t    timeoutUs     = 10000000;  // For the upscalers to accept the offer
+    uint64_t    peerTimeoutUs = 1000000;   // For the upscalers to stop responding, see TSRLivenessWatch
+};
+
+struct TSRReplayResult
+{
+    std::string  error;  // Empty on success
+    uint64_t     frames          = 0;
+    uint64_t     late            = 0;  // Frames published after they were due
+    double       seconds         = 0.0;
+    double       framesPerSecond = 0.0;
+    TSRHistogram lateUs;  // How long after it was due every frame was published
+    TSRRingStats ringStats;
+};
+
+// Offer the capture to the upscalers and feed them its frames. Frames get new frame ids and render times, the first
+// frame of every loop resets the history. At a fixed rate frame n is due n / fps after the first one, a replay that
+// falls more than a frame behind (slow upscalers or decoding) starts counting from the late frame rather than
+// catching up in a burst. Delta frames replay as captured, a keyframe request is only served by the full frames of the
+// capture. Ends after the last frame of the last loop has been consumed, or when pStop is set.
+TSRReplayResult TSRReplayCapture(const TSRReplayParams& params, const std::atomic<bool>* pStop = nullptr);
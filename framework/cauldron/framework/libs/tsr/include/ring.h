@@ -0,0 +1,210 @@
+#pragma once
+
+#include "transport.h"
+#include "timing.h"
+
+#include <cstdint>
+#include <vector>
+
+// Counters kept by either side of the ring
+struct TSRRingStats
+{
+    uint64_t produced   = 0;  // Frames published by the producer
+    uint64_t consumed   = 0;  // Frames released by the consumer
+    uint64_t dropped    = 0;  // Sequence numbers the consumer never saw
+    uint64_t outOfOrder = 0;  // Frames that completed after a newer frame was already consumed
+    uint64_t skipped    = 0;  // Frames released unread by the Latest policy
+    uint64_t skips      = 0;  // Acquires that skipped frames
+    uint64_t savedUs    = 0;  // Queueing latency the skips saved (the age of the oldest skipped frame), if the transport or the frame metadata can tell
+    uint64_t reclaimed  = 0;  // Producer: slots released on behalf of lost consumers
+    uint64_t rejoins    = 0;  // Consumer: times the producer took us for lost and we registered again
+};
+
+// Which completed frame the consumer takes
+enum class TSRConsumePolicy : uint32_t
+{
+    EveryFrame = 0,  // The oldest, every frame gets consumed and a slow consumer falls further and further behind
+    Latest,          // The newest, older frames are released unread
+};
+
+// How a side waits for the ring to make progress
+enum class TSRWaitMode : uint32_t
+{
+    Poll = 0,  // Spin on the slot values until the deadline
+    Event,     // Sleep on the transport until a slot is signaled or the deadline passes
+};
+
+// Counters for the time spent waiting on the peer
+struct TSRWaitStats
+{
+    TSRHistogram waitUs;         // Time spent inside a wait call, including waits that found a slot immediately
+    TSRHistogram wakeLatencyUs;  // Time from the peer signaling the slot to this side acquiring it (if the transport can tell)
+    uint64_t     waits    = 0;
+    uint64_t     timeouts = 0;
+    uint64_t     polls    = 0;   // Slot scans performed while waiting
+    uint64_t     cpuNs    = 0;   // CPU time of the waiting thread spent inside wait calls
+};
+
+// Single-producer ring over the transport slots, read by one consumer or fanned out to several.
+//
+// Every frame gets a monotonically increasing sequence number, which is encoded in the slot value:
+//   2 * seq + 1  the slot holds frame seq (READY)
+//   2 * seq + 2  frame seq was consumed, the slot is free (IDLE)
+// Slot values therefore only ever grow, which is what D3D12 fences expect, and each side can tell from a slot
+// value alone which frame it holds. The producer head and the consumer tail are the next sequence numbers each
+// side will produce/consume. The producer may write into any free slot and the consumer may drain any completed
+// slot, so neither side has to step in lockstep with the other.
+//
+// With several consumers the producer publishes on lane 0 and each consumer releases on its own lane (see
+// TSRTransport), a READY slot is shared by all registered consumers and only free once each of them released it.
+// Every consumer keeps its own tail and consume policy.
+class TSRSlotRing
+{
+public:
+    static constexpr uint64_t INVALID_SLOT = UINT64_MAX;
+
+    // consumer is the index of the consumer side, the producer side ignores it
+    TSRSlotRing(TSRTransport* pTransport, uint32_t consumer = 0)
+        : m_pTransport(pTransport)
+        , m_SlotFloor(pTransport->GetSlotCount(), 0)
+        , m_ActiveSlots(pTransport->GetSlotCount())
+        , m_Consumer(consumer)
+        , m_ReleaseLane(pTransport->GetReleaseLane(consumer))
+    {
+    }
+
+    static constexpr uint64_t ReadyValue(uint64_t sequence) { return 2 * sequence + 1; }
+    static constexpr uint64_t IdleValue(uint64_t sequence) { return 2 * sequence + 2; }
+    static constexpr bool     IsReadyValue(uint64_t value) { return (value & 1) == 1; }
+    static constexpr uint64_t SequenceOf(uint64_t value) { return value == 0 ? 0 : (value - 1) / 2; }
+
+    // Producer: claim a free slot for the frame at the head. Returns the already claimed slot if there is one.
+    bool AcquireWrite(uint64_t& slotIndex, uint64_t& sequence);
+
+    // Producer: hand the claimed slot over to the consumer
+    void Publish();
+
+    // Consumer: claim a completed slot, picked by the consume policy. Returns the already claimed slot if there is one.
+    bool AcquireRead(uint64_t& slotIndex, uint64_t& sequence);
+
+    void SetConsumePolicy(TSRConsumePolicy policy) { m_ConsumePolicy = policy; }
+
+    TSRConsumePolicy GetConsumePolicy() const { return m_ConsumePolicy; }
+
+    // Frames the last acquired frame skipped, the consumer has to reset its history if it relies on seeing every frame.
+    // Skipped delta frames also make the ring ask the producer for a keyframe.
+    uint64_t GetLastSkipCount() const { return m_LastSkipCount; }
+
+    // Consumer: hand the claimed slot back to the producer
+    void Release();
+
+    // Consumer: start reading the slots, the producer waits for our releases from now on. With several consumers the
+    // frames published before are left to the consumers that were already registered.
+    void RegisterConsumer();
+
+    // Consumer: stop reading the slots, the producer no longer waits for us
+    void UnregisterConsumer();
+
+    // Producer: release the frames a lost consumer still holds and stop waiting for it. A consumer that was only
+    // stalled notices on its next acquire or release, drops the frame it held and registers again.
+    void ReclaimConsumer(uint32_t consumer);
+
+    // Count up the heartbeat of our side, which the wait calls also do. For a side that stops waiting on the ring
+    // (e.g. a renderer upscaling by itself) but wants its peers to know it is alive.
+    void Heartbeat(bool producer);
+
+    uint32_t GetConsumer() const { return m_Consumer; }
+
+    TSRTransport* GetTransport() const { return m_pTransport; }
+
+    bool IsRegistered() const { return m_Registered; }
+
+    // Producer: AcquireWrite, waiting up to timeoutUs for a slot to free up
+    bool WaitAcquireWrite(uint64_t& slotIndex, uint64_t& sequence, TSRWaitMode mode, uint64_t timeoutUs)
+    {
+        return WaitAcquire(slotIndex, sequence, mode, timeoutUs, true);
+    }
+
+    // Consumer: AcquireRead, waiting up to timeoutUs for a frame to complete
+    bool WaitAcquireRead(uint64_t& slotIndex, uint64_t& sequence, TSRWaitMode mode, uint64_t timeoutUs)
+    {
+        return WaitAcquire(slotIndex, sequence, mode, timeoutUs, false);
+    }
+
+    // True once no slot holds a frame that still needs consuming, by any active consumer on the producer side and by
+    // us on a registered consumer side
+    bool IsDrained() { return CountReady() == 0; }
+
+    // Producer: only write into the first count slots (clamped to [1, slot count]). Frames already in the other slots
+    // are still consumed, so the count can change at any time.
+    void SetActiveSlotCount(uint64_t count);
+
+    uint64_t GetActiveSlotCount() const { return m_ActiveSlots; }
+
+    // Slots holding a frame that was not released yet, including the ones the consumers are reading. Counted like
+    // IsDrained.
+    uint64_t CountReady();
+
+    // Time from the last acquire to the wait call after it, the frame work of this side without the waits.
+    // Only tracked by the wait calls, the consumer also stores it in the control block for the producer.
+    uint64_t GetFrameBusyNs() const { return m_FrameBusyNs; }
+
+    // Whether the last acquire had to wait for the peer, or was preceded by wait calls that timed out
+    bool WasLastAcquireStalled() const { return m_LastAcquireStalled; }
+
+    bool HasAcquired() const { return m_AcquiredSlot != INVALID_SLOT; }
+
+    uint64_t GetAcquiredSlot() const { return m_AcquiredSlot; }
+
+    uint64_t GetAcquiredSequence() const { return m_AcquiredSequence; }
+
+    uint64_t GetHead() const { return m_Head; }
+
+    uint64_t GetTail() const { return m_Tail; }
+
+    const TSRRingStats& GetStats() const { return m_Stats; }
+
+    const TSRWaitStats& GetWaitStats() const { return m_WaitStats; }
+
+private:
+    bool WaitAcquire(uint64_t& slotIndex, uint64_t& sequence, TSRWaitMode mode, uint64_t timeoutUs, bool forWrite);
+
+    bool AcquireLatest(uint64_t& slotIndex, uint64_t& sequence);
+
+    // Producer: whether every active consumer released the frame we last published in the slot
+    bool IsSlotFree(uint64_t slotIndex);
+
+    // Whether the consumers in the mask still have to release the frame in the slot
+    bool IsSlotPending(uint64_t slotIndex, uint32_t consumers);
+
+    // Consumer: release the frame on our lane
+    void ReleaseSlot(uint64_t slotIndex, uint64_t sequence);
+
+    // Consumer: register again if the producer reclaimed our slots, returns true if it did
+    bool Rejoin();
+
+    TSRTransport* m_pTransport = nullptr;
+
+    // Per-slot value this side last signaled, the slot is not ours to touch again until the peer moves past it
+    std::vector<uint64_t> m_SlotFloor;
+    uint64_t              m_ActiveSlots;
+    uint32_t              m_Consumer;
+    uint32_t              m_ReleaseLane;
+    bool                  m_Registered    = false;
+    TSRConsumePolicy      m_ConsumePolicy = TSRConsumePolicy::EveryFrame;
+    uint64_t              m_LastSkipCount = 0;
+
+    // Frame pacing, see GetFrameBusyNs
+    uint64_t m_LastAcquireNs      = 0;
+    uint64_t m_FrameBusyNs        = 0;
+    bool     m_PendingStall       = false;
+    bool     m_LastAcquireStalled = false;
+    uint64_t m_LastBeatNs         = 0;
+
+    uint64_t     m_Head             = 0;
+    uint64_t     m_Tail             = 0;
+    uint64_t     m_AcquiredSlot     = INVALID_SLOT;
+    uint64_t     m_AcquiredSequence = 0;
+    TSRRingStats m_Stats            = {};
+    TSRWaitStats m_WaitStats        = {};
+};
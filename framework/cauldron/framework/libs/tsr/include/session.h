@@ -0,0 +1,278 @@
+#pragma once
+
+#include "ring.h"
+#include "shm.h"
+#include "timing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Most renderer sessions one upscaler serves
+constexpr uint32_t TSR_MAX_SESSIONS = 16;
+
+// What a renderer announces about its session
+struct TSRSessionInfo
+{
+    char     name[64];      // Shared name of the session's slots, null terminated
+    uint64_t slotCount;
+    uint64_t manifestHash;
+    uint32_t renderWidth;
+    uint32_t renderHeight;
+    uint64_t deadlineUs;    // Time a published frame may wait for the upscaler, for the Deadline policy (0 for none)
+};
+
+// Sessions announced to an upscaler, in shared memory named after the upscaler. Every renderer claims an entry for as
+// long as it runs, the upscaler lists the entries to find the sessions to open.
+class TSRSessionDirectory
+{
+public:
+    static constexpr uint32_t INVALID_ENTRY = UINT32_MAX;
+
+    // An announced session. The generation changes with every announcement, so a reused entry is a new session.
+    struct Entry
+    {
+        uint32_t       index;
+        uint64_t       generation;
+        TSRSessionInfo info;
+    };
+
+    // Create (or open, if shouldCreate is false) the directory. Returns false on failure.
+    bool Open(const std::string& name, bool shouldCreate);
+
+    void Close() { m_Memory.Close(); }
+
+    bool IsOpen() const { return m_Memory.IsOpen(); }
+
+    // Renderer: claim an entry for the session, returns its index or INVALID_ENTRY if the directory is full
+    uint32_t Announce(const TSRSessionInfo& info);
+
+    // Renderer: give the entry back
+    void Withdraw(uint32_t index);
+
+    // Upscaler: the announced sessions
+    std::vector<Entry> List();
+
+private:
+    static constexpr uint32_t TSR_SESSIONS_MAGIC   = 0x53535354;  // "TSSS"
+    static constexpr uint32_t TSR_SESSIONS_VERSION = 1;
+
+    enum EntryState : uint32_t
+    {
+        ENTRY_FREE = 0,
+        ENTRY_CLAIMED,  // Being filled in
+        ENTRY_ACTIVE,
+    };
+
+    struct alignas(64) SharedEntry
+    {
+        std::atomic<uint32_t> state;
+        std::atomic<uint64_t> generation;
+        TSRSessionInfo        info;
+    };
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t              version;
+        std::atomic<uint64_t> generation;  // Last generation handed out
+    };
+
+    SharedEntry* GetEntry(uint32_t index) const;
+
+    TSRSharedMemory m_Memory;
+    Header*         m_pHeader = nullptr;
+};
+
+// Which session the upscaler serves next
+enum class TSRSchedulePolicy : uint32_t
+{
+    RoundRobin = 0,  // The next session after the last one served that has a frame, every session gets its turn
+    Deadline,        // The frame closest to (or furthest past) its deadline, sessions without one go last
+};
+
+// Counters kept per session by the scheduler
+struct TSRSessionStats
+{
+    uint64_t     served          = 0;
+    uint64_t     missedDeadlines = 0;  // Frames picked after their deadline
+    TSRHistogram waitUs;               // Time from a frame being published to the scheduler picking it
+};
+
+// Orders the frames of several sessions for one consumer. Every session is a ring the scheduler acquires frames on,
+// the caller releases the picked frame through the ring as usual. Frames acquired on the other sessions stay claimed
+// until their turn comes.
+class TSRSessionScheduler
+{
+public:
+    TSRSessionScheduler(TSRSchedulePolicy policy)
+        : m_Policy(policy)
+    {
+    }
+
+    void AddSession(uint32_t id, TSRSlotRing* pRing, uint64_t deadlineUs);
+
+    void RemoveSession(uint32_t id);
+
+    // Pick the session to serve next and acquire its frame, returns false if no session has a frame
+    bool Next(uint32_t& id, uint64_t& slotIndex, uint64_t& sequence);
+
+    // Next, checking again every pollUs until timeoutUs ran out
+    bool WaitNext(uint32_t& id, uint64_t& slotIndex, uint64_t& sequence, uint64_t timeoutUs, uint64_t pollUs = 100);
+
+    TSRSchedulePolicy GetPolicy() const { return m_Policy; }
+
+    size_t GetSessionCount() const { return m_Sessions.size(); }
+
+    // Counters of the session, or nullptr if there is no such session
+    const TSRSessionStats* GetStats(uint32_t id) const;
+
+private:
+    struct Session
+    {
+        uint32_t        id;
+        TSRSlotRing*    pRing;
+        uint64_t        deadlineUs;
+        uint64_t        pendingSequence = UINT64_MAX;  // Frame acquired but not picked yet, and when we first saw it
+        uint64_t        pendingSeenNs   = 0;
+        TSRSessionStats stats;
+    };
+
+    // When the acquired frame of the session was published
+    uint64_t GetPublishTime(Session& session, uint64_t slotIndex, uint64_t sequence);
+
+    TSRSchedulePolicy    m_Policy;
+    std::vector<Session> m_Sessions;
+    size_t               m_Cursor = 0;  // Session served last
+};
+
+// Sessions an upscaler opened from the directory, together with whatever it keeps per session (transport, contexts,
+// history, ...), created on announcement and dropped on withdrawal.
+template <typename Session>
+class TSRSessionRegistry
+{
+public:
+    // Open the session, or return null to reject it (until it is announced again)
+    using OpenFunction = std::function<std::unique_ptr<Session>(uint32_t id, const TSRSessionInfo& info)>;
+
+    // Called before a session is dropped
+    using CloseFunction = std::function<void(uint32_t id, Session& session)>;
+
+    TSRSessionRegistry(OpenFunction open, CloseFunction close = nullptr)
+        : m_Open(std::move(open))
+        , m_Close(std::move(close))
+    {
+    }
+
+    ~TSRSessionRegistry()
+    {
+        for (auto& entry : m_Sessions)
+            CloseSession(entry.first, entry.second);
+    }
+
+    // Open the sessions announced in the directory since the last update and drop the withdrawn ones
+    void Update(TSRSessionDirectory& directory)
+    {
+        std::vector<TSRSessionDirectory::Entry> entries = directory.List();
+
+        // Withdrawn, or replaced by a new announcement in the same entry
+        for (auto it = m_Sessions.begin(); it != m_Sessions.end();)
+        {
+            bool announced = false;
+            for (const TSRSessionDirectory::Entry& entry : entries)
+                announced |= entry.index == it->first && entry.generation == it->second.generation;
+
+            if (announced)
+            {
+                ++it;
+                continue;
+            }
+
+            CloseSession(it->first, it->second);
+            it = m_Sessions.erase(it);
+        }
+
+        for (const TSRSessionDirectory::Entry& entry : entries)
+        {
+            auto rejected = m_Rejected.find(entry.index);
+            if (m_Sessions.count(entry.index) || (rejected != m_Rejected.end() && rejected->second == entry.generation))
+                continue;
+
+            std::unique_ptr<Session> pSession = m_Open(entry.index, entry.info);
+            if (!pSession)
+            {
+                m_Rejected[entry.index] = entry.generation;
+                continue;
+            }
+
+            m_Sessions[entry.index] = {entry.generation, std::move(pSession)};
+        }
+    }
+
+    Session* Find(uint32_t id)
+    {
+        auto it = m_Sessions.find(id);
+        return it != m_Sessions.end() ? it->second.pSession.get() : nullptr;
+    }
+
+    size_t GetCount() const { return m_Sessions.size(); }
+
+    template <typename Function>
+    void ForEach(Function function)
+    {
+        for (auto& entry : m_Sessions)
+            function(entry.first, *entry.second.pSession);
+    }
+
+private:
+    struct OpenSession
+    {
+        uint64_t                 generation;
+        std::unique_ptr<Session> pSession;
+    };
+
+    void CloseSession(uint32_t id, OpenSession& session)
+    {
+        if (m_Close)
+            m_Close(id, *session.pSession);
+    }
+
+    OpenFunction                    m_Open;
+    CloseFunction                   m_Close;
+    std::map<uint32_t, OpenSession> m_Sessions;
+    std::map<uint32_t, uint64_t>    m_Rejected;  // Generation the open function rejected, per entry
+};
+
+// Synthetic renderer sessions on host transports served by one consumer, for comparing schedule policies without a GPU
+struct TSRSessionSimSession
+{
+    double   frameUs    = 16667.0;  // Frame interval of the renderer
+    uint64_t deadlineUs = 0;        // See TSRSessionInfo
+};
+
+struct TSRSessionSimParams
+{
+    std::vector<TSRSessionSimSession> sessions;
+    TSRSchedulePolicy                 policy     = TSRSchedulePolicy::RoundRobin;
+    double                            upscaleUs  = 4000.0;  // Consumer work per frame
+    uint64_t                          slots      = 3;       // Slots per session
+    uint32_t                          durationMs = 2000;
+};
+
+struct TSRSessionSimResult
+{
+    struct Session
+    {
+        uint64_t        produced;
+        TSRSessionStats stats;
+    };
+
+    std::vector<Session> sessions;
+    double               framesPerSecond;  // Frames served over all sessions
+};
+
+TSRSessionSimResult TSRSimulateSessions(const TSRSessionSimParams& params);
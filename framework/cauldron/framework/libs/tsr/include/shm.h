@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef HANDLE TSRNativeHandle;
+#else
+typedef int TSRNativeHandle;
+#endif
+
+// Named shared memory region, backed by a file mapping on Windows and shm_open on POSIX
+class TSRSharedMemory
+{
+public:
+    TSRSharedMemory() = default;
+    ~TSRSharedMemory() { Close(); }
+
+    TSRSharedMemory(const TSRSharedMemory&)            = delete;
+    TSRSharedMemory& operator=(const TSRSharedMemory&) = delete;
+
+    // Create (or open, if shouldCreate is false) the named region and map it. Returns false on failure.
+    bool Open(const std::string& name, size_t size, bool shouldCreate);
+
+    // Unmap the region, and unlink the name if we created it
+    void Close();
+
+    bool IsOpen() const { return m_pView != nullptr; }
+
+    uint8_t* Data() const { return m_pView; }
+
+    size_t Size() const { return m_Size; }
+
+private:
+    std::string     m_Name;
+    uint8_t*        m_pView   = nullptr;
+    size_t          m_Size    = 0;
+    bool            m_IsOwner = false;
+    TSRNativeHandle m_Handle  = {};
+};
+
+// Read-only mapping of a whole file, for reading large files without copying them
+class TSRMappedFile
+{
+public:
+    TSRMappedFile() = default;
+    ~TSRMappedFile() { Close(); }
+
+    TSRMappedFile(const TSRMappedFile&)            = delete;
+    TSRMappedFile& operator=(const TSRMappedFile&) = delete;
+
+    // Map the file. Returns false if it can't be opened, an empty file can't be mapped either.
+    bool Open(const std::string& path);
+
+    void Close();
+
+    bool IsOpen() const { return m_pView != nullptr; }
+
+    const uint8_t* Data() const { return m_pView; }
+
+    size_t Size() const { return m_Size; }
+
+private:
+    uint8_t*        m_pView  = nullptr;
+    size_t          m_Size   = 0;
+    TSRNativeHandle m_Handle = {};
+#if defined(_WIN32)
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+#endif
+};
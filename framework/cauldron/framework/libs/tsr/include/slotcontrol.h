@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TSRSlotControllerParams
+{
+    uint64_t minSlots           = 2;
+    uint64_t maxSlots           = 10;     // At most the slots the transport was created with
+    double   ewmaWeight         = 0.05;   // Weight of the newest frame time in the moving averages
+    double   consumerBoundRatio = 1.05;   // The consumer is the bottleneck once it is this much slower than the producer,
+                                          // stalls only add slots while it is no slower at all
+    uint32_t growCooldownFrames = 30;     // Frames after a change before a stall may add another slot
+    uint32_t shrinkWindowFrames = 240;    // Frames a slot has to stay unused, without a stall, before it is taken away
+};
+
+enum class TSRSlotReason : uint32_t
+{
+    Stall = 0,      // The producer waited for a slot while the consumer keeps up on average, more slots absorb the jitter
+    Unused,         // A slot stayed unused for the whole window, it only adds latency
+    ConsumerBound,  // The consumer is the bottleneck, extra slots only fill up and add latency
+};
+
+const char* TSRSlotReasonName(TSRSlotReason reason);
+
+// A change of the active slot count, with the measurements it was based on
+struct TSRSlotDecision
+{
+    uint64_t      frame;
+    uint64_t      fromSlots;
+    uint64_t      toSlots;
+    TSRSlotReason reason;
+    double        producerFrameUs;  // Moving averages at the time of the decision
+    double        consumerFrameUs;
+    uint64_t      peakOccupancy;    // Most slots holding frames at once since the previous decision
+};
+
+struct TSRSlotControllerStats
+{
+    uint64_t frames              = 0;
+    uint64_t stalls              = 0;
+    uint64_t consumerBoundStalls = 0;  // Stalls no slot count could have avoided
+    uint64_t grows               = 0;
+    uint64_t shrinks             = 0;
+    uint64_t slotFrames          = 0;  // Sum of the active slot count over the frames
+
+    double AverageSlots() const { return frames ? static_cast<double>(slotFrames) / frames : 0.0; }
+};
+
+// Picks how many slots the producer writes into, looking for the fewest slots (the least queueing latency) that don't
+// stall the producer.
+//
+// The producer only stalls for lack of slots when the consumer is as fast on average but its frames don't line up
+// with the producer's, a stall then adds a slot. A slot nobody used for a whole window is taken away again. When the
+// consumer is slower on average the queue fills up whatever its size, so the slots shrink towards the minimum
+// instead: the producer runs at the consumer's rate either way, with less latency.
+class TSRSlotController
+{
+public:
+    TSRSlotController(const TSRSlotControllerParams& params, uint64_t initialSlots);
+
+    // Feed a producer frame and get the slot count to use from now on.
+    //   producerBusyNs  frame work of the producer, without waits (TSRSlotRing::GetFrameBusyNs)
+    //   consumerBusyNs  the same for the consumer (TSRControlBlock::consumerBusyNs), 0 if unknown
+    //   occupancy       slots holding frames right after the producer acquired its slot (TSRSlotRing::CountReady)
+    //   stalled         the producer had to wait for its slot (TSRSlotRing::WasLastAcquireStalled)
+    uint64_t Update(uint64_t producerBusyNs, uint64_t consumerBusyNs, uint64_t occupancy, bool stalled);
+
+    uint64_t GetActiveSlots() const { return m_ActiveSlots; }
+
+    double GetProducerFrameUs() const { return m_ProducerUs; }
+
+    double GetConsumerFrameUs() const { return m_ConsumerUs; }
+
+    // Decisions made since the previous call, oldest first
+    std::vector<TSRSlotDecision> TakeDecisions();
+
+    const TSRSlotControllerStats& GetStats() const { return m_Stats; }
+
+private:
+    void Change(uint64_t slots, TSRSlotReason reason);
+
+    bool IsConsumerSlower(double ratio) const { return m_ConsumerUs > 0.0 && m_ConsumerUs > m_ProducerUs * ratio; }
+
+    TSRSlotControllerParams      m_Params;
+    uint64_t                     m_ActiveSlots;
+    double                       m_ProducerUs        = 0.0;
+    double                       m_ConsumerUs        = 0.0;
+    uint64_t                     m_FramesSinceChange = 0;
+    uint64_t                     m_QuietFrames       = 0;  // Frames without a stall since the last stall or change
+    uint64_t                     m_PeakOccupancy     = 0;  // Over the quiet frames
+    TSRSlotControllerStats       m_Stats             = {};
+    std::vector<TSRSlotDecision> m_Decisions;
+};
+
+// Producer/consumer frame loop around a ring of slots, for tuning the controller without a GPU
+struct TSRSlotSimParams
+{
+    uint32_t frames         = 4000;    // Long enough for the controller to settle, it drops a slot per shrink window
+    double   producerUs     = 8000.0;  // Mean frame work of either side, the consumer is the bottleneck by default
+    double   consumerUs     = 9000.0;
+    double   producerJitter = 0.25;    // Frame work varies uniformly by this fraction of the mean
+    double   consumerJitter = 0.25;
+    uint64_t slots          = 10;      // Slots of the ring
+    bool     adaptive       = true;    // Run the controller, or keep all slots active
+    uint32_t seed           = 1;
+
+    TSRSlotControllerParams controller;
+};
+
+struct TSRSlotSimResult
+{
+    double                       averageSlots;      // Active slots averaged over the frames
+    double                       latencyUs;         // Mean time from a frame being published to the consumer picking it up
+    double                       producerFrameUs;   // Mean interval between producer frames, including stalls
+    double                       stallUs;           // Mean producer stall per frame
+    TSRSlotControllerStats       stats;
+    std::vector<TSRSlotDecision> decisions;
+};
+
+TSRSlotSimResult TSRSimulateSlots(const TSRSlotSimParams& params);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TSRHostPlane;
+
+// One bit per fixed-size tile of a width x height grid, set for the tiles which changed since the previous frame
+class TSRTileMap
+{
+public:
+    void Resize(uint32_t width, uint32_t height, uint32_t tileSize);
+
+    void SetAll(bool dirty);
+
+    void Set(uint32_t tileX, uint32_t tileY) { m_Words[Index(tileX, tileY) / 64] |= 1ull << (Index(tileX, tileY) % 64); }
+
+    bool Test(uint32_t tileX, uint32_t tileY) const { return (m_Words[Index(tileX, tileY) / 64] >> (Index(tileX, tileY) % 64)) & 1; }
+
+    uint32_t GetTileSize() const { return m_TileSize; }
+
+    uint32_t GetTilesX() const { return m_TilesX; }
+
+    uint32_t GetTilesY() const { return m_TilesY; }
+
+    uint64_t GetTileCount() const { return static_cast<uint64_t>(m_TilesX) * m_TilesY; }
+
+    uint64_t CountDirty() const;
+
+    // Bitmap as stored in a slot, GetBitmapSize bytes
+    const uint64_t* GetWords() const { return m_Words.data(); }
+
+    uint64_t* GetWords() { return m_Words.data(); }
+
+    uint64_t GetBitmapSize() const { return m_Words.size() * sizeof(uint64_t); }
+
+    static uint64_t GetBitmapSize(uint32_t width, uint32_t height, uint32_t tileSize);
+
+private:
+    uint64_t Index(uint32_t tileX, uint32_t tileY) const { return static_cast<uint64_t>(tileY) * m_TilesX + tileX; }
+
+    uint32_t              m_TileSize = 0;
+    uint32_t              m_TilesX   = 0;
+    uint32_t              m_TilesY   = 0;
+    std::vector<uint64_t> m_Words;
+};
+
+// CPU reference of the renderer side tile classification.
+// A tile is dirty if the hash of its color texels changed since the previous frame, or if any of its motion vectors
+// is longer than the threshold (the upscaler reprojects those tiles even when they look the same).
+class TSRTileClassifier
+{
+public:
+    TSRTileClassifier(uint32_t width, uint32_t height, uint32_t tileSize, float motionThreshold = 0.0f);
+
+    // Classify a frame. pMotion is optional and holds at least two floats per texel.
+    // The first frame after construction or Reset has every tile dirty.
+    const TSRTileMap& Classify(const TSRHostPlane& color, const TSRHostPlane* pMotion);
+
+    // Make the next frame a full frame, when the consumer lost the frame the next delta would be applied to
+    void Reset() { m_HasHistory = false; }
+
+    const TSRTileMap& GetTileMap() const { return m_TileMap; }
+
+private:
+    uint32_t              m_Width;
+    uint32_t              m_Height;
+    float                 m_MotionThreshold;
+    bool                  m_HasHistory = false;
+    TSRTileMap            m_TileMap;
+    std::vector<uint64_t> m_Hashes;
+};
+
+// Bytes a delta transfer moves compared to full frames, over a sequence of frames
+struct TSRTileDeltaStats
+{
+    uint64_t frames     = 0;
+    uint64_t tiles      = 0;  // Tiles classified
+    uint64_t dirtyTiles = 0;
+    uint64_t fullBytes  = 0;  // Texel bytes of full frames
+    uint64_t deltaBytes = 0;  // Texel bytes of the dirty tiles plus the tile maps
+
+    double SavedRatio() const { return fullBytes ? 1.0 - static_cast<double>(deltaBytes) / fullBytes : 0.0; }
+};
+
+// Run the classifier over recorded frames (pMotionFrames may be null) and count what delta transfers would have moved
+TSRTileDeltaStats TSRMeasureTileDelta(
+    const TSRHostPlane* pColorFrames, const TSRHostPlane* pMotionFrames, size_t frameCount, uint32_t tileSize, float motionThreshold = 0.0f);
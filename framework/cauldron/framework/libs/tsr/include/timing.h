@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Monotonic time in nanoseconds, comparable across processes on the same machine
+uint64_t tsr_now_ns();
+
+// Sleep until tsr_now_ns reaches the deadline. OS sleeps overshoot by up to a scheduler tick, so the last stretch is
+// spent yielding instead.
+void tsr_sleep_until_ns(uint64_t deadlineNs);
+
+// CPU time consumed by the calling thread, in nanoseconds
+uint64_t tsr_thread_cpu_ns();
+
+// Log2-bucketed histogram of durations in microseconds. Bucket i counts values in [2^(i-1), 2^i), bucket 0 counts 0.
+struct TSRHistogram
+{
+    static constexpr size_t BUCKET_COUNT = 24;
+
+    uint64_t buckets[BUCKET_COUNT] = {};
+    uint64_t count                 = 0;
+    uint64_t total                 = 0;
+    uint64_t max                   = 0;
+
+    void Add(uint64_t valueUs);
+
+    void Reset() { *this = TSRHistogram(); }
+
+    // Fold the values of another histogram in
+    void Merge(const TSRHistogram& other);
+
+    double Mean() const { return count ? static_cast<double>(total) / count : 0.0; }
+
+    // Upper bound of the bucket holding the given percentile (0..1)
+    uint64_t Percentile(double percentile) const;
+};
@@ -1,8 +1,12 @@
 #pragma once
+#include "transport_d3d12.h"
+#include "ring.h"
+#include "transferstats.h"
+
 #include <d3d12.h>
 #include <tuple>
-#include <array>
 #include <memory>
+#include <vector>
 
 struct TSRGraphicsResource
 {
@@ -12,51 +16,197 @@ struct TSRGraphicsResource
     DXGI_FORMAT           format;
 };
 
-typedef std::array<const TSRGraphicsResource*, 3> FSRResources;
+// Resources of a frame, indexed like the manifest. A null resource is left out of the frame.
+typedef std::vector<TSRGraphicsResource> TSRResources;
+
+// Where the transfers execute
+enum class TSRCopyMode
+{
+    Graphics = 0,  // On the frame's graphics command list
+    CopyQueue,     // On a dedicated copy queue, handed over to and from the graphics queue with fences
+};
+
+// The graphics queue waits for the copies before anything of the next frame is queued, so CopyQueue does not overlap
+// them with rendering (tsr-transfer-sim: "copy queue" against "copy queue, split frame"). The render module only uses
+// Graphics until the next frame's independent work can be submitted ahead of the hand-back.
 
 class TSROps
 {
 public:
-    TSROps(const wchar_t* pSharedName, ID3D12Device* pDevice, ID3D12CommandQueue* pQueue, uint64_t bufferCount)
-        : m_pSharedName(pSharedName)
-        , m_pDevice(pDevice)
-        , m_pQueue(pQueue)
+    // consumerCount upscalers read the frames of one renderer, consumer is the index of this upscaler among them
+    TSROps(const wchar_t*      pSharedName,
+           ID3D12Device*       pDevice,
+           ID3D12CommandQueue* pQueue,
+           uint64_t            bufferCount,
+           TSRCopyMode         copyMode      = TSRCopyMode::Graphics,
+           uint32_t            consumerCount = 1,
+           uint32_t            consumer      = 0)
+        : m_pTransport(std::make_unique<TSRD3D12Transport>(pSharedName, pDevice, pQueue, bufferCount, consumerCount))
+        , m_Ring(m_pTransport.get(), consumer)
         , m_BufferCount(bufferCount)
+        , m_CopyMode(copyMode)
+        , m_pGraphicsQueue(pQueue)
     {
+        if (m_CopyMode == TSRCopyMode::CopyQueue)
+            CreateCopyQueue();
+        CreateTimestamps();
     }
     ~TSROps();
 
-    enum class BufferState : UINT64
-    {
-        IDLE = 0,
-        READY,
-    };
+    using BufferState = TSRBufferState;
+
+    bool bufferStateMatches(uint64_t bufferIndex, BufferState state) { return m_pTransport->slotStateMatches(bufferIndex, state); }
+
+    bool bufferStateMatchesAll(BufferState state) { return m_pTransport->slotStateMatchesAll(state); }
+
+    // Lay the shared buffers out as described by the manifest. The manifest must be finalized.
+    // Opening them registers the upscaler, the renderer waits for its releases until the TSROps is destroyed.
+    void CreateSharedBuffers(const TSRManifest& manifest, bool shouldCreate = false);
+
+    const TSRManifest& GetManifest() const { return m_Manifest; }
+
+    // Upscaler: set the resources it reads, the renderer leaves the others out of the shared buffers
+    void SetConsumedResources(uint64_t resourceMask);
 
-    bool bufferStateMatches(uint64_t bufferIndex, BufferState state);
+    // Resources the render targets of the slots are placed in the shared heaps for (see TSRPlacedSlots). They are not
+    // copied, the transfers only hand the slot over. Both processes have to alias the same resources.
+    void SetAliasedResources(uint64_t resourceMask);
 
-    bool bufferStateMatchesAll(BufferState state);
+    uint64_t GetAliasedResources() const { return m_AliasedResources; }
 
-    void CreateSharedBuffers(FSRResources pResources, bool shouldCreate = false);
+    // Resources carried by the last transfer, copied or aliased
+    uint64_t GetTransferredResources() const { return m_TransferredResources; }
 
-    void TransferToSharedBuffer(FSRResources pResources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList)
+    // Renderer: state of the frame, stored in the slot header by the next TransferToSharedBuffer
+    void SetFrameMetadata(const TSRFrameMetadata& metadata) { m_FrameMetadata = metadata; }
+
+    // Upscaler: state of the frame read by the last TransferFromSharedBuffer
+    const TSRFrameMetadata& GetFrameMetadata() const { return m_FrameMetadata; }
+
+    // Upscaler: manifest hash the renderer stored with the frame read by the last TransferFromSharedBuffer
+    uint64_t GetSlotManifestHash() const { return m_SlotManifestHash; }
+
+    // Renderer: claim a free shared buffer for the next frame, waiting up to timeoutUs. Returns false if all of them are in use.
+    bool AcquireBufferForWrite(uint64_t& bufferIndex, TSRWaitMode mode = TSRWaitMode::Poll, uint64_t timeoutUs = 0)
+    {
+        uint64_t startNs  = tsr_now_ns();
+        uint64_t sequence = 0;
+        return EndAcquire(startNs, m_Ring.WaitAcquireWrite(bufferIndex, sequence, mode, timeoutUs));
+    }
+
+    // Upscaler: claim the oldest shared buffer holding a frame, waiting up to timeoutUs. Returns false if there is none.
+    bool AcquireBufferForRead(uint64_t& bufferIndex, TSRWaitMode mode = TSRWaitMode::Poll, uint64_t timeoutUs = 0)
     {
-        PerformTransfer(pResources, bufferIndex, pCmdList, true);
+        uint64_t startNs  = tsr_now_ns();
+        uint64_t sequence = 0;
+        return EndAcquire(startNs, m_Ring.WaitAcquireRead(bufferIndex, sequence, mode, timeoutUs));
     }
 
-    void TransferFromSharedBuffer(FSRResources pResources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList)
+    void TransferToSharedBuffer(const TSRResources& resources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList)
     {
-        PerformTransfer(pResources, bufferIndex, pCmdList, false);
+        PerformTransfer(resources, bufferIndex, pCmdList, true);
     }
 
+    void TransferFromSharedBuffer(const TSRResources& resources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList)
+    {
+        PerformTransfer(resources, bufferIndex, pCmdList, false);
+    }
+
+    // Renderer: only write into the first count shared buffers, see TSRSlotRing::SetActiveSlotCount
+    void SetActiveBufferCount(uint64_t count) { m_Ring.SetActiveSlotCount(count); }
+
+    // Upscaler: which completed shared buffer AcquireBufferForRead picks
+    void SetConsumePolicy(TSRConsumePolicy policy) { m_Ring.SetConsumePolicy(policy); }
+
+    // Shared buffers holding a frame an upscaler (this one, on the upscaler) did not release yet
+    uint64_t GetReadyBufferCount() { return m_Ring.CountReady(); }
+
+    // Renderer: true once every upscaler released every frame
+    bool IsDrained() { return m_Ring.IsDrained(); }
+
+    // Queue the transfer work of the frame behind it, call once the frame's graphics command lists were executed
+    void Submit();
+
+    TSRCopyMode GetCopyMode() const { return m_CopyMode; }
+
+    TSRTransport* GetTransport() const { return m_pTransport.get(); }
+
+    const TSRSlotRing& GetRing() const { return m_Ring; }
+
+    TSRSlotRing& GetRing() { return m_Ring; }
+
+    // Where the time of the transfers went since the last reset. The GPU timings of a transfer come back once its slot
+    // does, a few frames later, and only if the queue doing the copies has timestamps.
+    const TSRTransferStats& GetTransferStats() const { return m_Stats; }
+
+    void ResetTransferStats() { m_Stats.Reset(); }
+
+    bool HasGpuTimings() const { return m_pTimestampHeap != nullptr; }
+
 private:
-    const wchar_t*      m_pSharedName = nullptr;
-    ID3D12Device*       m_pDevice     = nullptr;
-    ID3D12CommandQueue* m_pQueue      = nullptr;
-    uint64_t            m_BufferCount = 0;
+    std::unique_ptr<TSRD3D12Transport> m_pTransport;
+    TSRSlotRing                        m_Ring;
+    uint64_t                           m_BufferCount          = 0;
+    TSRManifest                        m_Manifest;
+    uint64_t                           m_ConsumedResources    = UINT64_MAX;
+    uint64_t                           m_AliasedResources     = 0;
+    uint64_t                           m_TransferredResources = 0;
+    TSRFrameMetadata                   m_FrameMetadata        = {};
+    uint64_t                           m_SlotManifestHash     = 0;
+    TSRTransferStats                   m_Stats;
+    uint64_t                           m_AcquireWaitNs        = 0;  // Wait of the slot being acquired, over the calls that timed out
+
+    // Copy queue mode: per slot command lists, so recording a transfer never waits on the previous one
+    struct CopyContext
+    {
+        ID3D12CommandAllocator*     pPrepareAllocator  = nullptr;
+        ID3D12CommandAllocator*     pCopyAllocator     = nullptr;
+        ID3D12CommandAllocator*     pRestoreAllocator  = nullptr;
+        ID3D12GraphicsCommandList2* pPrepareList       = nullptr;  // Graphics queue, hands the resources to the copy queue
+        ID3D12GraphicsCommandList2* pCopyList          = nullptr;
+        ID3D12GraphicsCommandList2* pRestoreList       = nullptr;  // Graphics queue, back to the state the render modules expect
+        uint64_t                    fenceValue         = 0;        // Graphics fence value once the restore list is done
+    };
+
+    TSRCopyMode              m_CopyMode           = TSRCopyMode::Graphics;
+    ID3D12CommandQueue*      m_pGraphicsQueue     = nullptr;
+    ID3D12CommandQueue*      m_pCopyQueue         = nullptr;
+    ID3D12Fence*             m_pGraphicsFence     = nullptr;  // Graphics -> copy queue
+    ID3D12Fence*             m_pCopyFence         = nullptr;  // Copy -> graphics queue
+    uint64_t                 m_GraphicsFenceValue = 0;
+    uint64_t                 m_CopyFenceValue     = 0;
+    HANDLE                   m_FenceEvent         = nullptr;
+    std::vector<CopyContext> m_CopyContexts;
+    CopyContext*             m_pPendingCopy       = nullptr;
+
+    // GPU timestamps of the transfers, TSR_TRANSFER_MAX_TIMESTAMPS per slot. A slot only comes back once the peer is
+    // done with it, which is after our transfer into it ran, so they are read when the slot is transferred again.
+    struct SlotTiming
+    {
+        bool                pending = false;
+        std::vector<size_t> copiedPlanes;
+    };
+
+    ID3D12QueryHeap*        m_pTimestampHeap     = nullptr;
+    ID3D12Resource*         m_pTimestampReadback = nullptr;
+    const uint64_t*         m_pTimestamps        = nullptr;  // Persistently mapped readback
+    uint64_t                m_TimestampFrequency = 0;
+    std::vector<SlotTiming> m_SlotTimings;
+
+    void CreateCopyQueue();
+
+    void CreateTimestamps();
+
+    void WriteTimestamp(ID3D12GraphicsCommandList2* pCmdList, uint64_t bufferIndex, size_t index);
+
+    // Fold the timings of the slot's previous transfer in
+    void CollectTimestamps(uint64_t bufferIndex);
+
+    bool EndAcquire(uint64_t startNs, bool acquired);
 
-    std::tuple<ID3D12Resource*, ID3D12Fence*> p_SharedBuffer[TSR_SHARED_BUFFER_MAX];
+    CopyContext& BeginCopy(uint64_t bufferIndex);
 
-    size_t CalculateTotalSize(FSRResources pResources);
+    void SubmitCopy();
 
-    void PerformTransfer(FSRResources pResources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList, bool toSharedBuffer);
+    void PerformTransfer(const TSRResources& resources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList, bool toSharedBuffer);
 };
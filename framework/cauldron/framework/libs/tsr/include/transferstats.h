@@ -0,0 +1,52 @@
+#pragma once
+
+#include "manifest.h"
+#include "timing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GPU timestamps written around a transfer, on the list doing the copies:
+//   0            before the transitions into the copy state
+//   1            once they are done
+//   2 + k        after the copy of the k-th copied plane
+//   2 + copies   after the transitions back
+static constexpr size_t TSR_TRANSFER_MAX_TIMESTAMPS = TSR_MANIFEST_MAX_RESOURCES + 3;
+
+// Counters of one plane of the manifest
+struct TSRPlaneStats
+{
+    uint64_t     copies  = 0;  // Transfers the plane was copied in
+    uint64_t     aliased = 0;  // Transfers the plane was handed over in place (zero copy)
+    uint64_t     bytes   = 0;  // Bytes copied
+    TSRHistogram copyUs;       // GPU time of the copy, if the queue has timestamps
+};
+
+// Where the time of one side of the handoff goes, stage by stage. Kept by TSROps in either direction.
+struct TSRTransferStats
+{
+    uint64_t     transfers = 0;
+    uint64_t     bytes     = 0;
+    uint64_t     gpuFrames = 0;  // Transfers the GPU timings came back for
+    TSRHistogram acquireUs;      // Slot wait: the renderer waiting for a free slot, the upscaler for a frame
+    TSRHistogram recordUs;       // CPU time recording the transfer
+    TSRHistogram submitUs;       // CPU time queueing the transfer and the fence signals behind it
+    TSRHistogram barrierUs;      // GPU time of the transitions around the copies
+    TSRHistogram copyUs;         // GPU time of all copies of a transfer
+    TSRHistogram gpuUs;          // GPU time from the first timestamp to the last
+
+    std::vector<TSRPlaneStats> planes;  // Indexed like the manifest
+
+    void Reset() { *this = TSRTransferStats(); }
+
+    // Plane counters, the CPU side of recording a transfer
+    void AddPlane(size_t plane, uint64_t bytes, bool aliased);
+
+    // GPU timings of a transfer from its timestamps (see TSR_TRANSFER_MAX_TIMESTAMPS), in ticks of frequency per
+    // second. copiedPlanes are the manifest indices of the copied planes, in the order they were copied.
+    void AddTimestamps(const uint64_t* pTimestamps, const std::vector<size_t>& copiedPlanes, uint64_t frequency);
+
+    // Fold the counters of another window in
+    void Merge(const TSRTransferStats& other);
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "manifest.h"
+#include "metadata.h"
+#include "shm.h"
+#include "tiles.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// State of a shared buffer slot, as seen through the transport.
+// Slot values increase monotonically (see TSRSlotRing), odd values are READY and even values are IDLE.
+enum class TSRBufferState : uint64_t
+{
+    IDLE = 0,
+    READY,
+};
+
+// CPU-visible image plane (color, depth, motion vectors, ...)
+struct TSRHostPlane
+{
+    uint8_t* data;
+    uint32_t width;
+    uint32_t height;
+    uint64_t stride;
+    uint64_t rowPitch;
+};
+
+// Most consumers one producer can feed
+constexpr uint32_t TSR_MAX_CONSUMERS = 8;
+
+// Control block entry written by one consumer
+struct TSRConsumerState
+{
+    std::atomic<uint64_t> resourceMask;  // Resources the consumer reads, the producer may leave out the others
+    std::atomic<uint64_t> busyNs;        // Time the consumer spent on its last frame, not counting waits for the producer
+    std::atomic<uint64_t> heartbeat;     // Counts up while the consumer runs, see TSRPeerMonitor
+};
+
+// Host-visible state shared by all processes next to the slots
+struct alignas(64) TSRControlBlock
+{
+    std::atomic<uint32_t> magic;
+    uint32_t              version;
+    uint64_t              slotCount;
+    uint64_t              manifestHash;         // Hash of the manifest the slots were laid out with
+    uint32_t              consumerCount;        // Consumers the slots were created for
+    std::atomic<uint32_t> registeredConsumers;  // Bit per consumer currently reading the slots
+    std::atomic<uint64_t> keyframeRequest;      // Set by a consumer when it can't apply delta frames, the producer sends a full frame
+    std::atomic<uint64_t> producerHeartbeat;    // Counts up while the producer runs
+    TSRConsumerState      consumers[TSR_MAX_CONSUMERS];
+};
+
+// Host-visible header of a slot, written by the producer before the slot is published
+struct alignas(64) TSRSlotHeader
+{
+    uint64_t         manifestHash;
+    uint64_t         resourceMask;  // Resources present in the slot
+    uint64_t         deltaMask;     // Resources holding only the tiles set in the slot tile map, the others are unchanged
+    uint64_t         aliasedMask;   // Resources in the slot's placed resources instead of the shared buffer, see TSRPlacedSlots
+    TSRFrameMetadata metadata;      // State of the frame in the slot, written with the resources
+};
+
+// Moves frame payloads between the renderer and the upscalers through a fixed number of slots.
+// Every slot carries a state value which the producer and consumer signal to hand the slot over.
+//
+// With several consumers (fan-out) every slot gets one state value per lane: the producer publishes frames on lane 0
+// and consumer c releases them on lane c + 1, so each consumer has its own release fence. A slot is free again once
+// every registered consumer released its frame. A single consumer shares lane 0 with the producer.
+class TSRTransport
+{
+public:
+    TSRTransport(uint64_t slotCount, uint32_t consumerCount = 1)
+        : m_SlotCount(slotCount)
+        , m_ConsumerCount(consumerCount)
+        , m_LaneCount(consumerCount > 1 ? consumerCount + 1 : 1)
+    {
+    }
+    virtual ~TSRTransport() = default;
+
+    // Create (or open, if shouldCreate is false) the slots. Every slot holds slotSize bytes of payload laid out as
+    // described by the manifest with the given hash, opening fails if the peer used a different manifest.
+    virtual void CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate) = 0;
+
+    // The last state value signaled on the slot lane, which has completed
+    virtual uint64_t GetSlotValue(uint64_t slotIndex, uint32_t lane = 0) = 0;
+
+    // Signal the slot lane value once all previously submitted work on the slot is done
+    virtual void SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane = 0) = 0;
+
+    // CPU address of the slot payload, or nullptr if the payload is not host visible
+    virtual uint8_t* MapSlot(uint64_t /*slotIndex*/) { return nullptr; }
+
+    // Block until any slot i on any lane l reaches pTargetValues[l * slot count + i] (UINT64_MAX to ignore it), or the
+    // timeout (in microseconds) runs out. Returns false on timeout.
+    virtual bool WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs) = 0;
+
+    // When the last value was signaled on the slot lane (tsr_now_ns), or 0 if the transport can't tell
+    virtual uint64_t GetSlotSignalTime(uint64_t /*slotIndex*/, uint32_t /*lane*/ = 0) { return 0; }
+
+    // Block until the slot reaches the value, or the timeout (in microseconds) runs out
+    bool WaitSlotValue(uint64_t slotIndex, uint64_t value, uint64_t timeoutUs);
+
+    uint64_t GetSlotCount() const { return m_SlotCount; }
+
+    uint64_t GetSlotSize() const { return m_SlotSize; }
+
+    uint32_t GetConsumerCount() const { return m_ConsumerCount; }
+
+    uint32_t GetLaneCount() const { return m_LaneCount; }
+
+    // Lane the consumer releases its frames on
+    uint32_t GetReleaseLane(uint32_t consumer) const { return m_LaneCount > 1 ? consumer + 1 : 0; }
+
+    // Consumers whose releases the producer waits for: the registered ones, or consumer 0 until one registers
+    uint32_t GetActiveConsumers() const;
+
+    // Consumers that registered, without the consumer 0 default of GetActiveConsumers
+    uint32_t GetRegisteredConsumers() const { return m_pControlBlock->registeredConsumers.load(std::memory_order_acquire); }
+
+    // Consumer: announce that the consumer reads the slots (or stopped reading them). The ring registers its consumer,
+    // see TSRSlotRing::RegisterConsumer.
+    void RegisterConsumer(uint32_t consumer);
+    void UnregisterConsumer(uint32_t consumer);
+
+    // Consumer: the resources it reads
+    void SetConsumedResources(uint32_t consumer, uint64_t resourceMask);
+
+    // Producer: the resources any active consumer reads
+    uint64_t GetConsumedResources() const;
+
+    // Consumer: the frame work of its last frame
+    void SetConsumerBusyNs(uint32_t consumer, uint64_t busyNs);
+
+    // Producer: the frame work of the slowest active consumer
+    uint64_t GetConsumerBusyNs() const;
+
+    // Count up the heartbeat of a side. A side that stops counting is taken for dead by its peers.
+    void BeatProducer() { m_pControlBlock->producerHeartbeat.fetch_add(1, std::memory_order_relaxed); }
+    void BeatConsumer(uint32_t consumer);
+
+    uint64_t GetProducerHeartbeat() const { return m_pControlBlock->producerHeartbeat.load(std::memory_order_relaxed); }
+    uint64_t GetConsumerHeartbeat(uint32_t consumer) const;
+
+    bool slotStateMatches(uint64_t slotIndex, TSRBufferState state);
+
+    bool slotStateMatchesAll(TSRBufferState state);
+
+    TSRControlBlock* GetControlBlock() const { return m_pControlBlock; }
+
+    TSRSlotHeader* GetSlotHeader(uint64_t slotIndex) const { return m_pSlotHeaders + slotIndex; }
+
+    // Copy the planes into (or out of) a host visible slot. pPlanes is indexed like the manifest and only the
+    // resources in resourceMask are copied. Returns the mask of the resources actually copied.
+    // Handing the slot over is left to TSRSlotRing.
+    uint64_t WriteSlot(const TSRManifest& manifest, const TSRHostPlane* pPlanes, uint64_t resourceMask, uint64_t slotIndex)
+    {
+        return PerformHostTransfer(manifest, pPlanes, resourceMask, slotIndex, true, nullptr, nullptr);
+    }
+
+    uint64_t ReadSlot(const TSRManifest& manifest, const TSRHostPlane* pPlanes, uint64_t resourceMask, uint64_t slotIndex)
+    {
+        return PerformHostTransfer(manifest, pPlanes, resourceMask, slotIndex, false, nullptr, nullptr);
+    }
+
+    // Delta transfers: the tiled resources of the manifest (see TSRManifest::SetTileSize) only carry the dirty tiles of
+    // the tile map, which goes into the slot with them. Reading a delta frame leaves the clean tiles of the planes
+    // untouched, so the consumer planes must still hold the previous frame, and fills pTiles (if not null) with the
+    // tile map of the slot. A full frame is written when pTiles is null.
+    uint64_t WriteSlotTiles(const TSRManifest& manifest, const TSRHostPlane* pPlanes, uint64_t resourceMask, const TSRTileMap* pTiles, uint64_t slotIndex)
+    {
+        return PerformHostTransfer(manifest, pPlanes, resourceMask, slotIndex, true, pTiles, nullptr);
+    }
+
+    uint64_t ReadSlotTiles(const TSRManifest& manifest, const TSRHostPlane* pPlanes, uint64_t resourceMask, TSRTileMap* pTiles, uint64_t slotIndex)
+    {
+        return PerformHostTransfer(manifest, pPlanes, resourceMask, slotIndex, false, nullptr, pTiles);
+    }
+
+    // Consumer: ask for a full frame, when the planes no longer hold the frame the next delta applies to
+    void RequestKeyframe() { m_pControlBlock->keyframeRequest.store(1, std::memory_order_release); }
+
+    // Producer: true once per keyframe request
+    bool TakeKeyframeRequest() { return m_pControlBlock->keyframeRequest.exchange(0, std::memory_order_acq_rel) != 0; }
+
+protected:
+    // Create (or open) the host-visible control block and slot headers, called by the backends from CreateSlots
+    void CreateControlBlock(const std::string& sharedName, uint64_t manifestHash, bool shouldCreate);
+
+    uint64_t m_SlotCount     = 0;
+    uint64_t m_SlotSize      = 0;
+    uint32_t m_ConsumerCount = 1;
+    uint32_t m_LaneCount     = 1;
+
+private:
+    static constexpr uint32_t TSR_CONTROL_MAGIC   = 0x4c435354;  // "TSCL"
+    static constexpr uint32_t TSR_CONTROL_VERSION = 6;
+
+    TSRSharedMemory  m_ControlMemory;
+    TSRControlBlock* m_pControlBlock = nullptr;
+    TSRSlotHeader*   m_pSlotHeaders  = nullptr;
+
+    uint64_t PerformHostTransfer(const TSRManifest&  manifest,
+                                 const TSRHostPlane* pPlanes,
+                                 uint64_t            resourceMask,
+                                 uint64_t            slotIndex,
+                                 bool                toSlot,
+                                 const TSRTileMap*   pWriteTiles,
+                                 TSRTileMap*         pReadTiles);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "transport.h"
+
+#include <d3d12.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// GPU transport: every slot is a shared D3D12 buffer, slot states are shared fences signaled on the queue.
+// With several consumers every slot also gets a shared release fence per consumer.
+class TSRD3D12Transport : public TSRTransport
+{
+public:
+    TSRD3D12Transport(const wchar_t* pSharedName, ID3D12Device* pDevice, ID3D12CommandQueue* pQueue, uint64_t slotCount, uint32_t consumerCount = 1)
+        : TSRTransport(slotCount, consumerCount)
+        , m_SharedName(pSharedName)
+        , m_pDevice(pDevice)
+        , m_pQueue(pQueue)
+        , m_SharedBuffers(slotCount)
+        , m_ReleaseFences(slotCount * (m_LaneCount - 1), nullptr)
+    {
+    }
+    ~TSRD3D12Transport() override;
+
+    void CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate) override;
+
+    uint64_t GetSlotValue(uint64_t slotIndex, uint32_t lane = 0) override;
+
+    // Slot signals are held back until FlushSignals, so they land behind the command lists doing the transfer
+    void SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane = 0) override;
+
+    // Signal the pending slot values on the queue (the transport's queue if null)
+    void FlushSignals(ID3D12CommandQueue* pQueue = nullptr);
+
+    bool HasPendingSignals() const { return !m_PendingSignals.empty(); }
+
+    bool WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs) override;
+
+    ID3D12Device* GetDevice() const { return m_pDevice; }
+
+    ID3D12Resource* GetSlotResource(uint64_t slotIndex) const { return std::get<0>(m_SharedBuffers[slotIndex]); }
+
+private:
+    ID3D12Fence* GetFence(uint64_t slotIndex, uint32_t lane) const;
+
+    ID3D12Fence* CreateSharedFence(const std::wstring& name, bool shouldCreate);
+
+    std::wstring        m_SharedName;  // Callers may pass a temporary
+    ID3D12Device*       m_pDevice     = nullptr;
+    ID3D12CommandQueue* m_pQueue      = nullptr;
+    HANDLE              m_WaitEvent   = nullptr;
+
+    std::vector<std::tuple<ID3D12Resource*, ID3D12Fence*>> m_SharedBuffers;
+    std::vector<ID3D12Fence*>                               m_ReleaseFences;   // Lanes 1 and up, lane by lane
+    std::vector<std::tuple<uint64_t, uint64_t, uint32_t>>   m_PendingSignals;  // Slot index, value and lane
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "transport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// In-process transport: the slots live in the memory of this process and the producer and consumer rings share the
+// transport object, so CreateSlots is called once (with shouldCreate set). Stands in for the GPU transport when
+// testing what runs on top of the rings (schedulers, controllers, ...) without a device or a peer process.
+class TSRHostTransport : public TSRTransport
+{
+public:
+    TSRHostTransport(const std::string& sharedName, uint64_t slotCount, uint32_t consumerCount = 1)
+        : TSRTransport(slotCount, consumerCount)
+        , m_SharedName(sharedName)
+    {
+    }
+    ~TSRHostTransport() override = default;
+
+    void CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate) override;
+
+    uint64_t GetSlotValue(uint64_t slotIndex, uint32_t lane = 0) override;
+
+    void SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane = 0) override;
+
+    uint8_t* MapSlot(uint64_t slotIndex) override;
+
+    bool WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs) override;
+
+    uint64_t GetSlotSignalTime(uint64_t slotIndex, uint32_t lane = 0) override;
+
+private:
+    struct SlotControl
+    {
+        std::atomic<uint64_t> value{0};
+        std::atomic<uint64_t> signalTime{0};
+    };
+
+    SlotControl& Control(uint64_t slotIndex, uint32_t lane);
+
+    std::string                    m_SharedName;
+    std::vector<uint8_t>           m_Payload;
+    std::unique_ptr<SlotControl[]> m_pControl;
+    uint64_t                       m_SlotStride = 0;
+
+    std::mutex              m_WaitMutex;
+    std::condition_variable m_WaitCondition;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "transport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How frame payloads travel between the hosts. Control messages (handshake, releases, user data) always go over TCP.
+enum class TSRNetProtocol : uint32_t
+{
+    Tcp = 0,  // Payloads on the control connection, a frame only goes missing if the connection drops
+    Udp,      // Payloads split into datagrams, frames missing a datagram are discarded and handed back to the producer
+};
+
+struct TSRNetConfig
+{
+    TSRNetProtocol protocol         = TSRNetProtocol::Tcp;
+    std::string    host             = "127.0.0.1";  // Peer to connect to, unused when listening
+    uint16_t       port             = 47000;        // TCP control port, the consumer also receives UDP payloads on it
+    bool           listen           = false;        // Accept the connection instead of connecting
+    uint32_t       datagramSize     = 1200;         // Payload bytes per datagram, below the path MTU
+    uint64_t       connectTimeoutUs = 10000000;
+
+    // Testing only: the producer skips every Nth datagram it would send (0 to send everything)
+    uint32_t dropEveryNthDatagram = 0;
+};
+
+// Counters kept by either side of a network transport
+struct TSRNetStats
+{
+    uint64_t framesSent      = 0;
+    uint64_t framesReceived  = 0;
+    uint64_t framesDiscarded = 0;  // Partial frames the consumer gave up on
+    uint64_t datagramsSent   = 0;
+    uint64_t datagramsLost   = 0;  // Datagrams of discarded frames that never arrived
+    uint64_t bytesSent       = 0;
+    uint64_t bytesReceived   = 0;
+};
+
+// Transport between two hosts. Each side keeps its own copy of the slots in host memory: publishing a frame on the
+// producer ships the slot header and payload to the consumer, releasing a frame on the consumer ships the new slot
+// value back. TSRSlotRing and the host transfers work on top of it unchanged. It is library-only: TSRRenderModule
+// transfers through D3D12 and has no readback stage for host transports, tsr-net-loopback runs it.
+//
+// Every frame is tagged with its slot value, which carries the frame sequence number (see TSRSlotRing). Over UDP a
+// frame whose datagrams don't all arrive before a datagram of a newer frame is discarded and released on the
+// producer right away, the consumer ring counts it as dropped.
+//
+// Both ends have to agree on the protocol and the datagram size. Whatever the peer sends is checked against the slot
+// layout agreed on in the handshake: datagrams which don't fit it are dropped, a control message which doesn't drops
+// the connection. Datagrams are not authenticated, a host that can reach the port can still spoil frames: keep the UDP
+// protocol to trusted networks.
+//
+// Messages are sent in host byte order, both ends are expected to be little endian. A network transport connects one
+// producer to one consumer, fan-out needs a transport per consumer.
+class TSRNetTransport : public TSRTransport
+{
+public:
+    TSRNetTransport(const std::string& sharedName, uint64_t slotCount, const TSRNetConfig& config)
+        : TSRTransport(slotCount)
+        , m_SharedName(sharedName)
+        , m_Config(config)
+    {
+    }
+    ~TSRNetTransport() override;
+
+    // shouldCreate selects the producer side. Blocks until the peer connected and agreed on the slot layout.
+    void CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate) override;
+
+    uint64_t GetSlotValue(uint64_t slotIndex, uint32_t lane = 0) override;
+
+    // Producer: a READY value sends the slot. Consumer: an IDLE value hands the slot back.
+    void SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane = 0) override;
+
+    uint8_t* MapSlot(uint64_t slotIndex) override;
+
+    bool WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs) override;
+
+    uint64_t GetSlotSignalTime(uint64_t slotIndex, uint32_t lane = 0) override;
+
+    // Limits of the user data, the receiver drops the connection of a peer going past them
+    static constexpr uint32_t MAX_USER_DATA_COUNT = 64;
+    static constexpr uint32_t MAX_USER_DATA_SIZE  = 64 * 1024;
+
+    // Send a small per-frame blob to the peer (camera data and the like), the last one sent per index wins
+    void SendUserData(uint32_t index, const void* pData, uint32_t size);
+
+    // Copy out the last user data received for the index, returns false if none arrived yet
+    bool GetUserData(uint32_t index, void* pData, uint32_t size);
+
+    bool IsConnected() const { return m_Connected.load(std::memory_order_acquire); }
+
+    TSRNetStats GetStats();
+
+private:
+    struct SlotControl
+    {
+        std::atomic<uint64_t> value{0};
+        std::atomic<uint64_t> signalTime{0};
+    };
+
+    // Frame being reassembled from datagrams
+    struct PartialFrame
+    {
+        uint64_t             value      = 0;
+        uint64_t             slotIndex  = 0;
+        uint32_t             chunkCount = 0;
+        uint32_t             chunksLeft = 0;
+        std::vector<uint8_t> received;
+        TSRSlotHeader        header = {};
+    };
+
+    void Connect();
+    void Handshake(uint64_t manifestHash, bool isProducer);
+
+    void SendMessage(uint32_t type, const void* pBody, uint64_t bodySize, const void* pPayload, uint64_t payloadSize);
+    void SendFrame(uint64_t slotIndex, uint64_t value);
+    void SendRelease(uint64_t slotIndex, uint64_t value);
+
+    void ReceiveLoop();
+    void ReceiveDatagrams();
+    void CompleteFrame(uint64_t slotIndex, uint64_t value, const TSRSlotHeader& header);
+    void DiscardFrame(PartialFrame& frame);
+    void SetSlotValue(uint64_t slotIndex, uint64_t value);
+
+    std::string  m_SharedName;
+    TSRNetConfig m_Config;
+    bool         m_IsProducer = false;
+
+    int      m_Socket          = -1;  // TCP control connection
+    int      m_DatagramSocket  = -1;
+    uint64_t m_DatagramCounter = 0;   // Datagrams the producer went to send, for dropEveryNthDatagram
+
+    std::vector<uint8_t>     m_Payload;
+    std::vector<SlotControl> m_Control;
+    uint64_t                 m_SlotStride = 0;
+
+    std::mutex              m_SendMutex;
+    std::mutex              m_WaitMutex;
+    std::condition_variable m_WaitCondition;
+    std::atomic<bool>       m_Connected{false};
+    std::atomic<bool>       m_Stopping{false};
+    std::thread             m_ReceiveThread;
+    std::thread             m_DatagramThread;
+
+    std::mutex                        m_UserDataMutex;
+    std::vector<std::vector<uint8_t>> m_UserData;
+
+    std::mutex  m_StatsMutex;
+    TSRNetStats m_Stats = {};
+};
+
+// Producer and consumer on the loopback interface, for checking a transport configuration without two hosts
+struct TSRNetLoopbackParams
+{
+    TSRNetConfig config;
+    uint64_t     slotCount = 3;
+    uint32_t     width     = 640;
+    uint32_t     height    = 360;
+    uint32_t     frames    = 60;
+};
+
+struct TSRNetLoopbackResult
+{
+    uint64_t    framesConsumed     = 0;
+    uint64_t    framesDropped      = 0;  // As counted by the consumer ring
+    uint64_t    framesCorrupt      = 0;  // Consumed frames whose payload did not match what was sent
+    double      megabytesPerSecond = 0.0;
+    TSRNetStats producerStats;
+    TSRNetStats consumerStats;
+};
+
+TSRNetLoopbackResult TSRRunNetLoopback(const TSRNetLoopbackParams& params);
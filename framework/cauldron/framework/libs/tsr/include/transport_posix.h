@@ -0,0 +1,61 @@
+#pragma once
+
+#include "transport.h"
+#include "shm.h"
+
+#include <atomic>
+#include <string>
+
+// Host-memory transport: all slots live in one POSIX shared memory region, waiters sleep on a futex doorbell
+class TSRPosixTransport : public TSRTransport
+{
+public:
+    TSRPosixTransport(const std::string& sharedName, uint64_t slotCount, uint32_t consumerCount = 1)
+        : TSRTransport(slotCount, consumerCount)
+        , m_SharedName(sharedName)
+    {
+    }
+    ~TSRPosixTransport() override = default;
+
+    void CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate) override;
+
+    uint64_t GetSlotValue(uint64_t slotIndex, uint32_t lane = 0) override;
+
+    void SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane = 0) override;
+
+    uint8_t* MapSlot(uint64_t slotIndex) override;
+
+    bool WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs) override;
+
+    uint64_t GetSlotSignalTime(uint64_t slotIndex, uint32_t lane = 0) override;
+
+private:
+    static constexpr uint32_t TSR_POSIX_MAGIC   = 0x52535354;  // "TSSR"
+    static constexpr uint32_t TSR_POSIX_VERSION = 3;
+
+    struct Header
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t              version;
+        uint64_t              slotCount;
+        uint64_t              slotSize;
+        std::atomic<uint32_t> doorbell;  // Futex word bumped on every signal, waiters sleep on it
+        uint32_t              laneCount;
+    };
+
+    // One cache line per slot lane so the producer and the consumers don't false-share
+    struct alignas(64) SlotControl
+    {
+        std::atomic<uint64_t> value;
+        std::atomic<uint64_t> signalTime;
+    };
+
+    SlotControl& Control(uint64_t slotIndex, uint32_t lane);
+
+    std::string     m_SharedName;
+    TSRSharedMemory m_Memory;
+    Header*         m_pHeader    = nullptr;
+    SlotControl*    m_pControl   = nullptr;
+    uint8_t*        m_pPayload   = nullptr;
+    uint64_t        m_SlotStride = 0;
+};
@@ -1,4 +1,29 @@
 #pragma once
 
-#include "udta.h"
+#include "channel.h"
+#include "logging.h"
+#include "metadata.h"
+#include "transport.h"
+#include "layout.h"
+#include "packing.h"
+#include "tiles.h"
+#include "manifest.h"
+#include "negotiation.h"
+#include "ring.h"
+#include "liveness.h"
+#include "capture.h"
+#include "placement.h"
+#include "transferstats.h"
+#include "slotcontrol.h"
+#include "queuesim.h"
+#include "transport_host.h"
+#include "session.h"
+
+#if defined(_WIN32)
 #include "transfer.h"
+#include "placement_d3d12.h"
+#else
+#include "transport_posix.h"
+#include "transport_net.h"
+#include "replay.h"
+#endif
@@ -1,6 +1,9 @@
 #pragma once
 #include <exception>
 
+#if defined(_WIN32)
+#include <windows.h>
+
 #define AssertCritical(condition, message)                                       \
     do                                                                           \
     {                                                                            \
@@ -10,3 +13,17 @@
             std::terminate();                                                    \
         }                                                                        \
     } while (0)
+#else
+#include <cstdio>
+#include <cwchar>
+
+#define AssertCritical(condition, message)                            \
+    do                                                                \
+    {                                                                 \
+        if (!(condition))                                             \
+        {                                                             \
+            fwprintf(stderr, L"Critical Error: %ls\n", message);      \
+            std::terminate();                                         \
+        }                                                             \
+    } while (0)
+#endif
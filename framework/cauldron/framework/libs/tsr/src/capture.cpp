@@ -0,0 +1,459 @@
+#include "capture.h"
+#include "assert.h"
+#include "layout.h"
+#include "negotiation.h"
+#include "tiles.h"
+#include "timing.h"
+
+#include <cstring>
+
+#if defined(TSR_HAS_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace
+{
+    constexpr uint32_t TSR_CAPTURE_MAGIC       = 0x50435354;  // "TSCP"
+    constexpr uint32_t TSR_CAPTURE_VERSION     = 1;
+    constexpr uint32_t TSR_CAPTURE_CHUNK_MAGIC = 0x46435354;  // "TSCF"
+    constexpr uint32_t TSR_CAPTURE_INDEX_MAGIC = 0x49435354;  // "TSCI"
+
+    // Chunks start on a page so the planes of a mapped capture can be handed out as they are
+    constexpr uint64_t CHUNK_ALIGNMENT = 4096;
+    constexpr uint64_t PLANE_ALIGNMENT = 64;
+
+    // Plane table entry of the tile map
+    constexpr uint32_t TILE_MAP_PLANE = UINT32_MAX;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t tileSize;
+        uint32_t reserved;
+        TSROffer manifest;  // Only the resources and the hash are used
+    };
+
+    struct ChunkHeader
+    {
+        uint32_t        magic;
+        uint32_t        planeCount;
+        uint64_t        chunkSize;  // From the chunk header to the end of the last plane
+        TSRCaptureFrame frame;
+    };
+
+    struct PlaneEntry
+    {
+        uint32_t        resource;  // Manifest index, or TILE_MAP_PLANE
+        TSRCaptureCodec codec;
+        uint64_t        offset;      // From the chunk header
+        uint64_t        storedSize;  // Bytes in the file
+        uint64_t        size;        // Bytes in the slot
+    };
+
+    struct Footer
+    {
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t frameCount;
+        uint64_t indexOffset;
+    };
+
+    uint64_t GetFirstChunkOffset()
+    {
+        return TSRAlignUp(sizeof(FileHeader), CHUNK_ALIGNMENT);
+    }
+
+    uint64_t GetTileMapSize(const TSRManifest& manifest)
+    {
+        if (!manifest.GetTileSize() || !manifest.GetResourceCount())
+            return 0;
+        return TSRTileMap::GetBitmapSize(manifest.GetResource(0).width, manifest.GetResource(0).height, manifest.GetTileSize());
+    }
+
+    // Where a plane lives in the slot
+    bool GetPlaneRange(const TSRManifest& manifest, uint32_t resource, uint64_t& offset, uint64_t& size)
+    {
+        if (resource == TILE_MAP_PLANE)
+        {
+            offset = manifest.GetTileMapOffset();
+            size   = GetTileMapSize(manifest);
+            return size != 0;
+        }
+
+        if (resource >= manifest.GetResourceCount())
+            return false;
+
+        offset = manifest.GetResource(resource).offset;
+        size   = manifest.GetResource(resource).size;
+        return true;
+    }
+}  // namespace
+
+const char* TSRCaptureCodecName(TSRCaptureCodec codec)
+{
+    switch (codec)
+    {
+    case TSRCaptureCodec::Raw:
+        return "Raw";
+    case TSRCaptureCodec::Zstd:
+        return "Zstd";
+    }
+    return "Unknown";
+}
+
+bool TSRCaptureSupportsZstd()
+{
+#if defined(TSR_HAS_ZSTD)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TSRCaptureWriter::Open(const std::string& path, const TSRManifest& manifest, const TSRCaptureOptions& options)
+{
+    AssertCritical(manifest.IsFinalized(), L"The manifest is not finalized");
+    Close();
+
+    m_Manifest = manifest;
+    m_Options  = options;
+    m_Offset   = 0;
+    m_Stats    = TSRCaptureStats();
+    m_Error.clear();
+    m_Index.clear();
+
+    if (options.codec == TSRCaptureCodec::Zstd)
+    {
+#if defined(TSR_HAS_ZSTD)
+        m_pCompressor = ZSTD_createCCtx();
+        if (!m_pCompressor)
+            return Fail("can't create the zstd context");
+#else
+        return Fail("zstd support was not built in");
+#endif
+    }
+
+    m_pFile = fopen(path.c_str(), "wb");
+    if (!m_pFile)
+        return Fail("can't create " + path);
+
+    FileHeader header = {};
+    header.magic      = TSR_CAPTURE_MAGIC;
+    header.version    = TSR_CAPTURE_VERSION;
+    header.tileSize   = manifest.GetTileSize();
+    TSRDescribeManifest(manifest, header.manifest);
+
+    if (!Write(&header, sizeof(header)) || !Pad(CHUNK_ALIGNMENT))
+        return false;
+    return true;
+}
+
+bool TSRCaptureWriter::WriteFrame(const TSRCaptureFrame& frame, const uint8_t* pSlot)
+{
+    AssertCritical(m_pFile, L"The capture is not open");
+
+    // Planes of the frame, in manifest order with the tile map last
+    std::vector<PlaneEntry> planes;
+    uint64_t                resourceMask = frame.resourceMask & m_Manifest.GetAllMask();
+    for (uint32_t i = 0; i < m_Manifest.GetResourceCount(); i++)
+    {
+        if (resourceMask & (1ull << i))
+            planes.push_back(PlaneEntry{i, TSRCaptureCodec::Raw, 0, 0, 0});
+    }
+    if (frame.deltaMask & resourceMask)
+    {
+        AssertCritical(GetTileMapSize(m_Manifest), L"Delta frame without a tile map in the manifest");
+        planes.push_back(PlaneEntry{TILE_MAP_PLANE, TSRCaptureCodec::Raw, 0, 0, 0});
+    }
+
+    // Compress first, the plane table needs the stored sizes
+    if (m_Compressed.size() < planes.size())
+        m_Compressed.resize(planes.size());
+
+    uint64_t offset = TSRAlignUp(sizeof(ChunkHeader) + planes.size() * sizeof(PlaneEntry), PLANE_ALIGNMENT);
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        PlaneEntry& plane = planes[i];
+        uint64_t    slotOffset;
+        GetPlaneRange(m_Manifest, plane.resource, slotOffset, plane.size);
+        plane.storedSize = plane.size;
+
+#if defined(TSR_HAS_ZSTD)
+        if (m_Options.codec == TSRCaptureCodec::Zstd)
+        {
+            std::vector<uint8_t>& compressed = m_Compressed[i];
+            compressed.resize(ZSTD_compressBound(plane.size));
+
+            size_t result = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(m_pCompressor),
+                                              compressed.data(),
+                                              compressed.size(),
+                                              pSlot + slotOffset,
+                                              plane.size,
+                                              m_Options.level);
+            if (ZSTD_isError(result))
+                return Fail(std::string("zstd: ") + ZSTD_getErrorName(result));
+
+            // Planes that don't compress are kept raw, they read faster
+            if (result < plane.size)
+            {
+                plane.codec      = TSRCaptureCodec::Zstd;
+                plane.storedSize = result;
+            }
+        }
+#endif
+
+        plane.offset = offset;
+        offset       = TSRAlignUp(offset + plane.storedSize, PLANE_ALIGNMENT);
+
+        m_Stats.rawBytes += plane.size;
+        m_Stats.storedBytes += plane.storedSize;
+    }
+
+    ChunkHeader header = {};
+    header.magic       = TSR_CAPTURE_CHUNK_MAGIC;
+    header.planeCount  = static_cast<uint32_t>(planes.size());
+    header.chunkSize   = planes.empty() ? sizeof(ChunkHeader) : planes.back().offset + planes.back().storedSize;
+    header.frame       = frame;
+    header.frame.resourceMask &= m_Manifest.GetAllMask();
+
+    uint64_t chunkOffset = m_Offset;
+    if (!Write(&header, sizeof(header)) || !Write(planes.data(), planes.size() * sizeof(PlaneEntry)))
+        return false;
+
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        const PlaneEntry& plane = planes[i];
+        uint64_t          slotOffset, size;
+        GetPlaneRange(m_Manifest, plane.resource, slotOffset, size);
+
+        const uint8_t* pData = plane.codec == TSRCaptureCodec::Raw ? pSlot + slotOffset : m_Compressed[i].data();
+        if (!Pad(PLANE_ALIGNMENT) || !Write(pData, plane.storedSize))
+            return false;
+    }
+
+    if (!Pad(CHUNK_ALIGNMENT))
+        return false;
+
+    m_Index.push_back(chunkOffset);
+    m_Stats.frames++;
+    return true;
+}
+
+bool TSRCaptureWriter::WriteSlot(TSRTransport& transport, uint64_t slotIndex, uint64_t sequence)
+{
+    const uint8_t* pSlot = transport.MapSlot(slotIndex);
+    AssertCritical(pSlot, L"The shared buffer is not host visible");
+
+    const TSRSlotHeader& slotHeader = *transport.GetSlotHeader(slotIndex);
+    AssertCritical(slotHeader.manifestHash == m_Manifest.GetHash(), L"The shared buffer was laid out with another manifest");
+
+    TSRCaptureFrame frame = {};
+    frame.sequence        = sequence;
+    frame.captureTimeNs   = tsr_now_ns();
+    frame.resourceMask    = slotHeader.resourceMask & ~slotHeader.aliasedMask;  // Never went through the shared buffer
+    frame.deltaMask       = slotHeader.deltaMask;
+    frame.metadata        = slotHeader.metadata;
+    return WriteFrame(frame, pSlot);
+}
+
+bool TSRCaptureWriter::Close()
+{
+    bool succeeded = true;
+    if (m_pFile)
+    {
+        Footer footer      = {};
+        footer.magic       = TSR_CAPTURE_INDEX_MAGIC;
+        footer.frameCount  = m_Index.size();
+        footer.indexOffset = m_Offset;
+
+        succeeded = Write(m_Index.data(), m_Index.size() * sizeof(uint64_t)) && Write(&footer, sizeof(footer));
+        if (fclose(m_pFile) != 0 && succeeded)
+            succeeded = Fail("can't finish the capture");
+        m_pFile = nullptr;
+    }
+
+#if defined(TSR_HAS_ZSTD)
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_pCompressor));
+#endif
+    m_pCompressor = nullptr;
+    return succeeded;
+}
+
+bool TSRCaptureWriter::Write(const void* pData, uint64_t size)
+{
+    if (size && fwrite(pData, 1, static_cast<size_t>(size), m_pFile) != size)
+        return Fail("can't write the capture, the disk may be full");
+
+    m_Offset += size;
+    m_Stats.fileBytes = m_Offset;
+    return true;
+}
+
+bool TSRCaptureWriter::Pad(uint64_t alignment)
+{
+    static const uint8_t zeros[CHUNK_ALIGNMENT] = {};
+    return Write(zeros, TSRAlignUp(m_Offset, alignment) - m_Offset);
+}
+
+bool TSRCaptureWriter::Fail(const std::string& error)
+{
+    m_Error = error;
+    return false;
+}
+
+bool TSRCaptureReader::Open(const std::string& path)
+{
+    Close();
+    m_Error.clear();
+
+    if (!m_File.Open(path))
+        return Fail("can't open " + path);
+
+    const uint8_t*    pData  = m_File.Data();
+    uint64_t          size   = m_File.Size();
+    const FileHeader& header = *reinterpret_cast<const FileHeader*>(pData);
+    if (size < GetFirstChunkOffset() || header.magic != TSR_CAPTURE_MAGIC)
+        return Fail(path + " is not a capture");
+    if (header.version != TSR_CAPTURE_VERSION)
+        return Fail(path + " was captured with format version " + std::to_string(header.version) + ", this build reads version " + std::to_string(TSR_CAPTURE_VERSION));
+    if (!TSRBuildManifest(header.manifest, header.tileSize, m_Manifest))
+        return Fail("the manifest of " + path + " is corrupt");
+
+    // A closed capture ends with the index. A capture cut short may end anywhere, so the footer is copied out.
+    Footer footer = {};
+    if (size >= GetFirstChunkOffset() + sizeof(Footer))
+        memcpy(&footer, pData + size - sizeof(Footer), sizeof(Footer));
+
+    uint64_t maxFrames = (size - GetFirstChunkOffset() - sizeof(Footer)) / sizeof(uint64_t);
+    m_Complete         = footer.magic == TSR_CAPTURE_INDEX_MAGIC && footer.frameCount <= maxFrames &&
+                 footer.indexOffset == size - sizeof(Footer) - footer.frameCount * sizeof(uint64_t);
+    if (m_Complete)
+    {
+        const uint64_t* pIndex = reinterpret_cast<const uint64_t*>(pData + footer.indexOffset);
+        for (uint64_t i = 0; i < footer.frameCount; i++)
+        {
+            if (!CheckChunk(pIndex[i]))
+            {
+                m_Chunks.clear();
+                return Fail("frame " + std::to_string(i) + " of " + path + " is corrupt");
+            }
+            m_Chunks.push_back(pIndex[i]);
+        }
+        return true;
+    }
+
+    // Recover what made it to the disk
+    for (uint64_t offset = GetFirstChunkOffset(); CheckChunk(offset);)
+    {
+        m_Chunks.push_back(offset);
+        offset = TSRAlignUp(offset + reinterpret_cast<const ChunkHeader*>(pData + offset)->chunkSize, CHUNK_ALIGNMENT);
+    }
+    return true;
+}
+
+void TSRCaptureReader::Close()
+{
+    m_File.Close();
+    m_Chunks.clear();
+    m_Complete = false;
+
+#if defined(TSR_HAS_ZSTD)
+    ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(m_pDecompressor));
+#endif
+    m_pDecompressor = nullptr;
+}
+
+const TSRCaptureFrame& TSRCaptureReader::GetFrame(uint64_t index) const
+{
+    AssertCritical(index < m_Chunks.size(), L"Invalid capture frame");
+    return reinterpret_cast<const ChunkHeader*>(m_File.Data() + m_Chunks[index])->frame;
+}
+
+bool TSRCaptureReader::ReadFrame(uint64_t index, uint8_t* pSlot)
+{
+    AssertCritical(index < m_Chunks.size(), L"Invalid capture frame");
+
+    const uint8_t*     pChunk  = m_File.Data() + m_Chunks[index];
+    const ChunkHeader& header  = *reinterpret_cast<const ChunkHeader*>(pChunk);
+    const PlaneEntry*  pPlanes = reinterpret_cast<const PlaneEntry*>(pChunk + sizeof(ChunkHeader));
+    for (uint32_t i = 0; i < header.planeCount; i++)
+    {
+        const PlaneEntry& plane = pPlanes[i];
+        uint64_t          slotOffset, size;
+        GetPlaneRange(m_Manifest, plane.resource, slotOffset, size);
+
+        if (plane.codec == TSRCaptureCodec::Raw)
+        {
+            memcpy(pSlot + slotOffset, pChunk + plane.offset, plane.size);
+            continue;
+        }
+
+#if defined(TSR_HAS_ZSTD)
+        if (!m_pDecompressor)
+            m_pDecompressor = ZSTD_createDCtx();
+
+        size_t result = ZSTD_decompressDCtx(static_cast<ZSTD_DCtx*>(m_pDecompressor), pSlot + slotOffset, plane.size, pChunk + plane.offset, plane.storedSize);
+        if (ZSTD_isError(result) || result != plane.size)
+            return Fail("a plane of frame " + std::to_string(index) + " does not decompress");
+#else
+        return Fail("the capture is compressed with zstd, which was not built in");
+#endif
+    }
+    return true;
+}
+
+bool TSRCaptureReader::ReadSlot(uint64_t index, TSRTransport& transport, uint64_t slotIndex)
+{
+    uint8_t* pSlot = transport.MapSlot(slotIndex);
+    AssertCritical(pSlot, L"The shared buffer is not host visible");
+    AssertCritical(m_Manifest.GetTotalSize() <= transport.GetSlotSize(), L"The manifest does not fit in the shared buffer");
+
+    if (!ReadFrame(index, pSlot))
+        return false;
+
+    const TSRCaptureFrame& frame      = GetFrame(index);
+    TSRSlotHeader&         slotHeader = *transport.GetSlotHeader(slotIndex);
+    slotHeader.manifestHash           = m_Manifest.GetHash();
+    slotHeader.resourceMask           = frame.resourceMask;
+    slotHeader.deltaMask              = frame.deltaMask;
+    slotHeader.aliasedMask            = 0;
+    slotHeader.metadata               = frame.metadata;
+    return true;
+}
+
+bool TSRCaptureReader::Fail(const std::string& error)
+{
+    m_Error = error;
+    return false;
+}
+
+bool TSRCaptureReader::CheckChunk(uint64_t offset) const
+{
+    uint64_t size = m_File.Size();
+    if (offset % CHUNK_ALIGNMENT || offset < GetFirstChunkOffset() || offset > size || size - offset < sizeof(ChunkHeader))
+        return false;
+
+    const uint8_t*     pChunk = m_File.Data() + offset;
+    const ChunkHeader& header = *reinterpret_cast<const ChunkHeader*>(pChunk);
+    if (header.magic != TSR_CAPTURE_CHUNK_MAGIC || header.chunkSize > size - offset || header.planeCount > TSR_MANIFEST_MAX_RESOURCES + 1 ||
+        sizeof(ChunkHeader) + header.planeCount * sizeof(PlaneEntry) > header.chunkSize)
+    {
+        return false;
+    }
+
+    // Every plane has to fit in the chunk and in its place in the slot
+    const PlaneEntry* pPlanes = reinterpret_cast<const PlaneEntry*>(pChunk + sizeof(ChunkHeader));
+    for (uint32_t i = 0; i < header.planeCount; i++)
+    {
+        const PlaneEntry& plane = pPlanes[i];
+        uint64_t          slotOffset, slotSize;
+        if (!GetPlaneRange(m_Manifest, plane.resource, slotOffset, slotSize) || plane.size != slotSize)
+            return false;
+        if (plane.offset > header.chunkSize || plane.storedSize > header.chunkSize - plane.offset)
+            return false;
+        if (plane.codec == TSRCaptureCodec::Raw ? plane.storedSize != plane.size : plane.codec != TSRCaptureCodec::Zstd)
+            return false;
+    }
+    return true;
+}
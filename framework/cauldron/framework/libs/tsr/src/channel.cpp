@@ -0,0 +1,122 @@
+#include "channel.h"
+#include "assert.h"
+#include "layout.h"
+
+#include <atomic>
+#include <new>
+
+namespace
+{
+    constexpr uint32_t TSR_CHANNEL_MAGIC   = 0x48435354;  // "TSCH"
+    constexpr uint32_t TSR_CHANNEL_VERSION = 1;
+    constexpr size_t   ENTRY_HEADER_SIZE   = 64;          // The sequence gets its own cache line
+
+    struct alignas(64) ChannelHeader
+    {
+        std::atomic<uint32_t> magic;
+        uint32_t              version;
+        uint64_t              layoutHash;
+        uint64_t              entryCount;
+        uint64_t              payloadSize;
+    };
+
+    std::atomic<uint64_t>& Sequence(uint8_t* pEntry)
+    {
+        return *reinterpret_cast<std::atomic<uint64_t>*>(pEntry);
+    }
+}  // namespace
+
+namespace tsr
+{
+    bool ChannelBase::Open(const std::string& name, size_t entryCount, size_t payloadSize, uint64_t layoutHash, bool shouldCreate)
+    {
+        AssertCritical(entryCount > 0, L"A channel needs at least one entry");
+
+        m_EntryCount  = entryCount;
+        m_PayloadSize = payloadSize;
+        m_EntryOffset = sizeof(ChannelHeader);
+        m_EntryStride = TSRAlignUp(ENTRY_HEADER_SIZE + payloadSize, ENTRY_HEADER_SIZE);
+
+        if (!m_Memory.Open(name, m_EntryOffset + m_EntryStride * entryCount, shouldCreate))
+            return false;
+
+        ChannelHeader* pHeader = reinterpret_cast<ChannelHeader*>(m_Memory.Data());
+        if (shouldCreate)
+        {
+            for (size_t i = 0; i < entryCount; i++)
+                new (Entry(i)) std::atomic<uint64_t>(0);
+
+            pHeader->version     = TSR_CHANNEL_VERSION;
+            pHeader->layoutHash  = layoutHash;
+            pHeader->entryCount  = entryCount;
+            pHeader->payloadSize = payloadSize;
+
+            // Publish the header last, the peer validates against the magic
+            new (&pHeader->magic) std::atomic<uint32_t>(0);
+            pHeader->magic.store(TSR_CHANNEL_MAGIC, std::memory_order_release);
+            return true;
+        }
+
+        // A creator with another layout of the payload fails the open like one with another size, never a torn read
+        bool matches = pHeader->magic.load(std::memory_order_acquire) == TSR_CHANNEL_MAGIC && pHeader->version == TSR_CHANNEL_VERSION &&
+                       pHeader->entryCount == entryCount && pHeader->payloadSize == payloadSize && pHeader->layoutHash == layoutHash;
+        if (!matches)
+            m_Memory.Close();
+        return matches;
+    }
+
+    void ChannelBase::Close()
+    {
+        m_Memory.Close();
+    }
+
+    void ChannelBase::Write(size_t index, const void* pData)
+    {
+        AssertCritical(IsOpen() && index < m_EntryCount, L"Invalid channel entry");
+
+        uint8_t*               pEntry   = Entry(index);
+        std::atomic<uint64_t>& sequence = Sequence(pEntry);
+        uint64_t               value    = sequence.load(std::memory_order_relaxed);
+
+        // Odd while the payload is being written, the fence keeps the payload stores after it
+        sequence.store(value + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(pEntry + ENTRY_HEADER_SIZE, pData, m_PayloadSize);
+        sequence.store(value + 2, std::memory_order_release);
+
+        m_Stats.writes++;
+    }
+
+    uint64_t ChannelBase::Read(size_t index, void* pData, uint32_t maxRetries)
+    {
+        AssertCritical(IsOpen() && index < m_EntryCount, L"Invalid channel entry");
+
+        uint8_t*               pEntry   = Entry(index);
+        std::atomic<uint64_t>& sequence = Sequence(pEntry);
+
+        for (uint32_t attempt = 0; attempt <= maxRetries; attempt++)
+        {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before == 0)
+                break;
+
+            if (!(before & 1))
+            {
+                memcpy(pData, pEntry + ENTRY_HEADER_SIZE, m_PayloadSize);
+
+                // The payload loads stay before the second sequence load
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before)
+                {
+                    m_Stats.reads++;
+                    return before / 2;
+                }
+            }
+
+            m_Stats.retries++;
+        }
+
+        m_Stats.failedReads++;
+        return 0;
+    }
+}  // namespace tsr
@@ -0,0 +1,17 @@
+#include "layout.h"
+#include "assert.h"
+
+TSRFootprint TSRGetCopyableFootprint(uint64_t baseOffset, uint32_t width, uint32_t height, uint64_t stride)
+{
+    AssertCritical(width > 0 && height > 0 && stride > 0, L"Invalid texture footprint");
+
+    TSRFootprint footprint = {};
+    footprint.offset       = TSRAlignUp(baseOffset, TSR_PLACEMENT_ALIGNMENT);
+    footprint.rowBytes     = width * stride;
+    footprint.rowPitch     = TSRAlignUp(footprint.rowBytes, TSR_ROW_PITCH_ALIGNMENT);
+    footprint.rowCount     = height;
+
+    // Like D3D12, the last row only takes the bytes it needs
+    footprint.size = footprint.rowPitch * (height - 1) + footprint.rowBytes;
+    return footprint;
+}
@@ -0,0 +1,158 @@
+#include "liveness.h"
+#include "assert.h"
+
+const char* TSRPeerStateName(TSRPeerState state)
+{
+    switch (state)
+    {
+    case TSRPeerState::Unknown:
+        return "Unknown";
+    case TSRPeerState::Alive:
+        return "Alive";
+    case TSRPeerState::Lost:
+        return "Lost";
+    }
+    return "Unknown";
+}
+
+TSRPeerState TSRPeerMonitor::Update(uint64_t heartbeat, uint64_t nowNs)
+{
+    TSRPeerState previous = m_State;
+    if (!m_Started || heartbeat != m_Heartbeat)
+    {
+        // The first value only tells us where the counter stands, not that it counts
+        m_State     = m_Started ? TSRPeerState::Alive : m_State;
+        m_Started   = true;
+        m_Heartbeat = heartbeat;
+        m_ChangeNs  = nowNs;
+    }
+    else if (m_State != TSRPeerState::Lost && m_Heartbeat != 0 && nowNs - m_ChangeNs > m_TimeoutUs * 1000)
+    {
+        // A heartbeat that never counted at all belongs to a peer that did not start yet
+        m_State = TSRPeerState::Lost;
+        m_LostCount++;
+    }
+
+    m_Changed = m_State != previous;
+    return m_State;
+}
+
+void TSRPeerMonitor::Reset()
+{
+    m_State     = TSRPeerState::Unknown;
+    m_Changed   = false;
+    m_Started   = false;
+    m_Heartbeat = 0;
+    m_ChangeNs  = 0;
+}
+
+TSRLivenessWatch::TSRLivenessWatch(TSRSlotRing* pRing, bool producer, uint64_t timeoutUs)
+    : m_pRing(pRing)
+    , m_IsProducer(producer)
+    , m_Producer(timeoutUs)
+    , m_Consumers(producer ? pRing->GetTransport()->GetConsumerCount() : 0, TSRPeerMonitor(timeoutUs))
+{
+    AssertCritical(pRing->GetTransport()->GetControlBlock(), L"The transport has no control block to carry the heartbeats");
+}
+
+bool TSRLivenessWatch::Update(uint64_t nowNs)
+{
+    TSRTransport* pTransport = m_pRing->GetTransport();
+    m_pRing->Heartbeat(m_IsProducer);
+
+    if (!m_IsProducer)
+    {
+        m_Producer.Update(pTransport->GetProducerHeartbeat(), nowNs);
+        return m_Producer.HasChanged();
+    }
+
+    bool changed = false;
+    for (uint32_t i = 0; i < m_Consumers.size(); i++)
+    {
+        TSRPeerMonitor& monitor = m_Consumers[i];
+        monitor.Update(pTransport->GetConsumerHeartbeat(i), nowNs);
+        changed |= monitor.HasChanged();
+
+        // Frames the lost consumer holds would never be released
+        if (monitor.HasChanged() && monitor.GetState() == TSRPeerState::Lost)
+            m_pRing->ReclaimConsumer(i);
+    }
+    return changed;
+}
+
+uint32_t TSRLivenessWatch::GetConsumers(TSRPeerState state) const
+{
+    uint32_t consumers = 0;
+    for (uint32_t i = 0; i < m_Consumers.size(); i++)
+        consumers |= m_Consumers[i].GetState() == state ? 1u << i : 0;
+    return consumers;
+}
+
+bool TSRLivenessWatch::IsPeerLost() const
+{
+    if (!m_IsProducer)
+        return m_Producer.GetState() == TSRPeerState::Lost;
+
+    return GetConsumers(TSRPeerState::Lost) != 0 && GetConsumers(TSRPeerState::Alive) == 0;
+}
+
+void TSRPeerSupervisor::Watch(TSRSlotRing* pRing, bool producer)
+{
+    m_IsProducer = producer;
+    m_Fallback   = false;
+    m_Watch      = m_TimeoutUs ? std::make_unique<TSRLivenessWatch>(pRing, producer, m_TimeoutUs) : nullptr;
+}
+
+void TSRPeerSupervisor::Stop()
+{
+    m_Watch.reset();
+    m_Fallback = false;
+}
+
+bool TSRPeerSupervisor::Update(uint64_t nowNs)
+{
+    if (!m_Watch || !m_Watch->Update(nowNs))
+        return false;
+
+    bool lost = m_Watch->IsPeerLost();
+    if (m_IsProducer)
+    {
+        for (uint32_t i = 0; i < m_Watch->GetConsumerCount(); i++)
+        {
+            const TSRPeerMonitor& upscaler = m_Watch->GetConsumerMonitor(i);
+            if (!upscaler.HasChanged())
+                continue;
+
+            if (upscaler.GetState() == TSRPeerState::Lost)
+                Log(TSRLogLevel::Warning, "TSR upscaler " + std::to_string(i) + " stopped responding, its shared buffers were reclaimed");
+            else if (upscaler.GetLostCount())
+                Log(TSRLogLevel::Info, "TSR upscaler " + std::to_string(i) + " is back");
+        }
+
+        if (lost != m_Fallback)
+        {
+            m_Fallback = lost;
+            if (lost)
+                Log(TSRLogLevel::Warning, "No TSR upscaler left, upscaling in process until one comes back");
+            else
+                Log(TSRLogLevel::Info, "Sending the frames to the TSR upscaler again");
+        }
+        return false;
+    }
+
+    if (!lost)
+    {
+        if (m_Watch->GetProducerMonitor().GetLostCount())
+            Log(TSRLogLevel::Info, "The TSR renderer is back");
+        return false;
+    }
+
+    Log(TSRLogLevel::Warning, "The TSR renderer stopped responding");
+    return true;
+}
+
+void TSRPeerSupervisor::Log(TSRLogLevel level, const std::string& message) const
+{
+    if (m_Log)
+        m_Log(level, message);
+}
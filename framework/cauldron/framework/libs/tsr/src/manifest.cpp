@@ -0,0 +1,138 @@
+#include "manifest.h"
+#include "tiles.h"
+#include "assert.h"
+
+namespace
+{
+    // FNV-1a
+    void HashBytes(uint64_t& hash, const void* pData, size_t size)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    template <typename T>
+    void HashValue(uint64_t& hash, const T& value)
+    {
+        HashBytes(hash, &value, sizeof(T));
+    }
+}  // namespace
+
+size_t TSRManifest::AddResource(
+    const std::string& name, uint32_t width, uint32_t height, uint32_t format, uint64_t stride, bool optional, TSRPacking packing, float packingScale)
+{
+    AssertCritical(!m_Finalized, L"The manifest is already finalized");
+    AssertCritical(m_Resources.size() < TSR_MANIFEST_MAX_RESOURCES, L"Too many resources in the manifest");
+    AssertCritical(FindResource(name) == INVALID_RESOURCE, L"Duplicate resource name in the manifest");
+
+    AssertCritical(packing != TSRPacking::MotionRG16Snorm || packingScale > 0.0f, L"Invalid motion vector packing scale");
+
+    if (packing != TSRPacking::None)
+        stride = TSRGetPackedStride(packing);
+
+    m_Resources.push_back(TSRResourceDesc{name, width, height, format, stride, optional, packing, packingScale, 0, 0, 0});
+    return m_Resources.size() - 1;
+}
+
+void TSRManifest::SetTileSize(uint32_t tileSize)
+{
+    AssertCritical(!m_Finalized, L"The manifest is already finalized");
+    AssertCritical(tileSize > 0, L"Invalid tile size");
+    m_TileSize = tileSize;
+}
+
+void TSRManifest::Finalize()
+{
+    AssertCritical(!m_Finalized, L"The manifest is already finalized");
+
+    // Lay the resources out back to back, honoring the copy footprint alignment rules
+    uint64_t offset = 0;
+    for (TSRResourceDesc& resource : m_Resources)
+    {
+        TSRFootprint footprint = TSRGetCopyableFootprint(offset, resource.width, resource.height, resource.stride);
+        resource.rowPitch      = footprint.rowPitch;
+        resource.offset        = footprint.offset;
+        resource.size          = footprint.size;
+        offset                 = footprint.offset + footprint.size;
+    }
+
+    // The tile map goes after the resources
+    if (m_TileSize && !m_Resources.empty())
+    {
+        m_TileMapOffset = TSRAlignUp(offset, TSR_PLACEMENT_ALIGNMENT);
+        offset          = m_TileMapOffset + TSRTileMap::GetBitmapSize(m_Resources[0].width, m_Resources[0].height, m_TileSize);
+    }
+
+    m_TotalSize = TSRAlignUp(offset, TSR_PLACEMENT_ALIGNMENT);
+    m_Finalized = true;
+}
+
+size_t TSRManifest::FindResource(const std::string& name) const
+{
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        if (m_Resources[i].name == name)
+            return i;
+    }
+    return INVALID_RESOURCE;
+}
+
+uint64_t TSRManifest::GetTiledMask() const
+{
+    if (!m_TileSize)
+        return 0;
+
+    uint64_t mask = 0;
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        if (m_Resources[i].width == m_Resources[0].width && m_Resources[i].height == m_Resources[0].height)
+            mask |= 1ull << i;
+    }
+    return mask;
+}
+
+TSRLayoutReport TSRManifest::GetLayoutReport() const
+{
+    TSRLayoutReport report;
+    report.totalBytes = m_TotalSize;
+
+    for (const TSRResourceDesc& resource : m_Resources)
+    {
+        uint64_t rowBytes = resource.width * resource.stride;
+        report.texelBytes += rowBytes * resource.height;
+        report.rowPaddingBytes += (resource.rowPitch - rowBytes) * (resource.height - 1);
+    }
+
+    if (m_TileSize)
+        report.tileMapBytes = TSRTileMap::GetBitmapSize(m_Resources[0].width, m_Resources[0].height, m_TileSize);
+
+    report.placementPaddingBytes = report.totalBytes - report.texelBytes - report.rowPaddingBytes - report.tileMapBytes;
+    return report;
+}
+
+uint64_t TSRManifest::GetHash() const
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    HashValue(hash, TSR_MANIFEST_VERSION);
+    HashValue(hash, m_TileSize);
+
+    for (const TSRResourceDesc& resource : m_Resources)
+    {
+        HashBytes(hash, resource.name.data(), resource.name.size());
+        HashValue(hash, resource.width);
+        HashValue(hash, resource.height);
+        HashValue(hash, resource.format);
+        HashValue(hash, resource.stride);
+        HashValue(hash, resource.optional);
+        HashValue(hash, resource.packing);
+        HashValue(hash, resource.packingScale);
+        HashValue(hash, resource.rowPitch);
+        HashValue(hash, resource.offset);
+    }
+
+    return hash;
+}
@@ -0,0 +1,51 @@
+#include "metadata.h"
+
+bool TSRMetadataChecker::Check(const TSRFrameMetadata& metadata, uint64_t sideFrameId)
+{
+    m_Stats.frames++;
+
+    if (!metadata.renderTimeNs)
+    {
+        m_Stats.missing++;
+        return false;
+    }
+
+    bool consistent = true;
+    if (sideFrameId != NO_SIDE_DATA && sideFrameId != metadata.frameId)
+    {
+        m_Stats.mismatches++;
+        consistent = false;
+    }
+
+    // Dropped frames show up as gaps, they are not an inconsistency of this frame
+    if (m_HasLastFrame)
+    {
+        if (metadata.frameId == m_LastFrameId)
+        {
+            m_Stats.repeats++;
+            consistent = false;
+        }
+        else if (metadata.frameId < m_LastFrameId)
+        {
+            m_Stats.reversals++;
+            consistent = false;
+        }
+        else
+        {
+            m_Stats.gaps += metadata.frameId - m_LastFrameId - 1;
+        }
+    }
+
+    m_LastFrameId  = metadata.frameId;
+    m_HasLastFrame = true;
+    return consistent;
+}
+
+bool TSRMetadataChecker::CheckManifest(uint64_t slotManifestHash, uint64_t manifestHash)
+{
+    if (slotManifestHash == manifestHash)
+        return true;
+
+    m_Stats.manifests++;
+    return false;
+}
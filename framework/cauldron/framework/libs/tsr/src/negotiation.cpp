@@ -0,0 +1,534 @@
+#include "negotiation.h"
+#include "assert.h"
+#include "timing.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    template <size_t Size>
+    void CopyString(char (&destination)[Size], const std::string& source)
+    {
+        size_t length = std::min(source.size(), Size - 1);
+        memcpy(destination, source.c_str(), length);
+        destination[length] = 0;
+    }
+
+    template <size_t Size>
+    std::string ToString(const char (&source)[Size])
+    {
+        return std::string(source, strnlen(source, Size));
+    }
+}  // namespace
+
+const char* TSRNegotiationStateName(TSRNegotiationState state)
+{
+    switch (state)
+    {
+    case TSRNegotiationState::Idle:
+        return "Idle";
+    case TSRNegotiationState::Negotiating:
+        return "Negotiating";
+    case TSRNegotiationState::Allocating:
+        return "Allocating";
+    case TSRNegotiationState::Running:
+        return "Running";
+    case TSRNegotiationState::Failed:
+        return "Failed";
+    }
+    return "Unknown";
+}
+
+const char* TSRAnswerStatusName(TSRAnswerStatus status)
+{
+    switch (status)
+    {
+    case TSRAnswerStatus::Accepted:
+        return "Accepted";
+    case TSRAnswerStatus::Counter:
+        return "Counter";
+    case TSRAnswerStatus::Rejected:
+        return "Rejected";
+    }
+    return "Unknown";
+}
+
+void TSRDescribeManifest(const TSRManifest& manifest, TSROffer& offer)
+{
+    AssertCritical(manifest.IsFinalized(), L"The manifest is not finalized");
+
+    offer.resourceCount = static_cast<uint32_t>(manifest.GetResourceCount());
+    offer.manifestHash  = manifest.GetHash();
+    for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+    {
+        const TSRResourceDesc& desc     = manifest.GetResource(i);
+        TSROfferResource&      resource = offer.resources[i];
+        AssertCritical(desc.name.size() < sizeof(resource.name), L"The resource name is too long to offer");
+
+        CopyString(resource.name, desc.name);
+        resource.width        = desc.width;
+        resource.height       = desc.height;
+        resource.format       = desc.format;
+        resource.optional     = desc.optional ? 1 : 0;
+        resource.stride       = desc.stride;
+        resource.packing      = static_cast<uint32_t>(desc.packing);
+        resource.packingScale = desc.packingScale;
+    }
+}
+
+bool TSRBuildManifest(const TSROffer& offer, uint32_t tileSize, TSRManifest& manifest)
+{
+    if (offer.resourceCount == 0 || offer.resourceCount > TSR_MANIFEST_MAX_RESOURCES)
+        return false;
+
+    manifest = TSRManifest();
+    for (uint32_t i = 0; i < offer.resourceCount; i++)
+    {
+        const TSROfferResource& resource = offer.resources[i];
+        std::string             name     = ToString(resource.name);
+
+        // What AddResource would assert on, the offer may come from anywhere
+        bool validPacking = resource.packing <= static_cast<uint32_t>(TSRPacking::ColorR11G11B10) &&
+                            (resource.packing != static_cast<uint32_t>(TSRPacking::MotionRG16Snorm) || resource.packingScale > 0.0f);
+        if (!validPacking || manifest.FindResource(name) != TSRManifest::INVALID_RESOURCE)
+            return false;
+
+        manifest.AddResource(name,
+                             resource.width,
+                             resource.height,
+                             resource.format,
+                             resource.stride,
+                             resource.optional != 0,
+                             static_cast<TSRPacking>(resource.packing),
+                             resource.packingScale);
+    }
+    if (tileSize)
+        manifest.SetTileSize(tileSize);
+    manifest.Finalize();
+    return manifest.GetHash() == offer.manifestHash;
+}
+
+std::string TSRCompareManifest(const TSROffer& offer, const TSRManifest& manifest)
+{
+    if (offer.resourceCount != manifest.GetResourceCount())
+        return "the renderer sends " + std::to_string(offer.resourceCount) + " resources, the upscaler reads " + std::to_string(manifest.GetResourceCount());
+
+    // Same order, the resource masks are indexed like the manifest
+    for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+    {
+        const TSRResourceDesc&  desc     = manifest.GetResource(i);
+        const TSROfferResource& resource = offer.resources[i];
+        std::string             name     = ToString(resource.name);
+
+        if (name != desc.name)
+            return "resource " + std::to_string(i) + " is " + name + " on the renderer and " + desc.name + " on the upscaler";
+        if (resource.width != desc.width || resource.height != desc.height)
+        {
+            return name + " is " + std::to_string(resource.width) + "x" + std::to_string(resource.height) + " on the renderer and " +
+                   std::to_string(desc.width) + "x" + std::to_string(desc.height) + " on the upscaler";
+        }
+        if (resource.format != desc.format || resource.stride != desc.stride)
+            return name + " has format " + std::to_string(resource.format) + " on the renderer and " + std::to_string(desc.format) + " on the upscaler";
+        if (resource.optional != (desc.optional ? 1u : 0u))
+            return name + " is optional on one side only";
+        if (resource.packing != static_cast<uint32_t>(desc.packing) || resource.packingScale != desc.packingScale)
+            return name + " is packed differently";
+    }
+
+    // Anything else that goes into the layout
+    if (offer.manifestHash != manifest.GetHash())
+        return "the shared buffer layouts differ";
+    return std::string();
+}
+
+TSRAnswer TSREvaluateOffer(const TSROffer& offer, const TSRCapabilities& capabilities)
+{
+    TSRAnswer answer    = {};
+    answer.generation   = offer.generation;
+    answer.status       = TSRAnswerStatus::Accepted;
+    answer.slotCount    = offer.slotCount;
+    answer.renderWidth  = offer.renderWidth;
+    answer.renderHeight = offer.renderHeight;
+
+    if (offer.slotCount < capabilities.minSlots)
+    {
+        answer.status = TSRAnswerStatus::Rejected;
+        snprintf(answer.reason, sizeof(answer.reason), "at least %llu shared buffers are needed", static_cast<unsigned long long>(capabilities.minSlots));
+        return answer;
+    }
+
+    if (offer.slotCount > capabilities.maxSlots)
+    {
+        answer.status    = TSRAnswerStatus::Counter;
+        answer.slotCount = capabilities.maxSlots;
+        snprintf(answer.reason, sizeof(answer.reason), "at most %llu shared buffers", static_cast<unsigned long long>(capabilities.maxSlots));
+    }
+
+    if (offer.renderWidth > capabilities.maxRenderWidth || offer.renderHeight > capabilities.maxRenderHeight)
+    {
+        // Scale down to fit both limits
+        double scale = std::min(static_cast<double>(capabilities.maxRenderWidth) / offer.renderWidth,
+                                static_cast<double>(capabilities.maxRenderHeight) / offer.renderHeight);
+        answer.status       = TSRAnswerStatus::Counter;
+        answer.renderWidth  = std::max(1u, static_cast<uint32_t>(offer.renderWidth * scale));
+        answer.renderHeight = std::max(1u, static_cast<uint32_t>(offer.renderHeight * scale));
+        snprintf(answer.reason, sizeof(answer.reason), "at most %ux%u", capabilities.maxRenderWidth, capabilities.maxRenderHeight);
+    }
+    return answer;
+}
+
+bool TSRControlChannel::Open(const std::string& sharedName, uint32_t consumerCount, bool shouldCreate)
+{
+    AssertCritical(consumerCount > 0, L"Invalid consumer count");
+
+    if (!m_Offers.Open(sharedName + "_TSR_OFFER", 1, shouldCreate))
+        return false;
+
+    if (!m_Answers.Open(sharedName + "_TSR_ANSWERS", consumerCount, shouldCreate))
+    {
+        m_Offers.Close();
+        return false;
+    }
+
+    m_ConsumerCount = consumerCount;
+    m_Offer         = {};
+    return true;
+}
+
+void TSRControlChannel::Close()
+{
+    m_Offers.Close();
+    m_Answers.Close();
+}
+
+uint64_t TSRControlChannel::Offer(const TSROffer& offer)
+{
+    // A restarted renderer must not reuse the generations (and shared buffer names) of the previous one, so the first
+    // generation comes from the clock
+    uint64_t generation = m_Offer.generation ? m_Offer.generation + 1 : tsr_now_ns();
+
+    m_Offer            = offer;
+    m_Offer.generation = generation;
+    m_Offer.state      = TSROfferState::Proposed;
+    m_Offers.Write(0, m_Offer);
+    return generation;
+}
+
+void TSRControlChannel::Commit()
+{
+    AssertCritical(m_Offer.generation != 0, L"Nothing was offered");
+
+    m_Offer.state = TSROfferState::Committed;
+    m_Offers.Write(0, m_Offer);
+}
+
+bool TSRControlChannel::PollAnswers(TSRAnswer& answer)
+{
+    answer              = {};
+    answer.generation   = m_Offer.generation;
+    answer.status       = TSRAnswerStatus::Accepted;
+    answer.slotCount    = m_Offer.slotCount;
+    answer.renderWidth  = m_Offer.renderWidth;
+    answer.renderHeight = m_Offer.renderHeight;
+
+    for (uint32_t i = 0; i < m_ConsumerCount; i++)
+    {
+        TSRAnswer consumerAnswer = {};
+        if (!m_Answers.Read(i, consumerAnswer) || consumerAnswer.generation != m_Offer.generation)
+            return false;
+
+        if (consumerAnswer.status == TSRAnswerStatus::Accepted || answer.status == TSRAnswerStatus::Rejected)
+            continue;
+
+        if (consumerAnswer.status == TSRAnswerStatus::Rejected)
+        {
+            answer.status = TSRAnswerStatus::Rejected;
+            memcpy(answer.reason, consumerAnswer.reason, sizeof(answer.reason));
+            continue;
+        }
+
+        answer.status       = TSRAnswerStatus::Counter;
+        answer.slotCount    = std::min(answer.slotCount, consumerAnswer.slotCount);
+        answer.renderWidth  = std::min(answer.renderWidth, consumerAnswer.renderWidth);
+        answer.renderHeight = std::min(answer.renderHeight, consumerAnswer.renderHeight);
+        memcpy(answer.reason, consumerAnswer.reason, sizeof(answer.reason));
+    }
+
+    answer.reason[sizeof(answer.reason) - 1] = 0;
+    return true;
+}
+
+bool TSRControlChannel::PollOffer(TSROffer& offer)
+{
+    TSROffer latest;
+    if (!m_Offers.Read(0, latest))
+        return false;
+
+    if (latest.generation == m_Offer.generation && latest.state == m_Offer.state)
+        return false;
+
+    m_Offer = latest;
+    offer   = latest;
+    return true;
+}
+
+void TSRControlChannel::Answer(uint32_t consumer, const TSRAnswer& answer)
+{
+    m_Answers.Write(consumer, answer);
+}
+
+TSRNegotiator::TSRNegotiator(const std::string& sharedName, uint32_t consumerCount, uint32_t consumerIndex, bool isProducer, TSRNegotiationHooks hooks)
+    : m_SharedName(sharedName)
+    , m_ConsumerCount(consumerCount)
+    , m_ConsumerIndex(consumerIndex)
+    , m_IsProducer(isProducer)
+    , m_Hooks(std::move(hooks))
+{
+    AssertCritical(m_Hooks.buildManifest && m_Hooks.resize && m_Hooks.allocate && m_Hooks.install && m_Hooks.drop, L"Missing negotiation hooks");
+    AssertCritical(isProducer || m_Hooks.capabilities, L"An upscaler needs its capabilities to answer offers");
+}
+
+bool TSRNegotiator::Start(uint64_t slotCount, uint64_t maxSlots, uint32_t renderWidth, uint32_t renderHeight)
+{
+    AssertCritical(m_IsProducer && slotCount > 0 && slotCount <= maxSlots, L"Invalid shared buffer count");
+
+    m_SlotCount    = slotCount;
+    m_MaxSlots     = maxSlots;
+    m_RenderWidth  = renderWidth;
+    m_RenderHeight = renderHeight;
+    return m_Channel.Open(m_SharedName, m_ConsumerCount, true);
+}
+
+void TSRNegotiator::Start(uint32_t renderWidth, uint32_t renderHeight)
+{
+    AssertCritical(!m_IsProducer, L"The renderer offers the shared buffers");
+
+    m_RenderWidth  = renderWidth;
+    m_RenderHeight = renderHeight;
+}
+
+bool TSRNegotiator::Update()
+{
+    if (m_IsProducer)
+    {
+        AssertCritical(m_Channel.IsOpen(), L"The negotiation was not started");
+
+        TSRAnswer answer;
+        switch (m_State)
+        {
+        case TSRNegotiationState::Idle:
+            Offer();
+            return false;
+        case TSRNegotiationState::Negotiating:
+            if (m_Channel.PollAnswers(answer))
+                HandleAnswer(answer);
+            return false;
+        case TSRNegotiationState::Allocating:
+            if (!m_Hooks.install())
+                return false;
+
+            // The upscalers open the shared buffers once they exist
+            m_State = TSRNegotiationState::Running;
+            m_Channel.Commit();
+            return true;
+        case TSRNegotiationState::Running:
+            // An upscaler may ask for another resolution at any time
+            if (m_Channel.PollAnswers(answer) && answer.status != TSRAnswerStatus::Accepted)
+            {
+                HandleAnswer(answer);
+                return false;
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // The renderer creates the control channel, it may not be running yet
+    if (!m_Channel.IsOpen() && !m_Channel.Open(m_SharedName, m_ConsumerCount, false))
+        return false;
+
+    TSROffer offer;
+    if (m_Channel.PollOffer(offer))
+    {
+        if (offer.generation != m_AcceptedGeneration)
+        {
+            // The shared buffers we read are about to be replaced
+            m_Hooks.drop();
+            AnswerOffer(offer);
+        }
+
+        if (offer.state == TSROfferState::Committed && offer.generation == m_AcceptedGeneration)
+            Allocate(offer.generation);
+    }
+
+    if (m_State == TSRNegotiationState::Allocating && m_Hooks.install())
+        m_State = TSRNegotiationState::Running;
+    return m_State == TSRNegotiationState::Running;
+}
+
+void TSRNegotiator::Resize(uint32_t renderWidth, uint32_t renderHeight)
+{
+    m_RenderWidth  = renderWidth;
+    m_RenderHeight = renderHeight;
+    if (m_IsProducer)
+    {
+        if (m_Channel.IsOpen())
+            Offer();
+        return;
+    }
+
+    // Ask the renderer for the resolution our upscaler picked, the shared buffers we read no longer fit it
+    if (!m_Channel.IsOpen() || !m_Channel.GetOffer().generation)
+        return;
+
+    m_Hooks.drop();
+    m_AcceptedGeneration = 0;
+    m_State              = TSRNegotiationState::Negotiating;
+
+    TSRAnswer answer    = {};
+    answer.generation   = m_Channel.GetOffer().generation;
+    answer.status       = TSRAnswerStatus::Counter;
+    answer.slotCount    = m_Channel.GetOffer().slotCount;
+    answer.renderWidth  = m_RenderWidth;
+    answer.renderHeight = m_RenderHeight;
+    snprintf(answer.reason, sizeof(answer.reason), "the upscaler renders at %ux%u", m_RenderWidth, m_RenderHeight);
+    m_Channel.Answer(m_ConsumerIndex, answer);
+}
+
+void TSRNegotiator::PeerLost()
+{
+    AssertCritical(!m_IsProducer, L"Only the upscaler waits for a new generation");
+
+    // A renderer that comes back (or its successor) offers a new generation
+    m_AcceptedGeneration = 0;
+    m_State              = TSRNegotiationState::Negotiating;
+    m_Hooks.drop();
+}
+
+void TSRNegotiator::Offer()
+{
+    m_Manifest = m_Hooks.buildManifest();
+
+    TSROffer offer     = {};
+    offer.renderWidth  = m_RenderWidth;
+    offer.renderHeight = m_RenderHeight;
+    offer.slotCount    = m_SlotCount;
+    TSRDescribeManifest(m_Manifest, offer);
+
+    uint64_t generation = m_Channel.Offer(offer);
+    m_State             = TSRNegotiationState::Negotiating;
+
+    char message[128];
+    snprintf(message,
+             sizeof(message),
+             "TSR offers generation %llu: %llu shared buffers at %ux%u",
+             static_cast<unsigned long long>(generation),
+             static_cast<unsigned long long>(m_SlotCount),
+             m_RenderWidth,
+             m_RenderHeight);
+    Log(TSRLogLevel::Info, message);
+}
+
+void TSRNegotiator::HandleAnswer(const TSRAnswer& answer)
+{
+    if (answer.status == TSRAnswerStatus::Accepted)
+    {
+        m_CounterCount = 0;
+        Allocate(answer.generation);
+        return;
+    }
+
+    if (answer.status == TSRAnswerStatus::Rejected)
+    {
+        Fail(std::string("The upscaler rejected the TSR shared buffers: ") + answer.reason);
+        return;
+    }
+
+    // Counters that change nothing (or keep contradicting each other) would go on forever
+    uint64_t slotCount = std::min(answer.slotCount, m_MaxSlots);
+    bool     changed   = slotCount != m_SlotCount || answer.renderWidth != m_RenderWidth || answer.renderHeight != m_RenderHeight;
+    if (!changed || ++m_CounterCount > MAX_COUNTERS)
+    {
+        Fail(std::string("The upscalers keep countering the TSR shared buffers: ") + answer.reason);
+        return;
+    }
+
+    Log(TSRLogLevel::Info, std::string("The upscaler countered the TSR shared buffers: ") + answer.reason);
+    m_Hooks.drop();
+    m_SlotCount = slotCount;
+    if (answer.renderWidth != m_RenderWidth || answer.renderHeight != m_RenderHeight)
+    {
+        m_RenderWidth  = answer.renderWidth;
+        m_RenderHeight = answer.renderHeight;
+        m_Hooks.resize(m_RenderWidth, m_RenderHeight);
+    }
+
+    Offer();
+}
+
+void TSRNegotiator::AnswerOffer(const TSROffer& offer)
+{
+    TSRAnswer answer = TSREvaluateOffer(offer, m_Hooks.capabilities());
+    if (answer.status == TSRAnswerStatus::Accepted)
+    {
+        // Our textures follow the renderer's resolution, then the resources have to match
+        if (offer.renderWidth != m_RenderWidth || offer.renderHeight != m_RenderHeight)
+        {
+            m_RenderWidth  = offer.renderWidth;
+            m_RenderHeight = offer.renderHeight;
+            m_Hooks.resize(m_RenderWidth, m_RenderHeight);
+        }
+
+        m_Manifest             = m_Hooks.buildManifest();
+        std::string difference = TSRCompareManifest(offer, m_Manifest);
+        if (!difference.empty())
+        {
+            answer.status = TSRAnswerStatus::Rejected;
+            snprintf(answer.reason, sizeof(answer.reason), "%s", difference.c_str());
+        }
+    }
+
+    m_Channel.Answer(m_ConsumerIndex, answer);
+    m_AcceptedGeneration = answer.status == TSRAnswerStatus::Accepted ? offer.generation : 0;
+    m_SlotCount          = answer.status == TSRAnswerStatus::Accepted ? offer.slotCount : m_SlotCount;
+    m_State              = answer.status == TSRAnswerStatus::Rejected ? TSRNegotiationState::Failed : TSRNegotiationState::Negotiating;
+
+    char message[256];
+    if (answer.status == TSRAnswerStatus::Rejected)
+    {
+        snprintf(message, sizeof(message), "TSR generation %llu rejected: %s", static_cast<unsigned long long>(offer.generation), answer.reason);
+        Log(TSRLogLevel::Error, message);
+        return;
+    }
+
+    snprintf(message,
+             sizeof(message),
+             "TSR generation %llu %s: %llu shared buffers at %ux%u",
+             static_cast<unsigned long long>(offer.generation),
+             TSRAnswerStatusName(answer.status),
+             static_cast<unsigned long long>(answer.slotCount),
+             answer.renderWidth,
+             answer.renderHeight);
+    Log(TSRLogLevel::Info, message);
+}
+
+void TSRNegotiator::Allocate(uint64_t generation)
+{
+    m_State = TSRNegotiationState::Allocating;
+    m_Hooks.allocate(generation, m_SlotCount, m_Manifest);
+}
+
+void TSRNegotiator::Fail(const std::string& message)
+{
+    Log(TSRLogLevel::Error, message);
+    m_Hooks.drop();
+    m_State = TSRNegotiationState::Failed;
+}
+
+void TSRNegotiator::Log(TSRLogLevel level, const std::string& message) const
+{
+    if (m_Hooks.log)
+        m_Hooks.log(level, message);
+}
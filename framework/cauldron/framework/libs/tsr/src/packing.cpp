@@ -0,0 +1,228 @@
+#include "packing.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Unsigned float with a 5 bit exponent (bias 15) and mantissaBits of mantissa, as in R11G11B10_FLOAT
+    uint32_t FloatToSmallFloat(float value, uint32_t mantissaBits)
+    {
+        // Negatives and NaN go to 0
+        if (!(value > 0.0f))
+            return 0;
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        int32_t  exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = bits & 0x7fffff;
+        uint32_t maxValue = (30u << mantissaBits) | ((1u << mantissaBits) - 1);  // Largest finite value
+
+        if (exponent >= 31)
+            return maxValue;
+
+        if (exponent <= 0)
+        {
+            // Denormal, round to nearest
+            uint32_t shift = 23 - mantissaBits + 1 - exponent;
+            if (shift > 24)
+                return 0;
+            mantissa |= 0x800000;
+            return (mantissa + (1u << (shift - 1))) >> shift;
+        }
+
+        // Round to nearest, a carry out of the mantissa correctly bumps the exponent
+        uint32_t shift  = 23 - mantissaBits;
+        uint32_t result = (static_cast<uint32_t>(exponent) << mantissaBits) | (mantissa >> shift);
+        result += (mantissa >> (shift - 1)) & 1;
+        return std::min(result, maxValue);
+    }
+
+    float SmallFloatToFloat(uint32_t value, uint32_t mantissaBits)
+    {
+        uint32_t exponent = value >> mantissaBits;
+        uint32_t mantissa = value & ((1u << mantissaBits) - 1);
+
+        if (exponent == 0)
+            return std::ldexp(static_cast<float>(mantissa), -14 - static_cast<int32_t>(mantissaBits));
+        if (exponent == 31)
+            return mantissa ? NAN : INFINITY;
+        return std::ldexp(1.0f + static_cast<float>(mantissa) / (1u << mantissaBits), static_cast<int32_t>(exponent) - 15);
+    }
+}  // namespace
+
+const char* TSRGetPackingName(TSRPacking packing)
+{
+    switch (packing)
+    {
+    case TSRPacking::Depth24Unorm:
+        return "Depth24Unorm";
+    case TSRPacking::MotionRG16Snorm:
+        return "MotionRG16Snorm";
+    case TSRPacking::ColorR11G11B10:
+        return "ColorR11G11B10";
+    default:
+        return "None";
+    }
+}
+
+bool TSRParsePacking(const char* pName, TSRPacking& packing)
+{
+    for (TSRPacking candidate : {TSRPacking::None, TSRPacking::Depth24Unorm, TSRPacking::MotionRG16Snorm, TSRPacking::ColorR11G11B10})
+    {
+        if (strcmp(pName, TSRGetPackingName(candidate)) == 0)
+        {
+            packing = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t TSRGetPackingComponents(TSRPacking packing)
+{
+    switch (packing)
+    {
+    case TSRPacking::Depth24Unorm:
+        return 1;
+    case TSRPacking::MotionRG16Snorm:
+        return 2;
+    case TSRPacking::ColorR11G11B10:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+uint64_t TSRGetPackedStride(TSRPacking packing)
+{
+    switch (packing)
+    {
+    case TSRPacking::Depth24Unorm:
+        return 3;
+    case TSRPacking::MotionRG16Snorm:
+    case TSRPacking::ColorR11G11B10:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void TSRPackRow(TSRPacking packing, const float* pSrc, uint32_t srcComponents, uint8_t* pDst, uint32_t count, float scale)
+{
+    AssertCritical(srcComponents >= TSRGetPackingComponents(packing), L"Not enough components to pack");
+
+    for (uint32_t i = 0; i < count; i++, pSrc += srcComponents)
+    {
+        switch (packing)
+        {
+        case TSRPacking::Depth24Unorm:
+        {
+            uint32_t depth = static_cast<uint32_t>(std::lround(std::min(std::max(pSrc[0], 0.0f), 1.0f) * 16777215.0f));
+            *pDst++        = static_cast<uint8_t>(depth);
+            *pDst++        = static_cast<uint8_t>(depth >> 8);
+            *pDst++        = static_cast<uint8_t>(depth >> 16);
+            break;
+        }
+        case TSRPacking::MotionRG16Snorm:
+        {
+            for (uint32_t c = 0; c < 2; c++)
+            {
+                int16_t motion = static_cast<int16_t>(std::lround(std::min(std::max(pSrc[c] / scale, -1.0f), 1.0f) * 32767.0f));
+                memcpy(pDst, &motion, sizeof(motion));
+                pDst += sizeof(motion);
+            }
+            break;
+        }
+        case TSRPacking::ColorR11G11B10:
+        {
+            uint32_t color = FloatToSmallFloat(pSrc[0], 6) | (FloatToSmallFloat(pSrc[1], 6) << 11) | (FloatToSmallFloat(pSrc[2], 5) << 22);
+            memcpy(pDst, &color, sizeof(color));
+            pDst += sizeof(color);
+            break;
+        }
+        default:
+            AssertCritical(false, L"Invalid packing");
+        }
+    }
+}
+
+void TSRUnpackRow(TSRPacking packing, const uint8_t* pSrc, float* pDst, uint32_t dstComponents, uint32_t count, float scale)
+{
+    AssertCritical(dstComponents >= TSRGetPackingComponents(packing), L"Not enough components to unpack to");
+
+    for (uint32_t i = 0; i < count; i++, pDst += dstComponents)
+    {
+        // Components the packing doesn't carry
+        for (uint32_t c = 0; c < dstComponents; c++)
+            pDst[c] = c == 3 ? 1.0f : 0.0f;
+
+        switch (packing)
+        {
+        case TSRPacking::Depth24Unorm:
+        {
+            uint32_t depth = pSrc[0] | (pSrc[1] << 8) | (pSrc[2] << 16);
+            pDst[0]        = depth / 16777215.0f;
+            pSrc += 3;
+            break;
+        }
+        case TSRPacking::MotionRG16Snorm:
+        {
+            for (uint32_t c = 0; c < 2; c++)
+            {
+                int16_t motion;
+                memcpy(&motion, pSrc, sizeof(motion));
+                pDst[c] = std::max(motion / 32767.0f, -1.0f) * scale;
+                pSrc += sizeof(motion);
+            }
+            break;
+        }
+        case TSRPacking::ColorR11G11B10:
+        {
+            uint32_t color;
+            memcpy(&color, pSrc, sizeof(color));
+            pDst[0] = SmallFloatToFloat(color & 0x7ff, 6);
+            pDst[1] = SmallFloatToFloat((color >> 11) & 0x7ff, 6);
+            pDst[2] = SmallFloatToFloat(color >> 22, 5);
+            pSrc += sizeof(color);
+            break;
+        }
+        default:
+            AssertCritical(false, L"Invalid packing");
+        }
+    }
+}
+
+TSRPackingError TSRMeasurePackingError(TSRPacking packing, const float* pSrc, uint32_t srcComponents, uint32_t count, float scale)
+{
+    uint32_t components = TSRGetPackingComponents(packing);
+
+    std::vector<uint8_t> packed(TSRGetPackedStride(packing) * count);
+    std::vector<float>   unpacked(static_cast<size_t>(components) * count);
+    TSRPackRow(packing, pSrc, srcComponents, packed.data(), count, scale);
+    TSRUnpackRow(packing, packed.data(), unpacked.data(), components, count, scale);
+
+    TSRPackingError error;
+    double          squaredError = 0.0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t c = 0; c < components; c++)
+        {
+            double source   = pSrc[i * srcComponents + c];
+            double absError = std::fabs(unpacked[i * components + c] - source);
+
+            error.maxAbsError = std::max(error.maxAbsError, absError);
+            if (std::fabs(source) > 1e-6)
+                error.maxRelError = std::max(error.maxRelError, absError / std::fabs(source));
+            squaredError += absError * absError;
+            error.count++;
+        }
+    }
+
+    error.rmse = error.count ? std::sqrt(squaredError / error.count) : 0.0;
+    return error;
+}
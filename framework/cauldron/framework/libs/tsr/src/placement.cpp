@@ -0,0 +1,185 @@
+#include "placement.h"
+#include "layout.h"
+#include "manifest.h"
+#include "assert.h"
+
+#include <algorithm>
+
+size_t TSRPlacedSlots::AddResource(size_t manifestIndex, const TSRPlacedResourceDesc& desc)
+{
+    AssertCritical(!IsCreated(), L"The slot heaps are already created");
+    AssertCritical(manifestIndex < TSR_MANIFEST_MAX_RESOURCES, L"Invalid manifest resource index");
+    AssertCritical(!(GetAliasedMask() & (1ull << manifestIndex)), L"The manifest resource is already placed");
+
+    m_Descs.push_back(desc);
+    m_ManifestIndices.push_back(manifestIndex);
+    return m_Descs.size() - 1;
+}
+
+bool TSRPlacedSlots::Create(const std::string& sharedName, uint64_t slotCount, bool shouldCreate)
+{
+    AssertCritical(!IsCreated(), L"The slot heaps are already created");
+    AssertCritical(slotCount > 0 && !m_Descs.empty(), L"Nothing to place in the slot heaps");
+
+    // Every slot heap holds the resources back to back, the same way in both processes
+    m_Offsets.clear();
+    uint64_t offset = 0;
+    for (const TSRPlacedResourceDesc& desc : m_Descs)
+    {
+        TSRAllocationInfo info = m_pAllocator->GetAllocationInfo(desc);
+        offset                 = TSRAlignUp(offset, std::max<uint64_t>(info.alignment, 1));
+        m_Offsets.push_back(offset);
+        offset += info.size;
+    }
+    m_HeapSize = TSRAlignUp(offset, TSR_HEAP_ALIGNMENT);
+
+    m_Heaps.reserve(slotCount);
+    m_Resources.reserve(slotCount * m_Descs.size());
+    for (uint64_t slot = 0; slot < slotCount; slot++)
+    {
+        void* pHeap = m_pAllocator->CreateHeap(sharedName + std::to_string(slot) + "_HEAP", m_HeapSize, shouldCreate);
+        if (!pHeap)
+        {
+            Destroy();
+            return false;
+        }
+        m_Heaps.push_back(pHeap);
+
+        for (size_t i = 0; i < m_Descs.size(); i++)
+        {
+            void* pResource = m_pAllocator->CreatePlacedResource(pHeap, m_Offsets[i], m_Descs[i]);
+            if (!pResource)
+            {
+                Destroy();
+                return false;
+            }
+            m_Resources.push_back(pResource);
+        }
+    }
+
+    m_CurrentSlot = UINT64_MAX;
+    return true;
+}
+
+void TSRPlacedSlots::Destroy()
+{
+    for (void* pResource : m_Resources)
+        m_pAllocator->ReleaseResource(pResource);
+    for (void* pHeap : m_Heaps)
+        m_pAllocator->ReleaseHeap(pHeap);
+
+    m_Resources.clear();
+    m_Heaps.clear();
+    m_CurrentSlot = UINT64_MAX;
+}
+
+uint64_t TSRPlacedSlots::GetAliasedMask() const
+{
+    uint64_t mask = 0;
+    for (size_t manifestIndex : m_ManifestIndices)
+        mask |= 1ull << manifestIndex;
+    return mask;
+}
+
+bool TSRPlacedSlots::SetCurrentSlot(uint64_t slot)
+{
+    AssertCritical(slot < m_Heaps.size(), L"Invalid slot index");
+    if (slot == m_CurrentSlot)
+        return false;
+
+    m_CurrentSlot = slot;
+    m_Rotations++;
+    return true;
+}
+
+TSRMockAllocator::~TSRMockAllocator()
+{
+    for (auto& entry : m_Heaps)
+    {
+        for (Resource* pResource : entry.second->resources)
+            delete pResource;
+    }
+}
+
+bool TSRMockAllocator::Allocate()
+{
+    if (!m_Remaining)
+        return false;
+    if (m_Remaining != UINT64_MAX)
+        m_Remaining--;
+    return true;
+}
+
+TSRAllocationInfo TSRMockAllocator::GetAllocationInfo(const TSRPlacedResourceDesc& desc)
+{
+    TSRAllocationInfo info;
+    info.size      = TSRAlignUp(desc.width * desc.stride, TSR_ROW_PITCH_ALIGNMENT) * desc.height;
+    info.alignment = TSR_HEAP_ALIGNMENT;
+    return info;
+}
+
+void* TSRMockAllocator::CreateHeap(const std::string& name, uint64_t size, bool shouldCreate)
+{
+    auto it = m_Heaps.find(name);
+    if (shouldCreate)
+    {
+        if (it != m_Heaps.end() || !Allocate())
+            return nullptr;
+
+        std::unique_ptr<Heap> pHeap = std::make_unique<Heap>();
+        pHeap->name                 = name;
+        pHeap->size                 = size;
+        pHeap->references           = 1;
+        return (m_Heaps[name] = std::move(pHeap)).get();
+    }
+
+    // Opening a heap laid out differently is how the two processes find out they disagree
+    if (it == m_Heaps.end() || it->second->size != size || !Allocate())
+        return nullptr;
+
+    it->second->references++;
+    return it->second.get();
+}
+
+void* TSRMockAllocator::CreatePlacedResource(void* pHeap, uint64_t offset, const TSRPlacedResourceDesc& desc)
+{
+    Heap*    pMockHeap = static_cast<Heap*>(pHeap);
+    uint64_t size      = GetAllocationInfo(desc).size;
+    if (offset % TSR_HEAP_ALIGNMENT || offset + size > pMockHeap->size || !Allocate())
+        return nullptr;
+
+    // Each process places the same resources in the same heap, so only resources at the same place may overlap
+    for (const Resource* pOther : pMockHeap->resources)
+    {
+        bool overlaps = offset < pOther->offset + pOther->size && pOther->offset < offset + size;
+        if (overlaps && (pOther->offset != offset || pOther->size != size))
+            return nullptr;
+    }
+
+    Resource* pResource = new Resource{pMockHeap, offset, size, desc};
+    pMockHeap->resources.push_back(pResource);
+    m_ResourceCount++;
+    return pResource;
+}
+
+void TSRMockAllocator::ReleaseResource(void* pResource)
+{
+    Resource* pMockResource = static_cast<Resource*>(pResource);
+    auto&     resources     = pMockResource->pHeap->resources;
+    resources.erase(std::find(resources.begin(), resources.end(), pMockResource));
+    delete pMockResource;
+    m_ResourceCount--;
+}
+
+void TSRMockAllocator::ReleaseHeap(void* pHeap)
+{
+    Heap* pMockHeap = static_cast<Heap*>(pHeap);
+    if (--pMockHeap->references)
+        return;
+
+    // Like a device, the resources still placed in the heap go with it
+    m_ResourceCount -= pMockHeap->resources.size();
+    for (Resource* pResource : pMockHeap->resources)
+        delete pResource;
+    m_Heaps.erase(pMockHeap->name);
+}
@@ -0,0 +1,120 @@
+#if defined(_WIN32)
+
+#include "placement_d3d12.h"
+
+#include <string>
+
+namespace
+{
+    D3D12_RESOURCE_DESC GetResourceDesc(const TSRPlacedResourceDesc& desc)
+    {
+        D3D12_RESOURCE_DESC resourceDesc = {};
+        resourceDesc.Dimension           = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        resourceDesc.Width               = desc.width;
+        resourceDesc.Height              = desc.height;
+        resourceDesc.DepthOrArraySize    = 1;
+        resourceDesc.MipLevels           = 1;
+        resourceDesc.Format              = static_cast<DXGI_FORMAT>(desc.format);
+        resourceDesc.SampleDesc.Count    = 1;
+        resourceDesc.Layout              = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        resourceDesc.Flags               = desc.depthStencil ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        if (desc.allowUAV)
+            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        return resourceDesc;
+    }
+
+    std::wstring ToWString(const std::string& name)
+    {
+        // Shared names are ASCII
+        return std::wstring(name.begin(), name.end());
+    }
+}  // namespace
+
+TSRAllocationInfo TSRD3D12Allocator::GetAllocationInfo(const TSRPlacedResourceDesc& desc)
+{
+    D3D12_RESOURCE_DESC            resourceDesc = GetResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO allocation   = m_pDevice->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+    TSRAllocationInfo info;
+    info.size      = allocation.SizeInBytes;
+    info.alignment = allocation.Alignment;
+    return info;
+}
+
+void* TSRD3D12Allocator::CreateHeap(const std::string& name, uint64_t size, bool shouldCreate)
+{
+    std::wstring sharedName = ToWString(name);
+    ID3D12Heap*  pHeap      = nullptr;
+    HANDLE       handle     = {};
+
+    if (shouldCreate)
+    {
+        D3D12_HEAP_DESC heapDesc = {};
+        heapDesc.SizeInBytes     = size;
+        heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        heapDesc.Alignment       = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        heapDesc.Flags           = D3D12_HEAP_FLAG_SHARED | D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+        if (m_pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&pHeap)) != S_OK)
+            return nullptr;
+
+        if (m_pDevice->CreateSharedHandle(pHeap, nullptr, GENERIC_ALL, sharedName.c_str(), &handle) != S_OK)
+        {
+            pHeap->Release();
+            return nullptr;
+        }
+
+        pHeap->SetName(sharedName.c_str());
+        m_SharedHandles[pHeap] = handle;
+        return pHeap;
+    }
+
+    if (m_pDevice->OpenSharedHandleByName(sharedName.c_str(), GENERIC_ALL, &handle) != S_OK)
+        return nullptr;
+
+    HRESULT result = m_pDevice->OpenSharedHandle(handle, IID_PPV_ARGS(&pHeap));
+    CloseHandle(handle);
+    if (result != S_OK)
+        return nullptr;
+
+    // The renderer laid its heaps out with other resources than ours
+    if (pHeap->GetDesc().SizeInBytes != size)
+    {
+        pHeap->Release();
+        return nullptr;
+    }
+    return pHeap;
+}
+
+void* TSRD3D12Allocator::CreatePlacedResource(void* pHeap, uint64_t offset, const TSRPlacedResourceDesc& desc)
+{
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+    ID3D12Resource*     pResource    = nullptr;
+
+    D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE;
+    if (m_pDevice->CreatePlacedResource(static_cast<ID3D12Heap*>(pHeap), offset, &resourceDesc, state, nullptr, IID_PPV_ARGS(&pResource)) != S_OK)
+        return nullptr;
+
+    pResource->SetName(ToWString(desc.name).c_str());
+    return pResource;
+}
+
+void TSRD3D12Allocator::ReleaseResource(void* pResource)
+{
+    static_cast<ID3D12Resource*>(pResource)->Release();
+}
+
+void TSRD3D12Allocator::ReleaseHeap(void* pHeap)
+{
+    ID3D12Heap* pD3D12Heap = static_cast<ID3D12Heap*>(pHeap);
+
+    auto it = m_SharedHandles.find(pD3D12Heap);
+    if (it != m_SharedHandles.end())
+    {
+        CloseHandle(it->second);
+        m_SharedHandles.erase(it);
+    }
+    pD3D12Heap->Release();
+}
+
+#endif
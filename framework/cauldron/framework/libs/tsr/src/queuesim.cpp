@@ -0,0 +1,178 @@
+#include "queuesim.h"
+#include "assert.h"
+
+#include <algorithm>
+
+size_t TSRQueueSim::AddQueue(const std::string& name)
+{
+    m_Queues.push_back(Queue());
+    m_Queues.back().name = name;
+    return m_Queues.size() - 1;
+}
+
+size_t TSRQueueSim::AddFence()
+{
+    m_Fences.push_back({});
+    return m_Fences.size() - 1;
+}
+
+void TSRQueueSim::Execute(size_t queue, double durationUs, const std::string& label)
+{
+    m_Queues[queue].commands.push_back(Command{CommandType::Execute, durationUs, 0, 0, label});
+}
+
+void TSRQueueSim::Signal(size_t queue, size_t fence, uint64_t value)
+{
+    m_Queues[queue].commands.push_back(Command{CommandType::Signal, 0.0, fence, value, std::string()});
+}
+
+void TSRQueueSim::Wait(size_t queue, size_t fence, uint64_t value)
+{
+    m_Queues[queue].commands.push_back(Command{CommandType::Wait, 0.0, fence, value, std::string()});
+}
+
+bool TSRQueueSim::FenceReached(size_t fence, uint64_t value, double& timeUs) const
+{
+    // Fence values grow, the first signal reaching the value is when waiters wake up
+    for (const FenceSignal& signal : m_Fences[fence])
+    {
+        if (signal.value >= value)
+        {
+            timeUs = signal.timeUs;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TSRQueueSim::Run()
+{
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+
+        // Advance every queue until it blocks on a fence nobody signaled yet
+        for (Queue& queue : m_Queues)
+        {
+            while (queue.next < queue.commands.size())
+            {
+                const Command& command = queue.commands[queue.next];
+                if (command.type == CommandType::Execute)
+                {
+                    queue.timeline.push_back(Interval{queue.timeUs, queue.timeUs + command.durationUs, command.label});
+                    queue.timeUs += command.durationUs;
+                }
+                else if (command.type == CommandType::Signal)
+                {
+                    m_Fences[command.fence].push_back(FenceSignal{command.value, queue.timeUs});
+                }
+                else
+                {
+                    double signalTimeUs = 0.0;
+                    if (!FenceReached(command.fence, command.value, signalTimeUs))
+                        break;
+                    queue.timeUs = std::max(queue.timeUs, signalTimeUs);
+                }
+
+                queue.next++;
+                progress = true;
+            }
+        }
+    }
+
+    for (const Queue& queue : m_Queues)
+    {
+        if (queue.next < queue.commands.size())
+            return false;
+    }
+    return true;
+}
+
+double TSRQueueSim::GetQueueBusyUs(size_t queue) const
+{
+    double busyUs = 0.0;
+    for (const Interval& interval : m_Queues[queue].timeline)
+        busyUs += interval.endUs - interval.startUs;
+    return busyUs;
+}
+
+double TSRQueueSim::GetOverlapUs(size_t queueA, size_t queueB) const
+{
+    // Both timelines are sorted and free of overlaps within a queue, walk them together
+    const std::vector<Interval>& timelineA = m_Queues[queueA].timeline;
+    const std::vector<Interval>& timelineB = m_Queues[queueB].timeline;
+
+    double overlapUs = 0.0;
+    size_t a = 0, b = 0;
+    while (a < timelineA.size() && b < timelineB.size())
+    {
+        double startUs = std::max(timelineA[a].startUs, timelineB[b].startUs);
+        double endUs   = std::min(timelineA[a].endUs, timelineB[b].endUs);
+        if (endUs > startUs)
+            overlapUs += endUs - startUs;
+
+        if (timelineA[a].endUs < timelineB[b].endUs)
+            a++;
+        else
+            b++;
+    }
+    return overlapUs;
+}
+
+TSRTransferSimResult TSRSimulateTransfers(const TSRTransferSimParams& params)
+{
+    AssertCritical(params.frames > 0 && params.independentUs <= params.renderUs, L"Invalid transfer simulation parameters");
+
+    TSRQueueSim sim;
+    size_t      graphics      = sim.AddQueue("Graphics");
+    size_t      copy          = sim.AddQueue("Copy");
+    size_t      graphicsFence = sim.AddFence();
+    size_t      copyFence     = sim.AddFence();
+
+    uint64_t graphicsValue   = 0;
+    uint64_t copyValue       = 0;
+    bool     independentDone = false;
+
+    for (uint32_t frame = 0; frame < params.frames; frame++)
+    {
+        // The leading part of the frame may already have been submitted ahead of the previous hand-back
+        if (!independentDone)
+            sim.Execute(graphics, params.independentUs, "Independent");
+        sim.Execute(graphics, params.renderUs - params.independentUs, "Render");
+        independentDone = false;
+
+        if (!params.copyQueue)
+        {
+            // Barriers and copies inline, the slot is signaled behind them
+            sim.Execute(graphics, params.barrierUs * 2 + params.copyUs, "Transfer");
+            continue;
+        }
+
+        // Hand the resources to the copy queue
+        sim.Execute(graphics, params.barrierUs, "Prepare");
+        sim.Signal(graphics, graphicsFence, ++graphicsValue);
+
+        sim.Wait(copy, graphicsFence, graphicsValue);
+        sim.Execute(copy, params.barrierUs * 2 + params.copyUs, "Transfer");
+        sim.Signal(copy, copyFence, ++copyValue);
+
+        if (params.splitFrame && frame + 1 < params.frames)
+        {
+            sim.Execute(graphics, params.independentUs, "Independent");
+            independentDone = true;
+        }
+
+        // Take them back before they are rendered to again
+        sim.Wait(graphics, copyFence, copyValue);
+        sim.Execute(graphics, params.barrierUs, "Restore");
+    }
+
+    AssertCritical(sim.Run(), L"The transfer simulation deadlocked");
+
+    TSRTransferSimResult result = {};
+    result.frameUs              = sim.GetQueueEndUs(graphics) / params.frames;
+    result.graphicsBusyUs       = sim.GetQueueBusyUs(graphics) / params.frames;
+    result.overlapUs            = sim.GetOverlapUs(graphics, copy) / params.frames;
+    return result;
+}
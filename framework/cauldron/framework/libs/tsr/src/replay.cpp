@@ -0,0 +1,293 @@
+#if !defined(_WIN32)
+
+#include "replay.h"
+#include "liveness.h"
+#include "negotiation.h"
+#include "transport_posix.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+    constexpr uint64_t POLL_US      = 1000;    // Control channel polling while negotiating
+    constexpr uint64_t WAIT_US      = 100000;  // Slot waits between liveness checks
+    constexpr uint64_t LATE_US      = 1000;    // A replayed frame published this much after it was due is late
+    constexpr uint64_t HEARTBEAT_NS = 10000000;
+
+    bool IsStopping(const std::atomic<bool>* pStop)
+    {
+        return pStop && pStop->load(std::memory_order_relaxed);
+    }
+
+    void Pause()
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(POLL_US));
+    }
+
+    std::string GetGenerationName(const std::string& sharedName, uint64_t generation)
+    {
+        return sharedName + "_" + std::to_string(generation);
+    }
+}  // namespace
+
+TSRCaptureRecordResult TSRRecordCapture(const TSRCaptureRecordParams& params, const std::atomic<bool>* pStop)
+{
+    TSRCaptureRecordResult result;
+    uint64_t               deadlineNs = tsr_now_ns() + params.timeoutUs * 1000;
+
+    TSRControlChannel channel;
+    while (!channel.Open(params.sharedName, params.consumerCount, false))
+    {
+        if (IsStopping(pStop) || tsr_now_ns() > deadlineNs)
+        {
+            result.error = "no renderer opened " + params.sharedName;
+            return result;
+        }
+        Pause();
+    }
+
+    // Accept the first offer we can rebuild the manifest of, or join a generation that is already running
+    TSROffer    offer      = {};
+    TSRManifest manifest;
+    uint64_t    generation = 0;
+    for (;;)
+    {
+        if (channel.PollOffer(offer) && offer.generation != generation)
+        {
+            TSRAnswer answer  = {};
+            answer.generation = offer.generation;
+            if (TSRBuildManifest(offer, params.tileSize, manifest))
+            {
+                answer.status       = TSRAnswerStatus::Accepted;
+                answer.slotCount    = offer.slotCount;
+                answer.renderWidth  = offer.renderWidth;
+                answer.renderHeight = offer.renderHeight;
+                generation          = offer.generation;
+            }
+            else
+            {
+                answer.status = TSRAnswerStatus::Rejected;
+                snprintf(answer.reason, sizeof(answer.reason), "the capture can't rebuild the manifest, check the tile size");
+            }
+
+            if (offer.state == TSROfferState::Proposed)
+                channel.Answer(params.consumer, answer);
+        }
+
+        if (generation && offer.generation == generation && offer.state == TSROfferState::Committed)
+            break;
+
+        if (IsStopping(pStop) || tsr_now_ns() > deadlineNs)
+        {
+            result.error = generation ? "the renderer never created the shared buffers" : "the renderer offered nothing the capture can read";
+            return result;
+        }
+        Pause();
+    }
+
+    TSRCaptureWriter writer;
+    if (!writer.Open(params.path, manifest, params.options))
+    {
+        result.error = writer.GetError();
+        return result;
+    }
+
+    TSRPosixTransport transport(GetGenerationName(params.sharedName, generation), offer.slotCount, params.consumerCount);
+    transport.CreateSlots(manifest.GetTotalSize(), manifest.GetHash(), false);
+
+    TSRSlotRing ring(&transport, params.consumer);
+    ring.RegisterConsumer();
+
+    TSRLivenessWatch watch(&ring, false, params.peerTimeoutUs);
+    while (!params.frames || writer.GetStats().frames < params.frames)
+    {
+        watch.Update();
+        if (IsStopping(pStop) || watch.IsPeerLost())
+            break;
+
+        // A new generation may lay the frames out differently, which would need another capture
+        if (channel.PollOffer(offer) && offer.generation != generation)
+        {
+            TSRAnswer answer  = {};
+            answer.generation = offer.generation;
+            answer.status     = TSRAnswerStatus::Rejected;
+            snprintf(answer.reason, sizeof(answer.reason), "the capture ended");
+            channel.Answer(params.consumer, answer);
+            break;
+        }
+
+        uint64_t slotIndex, sequence;
+        if (!ring.WaitAcquireRead(slotIndex, sequence, TSRWaitMode::Event, WAIT_US))
+            continue;
+
+        bool written = writer.WriteSlot(transport, slotIndex, sequence);
+        ring.Release();
+        if (!written)
+        {
+            result.error = writer.GetError();
+            break;
+        }
+    }
+    ring.UnregisterConsumer();
+
+    if (!writer.Close() && result.error.empty())
+        result.error = writer.GetError();
+
+    result.dropped = ring.GetStats().dropped;
+    result.stats   = writer.GetStats();
+    return result;
+}
+
+TSRReplayResult TSRReplayCapture(const TSRReplayParams& params, const std::atomic<bool>* pStop)
+{
+    TSRReplayResult  result;
+    TSRCaptureReader reader;
+    if (!reader.Open(params.path))
+    {
+        result.error = reader.GetError();
+        return result;
+    }
+    if (!reader.GetFrameCount())
+    {
+        result.error = params.path + " holds no frames";
+        return result;
+    }
+
+    // The frames were rendered at a fixed resolution, an upscaler asking for less can't be served
+    const TSRManifest&      manifest = reader.GetManifest();
+    const TSRFrameMetadata& first    = reader.GetFrame(0).metadata;
+    TSROffer                offer    = {};
+    TSRDescribeManifest(manifest, offer);
+    offer.slotCount    = params.slotCount;
+    offer.renderWidth  = first.renderWidth ? first.renderWidth : manifest.GetResource(0).width;
+    offer.renderHeight = first.renderHeight ? first.renderHeight : manifest.GetResource(0).height;
+
+    TSRControlChannel channel;
+    if (!channel.Open(params.sharedName, params.consumerCount, true))
+    {
+        result.error = "can't create the control channel of " + params.sharedName;
+        return result;
+    }
+
+    uint64_t  generation = channel.Offer(offer);
+    uint64_t  deadlineNs = tsr_now_ns() + params.timeoutUs * 1000;
+    TSRAnswer answer     = {};
+    for (;;)
+    {
+        if (channel.PollAnswers(answer))
+        {
+            if (answer.status == TSRAnswerStatus::Accepted)
+                break;
+
+            if (answer.status == TSRAnswerStatus::Rejected)
+            {
+                result.error = std::string("an upscaler rejected the capture: ") + answer.reason;
+                return result;
+            }
+
+            if (answer.renderWidth < offer.renderWidth || answer.renderHeight < offer.renderHeight || answer.slotCount == 0)
+            {
+                result.error = "an upscaler takes at most " + std::to_string(answer.renderWidth) + "x" + std::to_string(answer.renderHeight) +
+                               ", the capture was rendered at " + std::to_string(offer.renderWidth) + "x" + std::to_string(offer.renderHeight);
+                return result;
+            }
+
+            offer.slotCount = answer.slotCount;
+            generation      = channel.Offer(offer);
+        }
+
+        if (IsStopping(pStop) || tsr_now_ns() > deadlineNs)
+        {
+            result.error = "the upscalers did not accept the capture in time";
+            return result;
+        }
+        Pause();
+    }
+
+    TSRPosixTransport transport(GetGenerationName(params.sharedName, generation), offer.slotCount, params.consumerCount);
+    transport.CreateSlots(manifest.GetTotalSize(), manifest.GetHash(), true);
+    channel.Commit();
+
+    TSRSlotRing      ring(&transport);
+    TSRLivenessWatch watch(&ring, true, params.peerTimeoutUs);
+    uint64_t         periodNs = params.fps > 0.0 ? static_cast<uint64_t>(1e9 / params.fps) : 0;
+    uint64_t         dueNs    = 0;
+    uint64_t         startNs  = tsr_now_ns();
+    uint64_t         endNs    = startNs;
+
+    auto stopReplay = [&](const std::string& error) {
+        result.error = error;
+        return !error.empty() || IsStopping(pStop);
+    };
+
+    bool stopped = false;
+    for (uint32_t loop = 0; loop < params.loops && !stopped; loop++)
+    {
+        for (uint64_t frame = 0; frame < reader.GetFrameCount() && !stopped; frame++)
+        {
+            uint64_t slotIndex, sequence;
+            while (!stopped && !ring.WaitAcquireWrite(slotIndex, sequence, params.waitMode, WAIT_US))
+            {
+                watch.Update();
+                stopped = stopReplay(watch.IsPeerLost() ? "the upscalers stopped responding" : "");
+            }
+            if (stopped)
+                break;
+
+            // Decode while the frame is not due yet
+            if (!reader.ReadSlot(frame, transport, slotIndex))
+            {
+                stopped = stopReplay(reader.GetError());
+                break;
+            }
+
+            // Frames the upscalers ask for can't be made up, the capture holds what it holds
+            transport.TakeKeyframeRequest();
+
+            uint64_t nowNs = tsr_now_ns();
+            if (periodNs)
+            {
+                dueNs = dueNs ? dueNs : nowNs;
+                for (; nowNs < dueNs; nowNs = tsr_now_ns())
+                {
+                    // Keep beating through long frame intervals
+                    watch.Update(nowNs);
+                    tsr_sleep_until_ns(std::min(dueNs, nowNs + HEARTBEAT_NS));
+                }
+
+                uint64_t lateNs = nowNs - dueNs;
+                result.lateUs.Add(lateNs / 1000);
+                result.late += lateNs / 1000 > LATE_US ? 1 : 0;
+
+                // Count from the late frame instead of catching up
+                dueNs = (lateNs > periodNs ? nowNs : dueNs) + periodNs;
+            }
+
+            TSRFrameMetadata& metadata = transport.GetSlotHeader(slotIndex)->metadata;
+            metadata.frameId           = result.frames;
+            metadata.renderTimeNs      = nowNs;
+            metadata.reset |= (loop > 0 && frame == 0) ? 1 : 0;
+            ring.Publish();
+
+            result.frames++;
+            endNs = tsr_now_ns();
+        }
+    }
+
+    // Let the upscalers consume the last frames before the shared buffers go away
+    while (result.error.empty() && !ring.IsDrained() && !watch.IsPeerLost() && !IsStopping(pStop))
+    {
+        watch.Update();
+        Pause();
+    }
+
+    result.seconds         = (endNs - startNs) / 1e9;
+    result.framesPerSecond = result.seconds > 0.0 ? result.frames / result.seconds : 0.0;
+    result.ringStats       = ring.GetStats();
+    return result;
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include "ring.h"
+#include "assert.h"
+
+#include <algorithm>
+
+bool TSRSlotRing::AcquireWrite(uint64_t& slotIndex, uint64_t& sequence)
+{
+    if (!HasAcquired())
+    {
+        // Prefer the slot that has been idle the longest so the slots rotate evenly
+        uint64_t bestValue = UINT64_MAX;
+        for (uint64_t i = 0; i < m_ActiveSlots; i++)
+        {
+            uint64_t value = m_pTransport->GetSlotValue(i);
+            if (value < bestValue && IsSlotFree(i))
+            {
+                bestValue      = value;
+                m_AcquiredSlot = i;
+            }
+        }
+
+        if (!HasAcquired())
+            return false;
+
+        m_AcquiredSequence = m_Head;
+    }
+
+    slotIndex = m_AcquiredSlot;
+    sequence  = m_AcquiredSequence;
+    return true;
+}
+
+void TSRSlotRing::Publish()
+{
+    AssertCritical(HasAcquired(), L"No shared buffer was acquired for writing");
+
+    m_pTransport->SignalSlot(m_AcquiredSlot, ReadyValue(m_AcquiredSequence));
+
+    // The slot is free again once the consumer has released this frame
+    m_SlotFloor[m_AcquiredSlot] = IdleValue(m_AcquiredSequence);
+    m_AcquiredSlot              = INVALID_SLOT;
+    m_Head++;
+    m_Stats.produced++;
+}
+
+bool TSRSlotRing::AcquireRead(uint64_t& slotIndex, uint64_t& sequence)
+{
+    if (!HasAcquired())
+    {
+        if (m_ConsumePolicy == TSRConsumePolicy::Latest)
+            return AcquireLatest(slotIndex, sequence);
+
+        // Pick the oldest frame that completed and was not consumed by us yet.
+        // Frames are published in sequence order, so if the scan raced with the producer and found a frame past the
+        // tail, a second scan is guaranteed to see every frame published before it.
+        uint64_t bestSequence = UINT64_MAX;
+        for (uint32_t pass = 0; pass < 2 && bestSequence != m_Tail; pass++)
+        {
+            for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+            {
+                uint64_t value = m_pTransport->GetSlotValue(i);
+                if (IsReadyValue(value) && value > m_SlotFloor[i] && SequenceOf(value) < bestSequence)
+                {
+                    bestSequence   = SequenceOf(value);
+                    m_AcquiredSlot = i;
+                }
+            }
+
+            if (!HasAcquired())
+                return false;
+        }
+
+        m_AcquiredSequence = bestSequence;
+        m_LastSkipCount    = 0;
+
+        if (bestSequence < m_Tail)
+        {
+            // Completed after a newer frame was consumed, still hand it out so the slot gets recycled
+            m_Stats.outOfOrder++;
+        }
+        else
+        {
+            // Anything between the tail and this frame was never published
+            m_Stats.dropped += bestSequence - m_Tail;
+            m_Tail = bestSequence + 1;
+        }
+    }
+
+    slotIndex = m_AcquiredSlot;
+    sequence  = m_AcquiredSequence;
+    return true;
+}
+
+bool TSRSlotRing::AcquireLatest(uint64_t& slotIndex, uint64_t& sequence)
+{
+    // Pick the newest frame that completed and was not consumed by us yet
+    for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+    {
+        uint64_t value = m_pTransport->GetSlotValue(i);
+        if (IsReadyValue(value) && value > m_SlotFloor[i] && (!HasAcquired() || SequenceOf(value) > m_AcquiredSequence))
+        {
+            m_AcquiredSlot     = i;
+            m_AcquiredSequence = SequenceOf(value);
+        }
+    }
+
+    if (!HasAcquired())
+        return false;
+
+    // Hand the older frames straight back, they would only queue up behind the newest one.
+    // Frames the producer published since the scan above are newer and stay for the next acquire.
+    uint64_t nowNs        = tsr_now_ns();
+    uint64_t oldestNs     = nowNs;
+    uint64_t pastTail     = 0;
+    bool     skippedDelta = false;
+    m_LastSkipCount       = 0;
+    for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+    {
+        uint64_t value = m_pTransport->GetSlotValue(i);
+        if (!IsReadyValue(value) || value <= m_SlotFloor[i] || SequenceOf(value) >= m_AcquiredSequence)
+            continue;
+
+        // When the frame was published, or at least handed over if the transport can't tell
+        uint64_t publishNs = m_pTransport->GetSlotSignalTime(i);
+        if (m_pTransport->GetControlBlock())
+        {
+            const TSRSlotHeader* pHeader = m_pTransport->GetSlotHeader(i);
+            publishNs                    = publishNs ? publishNs : pHeader->metadata.renderTimeNs;
+            skippedDelta |= pHeader->deltaMask != 0;
+        }
+        if (publishNs && publishNs < oldestNs)
+            oldestNs = publishNs;
+
+        ReleaseSlot(i, SequenceOf(value));
+        m_LastSkipCount++;
+        pastTail += SequenceOf(value) >= m_Tail ? 1 : 0;
+    }
+
+    if (m_LastSkipCount)
+    {
+        m_Stats.skipped += m_LastSkipCount;
+        m_Stats.skips++;
+        m_Stats.savedUs += (nowNs - oldestNs) / 1000;
+
+        // Delta frames after the skipped ones don't apply to what we have
+        if (skippedDelta)
+            m_pTransport->RequestKeyframe();
+    }
+
+    if (m_AcquiredSequence < m_Tail)
+    {
+        m_Stats.outOfOrder++;
+    }
+    else
+    {
+        // Skipped frames were published, the rest of the gap never was
+        m_Stats.dropped += m_AcquiredSequence - m_Tail - pastTail;
+        m_Tail = m_AcquiredSequence + 1;
+    }
+
+    slotIndex = m_AcquiredSlot;
+    sequence  = m_AcquiredSequence;
+    return true;
+}
+
+void TSRSlotRing::Release()
+{
+    AssertCritical(HasAcquired(), L"No shared buffer was acquired for reading");
+
+    // The producer released the frame for us already and may have reused the slot
+    if (Rejoin())
+        return;
+
+    ReleaseSlot(m_AcquiredSlot, m_AcquiredSequence);
+    m_AcquiredSlot = INVALID_SLOT;
+    m_Stats.consumed++;
+}
+
+void TSRSlotRing::ReleaseSlot(uint64_t slotIndex, uint64_t sequence)
+{
+    m_pTransport->SignalSlot(slotIndex, IdleValue(sequence), m_ReleaseLane);
+    m_SlotFloor[slotIndex] = IdleValue(sequence);
+}
+
+void TSRSlotRing::RegisterConsumer()
+{
+    m_pTransport->RegisterConsumer(m_Consumer);
+    m_Registered = true;
+
+    // A single consumer shares lane 0 with the producer, which waited for it all along
+    if (m_ReleaseLane == 0)
+        return;
+
+    // The producer may already be waiting for our lane (we registered above), release what was published before on
+    // it. Frames published from here on are newer than what we release and get consumed.
+    for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+    {
+        uint64_t value   = m_pTransport->GetSlotValue(i);
+        uint64_t release = m_pTransport->GetSlotValue(i, m_ReleaseLane);
+        if (IsReadyValue(value))
+        {
+            m_Tail = std::max(m_Tail, SequenceOf(value) + 1);
+            value++;
+        }
+
+        if (value > release)
+            m_pTransport->SignalSlot(i, value, m_ReleaseLane);
+        m_SlotFloor[i] = std::max(value, release);
+    }
+}
+
+void TSRSlotRing::UnregisterConsumer()
+{
+    m_pTransport->UnregisterConsumer(m_Consumer);
+    m_Registered = false;
+}
+
+void TSRSlotRing::ReclaimConsumer(uint32_t consumer)
+{
+    AssertCritical(consumer < m_pTransport->GetConsumerCount(), L"Invalid consumer index");
+
+    // Stop waiting first, so a consumer that comes back before we are done registers again instead of releasing
+    m_pTransport->UnregisterConsumer(consumer);
+
+    // Release every published frame on the consumer's lane, like RegisterConsumer does for a new consumer
+    uint32_t lane = m_pTransport->GetReleaseLane(consumer);
+    for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+    {
+        uint64_t value   = m_pTransport->GetSlotValue(i);
+        uint64_t release = m_pTransport->GetSlotValue(i, lane);
+        if (!IsReadyValue(value) || release > value)
+            continue;
+
+        m_pTransport->SignalSlot(i, value + 1, lane);
+        m_Stats.reclaimed++;
+    }
+}
+
+bool TSRSlotRing::Rejoin()
+{
+    if (!m_Registered || !m_pTransport->GetControlBlock() || (m_pTransport->GetRegisteredConsumers() & (1u << m_Consumer)))
+        return false;
+
+    // Whatever we held was released by the producer
+    m_AcquiredSlot = INVALID_SLOT;
+    RegisterConsumer();
+    m_Stats.rejoins++;
+    return true;
+}
+
+void TSRSlotRing::Heartbeat(bool producer)
+{
+    if (!m_pTransport->GetControlBlock())
+        return;
+
+    m_LastBeatNs = tsr_now_ns();
+    if (producer)
+        m_pTransport->BeatProducer();
+    else
+        m_pTransport->BeatConsumer(m_Consumer);
+}
+
+bool TSRSlotRing::IsSlotFree(uint64_t slotIndex)
+{
+    // With a single consumer the release lane is lane 0, which holds the READY value until the consumer releases it
+    uint32_t consumers = m_pTransport->GetActiveConsumers();
+    for (uint32_t i = 0; i < m_pTransport->GetConsumerCount(); i++)
+    {
+        if (!(consumers & (1u << i)))
+            continue;
+
+        uint64_t value = m_pTransport->GetSlotValue(slotIndex, m_pTransport->GetReleaseLane(i));
+        if (IsReadyValue(value) || value < m_SlotFloor[slotIndex])
+            return false;
+    }
+    return true;
+}
+
+bool TSRSlotRing::IsSlotPending(uint64_t slotIndex, uint32_t consumers)
+{
+    uint64_t value = m_pTransport->GetSlotValue(slotIndex);
+    if (!IsReadyValue(value))
+        return false;
+
+    for (uint32_t i = 0; i < m_pTransport->GetConsumerCount(); i++)
+    {
+        if ((consumers & (1u << i)) && m_pTransport->GetSlotValue(slotIndex, m_pTransport->GetReleaseLane(i)) <= value)
+            return true;
+    }
+    return false;
+}
+
+void TSRSlotRing::SetActiveSlotCount(uint64_t count)
+{
+    m_ActiveSlots = std::max<uint64_t>(1, std::min<uint64_t>(count, m_SlotFloor.size()));
+}
+
+uint64_t TSRSlotRing::CountReady()
+{
+    uint32_t consumers = m_Registered ? 1u << m_Consumer : m_pTransport->GetActiveConsumers();
+    uint64_t count     = 0;
+    for (uint64_t i = 0; i < m_SlotFloor.size(); i++)
+    {
+        if (IsSlotPending(i, consumers))
+            count++;
+    }
+    return count;
+}
+
+bool TSRSlotRing::WaitAcquire(uint64_t& slotIndex, uint64_t& sequence, TSRWaitMode mode, uint64_t timeoutUs, bool forWrite)
+{
+    // The producer took us for lost while we were away, start over
+    if (!forWrite)
+        Rejoin();
+
+    // Already holding a slot, nothing to wait for
+    if (HasAcquired())
+        return forWrite ? AcquireWrite(slotIndex, sequence) : AcquireRead(slotIndex, sequence);
+
+    uint64_t startNs    = tsr_now_ns();
+    uint64_t startCpuNs = tsr_thread_cpu_ns();
+    uint64_t deadlineNs = startNs + timeoutUs * 1000;
+    bool     waited     = false;
+    bool     acquired   = false;
+
+    // The first wait after an acquire ends the frame that used the slot
+    if (m_LastAcquireNs)
+    {
+        m_FrameBusyNs   = startNs - m_LastAcquireNs;
+        m_LastAcquireNs = 0;
+
+        if (!forWrite && m_pTransport->GetControlBlock())
+            m_pTransport->SetConsumerBusyNs(m_Consumer, m_FrameBusyNs);
+    }
+
+    uint64_t              slotCount = m_SlotFloor.size();
+    std::vector<uint64_t> targetValues(slotCount * m_pTransport->GetLaneCount());
+    for (;;)
+    {
+        // Keep beating while we wait, at most once a millisecond
+        if (tsr_now_ns() - m_LastBeatNs >= 1000000)
+            Heartbeat(forWrite);
+
+        m_WaitStats.polls++;
+        acquired = forWrite ? AcquireWrite(slotIndex, sequence) : AcquireRead(slotIndex, sequence);
+        if (acquired)
+            break;
+
+        uint64_t nowNs = tsr_now_ns();
+        if (nowNs >= deadlineNs)
+            break;
+
+        waited = true;
+        if (mode == TSRWaitMode::Event)
+        {
+            // The producer waits for the releases of its last frame in each active slot still missing, the consumer
+            // for any newer frame
+            std::fill(targetValues.begin(), targetValues.end(), UINT64_MAX);
+            uint32_t consumers = m_pTransport->GetActiveConsumers();
+            for (uint64_t i = 0; i < slotCount; i++)
+            {
+                if (!forWrite)
+                {
+                    targetValues[i] = m_SlotFloor[i] + 1;
+                    continue;
+                }
+
+                for (uint32_t c = 0; c < m_pTransport->GetConsumerCount() && i < m_ActiveSlots; c++)
+                {
+                    uint32_t lane = m_pTransport->GetReleaseLane(c);
+                    if ((consumers & (1u << c)) && m_pTransport->GetSlotValue(i, lane) < m_SlotFloor[i])
+                        targetValues[lane * slotCount + i] = m_SlotFloor[i];
+                }
+            }
+
+            m_pTransport->WaitAny(targetValues.data(), (deadlineNs - nowNs + 999) / 1000);
+        }
+    }
+
+    uint64_t endNs = tsr_now_ns();
+    m_WaitStats.waits++;
+    m_WaitStats.waitUs.Add((endNs - startNs) / 1000);
+    m_WaitStats.cpuNs += tsr_thread_cpu_ns() - startCpuNs;
+
+    if (!acquired)
+    {
+        m_WaitStats.timeouts++;
+        m_PendingStall = true;
+        return false;
+    }
+
+    m_LastAcquireNs      = endNs;
+    m_LastAcquireStalled = waited || m_PendingStall;
+    m_PendingStall       = false;
+
+    // Only meaningful if we actually had to wait for the peer. The producer waited for the last release of the slot.
+    uint64_t signalNs = 0;
+    if (forWrite)
+    {
+        uint32_t consumers = m_pTransport->GetActiveConsumers();
+        for (uint32_t c = 0; c < m_pTransport->GetConsumerCount(); c++)
+        {
+            if (consumers & (1u << c))
+                signalNs = std::max(signalNs, m_pTransport->GetSlotSignalTime(slotIndex, m_pTransport->GetReleaseLane(c)));
+        }
+    }
+    else
+    {
+        signalNs = m_pTransport->GetSlotSignalTime(slotIndex);
+    }
+    if (waited && signalNs && signalNs <= endNs)
+        m_WaitStats.wakeLatencyUs.Add((endNs - signalNs) / 1000);
+
+    return true;
+}
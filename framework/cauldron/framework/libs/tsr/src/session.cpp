@@ -0,0 +1,346 @@
+#include "session.h"
+#include "assert.h"
+#include "transport_host.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace
+{
+    constexpr uint64_t HEADER_SIZE = 64;
+}  // namespace
+
+bool TSRSessionDirectory::Open(const std::string& name, bool shouldCreate)
+{
+    if (!m_Memory.Open(name + "_TSR_SESSIONS", HEADER_SIZE + sizeof(SharedEntry) * TSR_MAX_SESSIONS, shouldCreate))
+        return false;
+
+    m_pHeader = reinterpret_cast<Header*>(m_Memory.Data());
+
+    if (shouldCreate)
+    {
+        for (uint32_t i = 0; i < TSR_MAX_SESSIONS; i++)
+        {
+            SharedEntry* pEntry = GetEntry(i);
+            new (&pEntry->state) std::atomic<uint32_t>(ENTRY_FREE);
+            new (&pEntry->generation) std::atomic<uint64_t>(0);
+        }
+
+        new (&m_pHeader->generation) std::atomic<uint64_t>(0);
+        m_pHeader->version = TSR_SESSIONS_VERSION;
+
+        // Publish the header last, the peers validate against the magic
+        m_pHeader->magic.store(TSR_SESSIONS_MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    if (m_pHeader->magic.load(std::memory_order_acquire) != TSR_SESSIONS_MAGIC || m_pHeader->version != TSR_SESSIONS_VERSION)
+    {
+        m_Memory.Close();
+        return false;
+    }
+    return true;
+}
+
+TSRSessionDirectory::SharedEntry* TSRSessionDirectory::GetEntry(uint32_t index) const
+{
+    AssertCritical(index < TSR_MAX_SESSIONS, L"Invalid session index");
+    return reinterpret_cast<SharedEntry*>(m_Memory.Data() + HEADER_SIZE) + index;
+}
+
+uint32_t TSRSessionDirectory::Announce(const TSRSessionInfo& info)
+{
+    AssertCritical(memchr(info.name, 0, sizeof(info.name)), L"The session name is not terminated");
+
+    for (uint32_t i = 0; i < TSR_MAX_SESSIONS; i++)
+    {
+        SharedEntry* pEntry   = GetEntry(i);
+        uint32_t     expected = ENTRY_FREE;
+        if (!pEntry->state.compare_exchange_strong(expected, ENTRY_CLAIMED, std::memory_order_acq_rel))
+            continue;
+
+        pEntry->info = info;
+        pEntry->generation.store(m_pHeader->generation.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        pEntry->state.store(ENTRY_ACTIVE, std::memory_order_release);
+        return i;
+    }
+    return INVALID_ENTRY;
+}
+
+void TSRSessionDirectory::Withdraw(uint32_t index)
+{
+    GetEntry(index)->state.store(ENTRY_FREE, std::memory_order_release);
+}
+
+std::vector<TSRSessionDirectory::Entry> TSRSessionDirectory::List()
+{
+    std::vector<Entry> entries;
+    for (uint32_t i = 0; i < TSR_MAX_SESSIONS; i++)
+    {
+        SharedEntry* pEntry = GetEntry(i);
+        if (pEntry->state.load(std::memory_order_acquire) != ENTRY_ACTIVE)
+            continue;
+
+        // The entry may be withdrawn and claimed again while we copy it, only keep a copy of one announcement
+        Entry entry;
+        entry.index      = i;
+        entry.generation = pEntry->generation.load(std::memory_order_relaxed);
+        entry.info       = pEntry->info;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (pEntry->state.load(std::memory_order_relaxed) != ENTRY_ACTIVE || pEntry->generation.load(std::memory_order_relaxed) != entry.generation)
+            continue;
+
+        entry.info.name[sizeof(entry.info.name) - 1] = 0;
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+void TSRSessionScheduler::AddSession(uint32_t id, TSRSlotRing* pRing, uint64_t deadlineUs)
+{
+    AssertCritical(!GetStats(id), L"The session is already scheduled");
+
+    Session session = {};
+    session.id         = id;
+    session.pRing      = pRing;
+    session.deadlineUs = deadlineUs;
+    m_Sessions.push_back(session);
+}
+
+void TSRSessionScheduler::RemoveSession(uint32_t id)
+{
+    for (size_t i = 0; i < m_Sessions.size(); i++)
+    {
+        if (m_Sessions[i].id != id)
+            continue;
+
+        m_Sessions.erase(m_Sessions.begin() + i);
+
+        // Keep the turn of the session after the removed one
+        if (m_Cursor >= i && m_Cursor > 0)
+            m_Cursor--;
+        return;
+    }
+}
+
+const TSRSessionStats* TSRSessionScheduler::GetStats(uint32_t id) const
+{
+    for (const Session& session : m_Sessions)
+    {
+        if (session.id == id)
+            return &session.stats;
+    }
+    return nullptr;
+}
+
+uint64_t TSRSessionScheduler::GetPublishTime(Session& session, uint64_t slotIndex, uint64_t sequence)
+{
+    uint64_t nowNs = tsr_now_ns();
+    if (session.pendingSequence != sequence)
+    {
+        session.pendingSequence = sequence;
+        session.pendingSeenNs   = nowNs;
+    }
+
+    // The transport may know when the frame was signaled, the renderer stamps it when it records the frame, and
+    // failing both the frame was published at the latest when we first saw it
+    TSRTransport* pTransport = session.pRing->GetTransport();
+    uint64_t      publishNs  = pTransport->GetSlotSignalTime(slotIndex);
+    if (!publishNs && pTransport->GetControlBlock())
+        publishNs = pTransport->GetSlotHeader(slotIndex)->metadata.renderTimeNs;
+    if (!publishNs || publishNs > nowNs)
+        publishNs = session.pendingSeenNs;
+    return publishNs;
+}
+
+bool TSRSessionScheduler::Next(uint32_t& id, uint64_t& slotIndex, uint64_t& sequence)
+{
+    size_t   best         = m_Sessions.size();
+    uint64_t bestDeadline = UINT64_MAX;
+    uint64_t bestPublish  = 0;
+    uint64_t bestSlot     = 0;
+    uint64_t bestSequence = 0;
+
+    // Round robin takes the first session with a frame after the one served last, the deadline policy looks at all of
+    // them and the scan order breaks the ties
+    for (size_t i = 0; i < m_Sessions.size(); i++)
+    {
+        size_t   index   = (m_Cursor + 1 + i) % m_Sessions.size();
+        Session& session = m_Sessions[index];
+
+        uint64_t slot = 0;
+        uint64_t seq  = 0;
+        if (!session.pRing->AcquireRead(slot, seq))
+            continue;
+
+        uint64_t publishNs  = GetPublishTime(session, slot, seq);
+        uint64_t deadlineNs = session.deadlineUs ? publishNs + session.deadlineUs * 1000 : UINT64_MAX;
+        if (best == m_Sessions.size() || (m_Policy == TSRSchedulePolicy::Deadline && deadlineNs < bestDeadline))
+        {
+            best         = index;
+            bestDeadline = deadlineNs;
+            bestPublish  = publishNs;
+            bestSlot     = slot;
+            bestSequence = seq;
+        }
+
+        if (m_Policy == TSRSchedulePolicy::RoundRobin)
+            break;
+    }
+
+    if (best == m_Sessions.size())
+        return false;
+
+    Session& session = m_Sessions[best];
+    uint64_t nowNs   = tsr_now_ns();
+    session.stats.served++;
+    session.stats.waitUs.Add((nowNs - bestPublish) / 1000);
+    if (nowNs > bestDeadline)
+        session.stats.missedDeadlines++;
+    session.pendingSequence = UINT64_MAX;
+
+    m_Cursor  = best;
+    id        = session.id;
+    slotIndex = bestSlot;
+    sequence  = bestSequence;
+    return true;
+}
+
+bool TSRSessionScheduler::WaitNext(uint32_t& id, uint64_t& slotIndex, uint64_t& sequence, uint64_t timeoutUs, uint64_t pollUs)
+{
+    // The sessions don't share a transport to sleep on, so poll them
+    uint64_t deadlineNs = tsr_now_ns() + timeoutUs * 1000;
+    for (;;)
+    {
+        if (Next(id, slotIndex, sequence))
+            return true;
+
+        uint64_t nowNs = tsr_now_ns();
+        if (nowNs >= deadlineNs)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(pollUs, (deadlineNs - nowNs + 999) / 1000)));
+    }
+}
+
+TSRSessionSimResult TSRSimulateSessions(const TSRSessionSimParams& params)
+{
+    AssertCritical(!params.sessions.empty() && params.sessions.size() <= TSR_MAX_SESSIONS && params.slots > 0, L"Invalid session simulation parameters");
+
+    // Sessions of this run only, in case several run at once
+    std::string baseName = "TSR_SESSION_SIM_" + std::to_string(tsr_now_ns());
+
+    TSRSessionDirectory directory;
+    AssertCritical(directory.Open(baseName, true), L"Failed to create the session directory");
+
+    // The renderers own their transports, the registry looks them up by name
+    size_t                                         sessionCount = params.sessions.size();
+    std::vector<std::unique_ptr<TSRHostTransport>> transports;
+    std::map<std::string, TSRHostTransport*>       transportsByName;
+    for (size_t i = 0; i < sessionCount; i++)
+    {
+        std::string name = baseName + "_" + std::to_string(i);
+        transports.push_back(std::make_unique<TSRHostTransport>(name, params.slots));
+        transports.back()->CreateSlots(4096, 0, true);
+        transportsByName[name] = transports.back().get();
+    }
+
+    // Renderers: publish a stamped frame every frameUs (or as soon as a slot frees up, when behind)
+    std::atomic<bool>     stopping{false};
+    std::vector<uint64_t> produced(sessionCount, 0);
+    std::vector<uint32_t> entries(sessionCount, TSRSessionDirectory::INVALID_ENTRY);
+    std::vector<std::thread> renderers;
+    for (size_t i = 0; i < sessionCount; i++)
+    {
+        TSRSessionInfo info = {};
+        snprintf(info.name, sizeof(info.name), "%s_%zu", baseName.c_str(), i);
+        info.slotCount  = params.slots;
+        info.deadlineUs = params.sessions[i].deadlineUs;
+        entries[i]      = directory.Announce(info);
+
+        renderers.emplace_back([&, i]() {
+            TSRHostTransport* pTransport = transports[i].get();
+            TSRSlotRing       ring(pTransport);
+            auto              frameInterval = std::chrono::nanoseconds(static_cast<uint64_t>(params.sessions[i].frameUs * 1000.0));
+            auto              nextFrame     = std::chrono::steady_clock::now();
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                std::this_thread::sleep_until(nextFrame);
+                nextFrame += frameInterval;
+
+                uint64_t slot     = 0;
+                uint64_t sequence = 0;
+                if (!ring.WaitAcquireWrite(slot, sequence, TSRWaitMode::Event, 10000))
+                    continue;
+
+                pTransport->GetSlotHeader(slot)->metadata.frameId      = sequence;
+                pTransport->GetSlotHeader(slot)->metadata.renderTimeNs = tsr_now_ns();
+                ring.Publish();
+                produced[i]++;
+            }
+        });
+    }
+
+    // Upscaler: open the announced sessions and serve them one frame of upscaleUs at a time
+    struct SimSession
+    {
+        std::unique_ptr<TSRSlotRing> pRing;
+    };
+
+    TSRSessionScheduler                   scheduler(params.policy);
+    std::map<uint32_t, TSRSessionStats>   closedStats;
+    TSRSessionRegistry<SimSession>        registry(
+        [&](uint32_t id, const TSRSessionInfo& info) {
+            auto it = transportsByName.find(info.name);
+            if (it == transportsByName.end())
+                return std::unique_ptr<SimSession>();
+
+            auto pSession   = std::make_unique<SimSession>();
+            pSession->pRing = std::make_unique<TSRSlotRing>(it->second);
+            pSession->pRing->RegisterConsumer();
+            scheduler.AddSession(id, pSession->pRing.get(), info.deadlineUs);
+            return pSession;
+        },
+        [&](uint32_t id, SimSession& session) {
+            closedStats[id] = *scheduler.GetStats(id);
+            scheduler.RemoveSession(id);
+            session.pRing->UnregisterConsumer();
+        });
+
+    uint64_t served  = 0;
+    uint64_t startNs = tsr_now_ns();
+    uint64_t endNs   = startNs + params.durationMs * 1000000ull;
+    while (tsr_now_ns() < endNs)
+    {
+        registry.Update(directory);
+
+        uint32_t id       = 0;
+        uint64_t slot     = 0;
+        uint64_t sequence = 0;
+        if (!scheduler.WaitNext(id, slot, sequence, 1000))
+            continue;
+
+        auto workEnd = std::chrono::steady_clock::now() + std::chrono::nanoseconds(static_cast<uint64_t>(params.upscaleUs * 1000.0));
+        std::this_thread::sleep_until(workEnd);
+        registry.Find(id)->pRing->Release();
+        served++;
+    }
+    double elapsedS = (tsr_now_ns() - startNs) / 1e9;
+
+    stopping.store(true, std::memory_order_relaxed);
+    for (std::thread& renderer : renderers)
+        renderer.join();
+
+    TSRSessionSimResult result;
+    for (size_t i = 0; i < sessionCount; i++)
+    {
+        const TSRSessionStats* pStats = scheduler.GetStats(entries[i]);
+        result.sessions.push_back({produced[i], pStats ? *pStats : closedStats[entries[i]]});
+        directory.Withdraw(entries[i]);
+    }
+    result.framesPerSecond = served / elapsedS;
+    return result;
+}
@@ -0,0 +1,227 @@
+#include "shm.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool TSRSharedMemory::Open(const std::string& name, size_t size, bool shouldCreate)
+{
+    Close();
+
+    std::string mappingName = "Local\\" + name;
+    DWORD       sizeHigh    = static_cast<DWORD>(static_cast<uint64_t>(size) >> 32);
+    DWORD       sizeLow     = static_cast<DWORD>(static_cast<uint64_t>(size) & 0xFFFFFFFF);
+
+    if (shouldCreate)
+        m_Handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, sizeHigh, sizeLow, mappingName.c_str());
+    else
+        m_Handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+
+    if (!m_Handle)
+        return false;
+
+    m_pView = reinterpret_cast<uint8_t*>(MapViewOfFile(m_Handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+    if (!m_pView)
+    {
+        CloseHandle(m_Handle);
+        m_Handle = nullptr;
+        return false;
+    }
+
+    m_Name    = mappingName;
+    m_Size    = size;
+    m_IsOwner = shouldCreate;
+    return true;
+}
+
+void TSRSharedMemory::Close()
+{
+    if (m_pView)
+    {
+        UnmapViewOfFile(m_pView);
+        m_pView = nullptr;
+    }
+
+    if (m_Handle)
+    {
+        CloseHandle(m_Handle);
+        m_Handle = nullptr;
+    }
+
+    m_Size    = 0;
+    m_IsOwner = false;
+}
+
+bool TSRMappedFile::Open(const std::string& path)
+{
+    Close();
+
+    m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_Handle = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m_Handle)
+    {
+        Close();
+        return false;
+    }
+
+    m_pView = reinterpret_cast<uint8_t*>(MapViewOfFile(m_Handle, FILE_MAP_READ, 0, 0, 0));
+    if (!m_pView)
+    {
+        Close();
+        return false;
+    }
+
+    m_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void TSRMappedFile::Close()
+{
+    if (m_pView)
+    {
+        UnmapViewOfFile(m_pView);
+        m_pView = nullptr;
+    }
+
+    if (m_Handle)
+    {
+        CloseHandle(m_Handle);
+        m_Handle = nullptr;
+    }
+
+    if (m_File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+
+    m_Size = 0;
+}
+
+#else
+
+bool TSRSharedMemory::Open(const std::string& name, size_t size, bool shouldCreate)
+{
+    Close();
+
+    // POSIX shared memory names need a single leading slash
+    std::string shmName = "/" + name;
+    for (size_t i = 1; i < shmName.size(); i++)
+    {
+        if (shmName[i] == '/' || shmName[i] == ' ')
+            shmName[i] = '_';
+    }
+
+    int flags = shouldCreate ? (O_CREAT | O_RDWR) : O_RDWR;
+    int fd    = shm_open(shmName.c_str(), flags, 0600);
+    if (fd < 0)
+        return false;
+
+    if (shouldCreate && ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return false;
+    }
+
+    // The opener must not map beyond what the creator allocated
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* pView = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pView == MAP_FAILED)
+    {
+        close(fd);
+        if (shouldCreate)
+            shm_unlink(shmName.c_str());
+        return false;
+    }
+
+    m_Name    = shmName;
+    m_Handle  = fd;
+    m_pView   = reinterpret_cast<uint8_t*>(pView);
+    m_Size    = size;
+    m_IsOwner = shouldCreate;
+    return true;
+}
+
+void TSRSharedMemory::Close()
+{
+    if (m_pView)
+    {
+        munmap(m_pView, m_Size);
+        m_pView = nullptr;
+
+        close(m_Handle);
+        m_Handle = {};
+
+        if (m_IsOwner)
+            shm_unlink(m_Name.c_str());
+    }
+
+    m_Size    = 0;
+    m_IsOwner = false;
+}
+
+bool TSRMappedFile::Open(const std::string& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* pView = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (pView == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    m_Handle = fd;
+    m_pView  = reinterpret_cast<uint8_t*>(pView);
+    m_Size   = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void TSRMappedFile::Close()
+{
+    if (m_pView)
+    {
+        munmap(m_pView, m_Size);
+        m_pView = nullptr;
+
+        close(m_Handle);
+        m_Handle = {};
+    }
+
+    m_Size = 0;
+}
+
+#endif
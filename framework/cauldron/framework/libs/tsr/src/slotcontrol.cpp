@@ -0,0 +1,167 @@
+#include "slotcontrol.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <random>
+
+const char* TSRSlotReasonName(TSRSlotReason reason)
+{
+    switch (reason)
+    {
+    case TSRSlotReason::Stall:
+        return "Stall";
+    case TSRSlotReason::Unused:
+        return "Unused";
+    case TSRSlotReason::ConsumerBound:
+        return "ConsumerBound";
+    }
+    return "Unknown";
+}
+
+TSRSlotController::TSRSlotController(const TSRSlotControllerParams& params, uint64_t initialSlots)
+    : m_Params(params)
+{
+    AssertCritical(params.minSlots > 0 && params.minSlots <= params.maxSlots, L"Invalid slot range");
+
+    m_ActiveSlots = std::max(params.minSlots, std::min(initialSlots, params.maxSlots));
+}
+
+uint64_t TSRSlotController::Update(uint64_t producerBusyNs, uint64_t consumerBusyNs, uint64_t occupancy, bool stalled)
+{
+    m_Stats.frames++;
+    m_Stats.slotFrames += m_ActiveSlots;
+
+    // The first sample seeds the averages
+    double producerUs = producerBusyNs / 1000.0;
+    double consumerUs = consumerBusyNs / 1000.0;
+    m_ProducerUs      = m_ProducerUs > 0.0 ? m_ProducerUs + (producerUs - m_ProducerUs) * m_Params.ewmaWeight : producerUs;
+    if (consumerBusyNs)
+        m_ConsumerUs = m_ConsumerUs > 0.0 ? m_ConsumerUs + (consumerUs - m_ConsumerUs) * m_Params.ewmaWeight : consumerUs;
+
+    m_FramesSinceChange++;
+    bool consumerBound = IsConsumerSlower(m_Params.consumerBoundRatio);
+
+    if (stalled)
+    {
+        m_Stats.stalls++;
+        if (consumerBound)
+            m_Stats.consumerBoundStalls++;
+
+        // A stall restarts the window a slot has to stay unused in
+        m_QuietFrames   = 0;
+        m_PeakOccupancy = 0;
+
+        if (!IsConsumerSlower(1.0) && m_ActiveSlots < m_Params.maxSlots && m_FramesSinceChange >= m_Params.growCooldownFrames)
+            Change(m_ActiveSlots + 1, TSRSlotReason::Stall);
+    }
+    else
+    {
+        m_QuietFrames++;
+        m_PeakOccupancy = std::max(m_PeakOccupancy, occupancy);
+    }
+
+    if (m_ActiveSlots > m_Params.minSlots && m_FramesSinceChange >= m_Params.shrinkWindowFrames)
+    {
+        // The producer's own slot is not in the occupancy
+        if (consumerBound)
+            Change(m_ActiveSlots - 1, TSRSlotReason::ConsumerBound);
+        else if (m_QuietFrames >= m_Params.shrinkWindowFrames && m_PeakOccupancy + 1 < m_ActiveSlots)
+            Change(m_ActiveSlots - 1, TSRSlotReason::Unused);
+    }
+
+    return m_ActiveSlots;
+}
+
+std::vector<TSRSlotDecision> TSRSlotController::TakeDecisions()
+{
+    std::vector<TSRSlotDecision> decisions;
+    decisions.swap(m_Decisions);
+    return decisions;
+}
+
+void TSRSlotController::Change(uint64_t slots, TSRSlotReason reason)
+{
+    m_Decisions.push_back({m_Stats.frames, m_ActiveSlots, slots, reason, m_ProducerUs, m_ConsumerUs, m_PeakOccupancy});
+
+    if (slots > m_ActiveSlots)
+        m_Stats.grows++;
+    else
+        m_Stats.shrinks++;
+
+    m_ActiveSlots       = slots;
+    m_FramesSinceChange = 0;
+    m_QuietFrames       = 0;
+    m_PeakOccupancy     = 0;
+}
+
+TSRSlotSimResult TSRSimulateSlots(const TSRSlotSimParams& params)
+{
+    AssertCritical(params.frames > 1 && params.slots > 0, L"Invalid slot simulation parameters");
+
+    std::mt19937                           random(params.seed);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+    TSRSlotControllerParams controllerParams = params.controller;
+    controllerParams.maxSlots                = std::min(controllerParams.maxSlots, params.slots);
+    controllerParams.minSlots                = std::min(controllerParams.minSlots, controllerParams.maxSlots);
+    TSRSlotController controller(controllerParams, params.slots);
+
+    // Frames are consumed in order and the consumer releases a slot as soon as it picks the frame up, so frame k can
+    // have a slot once fewer than the active count of the frames before it still wait to be picked up
+    std::vector<double> pickupUs(params.frames);
+    double              producerReadyUs = 0.0;
+    double              consumerReadyUs = 0.0;
+    double              firstAcquireUs  = 0.0;
+    double              lastAcquireUs   = 0.0;
+    double              lastProducerUs  = 0.0;
+    double              lastConsumerUs  = 0.0;
+    double              totalLatencyUs  = 0.0;
+    double              totalStallUs    = 0.0;
+    uint64_t            activeSlots     = params.slots;
+
+    for (uint32_t frame = 0; frame < params.frames; frame++)
+    {
+        double acquireUs = producerReadyUs;
+        if (frame >= activeSlots)
+            acquireUs = std::max(acquireUs, pickupUs[frame - activeSlots]);
+
+        // Frames published before this one which are still waiting
+        uint64_t occupancy = 0;
+        for (uint32_t i = 0; i < frame; i++)
+        {
+            if (pickupUs[i] > acquireUs)
+                occupancy++;
+        }
+
+        bool stalled = acquireUs > producerReadyUs;
+        totalStallUs += acquireUs - producerReadyUs;
+        if (frame == 0)
+            firstAcquireUs = acquireUs;
+        lastAcquireUs = acquireUs;
+
+        // The controller sees the last frame of either side
+        if (params.adaptive && frame > 0)
+        {
+            activeSlots = controller.Update(
+                static_cast<uint64_t>(lastProducerUs * 1000.0), static_cast<uint64_t>(lastConsumerUs * 1000.0), occupancy, stalled);
+        }
+
+        lastProducerUs   = params.producerUs * (1.0 + params.producerJitter * unit(random));
+        double publishUs = acquireUs + lastProducerUs;
+        producerReadyUs  = publishUs;
+
+        pickupUs[frame] = std::max(publishUs, consumerReadyUs);
+        lastConsumerUs  = params.consumerUs * (1.0 + params.consumerJitter * unit(random));
+        consumerReadyUs = pickupUs[frame] + lastConsumerUs;
+        totalLatencyUs += pickupUs[frame] - publishUs;
+    }
+
+    TSRSlotSimResult result;
+    result.averageSlots    = params.adaptive ? controller.GetStats().AverageSlots() : static_cast<double>(params.slots);
+    result.latencyUs       = totalLatencyUs / params.frames;
+    result.producerFrameUs = (lastAcquireUs - firstAcquireUs) / (params.frames - 1);
+    result.stallUs         = totalStallUs / params.frames;
+    result.stats           = controller.GetStats();
+    result.decisions       = controller.TakeDecisions();
+    return result;
+}
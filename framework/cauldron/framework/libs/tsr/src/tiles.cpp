@@ -0,0 +1,171 @@
+#include "tiles.h"
+#include "transport.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace
+{
+    // Word at a time multiplicative hash, change detection only
+    uint64_t HashSpan(uint64_t hash, const uint8_t* pData, size_t size)
+    {
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, pData + i, sizeof(word));
+            hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+            hash ^= hash >> 32;
+        }
+        for (; i < size; i++)
+            hash = (hash ^ pData[i]) * 0x100000001b3ull;
+        return hash;
+    }
+
+    uint64_t PlaneBytes(const TSRHostPlane* pPlane)
+    {
+        return pPlane ? static_cast<uint64_t>(pPlane->width) * pPlane->height * pPlane->stride : 0;
+    }
+}  // namespace
+
+void TSRTileMap::Resize(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+    AssertCritical(tileSize > 0, L"Invalid tile size");
+
+    m_TileSize = tileSize;
+    m_TilesX   = (width + tileSize - 1) / tileSize;
+    m_TilesY   = (height + tileSize - 1) / tileSize;
+    m_Words.assign(GetBitmapSize(width, height, tileSize) / sizeof(uint64_t), 0);
+}
+
+void TSRTileMap::SetAll(bool dirty)
+{
+    std::fill(m_Words.begin(), m_Words.end(), dirty ? UINT64_MAX : 0);
+
+    // Keep the bits past the last tile clear so CountDirty stays exact
+    uint64_t tail = GetTileCount() % 64;
+    if (dirty && tail)
+        m_Words.back() = (1ull << tail) - 1;
+}
+
+uint64_t TSRTileMap::CountDirty() const
+{
+    uint64_t count = 0;
+    for (uint64_t word : m_Words)
+        count += std::bitset<64>(word).count();
+    return count;
+}
+
+uint64_t TSRTileMap::GetBitmapSize(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+    uint64_t tiles = static_cast<uint64_t>((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize);
+    return (tiles + 63) / 64 * sizeof(uint64_t);
+}
+
+TSRTileClassifier::TSRTileClassifier(uint32_t width, uint32_t height, uint32_t tileSize, float motionThreshold)
+    : m_Width(width)
+    , m_Height(height)
+    , m_MotionThreshold(motionThreshold)
+{
+    m_TileMap.Resize(width, height, tileSize);
+    m_Hashes.resize(m_TileMap.GetTileCount());
+}
+
+const TSRTileMap& TSRTileClassifier::Classify(const TSRHostPlane& color, const TSRHostPlane* pMotion)
+{
+    AssertCritical(color.width == m_Width && color.height == m_Height, L"The color plane does not match the classifier");
+    AssertCritical(!pMotion || (pMotion->width == m_Width && pMotion->height == m_Height && pMotion->stride >= 2 * sizeof(float)),
+                   L"The motion vector plane does not match the classifier");
+
+    uint32_t tileSize = m_TileMap.GetTileSize();
+    uint32_t tilesX   = m_TileMap.GetTilesX();
+    float    limit    = m_MotionThreshold * m_MotionThreshold;
+
+    m_TileMap.SetAll(!m_HasHistory);
+
+    std::vector<uint64_t> rowHashes(tilesX);
+    for (uint32_t tileY = 0; tileY < m_TileMap.GetTilesY(); tileY++)
+    {
+        uint32_t rowBegin = tileY * tileSize;
+        uint32_t rowEnd   = std::min(rowBegin + tileSize, m_Height);
+
+        // Hash the tile row one image row at a time, so every row is read front to back once
+        std::fill(rowHashes.begin(), rowHashes.end(), 0xcbf29ce484222325ull);
+        for (uint32_t row = rowBegin; row < rowEnd; row++)
+        {
+            const uint8_t* pRow = color.data + row * color.rowPitch;
+            for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+            {
+                uint32_t columnBegin = tileX * tileSize;
+                uint32_t columnEnd   = std::min(columnBegin + tileSize, m_Width);
+                rowHashes[tileX]     = HashSpan(rowHashes[tileX], pRow + columnBegin * color.stride, (columnEnd - columnBegin) * color.stride);
+            }
+
+            if (!pMotion)
+                continue;
+
+            const uint8_t* pMotionRow = pMotion->data + row * pMotion->rowPitch;
+            for (uint32_t column = 0; column < m_Width; column++)
+            {
+                float motion[2];
+                memcpy(motion, pMotionRow + column * pMotion->stride, sizeof(motion));
+                if (motion[0] * motion[0] + motion[1] * motion[1] > limit)
+                    m_TileMap.Set(column / tileSize, tileY);
+            }
+        }
+
+        for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+        {
+            uint64_t& hash = m_Hashes[static_cast<uint64_t>(tileY) * tilesX + tileX];
+            if (hash != rowHashes[tileX])
+                m_TileMap.Set(tileX, tileY);
+            hash = rowHashes[tileX];
+        }
+    }
+
+    m_HasHistory = true;
+    return m_TileMap;
+}
+
+TSRTileDeltaStats TSRMeasureTileDelta(
+    const TSRHostPlane* pColorFrames, const TSRHostPlane* pMotionFrames, size_t frameCount, uint32_t tileSize, float motionThreshold)
+{
+    TSRTileDeltaStats stats;
+    if (!frameCount)
+        return stats;
+
+    uint32_t          width  = pColorFrames[0].width;
+    uint32_t          height = pColorFrames[0].height;
+    TSRTileClassifier classifier(width, height, tileSize, motionThreshold);
+
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        const TSRHostPlane* pMotion   = pMotionFrames ? &pMotionFrames[frame] : nullptr;
+        const TSRTileMap&   tiles     = classifier.Classify(pColorFrames[frame], pMotion);
+        uint64_t            texelSize = pColorFrames[frame].stride + (pMotion ? pMotion->stride : 0);
+
+        stats.frames++;
+        stats.tiles += tiles.GetTileCount();
+        stats.fullBytes += PlaneBytes(&pColorFrames[frame]) + PlaneBytes(pMotion);
+        stats.deltaBytes += tiles.GetBitmapSize();
+
+        // Edge tiles are cut by the frame bounds
+        for (uint32_t tileY = 0; tileY < tiles.GetTilesY(); tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < tiles.GetTilesX(); tileX++)
+            {
+                if (!tiles.Test(tileX, tileY))
+                    continue;
+
+                uint64_t tileWidth  = std::min(tileSize, width - tileX * tileSize);
+                uint64_t tileHeight = std::min(tileSize, height - tileY * tileSize);
+                stats.dirtyTiles++;
+                stats.deltaBytes += tileWidth * tileHeight * texelSize;
+            }
+        }
+    }
+
+    return stats;
+}
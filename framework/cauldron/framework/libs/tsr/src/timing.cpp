@@ -0,0 +1,91 @@
+#include "timing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t tsr_now_ns()
+{
+#if defined(_WIN32)
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+    // CLOCK_MONOTONIC is shared by all processes, so timestamps can be exchanged through shared memory
+    timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+void tsr_sleep_until_ns(uint64_t deadlineNs)
+{
+    constexpr uint64_t SPIN_NS = 200000;
+
+    for (uint64_t nowNs = tsr_now_ns(); nowNs < deadlineNs; nowNs = tsr_now_ns())
+    {
+        if (deadlineNs - nowNs > SPIN_NS)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadlineNs - nowNs - SPIN_NS));
+        else
+            std::this_thread::yield();
+    }
+}
+
+uint64_t tsr_thread_cpu_ns()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    // FILETIME is in 100ns units
+    uint64_t kernelTime = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    uint64_t userTime   = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return (kernelTime + userTime) * 100;
+#else
+    timespec ts = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+void TSRHistogram::Add(uint64_t valueUs)
+{
+    size_t bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && valueUs >= (1ull << bucket))
+        bucket++;
+
+    buckets[bucket]++;
+    count++;
+    total += valueUs;
+    max = std::max(max, valueUs);
+}
+
+void TSRHistogram::Merge(const TSRHistogram& other)
+{
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+        buckets[i] += other.buckets[i];
+    count += other.count;
+    total += other.total;
+    max = std::max(max, other.max);
+}
+
+uint64_t TSRHistogram::Percentile(double percentile) const
+{
+    if (!count)
+        return 0;
+
+    uint64_t target     = static_cast<uint64_t>(percentile * count);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        cumulative += buckets[i];
+        if (cumulative > target)
+            return std::min<uint64_t>(i ? (1ull << i) - 1 : 0, max);
+    }
+    return max;
+}
@@ -1,199 +1,494 @@
 #include "transfer.h"
 #include "assert.h"
 #include <string>
+#include <utility>
+#include <vector>
 
 TSROps::~TSROps()
 {
-    for (size_t i = 0; i < m_BufferCount; i++)
+    // The renderer stops waiting for us
+    if (m_Ring.IsRegistered())
+        m_Ring.UnregisterConsumer();
+
+    if (m_pTimestampHeap)
     {
-        ID3D12Resource* pResource = std::get<0>(p_SharedBuffer[i]);
-        ID3D12Fence*    pFence    = std::get<1>(p_SharedBuffer[i]);
+        m_pTimestampReadback->Unmap(0, nullptr);
+        m_pTimestampReadback->Release();
+        m_pTimestampHeap->Release();
+    }
 
-        if (pResource)
-        {
-            pResource->Release();
-        }
+    if (m_CopyMode != TSRCopyMode::CopyQueue)
+        return;
 
-        if (pFence)
-        {
-            pFence->Release();
-        }
+    // Let the queued transfers finish before releasing their command lists
+    if (m_pGraphicsFence->GetCompletedValue() < m_GraphicsFenceValue)
+    {
+        m_pGraphicsFence->SetEventOnCompletion(m_GraphicsFenceValue, m_FenceEvent);
+        WaitForSingleObject(m_FenceEvent, INFINITE);
     }
+
+    for (CopyContext& context : m_CopyContexts)
+    {
+        context.pPrepareList->Release();
+        context.pCopyList->Release();
+        context.pRestoreList->Release();
+        context.pPrepareAllocator->Release();
+        context.pCopyAllocator->Release();
+        context.pRestoreAllocator->Release();
+    }
+
+    m_pCopyFence->Release();
+    m_pGraphicsFence->Release();
+    m_pCopyQueue->Release();
+    CloseHandle(m_FenceEvent);
 }
 
-bool TSROps::bufferStateMatches(uint64_t bufferIndex, BufferState state)
+void TSROps::CreateCopyQueue()
 {
-    AssertCritical(bufferIndex < m_BufferCount, L"Invalid buffer index");
-    ID3D12Fence* pFence = std::get<1>(p_SharedBuffer[bufferIndex]);
-    return pFence->GetCompletedValue() == static_cast<UINT64>(state);
+    ID3D12Device* pDevice = m_pTransport->GetDevice();
+
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type                     = D3D12_COMMAND_LIST_TYPE_COPY;
+    queueDesc.Priority                 = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+    AssertCritical(pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_pCopyQueue)) == S_OK, L"Failed to create the copy queue");
+    m_pCopyQueue->SetName(L"TSRCopyQueue");
+
+    AssertCritical(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pGraphicsFence)) == S_OK, L"Failed to create the graphics fence");
+    AssertCritical(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pCopyFence)) == S_OK, L"Failed to create the copy fence");
+
+    m_FenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    AssertCritical(m_FenceEvent, L"Failed to create the fence event");
+
+    m_CopyContexts.resize(m_BufferCount);
+    for (CopyContext& context : m_CopyContexts)
+    {
+        AssertCritical(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&context.pPrepareAllocator)) == S_OK,
+                       L"Failed to create a command allocator");
+        AssertCritical(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&context.pCopyAllocator)) == S_OK,
+                       L"Failed to create a command allocator");
+        AssertCritical(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&context.pRestoreAllocator)) == S_OK,
+                       L"Failed to create a command allocator");
+
+        AssertCritical(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, context.pPrepareAllocator, nullptr, IID_PPV_ARGS(&context.pPrepareList)) == S_OK,
+                       L"Failed to create a command list");
+        AssertCritical(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, context.pCopyAllocator, nullptr, IID_PPV_ARGS(&context.pCopyList)) == S_OK,
+                       L"Failed to create a command list");
+        AssertCritical(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, context.pRestoreAllocator, nullptr, IID_PPV_ARGS(&context.pRestoreList)) == S_OK,
+                       L"Failed to create a command list");
+
+        // Lists are created open, BeginCopy expects them closed
+        context.pPrepareList->Close();
+        context.pCopyList->Close();
+        context.pRestoreList->Close();
+    }
 }
 
-bool TSROps::bufferStateMatchesAll(BufferState state)
+void TSROps::CreateTimestamps()
 {
-    for (size_t i = 0; i < m_BufferCount; i++)
+    ID3D12Device* pDevice = m_pTransport->GetDevice();
+
+    // The copies run on the copy queue in that mode, which only some devices can timestamp
+    D3D12_QUERY_HEAP_TYPE heapType = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    ID3D12CommandQueue*   pQueue   = m_pGraphicsQueue;
+    if (m_CopyMode == TSRCopyMode::CopyQueue)
     {
-        if (!bufferStateMatches(i, state))
-            return false;
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options = {};
+        if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options, sizeof(options))) ||
+            !options.CopyQueueTimestampQueriesSupported)
+            return;
+
+        heapType = D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP;
+        pQueue   = m_pCopyQueue;
+    }
+
+    // Without timestamps the transfers still get their counters, only the GPU timings are missing
+    if (FAILED(pQueue->GetTimestampFrequency(&m_TimestampFrequency)))
+        return;
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type                  = heapType;
+    heapDesc.Count                 = static_cast<UINT>(m_BufferCount * TSR_TRANSFER_MAX_TIMESTAMPS);
+    if (FAILED(pDevice->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&m_pTimestampHeap))))
+        return;
+
+    D3D12_HEAP_PROPERTIES heapProperties = {};
+    heapProperties.Type                  = D3D12_HEAP_TYPE_READBACK;
+
+    D3D12_RESOURCE_DESC bufferDesc = {};
+    bufferDesc.Dimension           = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Width               = heapDesc.Count * sizeof(uint64_t);
+    bufferDesc.Height              = 1;
+    bufferDesc.DepthOrArraySize    = 1;
+    bufferDesc.MipLevels           = 1;
+    bufferDesc.SampleDesc.Count    = 1;
+    bufferDesc.Layout              = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    void* pMapped = nullptr;
+    if (FAILED(pDevice->CreateCommittedResource(
+            &heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_pTimestampReadback))) ||
+        FAILED(m_pTimestampReadback->Map(0, nullptr, &pMapped)))
+    {
+        if (m_pTimestampReadback)
+            m_pTimestampReadback->Release();
+        m_pTimestampReadback = nullptr;
+        m_pTimestampHeap->Release();
+        m_pTimestampHeap = nullptr;
+        return;
     }
-    return true;
+    m_pTimestampReadback->SetName(L"TSRTimestampReadback");
+
+    m_pTimestamps = static_cast<const uint64_t*>(pMapped);
+    m_SlotTimings.resize(m_BufferCount);
 }
 
-size_t TSROps::CalculateTotalSize(FSRResources pResources)
+void TSROps::WriteTimestamp(ID3D12GraphicsCommandList2* pCmdList, uint64_t bufferIndex, size_t index)
 {
-    size_t totalSize = 0;
+    if (m_pTimestampHeap)
+        pCmdList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, static_cast<UINT>(bufferIndex * TSR_TRANSFER_MAX_TIMESTAMPS + index));
+}
 
-    for (size_t i = 0; i < pResources.size(); i++)
+void TSROps::CollectTimestamps(uint64_t bufferIndex)
+{
+    if (!m_pTimestampHeap || !m_SlotTimings[bufferIndex].pending)
+        return;
+
+    SlotTiming& timing = m_SlotTimings[bufferIndex];
+    m_Stats.AddTimestamps(m_pTimestamps + bufferIndex * TSR_TRANSFER_MAX_TIMESTAMPS, timing.copiedPlanes, m_TimestampFrequency);
+    timing.pending = false;
+}
+
+bool TSROps::EndAcquire(uint64_t startNs, bool acquired)
+{
+    // The wait for a slot may take several calls which timed out, it only counts once the slot is there
+    m_AcquireWaitNs += tsr_now_ns() - startNs;
+    if (acquired)
     {
-        const TSRGraphicsResource* pResource = pResources[i];
-        D3D12_RESOURCE_DESC        desc      = pResource->desc;
-        uint64_t                   stride    = pResource->stride;
+        m_Stats.acquireUs.Add(m_AcquireWaitNs / 1000);
+        m_AcquireWaitNs = 0;
+    }
+    return acquired;
+}
+
+TSROps::CopyContext& TSROps::BeginCopy(uint64_t bufferIndex)
+{
+    CopyContext& context = m_CopyContexts[bufferIndex];
 
-        totalSize += desc.Width * desc.Height * stride;
+    // The slot's previous transfer has to be off the GPU before its allocators can be reset
+    if (m_pGraphicsFence->GetCompletedValue() < context.fenceValue)
+    {
+        m_pGraphicsFence->SetEventOnCompletion(context.fenceValue, m_FenceEvent);
+        WaitForSingleObject(m_FenceEvent, INFINITE);
     }
 
-    return totalSize;
+    context.pPrepareAllocator->Reset();
+    context.pCopyAllocator->Reset();
+    context.pRestoreAllocator->Reset();
+    context.pPrepareList->Reset(context.pPrepareAllocator, nullptr);
+    context.pCopyList->Reset(context.pCopyAllocator, nullptr);
+    context.pRestoreList->Reset(context.pRestoreAllocator, nullptr);
+
+    return context;
+}
+
+void TSROps::SubmitCopy()
+{
+    uint64_t     startNs = tsr_now_ns();
+    CopyContext& context = *m_pPendingCopy;
+    m_pPendingCopy       = nullptr;
+
+    // Graphics: release the resources once the work queued so far is done
+    ID3D12CommandList* pPrepareList = context.pPrepareList;
+    m_pGraphicsQueue->ExecuteCommandLists(1, &pPrepareList);
+    m_pGraphicsQueue->Signal(m_pGraphicsFence, ++m_GraphicsFenceValue);
+
+    // Copy: transfer, then hand the slot to the other process straight from the copy queue
+    ID3D12CommandList* pCopyList = context.pCopyList;
+    m_pCopyQueue->Wait(m_pGraphicsFence, m_GraphicsFenceValue);
+    m_pCopyQueue->ExecuteCommandLists(1, &pCopyList);
+    m_pTransport->FlushSignals(m_pCopyQueue);
+    m_pCopyQueue->Signal(m_pCopyFence, ++m_CopyFenceValue);
+
+    // Graphics: take the resources back before the next frame uses them
+    ID3D12CommandList* pRestoreList = context.pRestoreList;
+    m_pGraphicsQueue->Wait(m_pCopyFence, m_CopyFenceValue);
+    m_pGraphicsQueue->ExecuteCommandLists(1, &pRestoreList);
+    m_pGraphicsQueue->Signal(m_pGraphicsFence, ++m_GraphicsFenceValue);
+    context.fenceValue = m_GraphicsFenceValue;
+
+    m_Stats.submitUs.Add((tsr_now_ns() - startNs) / 1000);
 }
 
-void TSROps::CreateSharedBuffers(FSRResources pResources, bool shouldCreate)
+void TSROps::Submit()
 {
-    for (size_t i = 0; i < m_BufferCount; i++)
+    if (m_pPendingCopy)
+        SubmitCopy();
+
+    // Graphics mode: the transfers are in the frame's command lists, signal the slots behind them
+    if (m_pTransport->HasPendingSignals())
     {
-        ID3D12Resource* pResource    = nullptr;
-        ID3D12Fence*    pFence       = nullptr;
-        std::wstring    resourceName = m_pSharedName + std::to_wstring(i) + L"_RESOURCE";
-        std::wstring    fenceName    = m_pSharedName + std::to_wstring(i) + L"_FENCE";
+        uint64_t startNs = tsr_now_ns();
+        m_pTransport->FlushSignals(m_pGraphicsQueue);
+        m_Stats.submitUs.Add((tsr_now_ns() - startNs) / 1000);
+    }
+}
 
-        if (shouldCreate)
-        {
-            // Create a shared buffer
-            D3D12_RESOURCE_DESC bufferDesc = {};
-            bufferDesc.Alignment           = 0;
-            bufferDesc.DepthOrArraySize    = 1;
-            bufferDesc.Dimension           = D3D12_RESOURCE_DIMENSION_BUFFER;
-            bufferDesc.Flags               = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;  // D3D12_RESOURCE_FLAG_NONE
-            bufferDesc.Format              = DXGI_FORMAT_UNKNOWN;
-            bufferDesc.Height              = 1;
-            bufferDesc.Width               = CalculateTotalSize(pResources);
-            bufferDesc.Layout              = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-            bufferDesc.MipLevels           = 1;
-            bufferDesc.SampleDesc.Count    = 1;
-            bufferDesc.SampleDesc.Quality  = 0;
-
-            // Heap properties
-            D3D12_HEAP_PROPERTIES heapProps = {};
-            heapProps.Type                  = D3D12_HEAP_TYPE_DEFAULT;
-
-            D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
-            AssertCritical(
-                m_pDevice->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_SHARED, &bufferDesc, state, nullptr, IID_PPV_ARGS(&pResource)) == S_OK,
-                L"Failed to create shared buffer");
-
-            // Create a fence
-            AssertCritical(m_pDevice->CreateFence(static_cast<UINT64>(BufferState::IDLE), D3D12_FENCE_FLAG_SHARED, IID_PPV_ARGS(&pFence)) == S_OK,
-                           L"Failed to create shared fence");
-
-            // Create the shared handles
-            HANDLE handle = {};
-            AssertCritical(m_pDevice->CreateSharedHandle(pResource, nullptr, GENERIC_ALL, resourceName.c_str(), &handle) == S_OK, L"Failed to create shared handle for resource");
-
-            handle = {};
-            AssertCritical(m_pDevice->CreateSharedHandle(pFence, nullptr, GENERIC_ALL, fenceName.c_str(), &handle) == S_OK, L"Failed to create shared handle for fence");
-        }
-        else
-        {
-            // Open the shared handles
-            HANDLE handle = {};
-            AssertCritical(m_pDevice->OpenSharedHandleByName(resourceName.c_str(), GENERIC_ALL, &handle) == S_OK, L"Failed to open shared handle by name for resource");
-            AssertCritical(m_pDevice->OpenSharedHandle(handle, IID_PPV_ARGS(&pResource)) == S_OK, L"Failed to open shared handle for resource");
-
-            handle = {};
-            AssertCritical(m_pDevice->OpenSharedHandleByName(fenceName.c_str(), GENERIC_ALL, &handle) == S_OK, L"Failed to open shared handle by name for fence");
-            AssertCritical(m_pDevice->OpenSharedHandle(handle, IID_PPV_ARGS(&pFence)) == S_OK, L"Failed to open shared handle for fence");
-        }
+void TSROps::CreateSharedBuffers(const TSRManifest& manifest, bool shouldCreate)
+{
+    AssertCritical(manifest.IsFinalized(), L"The resource manifest is not finalized");
+
+    m_Manifest = manifest;
 
-        p_SharedBuffer[i] = std::make_tuple(pResource, pFence);
+    // The tile map is classified on the CPU, GPU transfers always send full frames
+    AssertCritical(!m_Manifest.GetTileSize(), L"Delta transfers are only supported by host transports");
+
+    // The portable layout has to agree with what the device reports for every resource
+    for (size_t i = 0; i < m_Manifest.GetResourceCount(); i++)
+    {
+        const TSRResourceDesc& layout = m_Manifest.GetResource(i);
+
+        // GPU transfers copy texels as they are, packing happens in the render passes producing the resources
+        AssertCritical(layout.packing == TSRPacking::None, L"Packed resources are only supported by host transports");
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension           = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        desc.Width               = layout.width;
+        desc.Height              = layout.height;
+        desc.DepthOrArraySize    = 1;
+        desc.MipLevels           = 1;
+        desc.Format              = static_cast<DXGI_FORMAT>(layout.format);
+        desc.SampleDesc.Count    = 1;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint  = {};
+        UINT64                             totalBytes = 0;
+        m_pTransport->GetDevice()->GetCopyableFootprints(&desc, 0, 1, layout.offset, &footprint, nullptr, nullptr, &totalBytes);
+
+        AssertCritical(footprint.Offset == layout.offset && footprint.Footprint.RowPitch == layout.rowPitch && totalBytes == layout.size,
+                       L"The shared buffer layout does not match the device copy footprints");
     }
+
+    m_pTransport->CreateSlots(m_Manifest.GetTotalSize(), m_Manifest.GetHash(), shouldCreate);
+
+    if (!shouldCreate)
+        m_Ring.RegisterConsumer();
+}
+
+void TSROps::SetConsumedResources(uint64_t resourceMask)
+{
+    m_ConsumedResources = resourceMask;
+    m_pTransport->SetConsumedResources(m_Ring.GetConsumer(), resourceMask);
 }
 
-void TSROps::PerformTransfer(FSRResources pResources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList, bool toSharedBuffer)
+void TSROps::SetAliasedResources(uint64_t resourceMask)
+{
+    // On the copy queue the upscaler releases the slot right after the copies, before its frame read the aliased resources
+    AssertCritical(!resourceMask || m_CopyMode == TSRCopyMode::Graphics, L"Aliased resources are only supported by graphics transfers");
+    m_AliasedResources = resourceMask;
+}
+
+void TSROps::PerformTransfer(const TSRResources& resources, uint64_t bufferIndex, ID3D12GraphicsCommandList2* pCmdList, bool toSharedBuffer)
 {
     AssertCritical(bufferIndex < m_BufferCount, L"Invalid buffer index");
+    uint64_t startNs = tsr_now_ns();
+
+    // Get the shared buffer of the slot
+    ID3D12Resource* pSharedResource = m_pTransport->GetSlotResource(bufferIndex);
+
+    // Verify the shared buffer was claimed through the ring
+    AssertCritical(m_Ring.HasAcquired() && m_Ring.GetAcquiredSlot() == bufferIndex, L"The shared buffer is not in the correct state");
+
+    AssertCritical(resources.size() == m_Manifest.GetResourceCount(), L"The resources do not match the manifest");
 
-    // Get the device and command list
-    ID3D12Resource* pSharedResource = std::get<0>(p_SharedBuffer[bufferIndex]);
-    ID3D12Fence*    pSharedFence    = std::get<1>(p_SharedBuffer[bufferIndex]);
+    // The slot is back, so is its previous transfer
+    CollectTimestamps(bufferIndex);
 
-    // Verify the shared buffer is in the correct state
-    UINT64 desiredState = static_cast<UINT64>(toSharedBuffer ? BufferState::IDLE : BufferState::READY);
-    AssertCritical(pSharedFence->GetCompletedValue() == desiredState, L"The shared buffer is not in the correct state");
+    // The renderer writes what it has and the upscaler wants, the upscaler reads what it wants and the renderer wrote
+    TSRSlotHeader& header       = *m_pTransport->GetSlotHeader(bufferIndex);
+    uint64_t       resourceMask = toSharedBuffer ? m_pTransport->GetConsumedResources() : m_ConsumedResources & header.resourceMask;
 
-    // Keep track of the current offset in the staging resource
-    size_t offset = 0;
+    // Reading an aliased resource out of the shared buffer (or a copied one out of the heaps) would read garbage
+    AssertCritical(toSharedBuffer || !((header.aliasedMask ^ m_AliasedResources) & resourceMask),
+                   L"The renderer and the upscaler do not alias the same resources");
 
-    for (size_t i = 0; i < pResources.size(); i++)
+    // Pick the resources to copy and batch their transitions, so the copies sit between one barrier call on each side
+    std::vector<size_t>                 transfers;
+    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    transfers.reserve(resources.size());
+    barriers.reserve(resources.size());
+
+    // On the copy queue, the graphics queue hands the resources over in the COMMON state and the copy queue moves them
+    // in and out of the copy state itself
+    D3D12_RESOURCE_STATES copyState = toSharedBuffer ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_COPY_DEST;
+    ID3D12GraphicsCommandList2* pCopyList    = pCmdList;
+    ID3D12GraphicsCommandList2* pRestoreList = pCmdList;
+    CopyContext*                pContext     = nullptr;
+    if (m_CopyMode == TSRCopyMode::CopyQueue)
     {
-        TSRGraphicsResource* pResource = const_cast<TSRGraphicsResource*>(pResources[i]);
-        D3D12_RESOURCE_DESC  desc      = pResource->desc;
-        DXGI_FORMAT          format    = pResource->format;
-        UINT64               size      = desc.Width * desc.Height * pResource->stride;
+        pContext     = &BeginCopy(bufferIndex);
+        pCmdList     = pContext->pPrepareList;
+        pCopyList    = pContext->pCopyList;
+        pRestoreList = pContext->pRestoreList;
+    }
 
-        // Transition the resource to appropriate state
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        const TSRGraphicsResource* pResource = &resources[i];
+        const TSRResourceDesc&     layout    = m_Manifest.GetResource(i);
+        if (!(resourceMask & (1ull << i)) || !pResource->resource)
         {
-            D3D12_RESOURCE_BARRIER barrier{};
-            barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Transition.pResource   = const_cast<ID3D12Resource*>(pResource->resource);
-            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE;
-            barrier.Transition.StateAfter  = toSharedBuffer ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_COPY_DEST;
-
-            pCmdList->ResourceBarrier(1, &barrier);
+            // The upscaler can't do without the required resources it reads
+            AssertCritical(toSharedBuffer || layout.optional || !(m_ConsumedResources & (1ull << i)), L"A required resource is missing from the shared buffer");
+            resourceMask &= ~(1ull << i);
+            continue;
         }
 
-        // Perform the transfer command
+        AssertCritical(pResource->desc.Width == layout.width && pResource->desc.Height == layout.height &&
+                           pResource->format == static_cast<DXGI_FORMAT>(layout.format),
+                       L"The resource does not match the manifest");
+
+        // Rendered into (or read) in the slot's heap already, only the slot changes hands
+        if (m_AliasedResources & (1ull << i))
         {
-            D3D12_TEXTURE_COPY_LOCATION actualResource{};
-            actualResource.Type             = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            actualResource.pResource        = const_cast<ID3D12Resource*>(pResource->resource);
-            actualResource.SubresourceIndex = 0;
-
-            D3D12_TEXTURE_COPY_LOCATION sharedResource{};
-            sharedResource.Type                               = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-            sharedResource.pResource                          = pSharedResource;
-            sharedResource.PlacedFootprint.Footprint.Depth    = 1;
-            sharedResource.PlacedFootprint.Footprint.Height   = desc.Height;
-            sharedResource.PlacedFootprint.Footprint.Width    = static_cast<UINT>(desc.Width);
-            sharedResource.PlacedFootprint.Footprint.Format   = format;
-            sharedResource.PlacedFootprint.Footprint.RowPitch = static_cast<UINT>(desc.Width * pResource->stride);
-            sharedResource.PlacedFootprint.Offset             = offset;
-
-            if (toSharedBuffer)
-            {
-                pCmdList->CopyTextureRegion(&sharedResource, 0, 0, 0, &actualResource, nullptr);
-            }
-            else
-            {
-                pCmdList->CopyTextureRegion(&actualResource, 0, 0, 0, &sharedResource, nullptr);
-            }
+            m_Stats.AddPlane(i, 0, true);
+            continue;
         }
 
-        // Transition the resource back to its original state
+        // Transition the resource to appropriate state
+        D3D12_RESOURCE_BARRIER barrier{};
+        barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource   = const_cast<ID3D12Resource*>(pResource->resource);
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE;
+        barrier.Transition.StateAfter  = pContext ? D3D12_RESOURCE_STATE_COMMON : copyState;
+
+        transfers.push_back(i);
+        barriers.push_back(barrier);
+    }
+
+    // The GPU timings are taken on the list doing the copies, around the transitions of that list
+    if (!pContext)
+        WriteTimestamp(pCopyList, bufferIndex, 0);
+
+    if (!barriers.empty())
+        pCmdList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+
+    std::vector<D3D12_RESOURCE_BARRIER> copyBarriers;
+    if (pContext)
+    {
+        copyBarriers = barriers;
+        for (D3D12_RESOURCE_BARRIER& barrier : copyBarriers)
         {
-            D3D12_RESOURCE_BARRIER barrier{};
-            barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-            barrier.Transition.pResource   = const_cast<ID3D12Resource*>(pResource->resource);
-            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-            barrier.Transition.StateBefore = toSharedBuffer ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_COPY_DEST;
-            barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE;
-
-            pCmdList->ResourceBarrier(1, &barrier);
+            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COMMON;
+            barrier.Transition.StateAfter  = copyState;
         }
 
-        // Update the offset
-        offset += size;
+        WriteTimestamp(pCopyList, bufferIndex, 0);
+        if (!copyBarriers.empty())
+            pCopyList->ResourceBarrier(static_cast<UINT>(copyBarriers.size()), copyBarriers.data());
     }
+    WriteTimestamp(pCopyList, bufferIndex, 1);
+
+    // Perform the transfer commands
+    for (size_t k = 0; k < transfers.size(); k++)
+    {
+        size_t i = transfers[k];
+
+        const TSRGraphicsResource& resource = resources[i];
+        const TSRResourceDesc&     layout   = m_Manifest.GetResource(i);
+
+        D3D12_TEXTURE_COPY_LOCATION actualResource{};
+        actualResource.Type             = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        actualResource.pResource        = const_cast<ID3D12Resource*>(resource.resource);
+        actualResource.SubresourceIndex = 0;
+
+        D3D12_TEXTURE_COPY_LOCATION sharedResource{};
+        sharedResource.Type                               = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        sharedResource.pResource                          = pSharedResource;
+        sharedResource.PlacedFootprint.Footprint.Depth    = 1;
+        sharedResource.PlacedFootprint.Footprint.Height   = layout.height;
+        sharedResource.PlacedFootprint.Footprint.Width    = layout.width;
+        sharedResource.PlacedFootprint.Footprint.Format   = resource.format;
+        sharedResource.PlacedFootprint.Footprint.RowPitch = static_cast<UINT>(layout.rowPitch);
+        sharedResource.PlacedFootprint.Offset             = layout.offset;
+
+        if (toSharedBuffer)
+        {
+            pCopyList->CopyTextureRegion(&sharedResource, 0, 0, 0, &actualResource, nullptr);
+        }
+        else
+        {
+            pCopyList->CopyTextureRegion(&actualResource, 0, 0, 0, &sharedResource, nullptr);
+        }
+        WriteTimestamp(pCopyList, bufferIndex, 2 + k);
+        m_Stats.AddPlane(i, layout.size, false);
+    }
+
+    // Transition the resources back to their original state
+    for (D3D12_RESOURCE_BARRIER& barrier : copyBarriers)
+        std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+
+    if (!copyBarriers.empty())
+        pCopyList->ResourceBarrier(static_cast<UINT>(copyBarriers.size()), copyBarriers.data());
+    if (pContext)
+        WriteTimestamp(pCopyList, bufferIndex, 2 + transfers.size());
+
+    for (D3D12_RESOURCE_BARRIER& barrier : barriers)
+        std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+
+    if (!barriers.empty())
+        pRestoreList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+    if (!pContext)
+        WriteTimestamp(pCopyList, bufferIndex, 2 + transfers.size());
+
+    // Read the timestamps back with the transfer, they are collected when the slot comes back
+    if (m_pTimestampHeap)
+    {
+        UINT first = static_cast<UINT>(bufferIndex * TSR_TRANSFER_MAX_TIMESTAMPS);
+        pCopyList->ResolveQueryData(m_pTimestampHeap,
+                                    D3D12_QUERY_TYPE_TIMESTAMP,
+                                    first,
+                                    static_cast<UINT>(transfers.size() + 3),
+                                    m_pTimestampReadback,
+                                    first * sizeof(uint64_t));
+
+        SlotTiming& timing  = m_SlotTimings[bufferIndex];
+        timing.pending      = true;
+        timing.copiedPlanes = transfers;
+    }
+
+    if (pContext)
+    {
+        pContext->pPrepareList->Close();
+        pContext->pCopyList->Close();
+        pContext->pRestoreList->Close();
+        m_pPendingCopy = pContext;
+    }
+
+    // Tell the upscaler which resources made it into the slot, and which frame they belong to
+    if (toSharedBuffer)
+    {
+        header.manifestHash = m_Manifest.GetHash();
+        header.resourceMask = resourceMask;
+        header.deltaMask    = 0;
+        header.aliasedMask  = resourceMask & m_AliasedResources;
+        header.metadata     = m_FrameMetadata;
+    }
+    else
+    {
+        m_FrameMetadata    = header.metadata;
+        m_SlotManifestHash = header.manifestHash;
+    }
+    m_TransferredResources = resourceMask;
+
+    m_Stats.transfers++;
+    m_Stats.recordUs.Add((tsr_now_ns() - startNs) / 1000);
+
+    // Signal the fence to indicate the transfer is complete, the signal is queued by Submit
+    if (toSharedBuffer)
+        m_Ring.Publish();
+    else
+        m_Ring.Release();
 
-    // Signal the fence to indicate the transfer is complete
-    AssertCritical(m_pQueue->Signal(pSharedFence, static_cast<UINT64>(toSharedBuffer ? BufferState::READY : BufferState::IDLE)) == S_OK,
-                   L"Failed to signal the fence");
-    return;
+    // The upscaler reads at the start of its frame, with the previous frame already queued the copy can go right away
+    if (pContext && !toSharedBuffer)
+        SubmitCopy();
 }
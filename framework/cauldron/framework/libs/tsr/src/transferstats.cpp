@@ -0,0 +1,74 @@
+#include "transferstats.h"
+#include "assert.h"
+
+void TSRTransferStats::AddPlane(size_t plane, uint64_t bytes, bool aliased)
+{
+    AssertCritical(plane < TSR_MANIFEST_MAX_RESOURCES, L"Invalid manifest resource index");
+    if (planes.size() <= plane)
+        planes.resize(plane + 1);
+
+    TSRPlaneStats& stats = planes[plane];
+    if (aliased)
+    {
+        stats.aliased++;
+        return;
+    }
+
+    stats.copies++;
+    stats.bytes += bytes;
+    this->bytes += bytes;
+}
+
+void TSRTransferStats::AddTimestamps(const uint64_t* pTimestamps, const std::vector<size_t>& copiedPlanes, uint64_t frequency)
+{
+    AssertCritical(copiedPlanes.size() + 3 <= TSR_TRANSFER_MAX_TIMESTAMPS, L"Too many planes for the transfer timestamps");
+
+    // A queue which was reset in between, or a slot timed before its transfer, hands back timestamps out of order
+    size_t end = copiedPlanes.size() + 2;
+    for (size_t i = 0; i < end; i++)
+    {
+        if (pTimestamps[i + 1] < pTimestamps[i])
+            return;
+    }
+    if (!frequency)
+        return;
+
+    auto toUs = [frequency](uint64_t ticks) { return static_cast<uint64_t>(static_cast<double>(ticks) * 1000000.0 / frequency); };
+
+    // The GPU may overlap a copy with the next, the timings of the planes are where the time went roughly
+    for (size_t k = 0; k < copiedPlanes.size(); k++)
+    {
+        size_t plane = copiedPlanes[k];
+        if (planes.size() <= plane)
+            planes.resize(plane + 1);
+        planes[plane].copyUs.Add(toUs(pTimestamps[2 + k] - pTimestamps[1 + k]));
+    }
+
+    barrierUs.Add(toUs((pTimestamps[1] - pTimestamps[0]) + (pTimestamps[end] - pTimestamps[end - 1])));
+    copyUs.Add(toUs(pTimestamps[end - 1] - pTimestamps[1]));
+    gpuUs.Add(toUs(pTimestamps[end] - pTimestamps[0]));
+    gpuFrames++;
+}
+
+void TSRTransferStats::Merge(const TSRTransferStats& other)
+{
+    transfers += other.transfers;
+    bytes += other.bytes;
+    gpuFrames += other.gpuFrames;
+    acquireUs.Merge(other.acquireUs);
+    recordUs.Merge(other.recordUs);
+    submitUs.Merge(other.submitUs);
+    barrierUs.Merge(other.barrierUs);
+    copyUs.Merge(other.copyUs);
+    gpuUs.Merge(other.gpuUs);
+
+    if (planes.size() < other.planes.size())
+        planes.resize(other.planes.size());
+    for (size_t i = 0; i < other.planes.size(); i++)
+    {
+        planes[i].copies += other.planes[i].copies;
+        planes[i].aliased += other.planes[i].aliased;
+        planes[i].bytes += other.planes[i].bytes;
+        planes[i].copyUs.Merge(other.planes[i].copyUs);
+    }
+}
@@ -0,0 +1,250 @@
+#include "transport.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+bool TSRTransport::slotStateMatches(uint64_t slotIndex, TSRBufferState state)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+    return (GetSlotValue(slotIndex) & 1) == static_cast<uint64_t>(state);
+}
+
+bool TSRTransport::slotStateMatchesAll(TSRBufferState state)
+{
+    for (uint64_t i = 0; i < m_SlotCount; i++)
+    {
+        if (!slotStateMatches(i, state))
+            return false;
+    }
+    return true;
+}
+
+bool TSRTransport::WaitSlotValue(uint64_t slotIndex, uint64_t value, uint64_t timeoutUs)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+
+    std::vector<uint64_t> targetValues(m_SlotCount * m_LaneCount, UINT64_MAX);
+    targetValues[slotIndex] = value;
+    return WaitAny(targetValues.data(), timeoutUs);
+}
+
+uint32_t TSRTransport::GetActiveConsumers() const
+{
+    uint32_t registered = m_pControlBlock->registeredConsumers.load(std::memory_order_acquire);
+    return registered ? registered : 1;
+}
+
+void TSRTransport::RegisterConsumer(uint32_t consumer)
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    m_pControlBlock->registeredConsumers.fetch_or(1u << consumer, std::memory_order_acq_rel);
+}
+
+void TSRTransport::UnregisterConsumer(uint32_t consumer)
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    m_pControlBlock->registeredConsumers.fetch_and(~(1u << consumer), std::memory_order_acq_rel);
+}
+
+void TSRTransport::SetConsumedResources(uint32_t consumer, uint64_t resourceMask)
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    m_pControlBlock->consumers[consumer].resourceMask.store(resourceMask, std::memory_order_relaxed);
+}
+
+uint64_t TSRTransport::GetConsumedResources() const
+{
+    uint32_t active       = GetActiveConsumers();
+    uint64_t resourceMask = 0;
+    for (uint32_t i = 0; i < m_ConsumerCount; i++)
+    {
+        if (active & (1u << i))
+            resourceMask |= m_pControlBlock->consumers[i].resourceMask.load(std::memory_order_relaxed);
+    }
+    return resourceMask;
+}
+
+void TSRTransport::SetConsumerBusyNs(uint32_t consumer, uint64_t busyNs)
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    m_pControlBlock->consumers[consumer].busyNs.store(busyNs, std::memory_order_relaxed);
+}
+
+uint64_t TSRTransport::GetConsumerBusyNs() const
+{
+    uint32_t active = GetActiveConsumers();
+    uint64_t busyNs = 0;
+    for (uint32_t i = 0; i < m_ConsumerCount; i++)
+    {
+        if (active & (1u << i))
+            busyNs = std::max(busyNs, m_pControlBlock->consumers[i].busyNs.load(std::memory_order_relaxed));
+    }
+    return busyNs;
+}
+
+void TSRTransport::BeatConsumer(uint32_t consumer)
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    m_pControlBlock->consumers[consumer].heartbeat.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t TSRTransport::GetConsumerHeartbeat(uint32_t consumer) const
+{
+    AssertCritical(consumer < m_ConsumerCount, L"Invalid consumer index");
+    return m_pControlBlock->consumers[consumer].heartbeat.load(std::memory_order_relaxed);
+}
+
+void TSRTransport::CreateControlBlock(const std::string& sharedName, uint64_t manifestHash, bool shouldCreate)
+{
+    AssertCritical(m_ConsumerCount > 0 && m_ConsumerCount <= TSR_MAX_CONSUMERS, L"Invalid consumer count");
+
+    size_t size = sizeof(TSRControlBlock) + sizeof(TSRSlotHeader) * m_SlotCount;
+    AssertCritical(m_ControlMemory.Open(sharedName + "_TSR_CONTROL", size, shouldCreate), L"Failed to map the shared control block");
+
+    m_pControlBlock = reinterpret_cast<TSRControlBlock*>(m_ControlMemory.Data());
+    m_pSlotHeaders  = reinterpret_cast<TSRSlotHeader*>(m_ControlMemory.Data() + sizeof(TSRControlBlock));
+
+    if (shouldCreate)
+    {
+        for (uint64_t i = 0; i < m_SlotCount; i++)
+            m_pSlotHeaders[i] = TSRSlotHeader{manifestHash, 0, 0, 0, {}};
+
+        // Until a consumer says otherwise it reads everything
+        for (TSRConsumerState& consumer : m_pControlBlock->consumers)
+        {
+            new (&consumer.resourceMask) std::atomic<uint64_t>(UINT64_MAX);
+            new (&consumer.busyNs) std::atomic<uint64_t>(0);
+            new (&consumer.heartbeat) std::atomic<uint64_t>(0);
+        }
+        new (&m_pControlBlock->registeredConsumers) std::atomic<uint32_t>(0);
+        new (&m_pControlBlock->keyframeRequest) std::atomic<uint64_t>(0);
+        new (&m_pControlBlock->producerHeartbeat) std::atomic<uint64_t>(0);
+        m_pControlBlock->version       = TSR_CONTROL_VERSION;
+        m_pControlBlock->slotCount     = m_SlotCount;
+        m_pControlBlock->manifestHash  = manifestHash;
+        m_pControlBlock->consumerCount = m_ConsumerCount;
+
+        // Publish the control block last, the peer validates against the magic
+        new (&m_pControlBlock->magic) std::atomic<uint32_t>(0);
+        m_pControlBlock->magic.store(TSR_CONTROL_MAGIC, std::memory_order_release);
+    }
+    else
+    {
+        AssertCritical(m_pControlBlock->magic.load(std::memory_order_acquire) == TSR_CONTROL_MAGIC, L"Shared control block is not initialized");
+        AssertCritical(m_pControlBlock->version == TSR_CONTROL_VERSION, L"Shared control block version mismatch");
+        AssertCritical(m_pControlBlock->slotCount == m_SlotCount, L"Shared buffer count mismatch");
+        AssertCritical(m_pControlBlock->consumerCount == m_ConsumerCount, L"Shared consumer count mismatch");
+        AssertCritical(m_pControlBlock->manifestHash == manifestHash, L"The renderer and the upscaler use different resource manifests");
+    }
+}
+
+uint64_t TSRTransport::PerformHostTransfer(const TSRManifest&  manifest,
+                                           const TSRHostPlane* pPlanes,
+                                           uint64_t            resourceMask,
+                                           uint64_t            slotIndex,
+                                           bool                toSlot,
+                                           const TSRTileMap*   pWriteTiles,
+                                           TSRTileMap*         pReadTiles)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+    AssertCritical(manifest.GetTotalSize() <= m_SlotSize, L"The manifest does not fit in the shared buffer");
+
+    uint8_t* pSlot = MapSlot(slotIndex);
+    AssertCritical(pSlot, L"The shared buffer is not host visible");
+
+    TSRSlotHeader& header = *GetSlotHeader(slotIndex);
+
+    // Only read what the producer put in the slot
+    resourceMask &= manifest.GetAllMask();
+    if (!toSlot)
+        resourceMask &= header.resourceMask;
+
+    // The tile map travels in the slot, both sides walk the slot copy
+    uint64_t  deltaMask = toSlot ? (pWriteTiles ? manifest.GetTiledMask() : 0) : header.deltaMask;
+    uint64_t* pTileMap  = reinterpret_cast<uint64_t*>(pSlot + manifest.GetTileMapOffset());
+    uint32_t  tileSize  = manifest.GetTileSize();
+    uint32_t  tilesX    = tileSize ? (manifest.GetResource(0).width + tileSize - 1) / tileSize : 0;
+    if (pWriteTiles)
+    {
+        AssertCritical(tileSize && pWriteTiles->GetTileSize() == tileSize && pWriteTiles->GetTilesX() == tilesX, L"The tile map does not match the manifest");
+        memcpy(pTileMap, pWriteTiles->GetWords(), pWriteTiles->GetBitmapSize());
+    }
+
+    for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+    {
+        if (!(resourceMask & (1ull << i)))
+            continue;
+
+        const TSRResourceDesc& resource = manifest.GetResource(i);
+        const TSRHostPlane&    plane    = pPlanes[i];
+        AssertCritical(plane.width == resource.width && plane.height == resource.height, L"The plane does not match the manifest");
+
+        // Packed planes hold floats, packed or unpacked a row at a time
+        bool     isPacked        = resource.packing != TSRPacking::None;
+        uint32_t planeComponents = static_cast<uint32_t>(plane.stride / sizeof(float));
+        AssertCritical(isPacked ? plane.stride % sizeof(float) == 0 : plane.stride == resource.stride, L"The plane does not match the manifest");
+
+        // Copy texels [begin, end) of a row
+        auto copySpan = [&](uint32_t row, uint32_t begin, uint32_t end) {
+            uint8_t* pSlotTexels  = pSlot + resource.offset + row * resource.rowPitch + begin * resource.stride;
+            uint8_t* pPlaneTexels = plane.data + row * plane.rowPitch + begin * plane.stride;
+            uint32_t count        = end - begin;
+
+            if (isPacked && toSlot)
+                TSRPackRow(resource.packing, reinterpret_cast<const float*>(pPlaneTexels), planeComponents, pSlotTexels, count, resource.packingScale);
+            else if (isPacked)
+                TSRUnpackRow(resource.packing, pSlotTexels, reinterpret_cast<float*>(pPlaneTexels), planeComponents, count, resource.packingScale);
+            else if (toSlot)
+                memcpy(pSlotTexels, pPlaneTexels, count * resource.stride);
+            else
+                memcpy(pPlaneTexels, pSlotTexels, count * resource.stride);
+        };
+
+        bool isDelta = (deltaMask & (1ull << i)) != 0;
+        for (uint32_t row = 0; row < resource.height; row++)
+        {
+            if (!isDelta)
+            {
+                copySpan(row, 0, resource.width);
+                continue;
+            }
+
+            // Runs of dirty tiles along the row
+            uint64_t tileIndex = static_cast<uint64_t>(row / tileSize) * tilesX;
+            for (uint32_t tileX = 0; tileX < tilesX;)
+            {
+                if (!((pTileMap[(tileIndex + tileX) / 64] >> ((tileIndex + tileX) % 64)) & 1))
+                {
+                    tileX++;
+                    continue;
+                }
+
+                uint32_t runBegin = tileX;
+                while (tileX < tilesX && ((pTileMap[(tileIndex + tileX) / 64] >> ((tileIndex + tileX) % 64)) & 1))
+                    tileX++;
+                copySpan(row, runBegin * tileSize, std::min(tileX * tileSize, resource.width));
+            }
+        }
+    }
+
+    if (toSlot)
+    {
+        header.manifestHash = manifest.GetHash();
+        header.resourceMask = resourceMask;
+        header.deltaMask    = deltaMask & resourceMask;
+    }
+    else if (pReadTiles && tileSize)
+    {
+        const TSRResourceDesc& tiled = manifest.GetResource(0);
+        pReadTiles->Resize(tiled.width, tiled.height, tileSize);
+        if (deltaMask & resourceMask)
+            memcpy(pReadTiles->GetWords(), pTileMap, pReadTiles->GetBitmapSize());
+        else
+            pReadTiles->SetAll(true);
+    }
+
+    return resourceMask;
+}
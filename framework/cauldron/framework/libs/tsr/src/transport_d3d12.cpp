@@ -0,0 +1,194 @@
+#if defined(_WIN32)
+
+#include "transport_d3d12.h"
+#include "assert.h"
+
+#include <string>
+#include <vector>
+
+TSRD3D12Transport::~TSRD3D12Transport()
+{
+    for (auto& sharedBuffer : m_SharedBuffers)
+    {
+        ID3D12Resource* pResource = std::get<0>(sharedBuffer);
+        ID3D12Fence*    pFence    = std::get<1>(sharedBuffer);
+
+        if (pResource)
+        {
+            pResource->Release();
+        }
+
+        if (pFence)
+        {
+            pFence->Release();
+        }
+    }
+
+    for (ID3D12Fence* pFence : m_ReleaseFences)
+    {
+        if (pFence)
+        {
+            pFence->Release();
+        }
+    }
+
+    if (m_WaitEvent)
+    {
+        CloseHandle(m_WaitEvent);
+    }
+}
+
+void TSRD3D12Transport::CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate)
+{
+    m_SlotSize = slotSize;
+
+    for (size_t i = 0; i < m_SlotCount; i++)
+    {
+        ID3D12Resource* pResource    = nullptr;
+        ID3D12Fence*    pFence       = nullptr;
+        std::wstring    resourceName = m_SharedName + std::to_wstring(i) + L"_RESOURCE";
+        std::wstring    fenceName    = m_SharedName + std::to_wstring(i) + L"_FENCE";
+
+        if (shouldCreate)
+        {
+            // Create a shared buffer
+            D3D12_RESOURCE_DESC bufferDesc = {};
+            bufferDesc.Alignment           = 0;
+            bufferDesc.DepthOrArraySize    = 1;
+            bufferDesc.Dimension           = D3D12_RESOURCE_DIMENSION_BUFFER;
+            bufferDesc.Flags               = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;  // D3D12_RESOURCE_FLAG_NONE
+            bufferDesc.Format              = DXGI_FORMAT_UNKNOWN;
+            bufferDesc.Height              = 1;
+            bufferDesc.Width               = slotSize;
+            bufferDesc.Layout              = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+            bufferDesc.MipLevels           = 1;
+            bufferDesc.SampleDesc.Count    = 1;
+            bufferDesc.SampleDesc.Quality  = 0;
+
+            // Heap properties
+            D3D12_HEAP_PROPERTIES heapProps = {};
+            heapProps.Type                  = D3D12_HEAP_TYPE_DEFAULT;
+
+            D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
+            AssertCritical(
+                m_pDevice->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_SHARED, &bufferDesc, state, nullptr, IID_PPV_ARGS(&pResource)) == S_OK,
+                L"Failed to create shared buffer");
+
+            // Create the shared handle
+            HANDLE handle = {};
+            AssertCritical(m_pDevice->CreateSharedHandle(pResource, nullptr, GENERIC_ALL, resourceName.c_str(), &handle) == S_OK, L"Failed to create shared handle for resource");
+        }
+        else
+        {
+            // Open the shared handle
+            HANDLE handle = {};
+            AssertCritical(m_pDevice->OpenSharedHandleByName(resourceName.c_str(), GENERIC_ALL, &handle) == S_OK, L"Failed to open shared handle by name for resource");
+            AssertCritical(m_pDevice->OpenSharedHandle(handle, IID_PPV_ARGS(&pResource)) == S_OK, L"Failed to open shared handle for resource");
+        }
+
+        pFence             = CreateSharedFence(fenceName, shouldCreate);
+        m_SharedBuffers[i] = std::make_tuple(pResource, pFence);
+
+        // Release fences of the consumers, named after the lane
+        for (uint32_t lane = 1; lane < m_LaneCount; lane++)
+            m_ReleaseFences[(lane - 1) * m_SlotCount + i] = CreateSharedFence(fenceName + std::to_wstring(lane), shouldCreate);
+    }
+
+    // Slot headers are written by the CPU, keep them in host shared memory next to the buffers (the names are ASCII)
+    std::string sharedName;
+    for (wchar_t character : m_SharedName)
+        sharedName.push_back(static_cast<char>(character));
+
+    CreateControlBlock(sharedName, manifestHash, shouldCreate);
+}
+
+ID3D12Fence* TSRD3D12Transport::CreateSharedFence(const std::wstring& name, bool shouldCreate)
+{
+    ID3D12Fence* pFence = nullptr;
+    HANDLE       handle = {};
+
+    if (shouldCreate)
+    {
+        AssertCritical(m_pDevice->CreateFence(static_cast<UINT64>(TSRBufferState::IDLE), D3D12_FENCE_FLAG_SHARED, IID_PPV_ARGS(&pFence)) == S_OK,
+                       L"Failed to create shared fence");
+        AssertCritical(m_pDevice->CreateSharedHandle(pFence, nullptr, GENERIC_ALL, name.c_str(), &handle) == S_OK, L"Failed to create shared handle for fence");
+    }
+    else
+    {
+        AssertCritical(m_pDevice->OpenSharedHandleByName(name.c_str(), GENERIC_ALL, &handle) == S_OK, L"Failed to open shared handle by name for fence");
+        AssertCritical(m_pDevice->OpenSharedHandle(handle, IID_PPV_ARGS(&pFence)) == S_OK, L"Failed to open shared handle for fence");
+    }
+
+    return pFence;
+}
+
+ID3D12Fence* TSRD3D12Transport::GetFence(uint64_t slotIndex, uint32_t lane) const
+{
+    AssertCritical(slotIndex < m_SlotCount && lane < m_LaneCount, L"Invalid buffer index");
+    return lane == 0 ? std::get<1>(m_SharedBuffers[slotIndex]) : m_ReleaseFences[(lane - 1) * m_SlotCount + slotIndex];
+}
+
+uint64_t TSRD3D12Transport::GetSlotValue(uint64_t slotIndex, uint32_t lane)
+{
+    return GetFence(slotIndex, lane)->GetCompletedValue();
+}
+
+void TSRD3D12Transport::SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane < m_LaneCount, L"Invalid buffer index");
+    m_PendingSignals.push_back(std::make_tuple(slotIndex, value, lane));
+}
+
+void TSRD3D12Transport::FlushSignals(ID3D12CommandQueue* pQueue)
+{
+    if (!pQueue)
+        pQueue = m_pQueue;
+
+    for (const auto& signal : m_PendingSignals)
+    {
+        ID3D12Fence* pFence = GetFence(std::get<0>(signal), std::get<2>(signal));
+        AssertCritical(pQueue->Signal(pFence, std::get<1>(signal)) == S_OK, L"Failed to signal the fence");
+    }
+
+    m_PendingSignals.clear();
+}
+
+bool TSRD3D12Transport::WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs)
+{
+    std::vector<ID3D12Fence*> fences;
+    std::vector<UINT64>       values;
+    for (uint64_t i = 0; i < m_SlotCount * m_LaneCount; i++)
+    {
+        if (pTargetValues[i] == UINT64_MAX)
+            continue;
+
+        ID3D12Fence* pFence = GetFence(i % m_SlotCount, static_cast<uint32_t>(i / m_SlotCount));
+        if (pFence->GetCompletedValue() >= pTargetValues[i])
+            return true;
+
+        fences.push_back(pFence);
+        values.push_back(pTargetValues[i]);
+    }
+
+    if (fences.empty())
+        return false;
+
+    if (!m_WaitEvent)
+    {
+        m_WaitEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        AssertCritical(m_WaitEvent, L"Failed to create the wait event");
+    }
+
+    // Let the driver wake us when the first of the fences completes instead of polling them
+    ID3D12Device1* pDevice1 = nullptr;
+    AssertCritical(m_pDevice->QueryInterface(IID_PPV_ARGS(&pDevice1)) == S_OK, L"Failed to query ID3D12Device1");
+    HRESULT hr = pDevice1->SetEventOnMultipleFenceCompletion(
+        fences.data(), values.data(), static_cast<UINT>(fences.size()), D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY, m_WaitEvent);
+    pDevice1->Release();
+    AssertCritical(hr == S_OK, L"Failed to set the fence completion event");
+
+    DWORD timeoutMs = static_cast<DWORD>((timeoutUs + 999) / 1000);
+    return WaitForSingleObject(m_WaitEvent, timeoutMs) == WAIT_OBJECT_0;
+}
+
+#endif
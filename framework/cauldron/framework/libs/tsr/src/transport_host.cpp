@@ -0,0 +1,68 @@
+#include "transport_host.h"
+#include "assert.h"
+#include "layout.h"
+#include "timing.h"
+
+#include <chrono>
+
+void TSRHostTransport::CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate)
+{
+    AssertCritical(shouldCreate, L"Host transport slots are shared by handing out the transport, not by opening them");
+
+    m_SlotSize   = slotSize;
+    m_SlotStride = TSRAlignUp(slotSize, TSR_PLACEMENT_ALIGNMENT);
+    m_Payload.assign(m_SlotStride * m_SlotCount, 0);
+    m_pControl.reset(new SlotControl[m_SlotCount * m_LaneCount]);
+
+    CreateControlBlock(m_SharedName, manifestHash, true);
+}
+
+TSRHostTransport::SlotControl& TSRHostTransport::Control(uint64_t slotIndex, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane < m_LaneCount, L"Invalid buffer index");
+    return m_pControl[lane * m_SlotCount + slotIndex];
+}
+
+uint64_t TSRHostTransport::GetSlotValue(uint64_t slotIndex, uint32_t lane)
+{
+    return Control(slotIndex, lane).value.load(std::memory_order_acquire);
+}
+
+void TSRHostTransport::SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane)
+{
+    SlotControl& control = Control(slotIndex, lane);
+    control.signalTime.store(tsr_now_ns(), std::memory_order_relaxed);
+
+    // Store under the lock so a waiter can't miss the wake between its check and its wait
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        control.value.store(value, std::memory_order_release);
+    }
+    m_WaitCondition.notify_all();
+}
+
+uint8_t* TSRHostTransport::MapSlot(uint64_t slotIndex)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+    return m_Payload.data() + slotIndex * m_SlotStride;
+}
+
+bool TSRHostTransport::WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs)
+{
+    auto reached = [&]() {
+        for (uint64_t i = 0; i < m_SlotCount * m_LaneCount; i++)
+        {
+            if (pTargetValues[i] != UINT64_MAX && m_pControl[i].value.load(std::memory_order_acquire) >= pTargetValues[i])
+                return true;
+        }
+        return false;
+    };
+
+    std::unique_lock<std::mutex> lock(m_WaitMutex);
+    return m_WaitCondition.wait_for(lock, std::chrono::microseconds(timeoutUs), reached);
+}
+
+uint64_t TSRHostTransport::GetSlotSignalTime(uint64_t slotIndex, uint32_t lane)
+{
+    return Control(slotIndex, lane).signalTime.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,723 @@
+#if !defined(_WIN32)
+
+#include "transport_net.h"
+#include "assert.h"
+#include "layout.h"
+#include "ring.h"
+#include "timing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr uint32_t TSR_NET_MAGIC   = 0x4e525354;  // "TSRN"
+    constexpr uint32_t TSR_NET_VERSION = 3;
+    constexpr int      POLL_PERIOD_MS  = 100;         // How often the receive threads check for shutdown
+
+    enum MessageType : uint32_t
+    {
+        MESSAGE_HELLO = 1,
+        MESSAGE_FRAME,
+        MESSAGE_RELEASE,
+        MESSAGE_USER_DATA,
+    };
+
+    struct MessageHeader
+    {
+        uint32_t magic;
+        uint32_t type;
+        uint64_t bodySize;
+        uint64_t payloadSize;  // Bytes following the body
+    };
+
+    struct HelloMessage
+    {
+        uint32_t version;
+        uint32_t isProducer;
+        uint64_t slotCount;
+        uint64_t slotSize;
+        uint64_t manifestHash;
+        uint32_t protocol;
+        uint32_t datagramSize;  // Chunks of a UDP frame, the receiver places them by it
+    };
+
+    struct FrameMessage
+    {
+        uint64_t      slotIndex;
+        uint64_t      value;
+        TSRSlotHeader header;
+    };
+
+    struct ReleaseMessage
+    {
+        uint64_t slotIndex;
+        uint64_t value;
+        uint64_t consumerMask;
+        uint64_t keyframeRequest;
+        uint64_t consumerBusyNs;
+    };
+
+    struct UserDataMessage
+    {
+        uint32_t index;
+        uint32_t size;
+    };
+
+    // UDP frames are the slot header followed by the payload, cut into equally sized chunks
+    struct DatagramHeader
+    {
+        uint32_t magic;
+        uint32_t chunkIndex;
+        uint32_t chunkCount;
+        uint32_t size;
+        uint64_t slotIndex;
+        uint64_t value;
+    };
+
+    // Largest message body, anything longer is not from a well-behaved peer
+    constexpr uint64_t MAX_BODY_SIZE = std::max({sizeof(HelloMessage), sizeof(FrameMessage), sizeof(ReleaseMessage), sizeof(UserDataMessage)});
+
+    bool SendAll(int socket, const void* pData, uint64_t size)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+        while (size)
+        {
+            ssize_t sent = send(socket, pBytes, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            pBytes += sent;
+            size -= static_cast<uint64_t>(sent);
+        }
+        return true;
+    }
+
+    // Blocks until size bytes arrived, waking up regularly to check pStopping. Returns false on shutdown or disconnect.
+    bool ReceiveAll(int socket, void* pData, uint64_t size, const std::atomic<bool>* pStopping)
+    {
+        uint8_t* pBytes = reinterpret_cast<uint8_t*>(pData);
+        while (size)
+        {
+            pollfd descriptor = {socket, POLLIN, 0};
+            int    ready      = poll(&descriptor, 1, POLL_PERIOD_MS);
+            if (pStopping && pStopping->load(std::memory_order_relaxed))
+                return false;
+            if (ready <= 0)
+            {
+                if (ready < 0)
+                    return false;
+                continue;
+            }
+
+            ssize_t received = recv(socket, pBytes, size, 0);
+            if (received <= 0)
+                return false;
+            pBytes += received;
+            size -= static_cast<uint64_t>(received);
+        }
+        return true;
+    }
+
+    // Read and throw away size bytes, a chunk at a time
+    bool SkipAll(int socket, uint64_t size, const std::atomic<bool>* pStopping)
+    {
+        uint8_t buffer[4096];
+        while (size)
+        {
+            uint64_t chunk = std::min<uint64_t>(size, sizeof(buffer));
+            if (!ReceiveAll(socket, buffer, chunk, pStopping))
+                return false;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    sockaddr_in MakeAddress(uint32_t address, uint16_t port)
+    {
+        sockaddr_in socketAddress     = {};
+        socketAddress.sin_family      = AF_INET;
+        socketAddress.sin_addr.s_addr = address;
+        socketAddress.sin_port        = htons(port);
+        return socketAddress;
+    }
+}  // namespace
+
+TSRNetTransport::~TSRNetTransport()
+{
+    m_Stopping.store(true, std::memory_order_relaxed);
+
+    if (m_ReceiveThread.joinable())
+        m_ReceiveThread.join();
+    if (m_DatagramThread.joinable())
+        m_DatagramThread.join();
+
+    if (m_Socket >= 0)
+        close(m_Socket);
+    if (m_DatagramSocket >= 0)
+        close(m_DatagramSocket);
+}
+
+void TSRNetTransport::CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate)
+{
+    AssertCritical(m_Config.protocol != TSRNetProtocol::Udp || m_Config.datagramSize > 0, L"Invalid TSR datagram size");
+
+    m_IsProducer = shouldCreate;
+    m_SlotSize   = slotSize;
+    m_SlotStride = TSRAlignUp(slotSize, TSR_PLACEMENT_ALIGNMENT);
+
+    m_Payload.assign(m_SlotStride * m_SlotCount, 0);
+    m_Control = std::vector<SlotControl>(m_SlotCount);
+
+    // Each host keeps its own control block, the handshake checks the manifests agree
+    CreateControlBlock(m_SharedName + (m_IsProducer ? "_NET_PRODUCER" : "_NET_CONSUMER"), manifestHash, true);
+
+    Connect();
+    Handshake(manifestHash, m_IsProducer);
+
+    m_Connected.store(true, std::memory_order_release);
+    m_ReceiveThread = std::thread(&TSRNetTransport::ReceiveLoop, this);
+    if (!m_IsProducer && m_Config.protocol == TSRNetProtocol::Udp)
+        m_DatagramThread = std::thread(&TSRNetTransport::ReceiveDatagrams, this);
+}
+
+void TSRNetTransport::Connect()
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_Config.connectTimeoutUs);
+
+    // The consumer receives payload datagrams on the control port number, bind before the producer can send any
+    if (!m_IsProducer && m_Config.protocol == TSRNetProtocol::Udp)
+    {
+        m_DatagramSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        AssertCritical(m_DatagramSocket >= 0, L"Failed to create the TSR datagram socket");
+
+        int bufferSize = 64 * 1024 * 1024;
+        setsockopt(m_DatagramSocket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+        sockaddr_in address = MakeAddress(htonl(INADDR_ANY), m_Config.port);
+        AssertCritical(bind(m_DatagramSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, L"Failed to bind the TSR datagram socket");
+    }
+
+    if (m_Config.listen)
+    {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        AssertCritical(listener >= 0, L"Failed to create the TSR listening socket");
+
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address = MakeAddress(htonl(INADDR_ANY), m_Config.port);
+        AssertCritical(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && listen(listener, 1) == 0,
+                       L"Failed to listen on the TSR port");
+
+        while (m_Socket < 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            pollfd descriptor = {listener, POLLIN, 0};
+            if (poll(&descriptor, 1, POLL_PERIOD_MS) > 0)
+                m_Socket = accept(listener, nullptr, nullptr);
+        }
+        close(listener);
+    }
+    else
+    {
+        addrinfo  hints   = {};
+        addrinfo* pResult = nullptr;
+        hints.ai_family   = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        AssertCritical(getaddrinfo(m_Config.host.c_str(), std::to_string(m_Config.port).c_str(), &hints, &pResult) == 0 && pResult,
+                       L"Failed to resolve the TSR peer");
+
+        // The peer may not be listening yet
+        while (m_Socket < 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            int candidate = socket(AF_INET, SOCK_STREAM, 0);
+            if (candidate >= 0 && connect(candidate, pResult->ai_addr, pResult->ai_addrlen) == 0)
+            {
+                m_Socket = candidate;
+                break;
+            }
+            if (candidate >= 0)
+                close(candidate);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        freeaddrinfo(pResult);
+    }
+
+    AssertCritical(m_Socket >= 0, L"Failed to connect to the TSR peer");
+
+    // Releases are tiny and latency bound
+    int noDelay = 1;
+    setsockopt(m_Socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    // The producer sends payload datagrams to the host at the other end of the control connection
+    if (m_IsProducer && m_Config.protocol == TSRNetProtocol::Udp)
+    {
+        sockaddr_in peer       = {};
+        socklen_t   peerLength = sizeof(peer);
+        AssertCritical(getpeername(m_Socket, reinterpret_cast<sockaddr*>(&peer), &peerLength) == 0, L"Failed to query the TSR peer address");
+        peer.sin_port = htons(m_Config.port);
+
+        m_DatagramSocket = socket(AF_INET, SOCK_DGRAM, 0);
+        AssertCritical(m_DatagramSocket >= 0 && connect(m_DatagramSocket, reinterpret_cast<sockaddr*>(&peer), sizeof(peer)) == 0,
+                       L"Failed to create the TSR datagram socket");
+    }
+}
+
+void TSRNetTransport::Handshake(uint64_t manifestHash, bool isProducer)
+{
+    HelloMessage hello = {
+        TSR_NET_VERSION, isProducer ? 1u : 0u, m_SlotCount, m_SlotSize, manifestHash, static_cast<uint32_t>(m_Config.protocol), m_Config.datagramSize};
+    SendMessage(MESSAGE_HELLO, &hello, sizeof(hello), nullptr, 0);
+
+    MessageHeader header = {};
+    HelloMessage  peer   = {};
+    AssertCritical(ReceiveAll(m_Socket, &header, sizeof(header), nullptr) && header.magic == TSR_NET_MAGIC && header.type == MESSAGE_HELLO &&
+                       header.bodySize == sizeof(peer) && ReceiveAll(m_Socket, &peer, sizeof(peer), nullptr),
+                   L"The TSR peer did not answer the handshake");
+
+    AssertCritical(peer.version == TSR_NET_VERSION, L"TSR network protocol version mismatch");
+    AssertCritical(peer.isProducer != hello.isProducer, L"Both TSR peers have the same role");
+    AssertCritical(peer.slotCount == m_SlotCount && peer.slotSize == m_SlotSize, L"Shared buffer layout mismatch");
+    AssertCritical(peer.manifestHash == manifestHash, L"The renderer and the upscaler use different resource manifests");
+    AssertCritical(peer.protocol == hello.protocol, L"The TSR peers use different payload protocols");
+    AssertCritical(m_Config.protocol != TSRNetProtocol::Udp || peer.datagramSize == hello.datagramSize, L"The TSR peers use different datagram sizes");
+}
+
+uint64_t TSRNetTransport::GetSlotValue(uint64_t slotIndex, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane == 0, L"Invalid buffer index");
+    return m_Control[slotIndex].value.load(std::memory_order_acquire);
+}
+
+void TSRNetTransport::SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane == 0, L"Invalid buffer index");
+
+    SetSlotValue(slotIndex, value);
+
+    if (m_IsProducer && TSRSlotRing::IsReadyValue(value))
+        SendFrame(slotIndex, value);
+    else if (!m_IsProducer && !TSRSlotRing::IsReadyValue(value))
+        SendRelease(slotIndex, value);
+}
+
+uint8_t* TSRNetTransport::MapSlot(uint64_t slotIndex)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+    return m_Payload.data() + slotIndex * m_SlotStride;
+}
+
+bool TSRNetTransport::WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs)
+{
+    auto reached = [&]() {
+        for (uint64_t i = 0; i < m_SlotCount; i++)
+        {
+            if (pTargetValues[i] != UINT64_MAX && m_Control[i].value.load(std::memory_order_acquire) >= pTargetValues[i])
+                return true;
+        }
+        return false;
+    };
+
+    // A dropped connection never signals again, so don't sleep on it
+    std::unique_lock<std::mutex> lock(m_WaitMutex);
+    return m_WaitCondition.wait_for(lock, std::chrono::microseconds(timeoutUs), [&]() { return reached() || !IsConnected(); }) && reached();
+}
+
+uint64_t TSRNetTransport::GetSlotSignalTime(uint64_t slotIndex, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane == 0, L"Invalid buffer index");
+    return m_Control[slotIndex].signalTime.load(std::memory_order_relaxed);
+}
+
+void TSRNetTransport::SendUserData(uint32_t index, const void* pData, uint32_t size)
+{
+    AssertCritical(index < MAX_USER_DATA_COUNT && size <= MAX_USER_DATA_SIZE, L"Invalid TSR user data");
+
+    UserDataMessage message = {index, size};
+    SendMessage(MESSAGE_USER_DATA, &message, sizeof(message), pData, size);
+}
+
+bool TSRNetTransport::GetUserData(uint32_t index, void* pData, uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(m_UserDataMutex);
+    if (index >= m_UserData.size() || m_UserData[index].empty())
+        return false;
+
+    memcpy(pData, m_UserData[index].data(), std::min<size_t>(size, m_UserData[index].size()));
+    return true;
+}
+
+TSRNetStats TSRNetTransport::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_StatsMutex);
+    return m_Stats;
+}
+
+void TSRNetTransport::SendMessage(uint32_t type, const void* pBody, uint64_t bodySize, const void* pPayload, uint64_t payloadSize)
+{
+    MessageHeader header = {TSR_NET_MAGIC, type, bodySize, payloadSize};
+
+    // Messages from the render thread and the receive thread must not interleave
+    std::lock_guard<std::mutex> lock(m_SendMutex);
+    bool sent = SendAll(m_Socket, &header, sizeof(header)) && SendAll(m_Socket, pBody, bodySize) && (!payloadSize || SendAll(m_Socket, pPayload, payloadSize));
+    if (!sent)
+    {
+        m_Connected.store(false, std::memory_order_release);
+        m_WaitCondition.notify_all();
+    }
+}
+
+void TSRNetTransport::SendFrame(uint64_t slotIndex, uint64_t value)
+{
+    const uint8_t*       pPayload = MapSlot(slotIndex);
+    const TSRSlotHeader& header   = *GetSlotHeader(slotIndex);
+
+    uint64_t datagrams = 0;
+    if (m_Config.protocol == TSRNetProtocol::Tcp)
+    {
+        FrameMessage message = {slotIndex, value, header};
+        SendMessage(MESSAGE_FRAME, &message, sizeof(message), pPayload, m_SlotSize);
+    }
+    else
+    {
+        uint64_t frameSize  = sizeof(TSRSlotHeader) + m_SlotSize;
+        uint32_t chunkCount = static_cast<uint32_t>((frameSize + m_Config.datagramSize - 1) / m_Config.datagramSize);
+
+        std::vector<uint8_t> datagram(sizeof(DatagramHeader) + m_Config.datagramSize);
+        for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+        {
+            uint64_t offset = static_cast<uint64_t>(chunk) * m_Config.datagramSize;
+            uint32_t size   = static_cast<uint32_t>(std::min<uint64_t>(m_Config.datagramSize, frameSize - offset));
+
+            DatagramHeader datagramHeader = {TSR_NET_MAGIC, chunk, chunkCount, size, slotIndex, value};
+            memcpy(datagram.data(), &datagramHeader, sizeof(datagramHeader));
+
+            // The slot header and the payload aren't contiguous, a chunk may straddle both
+            for (uint32_t i = 0; i < size;)
+            {
+                uint64_t frameOffset = offset + i;
+                uint32_t span;
+                if (frameOffset < sizeof(TSRSlotHeader))
+                {
+                    span = static_cast<uint32_t>(std::min<uint64_t>(size - i, sizeof(TSRSlotHeader) - frameOffset));
+                    memcpy(datagram.data() + sizeof(DatagramHeader) + i, reinterpret_cast<const uint8_t*>(&header) + frameOffset, span);
+                }
+                else
+                {
+                    span = size - i;
+                    memcpy(datagram.data() + sizeof(DatagramHeader) + i, pPayload + frameOffset - sizeof(TSRSlotHeader), span);
+                }
+                i += span;
+            }
+
+            datagrams++;
+            if (m_Config.dropEveryNthDatagram && ++m_DatagramCounter % m_Config.dropEveryNthDatagram == 0)
+                continue;
+            send(m_DatagramSocket, datagram.data(), sizeof(DatagramHeader) + size, 0);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_StatsMutex);
+    m_Stats.framesSent++;
+    m_Stats.datagramsSent += datagrams;
+    m_Stats.bytesSent += m_SlotSize;
+}
+
+void TSRNetTransport::SendRelease(uint64_t slotIndex, uint64_t value)
+{
+    // The producer only sees our control block through the releases
+    TSRControlBlock* pControlBlock = GetControlBlock();
+    ReleaseMessage   message       = {slotIndex,
+                                      value,
+                                      pControlBlock->consumers[0].resourceMask.load(std::memory_order_relaxed),
+                                      pControlBlock->keyframeRequest.exchange(0, std::memory_order_acq_rel),
+                                      pControlBlock->consumers[0].busyNs.load(std::memory_order_relaxed)};
+    SendMessage(MESSAGE_RELEASE, &message, sizeof(message), nullptr, 0);
+}
+
+void TSRNetTransport::ReceiveLoop()
+{
+    std::vector<uint8_t> body;
+    for (;;)
+    {
+        // Sizes come from the peer, nothing is allocated for them before they are checked. A frame carries at most a
+        // slot, anything else that large is a broken peer.
+        MessageHeader header = {};
+        if (!ReceiveAll(m_Socket, &header, sizeof(header), &m_Stopping) || header.magic != TSR_NET_MAGIC || header.bodySize > MAX_BODY_SIZE ||
+            header.payloadSize > m_SlotSize)
+            break;
+
+        body.resize(header.bodySize);
+        if (!ReceiveAll(m_Socket, body.data(), header.bodySize, &m_Stopping))
+            break;
+
+        if (header.type == MESSAGE_FRAME && !m_IsProducer && body.size() == sizeof(FrameMessage))
+        {
+            FrameMessage message;
+            memcpy(&message, body.data(), sizeof(message));
+            if (message.slotIndex >= m_SlotCount || header.payloadSize > m_SlotSize)
+                break;
+
+            // The producer only sends into slots we released, nobody is reading this one
+            if (!ReceiveAll(m_Socket, MapSlot(message.slotIndex), header.payloadSize, &m_Stopping))
+            {
+                // A partial frame is never published
+                std::lock_guard<std::mutex> lock(m_StatsMutex);
+                m_Stats.framesDiscarded++;
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_StatsMutex);
+                m_Stats.bytesReceived += header.payloadSize;
+            }
+            CompleteFrame(message.slotIndex, message.value, message.header);
+        }
+        else if (header.type == MESSAGE_RELEASE && m_IsProducer && body.size() == sizeof(ReleaseMessage))
+        {
+            ReleaseMessage message;
+            memcpy(&message, body.data(), sizeof(message));
+            if (message.slotIndex >= m_SlotCount)
+                break;
+
+            TSRControlBlock* pControlBlock = GetControlBlock();
+            pControlBlock->consumers[0].resourceMask.store(message.consumerMask, std::memory_order_relaxed);
+            pControlBlock->consumers[0].busyNs.store(message.consumerBusyNs, std::memory_order_relaxed);
+            if (message.keyframeRequest)
+                pControlBlock->keyframeRequest.store(1, std::memory_order_release);
+            SetSlotValue(message.slotIndex, message.value);
+        }
+        else if (header.type == MESSAGE_USER_DATA && body.size() == sizeof(UserDataMessage))
+        {
+            UserDataMessage message;
+            memcpy(&message, body.data(), sizeof(message));
+            if (message.index >= MAX_USER_DATA_COUNT || message.size != header.payloadSize || message.size > MAX_USER_DATA_SIZE)
+                break;
+
+            std::vector<uint8_t> data(header.payloadSize);
+            if (!ReceiveAll(m_Socket, data.data(), data.size(), &m_Stopping))
+                break;
+
+            std::lock_guard<std::mutex> lock(m_UserDataMutex);
+            if (message.index >= m_UserData.size())
+                m_UserData.resize(message.index + 1);
+            m_UserData[message.index] = std::move(data);
+        }
+        else
+        {
+            // Not ours to handle, skip it
+            if (!SkipAll(m_Socket, header.payloadSize, &m_Stopping))
+                break;
+        }
+    }
+
+    m_Connected.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(m_WaitMutex);
+    m_WaitCondition.notify_all();
+}
+
+void TSRNetTransport::ReceiveDatagrams()
+{
+    PartialFrame         frame;
+    std::vector<uint8_t> datagram(sizeof(DatagramHeader) + m_Config.datagramSize);
+
+    // Every frame is cut the same way, the handshake made sure the producer uses our datagram size
+    uint64_t frameSize  = sizeof(TSRSlotHeader) + m_SlotSize;
+    uint32_t chunkCount = static_cast<uint32_t>((frameSize + m_Config.datagramSize - 1) / m_Config.datagramSize);
+
+    while (!m_Stopping.load(std::memory_order_relaxed))
+    {
+        pollfd descriptor = {m_DatagramSocket, POLLIN, 0};
+        if (poll(&descriptor, 1, POLL_PERIOD_MS) <= 0)
+            continue;
+
+        ssize_t received = recv(m_DatagramSocket, datagram.data(), datagram.size(), 0);
+        if (received < static_cast<ssize_t>(sizeof(DatagramHeader)))
+            continue;
+
+        // Drop whatever doesn't fit the frames as we cut them: anyone can send to the port
+        DatagramHeader header;
+        memcpy(&header, datagram.data(), sizeof(header));
+        uint64_t offset = static_cast<uint64_t>(header.chunkIndex) * m_Config.datagramSize;
+        if (header.magic != TSR_NET_MAGIC || header.slotIndex >= m_SlotCount || !TSRSlotRing::IsReadyValue(header.value) ||
+            header.chunkCount != chunkCount || header.chunkIndex >= chunkCount || header.size != std::min<uint64_t>(m_Config.datagramSize, frameSize - offset) ||
+            sizeof(DatagramHeader) + header.size > static_cast<size_t>(received))
+            continue;
+
+        // Late datagram of a frame we already completed or gave up on
+        if (header.value < frame.value)
+            continue;
+
+        // First datagram of a newer frame, whatever is still missing from the current one is not coming
+        if (header.value > frame.value)
+        {
+            if (frame.chunksLeft)
+                DiscardFrame(frame);
+
+            frame.value      = header.value;
+            frame.slotIndex  = header.slotIndex;
+            frame.chunkCount = header.chunkCount;
+            frame.chunksLeft = header.chunkCount;
+            frame.received.assign(header.chunkCount, 0);
+        }
+
+        // A frame only ever goes into one slot
+        if (!frame.chunksLeft || header.slotIndex != frame.slotIndex || frame.received[header.chunkIndex])
+            continue;
+
+        const uint8_t* pData = datagram.data() + sizeof(DatagramHeader);
+        uint8_t*       pSlot = MapSlot(frame.slotIndex);
+        for (uint32_t i = 0; i < header.size;)
+        {
+            uint64_t frameOffset = offset + i;
+            uint32_t span;
+            if (frameOffset < sizeof(TSRSlotHeader))
+            {
+                span = static_cast<uint32_t>(std::min<uint64_t>(header.size - i, sizeof(TSRSlotHeader) - frameOffset));
+                memcpy(reinterpret_cast<uint8_t*>(&frame.header) + frameOffset, pData + i, span);
+            }
+            else
+            {
+                span = header.size - i;
+                memcpy(pSlot + frameOffset - sizeof(TSRSlotHeader), pData + i, span);
+            }
+            i += span;
+        }
+
+        frame.received[header.chunkIndex] = 1;
+        {
+            std::lock_guard<std::mutex> lock(m_StatsMutex);
+            m_Stats.bytesReceived += header.size;
+        }
+
+        if (--frame.chunksLeft == 0)
+            CompleteFrame(frame.slotIndex, frame.value, frame.header);
+    }
+}
+
+void TSRNetTransport::CompleteFrame(uint64_t slotIndex, uint64_t value, const TSRSlotHeader& header)
+{
+    *GetSlotHeader(slotIndex) = header;
+
+    {
+        std::lock_guard<std::mutex> lock(m_StatsMutex);
+        m_Stats.framesReceived++;
+    }
+    SetSlotValue(slotIndex, value);
+}
+
+void TSRNetTransport::DiscardFrame(PartialFrame& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_StatsMutex);
+        m_Stats.framesDiscarded++;
+        m_Stats.datagramsLost += frame.chunksLeft;
+    }
+    frame.chunksLeft = 0;
+
+    // The frame never becomes READY here, hand the slot straight back so the producer can reuse it
+    SendRelease(frame.slotIndex, TSRSlotRing::IdleValue(TSRSlotRing::SequenceOf(frame.value)));
+}
+
+void TSRNetTransport::SetSlotValue(uint64_t slotIndex, uint64_t value)
+{
+    SlotControl& control = m_Control[slotIndex];
+    control.signalTime.store(tsr_now_ns(), std::memory_order_relaxed);
+    control.value.store(value, std::memory_order_release);
+
+    // Take the lock so a waiter can't miss the notification between checking the values and sleeping
+    std::lock_guard<std::mutex> lock(m_WaitMutex);
+    m_WaitCondition.notify_all();
+}
+
+TSRNetLoopbackResult TSRRunNetLoopback(const TSRNetLoopbackParams& params)
+{
+    TSRManifest manifest;
+    manifest.AddResource("Color", params.width, params.height, 0, sizeof(uint32_t));
+    manifest.Finalize();
+
+    TSRNetConfig producerConfig = params.config;
+    TSRNetConfig consumerConfig = params.config;
+    producerConfig.host         = "127.0.0.1";
+    producerConfig.listen       = false;
+    consumerConfig.listen       = true;
+
+    // Every texel of a frame encodes the frame sequence, so the consumer can tell torn or stale payloads
+    auto texelValue = [](uint64_t sequence, uint64_t texel) { return static_cast<uint32_t>(sequence * 0x9e3779b1u ^ texel); };
+
+    TSRNetLoopbackResult  result;
+    std::atomic<bool>     producerDone{false};
+    uint64_t              texelCount = static_cast<uint64_t>(params.width) * params.height;
+    std::vector<uint32_t> consumerTexels(texelCount);
+
+    TSRNetTransport consumer("TSRNetLoopback", params.slotCount, consumerConfig);
+    std::thread     consumerThread([&]() {
+        consumer.CreateSlots(manifest.GetTotalSize(), manifest.GetHash(), false);
+
+        TSRSlotRing  ring(&consumer);
+        TSRHostPlane plane = {reinterpret_cast<uint8_t*>(consumerTexels.data()), params.width, params.height, sizeof(uint32_t), params.width * sizeof(uint32_t)};
+        for (;;)
+        {
+            uint64_t slotIndex, sequence;
+            if (!ring.WaitAcquireRead(slotIndex, sequence, TSRWaitMode::Event, 100000))
+            {
+                if (producerDone.load() || !consumer.IsConnected())
+                    break;
+                continue;
+            }
+
+            consumer.ReadSlot(manifest, &plane, manifest.GetAllMask(), slotIndex);
+            for (uint64_t i = 0; i < texelCount; i++)
+            {
+                if (consumerTexels[i] != texelValue(sequence, i))
+                {
+                    result.framesCorrupt++;
+                    break;
+                }
+            }
+            ring.Release();
+
+            result.framesConsumed++;
+            if (sequence + 1 == params.frames)
+                break;
+        }
+        result.framesDropped = ring.GetStats().dropped;
+    });
+
+    TSRNetTransport producer("TSRNetLoopback", params.slotCount, producerConfig);
+    producer.CreateSlots(manifest.GetTotalSize(), manifest.GetHash(), true);
+
+    uint64_t              startNs = tsr_now_ns();
+    TSRSlotRing           ring(&producer);
+    std::vector<uint32_t> producerTexels(texelCount);
+    TSRHostPlane          plane = {reinterpret_cast<uint8_t*>(producerTexels.data()), params.width, params.height, sizeof(uint32_t), params.width * sizeof(uint32_t)};
+    for (uint32_t frame = 0; frame < params.frames && producer.IsConnected(); frame++)
+    {
+        uint64_t slotIndex, sequence;
+        if (!ring.WaitAcquireWrite(slotIndex, sequence, TSRWaitMode::Event, 1000000))
+            break;
+
+        for (uint64_t i = 0; i < texelCount; i++)
+            producerTexels[i] = texelValue(sequence, i);
+        producer.WriteSlot(manifest, &plane, manifest.GetAllMask(), slotIndex);
+        ring.Publish();
+    }
+    producerDone.store(true);
+    consumerThread.join();
+
+    double seconds            = (tsr_now_ns() - startNs) / 1e9;
+    result.megabytesPerSecond = seconds > 0.0 ? result.framesConsumed * manifest.GetTotalSize() / seconds / (1024.0 * 1024.0) : 0.0;
+    result.producerStats      = producer.GetStats();
+    result.consumerStats      = consumer.GetStats();
+    return result;
+}
+
+#endif
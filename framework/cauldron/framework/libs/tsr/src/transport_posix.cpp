@@ -0,0 +1,146 @@
+#if !defined(_WIN32)
+
+#include "transport_posix.h"
+#include "assert.h"
+#include "timing.h"
+#include "layout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr uint64_t HEADER_SIZE   = 64;
+    constexpr uint64_t PAYLOAD_ALIGN = 4096;
+
+    void FutexWait(std::atomic<uint32_t>* pWord, uint32_t expected, uint64_t timeoutUs)
+    {
+#if defined(__linux__)
+        // Shared (non-private) futex, the word lives in memory mapped by both processes
+        timespec timeout = {static_cast<time_t>(timeoutUs / 1000000), static_cast<long>((timeoutUs % 1000000) * 1000)};
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+        (void)pWord;
+        (void)expected;
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min<uint64_t>(timeoutUs, 100)));
+#endif
+    }
+
+    void FutexWakeAll(std::atomic<uint32_t>* pWord)
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)pWord;
+#endif
+    }
+}  // namespace
+
+void TSRPosixTransport::CreateSlots(uint64_t slotSize, uint64_t manifestHash, bool shouldCreate)
+{
+    m_SlotSize   = slotSize;
+    m_SlotStride = TSRAlignUp(slotSize, PAYLOAD_ALIGN);
+
+    uint64_t payloadOffset = TSRAlignUp(HEADER_SIZE + sizeof(SlotControl) * m_SlotCount * m_LaneCount, PAYLOAD_ALIGN);
+    uint64_t totalSize     = payloadOffset + m_SlotStride * m_SlotCount;
+
+    AssertCritical(m_Memory.Open(m_SharedName + "_TSR", totalSize, shouldCreate), L"Failed to map shared buffers");
+
+    m_pHeader  = reinterpret_cast<Header*>(m_Memory.Data());
+    m_pControl = reinterpret_cast<SlotControl*>(m_Memory.Data() + HEADER_SIZE);
+    m_pPayload = m_Memory.Data() + payloadOffset;
+
+    if (shouldCreate)
+    {
+        for (uint64_t i = 0; i < m_SlotCount * m_LaneCount; i++)
+        {
+            new (&m_pControl[i].value) std::atomic<uint64_t>(static_cast<uint64_t>(TSRBufferState::IDLE));
+            new (&m_pControl[i].signalTime) std::atomic<uint64_t>(0);
+        }
+
+        new (&m_pHeader->doorbell) std::atomic<uint32_t>(0);
+        m_pHeader->version   = TSR_POSIX_VERSION;
+        m_pHeader->slotCount = m_SlotCount;
+        m_pHeader->slotSize  = m_SlotSize;
+        m_pHeader->laneCount = m_LaneCount;
+
+        // Publish the header last, the peer validates against the magic
+        m_pHeader->magic.store(TSR_POSIX_MAGIC, std::memory_order_release);
+    }
+    else
+    {
+        AssertCritical(m_pHeader->magic.load(std::memory_order_acquire) == TSR_POSIX_MAGIC, L"Shared buffers are not initialized");
+        AssertCritical(m_pHeader->version == TSR_POSIX_VERSION, L"Shared buffer version mismatch");
+        AssertCritical(m_pHeader->slotCount == m_SlotCount && m_pHeader->slotSize == m_SlotSize && m_pHeader->laneCount == m_LaneCount,
+                       L"Shared buffer layout mismatch");
+    }
+
+    CreateControlBlock(m_SharedName, manifestHash, shouldCreate);
+}
+
+TSRPosixTransport::SlotControl& TSRPosixTransport::Control(uint64_t slotIndex, uint32_t lane)
+{
+    AssertCritical(slotIndex < m_SlotCount && lane < m_LaneCount, L"Invalid buffer index");
+    return m_pControl[lane * m_SlotCount + slotIndex];
+}
+
+uint64_t TSRPosixTransport::GetSlotValue(uint64_t slotIndex, uint32_t lane)
+{
+    return Control(slotIndex, lane).value.load(std::memory_order_acquire);
+}
+
+void TSRPosixTransport::SignalSlot(uint64_t slotIndex, uint64_t value, uint32_t lane)
+{
+    SlotControl& control = Control(slotIndex, lane);
+
+    // Payload writes are ordered before the value, waiters re-check all values after every doorbell bump
+    control.signalTime.store(tsr_now_ns(), std::memory_order_relaxed);
+    control.value.store(value, std::memory_order_release);
+    m_pHeader->doorbell.fetch_add(1, std::memory_order_release);
+    FutexWakeAll(&m_pHeader->doorbell);
+}
+
+uint8_t* TSRPosixTransport::MapSlot(uint64_t slotIndex)
+{
+    AssertCritical(slotIndex < m_SlotCount, L"Invalid buffer index");
+    return m_pPayload + slotIndex * m_SlotStride;
+}
+
+bool TSRPosixTransport::WaitAny(const uint64_t* pTargetValues, uint64_t timeoutUs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+
+    for (;;)
+    {
+        // Sample the doorbell before the values, so a signal in between makes the futex wait return immediately
+        uint32_t doorbell = m_pHeader->doorbell.load(std::memory_order_acquire);
+        for (uint64_t i = 0; i < m_SlotCount * m_LaneCount; i++)
+        {
+            if (pTargetValues[i] != UINT64_MAX && m_pControl[i].value.load(std::memory_order_acquire) >= pTargetValues[i])
+                return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return false;
+
+        FutexWait(&m_pHeader->doorbell, doorbell, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+    }
+}
+
+uint64_t TSRPosixTransport::GetSlotSignalTime(uint64_t slotIndex, uint32_t lane)
+{
+    return Control(slotIndex, lane).signalTime.load(std::memory_order_relaxed);
+}
+
+#endif
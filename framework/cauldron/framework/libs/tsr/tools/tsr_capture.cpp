@@ -0,0 +1,100 @@
+// tsr-capture: records the frames a renderer sends to its upscalers, see TSRRecordCapture
+
+#include "tsr.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    std::atomic<bool> s_Stop{false};
+
+    void OnSignal(int)
+    {
+        s_Stop.store(true);
+    }
+
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-capture --name <shared name> --output <file> [options]\n"
+                "  --consumers <n>       upscalers the renderer feeds (1)\n"
+                "  --consumer <i>        which of them the capture replaces (0)\n"
+                "  --frames <n>          frames to capture, 0 until the renderer goes away (0)\n"
+                "  --zstd [level]        compress the planes with zstd (level 3)\n"
+                "  --tile-size <n>       tile size of the renderer's manifest (0)\n"
+                "  --timeout <ms>        wait this long for the renderer (10000)\n"
+                "  --peer-timeout <ms>   take the renderer for gone after this long (1000)\n");
+        return 2;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    TSRCaptureRecordParams params;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg   = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--zstd")
+        {
+            params.options.codec = TSRCaptureCodec::Zstd;
+            if (value && value[0] != '-')
+                params.options.level = atoi(argv[++i]);
+            continue;
+        }
+
+        if (!value)
+            return Usage();
+        i++;
+
+        if (arg == "--name")
+            params.sharedName = value;
+        else if (arg == "--output")
+            params.path = value;
+        else if (arg == "--consumers")
+            params.consumerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--consumer")
+            params.consumer = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--frames")
+            params.frames = strtoull(value, nullptr, 10);
+        else if (arg == "--tile-size")
+            params.tileSize = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--timeout")
+            params.timeoutUs = strtoull(value, nullptr, 10) * 1000;
+        else if (arg == "--peer-timeout")
+            params.peerTimeoutUs = strtoull(value, nullptr, 10) * 1000;
+        else
+            return Usage();
+    }
+
+    if (params.sharedName.empty() || params.path.empty() || params.consumer >= params.consumerCount || params.consumerCount > TSR_MAX_CONSUMERS)
+        return Usage();
+    if (params.options.codec == TSRCaptureCodec::Zstd && !TSRCaptureSupportsZstd())
+    {
+        fprintf(stderr, "tsr-capture: this build has no zstd support\n");
+        return 1;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    TSRCaptureRecordResult result = TSRRecordCapture(params, &s_Stop);
+    const TSRCaptureStats& stats  = result.stats;
+    printf("%llu frames, %llu dropped, %.1f MB of planes stored in %.1f MB (%.2fx)\n",
+           static_cast<unsigned long long>(stats.frames),
+           static_cast<unsigned long long>(result.dropped),
+           stats.rawBytes / (1024.0 * 1024.0),
+           stats.storedBytes / (1024.0 * 1024.0),
+           stats.storedBytes ? static_cast<double>(stats.rawBytes) / stats.storedBytes : 1.0);
+
+    if (!result.error.empty())
+    {
+        fprintf(stderr, "tsr-capture: %s\n", result.error.c_str());
+        return 1;
+    }
+    return 0;
+}
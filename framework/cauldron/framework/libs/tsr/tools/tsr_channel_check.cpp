@@ -0,0 +1,306 @@
+// tsr-channel-check: races a writer against several readers over a tsr::Channel of a payload laid out like
+// ShareableCameraData and checks that no read is torn, then that opening the channel with another layout of the payload
+// (or another entry count) fails
+//
+// Every 4 byte word after the frame id of a written entry carries the frame id, a read mixing two writes shows as a
+// word that does not
+
+#include "tsr.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-channel-check [options]\n"
+                "  --writes <n>          entries written by the writer, and at least as many reads (200000)\n"
+                "  --readers <n>         reader threads, each with its own mapping (3)\n"
+                "  --entries <n>         channel entries, one per shared buffer (3)\n");
+        return 2;
+    }
+
+    const char* SHARED_NAME = "TSR_CHANNEL_CHECK";
+
+    int failures = 0;
+
+    void Check(bool pass, const char* pWhat)
+    {
+        printf("%-4s %s\n", pass ? "ok" : "FAIL", pWhat);
+        failures += pass ? 0 : 1;
+    }
+
+    // The fields of cauldron::ShareableCameraData, which the tools can't include
+    struct CheckCamera
+    {
+        uint64_t m_FrameId;
+
+        uint32_t m_Type;
+        float    m_Znear;
+        float    m_Zfar;
+        float    m_ProjectionParams[2];
+
+        float m_Distance;
+        float m_Yaw;
+        float m_Pitch;
+
+        float m_OwnerTransform[16];
+        float m_ViewMatrix[16];
+        float m_ProjectionMatrix[16];
+        float m_ViewProjectionMatrix[16];
+
+        float m_InvViewMatrix[16];
+        float m_InvProjectionMatrix[16];
+        float m_InvViewProjectionMatrix[16];
+
+        float m_PrevViewMatrix[16];
+        float m_PrevViewProjectionMatrix[16];
+
+        float    m_Speed;
+        uint32_t m_Dirty;
+        uint32_t m_ArcBallMode;
+
+        float m_JitterValues[2];
+        float m_ProjJittered[16];
+        float m_PrevProjJittered[16];
+    };
+
+    // The same fields with the near and far planes swapped, as a renderer built from other sources would lay them out
+    struct SwappedCamera
+    {
+        uint64_t m_FrameId;
+
+        uint32_t m_Type;
+        float    m_Zfar;
+        float    m_Znear;
+        float    m_Rest[2 + 3 + 9 * 16 + 3 + 2 + 2 * 16];
+    };
+
+    constexpr size_t PAYLOAD_WORDS = (sizeof(CheckCamera) - sizeof(uint64_t)) / sizeof(uint32_t);
+
+    void Fill(CheckCamera& camera, uint64_t frameId)
+    {
+        uint32_t word    = static_cast<uint32_t>(frameId);
+        camera.m_FrameId = frameId;
+        for (size_t i = 0; i < PAYLOAD_WORDS; i++)
+            memcpy(reinterpret_cast<uint8_t*>(&camera) + sizeof(uint64_t) + i * sizeof(word), &word, sizeof(word));
+    }
+
+    bool IsWhole(const CheckCamera& camera)
+    {
+        uint32_t word = static_cast<uint32_t>(camera.m_FrameId);
+        for (size_t i = 0; i < PAYLOAD_WORDS; i++)
+        {
+            uint32_t value;
+            memcpy(&value, reinterpret_cast<const uint8_t*>(&camera) + sizeof(uint64_t) + i * sizeof(value), sizeof(value));
+            if (value != word)
+                return false;
+        }
+        return true;
+    }
+
+    struct ReaderResult
+    {
+        uint64_t          reads     = 0;
+        uint64_t          torn      = 0;
+        uint64_t          backwards = 0;  // Entries whose write count went down between two reads
+        tsr::ChannelStats stats     = {};
+        bool              opened    = false;
+    };
+
+    void RunReader(size_t entryCount, const std::atomic<bool>& done, std::atomic<uint64_t>& allReads, ReaderResult& result)
+    {
+        tsr::Channel<CheckCamera> channel;
+        result.opened = channel.Open(SHARED_NAME, entryCount, false);
+        if (!result.opened)
+            return;
+
+        std::vector<uint64_t> lastWrites(entryCount, 0);
+        for (size_t i = 0; !done.load(std::memory_order_acquire); i++)
+        {
+            size_t      index  = i % entryCount;
+            CheckCamera camera = {};
+            uint64_t    writes = channel.Read(index, camera);
+            if (!writes)
+                continue;
+
+            result.reads++;
+            allReads.fetch_add(1, std::memory_order_relaxed);
+            result.torn += IsWhole(camera) ? 0 : 1;
+            result.backwards += writes < lastWrites[index] ? 1 : 0;
+            lastWrites[index] = writes;
+        }
+        result.stats = channel.GetStats();
+    }
+}  // namespace
+
+// The layouts field by field, as the camera component lists ShareableCameraData
+namespace tsr
+{
+    template <>
+    struct ChannelLayout<CheckCamera>
+    {
+        static uint64_t Hash()
+        {
+            return LayoutHash(sizeof(CheckCamera), alignof(CheckCamera))
+                .TSR_LAYOUT_FIELD(CheckCamera, m_FrameId)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Type)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Znear)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Zfar)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ProjectionParams)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Distance)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Yaw)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Pitch)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_OwnerTransform)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ViewMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ProjectionMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ViewProjectionMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_InvViewMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_InvProjectionMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_InvViewProjectionMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_PrevViewMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_PrevViewProjectionMatrix)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Speed)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_Dirty)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ArcBallMode)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_JitterValues)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_ProjJittered)
+                .TSR_LAYOUT_FIELD(CheckCamera, m_PrevProjJittered)
+                .Get();
+        }
+    };
+
+    template <>
+    struct ChannelLayout<SwappedCamera>
+    {
+        static uint64_t Hash()
+        {
+            return LayoutHash(sizeof(SwappedCamera), alignof(SwappedCamera))
+                .TSR_LAYOUT_FIELD(SwappedCamera, m_FrameId)
+                .TSR_LAYOUT_FIELD(SwappedCamera, m_Type)
+                .TSR_LAYOUT_FIELD(SwappedCamera, m_Znear)
+                .TSR_LAYOUT_FIELD(SwappedCamera, m_Zfar)
+                .TSR_LAYOUT_FIELD(SwappedCamera, m_Rest)
+                .Get();
+        }
+    };
+}  // namespace tsr
+
+int main(int argc, char** argv)
+{
+    uint64_t writeCount  = 200000;
+    uint32_t readerCount = 3;
+    size_t   entryCount  = 3;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--writes")
+            writeCount = strtoull(value, nullptr, 10);
+        else if (arg == "--readers")
+            readerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--entries")
+            entryCount = strtoull(value, nullptr, 10);
+        else
+            return Usage();
+    }
+    if (!writeCount || !readerCount || !entryCount)
+        return Usage();
+
+    static_assert(sizeof(SwappedCamera) == sizeof(CheckCamera), "The swapped layout only differs in the field order");
+
+    tsr::Channel<CheckCamera> writer;
+    tsr::Channel<CheckCamera> unopened;
+    Check(!unopened.Open(SHARED_NAME, entryCount, false), "opening a channel nobody created fails");
+    Check(writer.Open(SHARED_NAME, entryCount, true), "create");
+
+    // Nothing written yet: reads fail and leave the value alone
+    CheckCamera untouched = {};
+    Fill(untouched, 7);
+    Check(!writer.Read(0, untouched) && untouched.m_FrameId == 7 && IsWhole(untouched), "an entry never written reads as nothing");
+
+    // Every entry written before the readers start, so a failed read is one the writer kept busy
+    CheckCamera camera = {};
+    uint64_t    frame  = 0;
+    while (++frame <= entryCount)
+    {
+        Fill(camera, frame);
+        writer.Write(frame % entryCount, camera);
+    }
+
+    // The readers map the channel themselves, like the upscaler does. The writer goes on until it wrote writeCount
+    // entries and the readers read as many, so they overlap however the threads get scheduled.
+    std::atomic<bool>         done(false);
+    std::atomic<uint64_t>     allReads(0);
+    std::vector<ReaderResult> results(readerCount);
+    std::vector<std::thread>  readers;
+    for (uint32_t r = 0; r < readerCount; r++)
+        readers.emplace_back(RunReader, entryCount, std::cref(done), std::ref(allReads), std::ref(results[r]));
+
+    for (; frame <= writeCount || allReads.load(std::memory_order_relaxed) < writeCount; frame++)
+    {
+        Fill(camera, frame);
+        writer.Write(frame % entryCount, camera);
+    }
+    uint64_t lastFrame = frame - 1;
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers)
+        reader.join();
+
+    ReaderResult total;
+    total.opened = true;
+    for (const ReaderResult& result : results)
+    {
+        total.opened = total.opened && result.opened;
+        total.reads += result.reads;
+        total.torn += result.torn;
+        total.backwards += result.backwards;
+        total.stats.retries += result.stats.retries;
+        total.stats.failedReads += result.stats.failedReads;
+    }
+    printf("     %llu writes of %zu bytes, %u readers: %llu reads, %llu retries, %llu failed, %llu torn\n",
+           static_cast<unsigned long long>(writer.GetStats().writes),
+           sizeof(CheckCamera),
+           readerCount,
+           static_cast<unsigned long long>(total.reads),
+           static_cast<unsigned long long>(total.stats.retries),
+           static_cast<unsigned long long>(total.stats.failedReads),
+           static_cast<unsigned long long>(total.torn));
+    Check(total.opened, "every reader opens the channel");
+    Check(total.reads > 0, "the readers saw writes");
+    Check(total.torn == 0, "no read is torn");
+    Check(total.backwards == 0, "write counts never go back");
+
+    // The last write of every entry reads back whole
+    bool last = true;
+    for (size_t index = 0; index < entryCount; index++)
+    {
+        CheckCamera value  = {};
+        uint64_t    writes = writer.Read(index, value);
+        last = last && writes && IsWhole(value) && value.m_FrameId % entryCount == index && lastFrame - value.m_FrameId < entryCount;
+    }
+    Check(last, "the last write of every entry reads back");
+
+    // A peer with another layout, or another number of entries, can't open the channel
+    tsr::Channel<SwappedCamera> swapped;
+    tsr::Channel<CheckCamera>   fewer;
+    Check(tsr::ChannelLayout<SwappedCamera>::Hash() != tsr::ChannelLayout<CheckCamera>::Hash(), "swapping two fields changes the layout hash");
+    Check(!swapped.Open(SHARED_NAME, entryCount, false) && !swapped.IsOpen(), "opening with another layout fails");
+    Check(!fewer.Open(SHARED_NAME, entryCount + 1, false) && !fewer.IsOpen(), "opening with another entry count fails");
+
+    writer.Close();
+    Check(!unopened.Open(SHARED_NAME, entryCount, false), "closing the creator removes the channel");
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
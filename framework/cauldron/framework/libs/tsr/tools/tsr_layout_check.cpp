@@ -0,0 +1,151 @@
+// tsr-layout-check: lays out the shared buffer of a 1366x768 frame, whose rows are not a multiple of the row pitch
+// alignment for any stride, and checks the offsets, row pitches, sizes and padding against what
+// ID3D12Device::GetCopyableFootprints reports for the same textures placed back to back
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr, "usage: tsr-layout-check\n");
+        return 2;
+    }
+
+    int failures = 0;
+
+    void Check(bool pass, const char* pWhat)
+    {
+        printf("%-4s %s\n", pass ? "ok" : "FAIL", pWhat);
+        failures += pass ? 0 : 1;
+    }
+
+    constexpr uint32_t WIDTH  = 1366;
+    constexpr uint32_t HEIGHT = 768;
+
+    // GetCopyableFootprints of a single-mip WIDTH x HEIGHT texture placed at the end of the previous one: the offset
+    // rounded up to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, the row pitch to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, and
+    // the last row left unpadded in the total size
+    struct Expected
+    {
+        const char* pName;
+        uint32_t    format;  // DXGI_FORMAT
+        uint64_t    stride;
+        uint64_t    offset;
+        uint64_t    rowPitch;
+        uint64_t    size;
+    };
+
+    constexpr Expected EXPECTED[] = {
+        {"Color", 10, 8, 0, 11008, 8454064},                // R16G16B16A16_FLOAT, 10928 byte rows
+        {"Depth", 40, 4, 8454144, 5632, 4325208},           // D32_FLOAT, 5464 byte rows
+        {"MotionVectors", 34, 4, 12779520, 5632, 4325208},  // R16G16_FLOAT
+        {"PackedColor", 26, 4, 17104896, 5632, 4325208},    // R11G11B10_FLOAT
+        {"Reactive", 61, 1, 21430272, 1536, 1179478},       // R8_UNORM, 1366 byte rows
+    };
+
+    constexpr uint64_t EXPECTED_TOTAL             = 22609920;
+    constexpr uint64_t EXPECTED_TEXEL_BYTES       = 22030848;  // 1366 x 768 x 21 bytes
+    constexpr uint64_t EXPECTED_ROW_PADDING       = 578318;    // (80 + 3 x 168 + 170) bytes on each of 767 rows
+    constexpr uint64_t EXPECTED_PLACEMENT_PADDING = 754;       // 80 + 3 x 168 between the resources, 170 at the end
+
+    TSRManifest BuildManifest(uint32_t tileSize)
+    {
+        TSRManifest manifest;
+        for (const Expected& expected : EXPECTED)
+            manifest.AddResource(expected.pName, WIDTH, HEIGHT, expected.format, expected.stride);
+        if (tileSize)
+            manifest.SetTileSize(tileSize);
+        manifest.Finalize();
+        return manifest;
+    }
+
+    // The rules every layout follows, whatever the sizes
+    bool CheckAlignment(const TSRManifest& manifest)
+    {
+        uint64_t end = 0;
+        for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+        {
+            const TSRResourceDesc& resource = manifest.GetResource(i);
+            uint64_t               rowBytes = resource.width * resource.stride;
+            if (resource.offset % TSR_PLACEMENT_ALIGNMENT || resource.rowPitch % TSR_ROW_PITCH_ALIGNMENT)
+                return false;
+
+            // Rows padded as little as the alignment allows, resources placed as close as it allows
+            if (resource.rowPitch < rowBytes || resource.rowPitch - rowBytes >= TSR_ROW_PITCH_ALIGNMENT)
+                return false;
+            if (resource.offset < end || resource.offset - end >= TSR_PLACEMENT_ALIGNMENT)
+                return false;
+            if (resource.size != resource.rowPitch * (resource.height - 1) + rowBytes)
+                return false;
+            end = resource.offset + resource.size;
+        }
+        if (manifest.GetTileSize())
+        {
+            if (manifest.GetTileMapOffset() % TSR_PLACEMENT_ALIGNMENT || manifest.GetTileMapOffset() < end)
+                return false;
+            end = manifest.GetTileMapOffset() + TSRTileMap::GetBitmapSize(WIDTH, HEIGHT, manifest.GetTileSize());
+        }
+        return manifest.GetTotalSize() % TSR_PLACEMENT_ALIGNMENT == 0 && manifest.GetTotalSize() >= end &&
+               manifest.GetTotalSize() - end < TSR_PLACEMENT_ALIGNMENT;
+    }
+}  // namespace
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+        return Usage();
+
+    TSRManifest manifest = BuildManifest(0);
+    for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+    {
+        const TSRResourceDesc& resource = manifest.GetResource(i);
+        const Expected&        expected = EXPECTED[i];
+        bool                   pass     = resource.offset == expected.offset && resource.rowPitch == expected.rowPitch && resource.size == expected.size;
+        printf("%-4s %-14s offset %9llu (%9llu)  row pitch %6llu (%6llu)  size %8llu (%8llu)\n",
+               pass ? "ok" : "FAIL",
+               expected.pName,
+               static_cast<unsigned long long>(resource.offset),
+               static_cast<unsigned long long>(expected.offset),
+               static_cast<unsigned long long>(resource.rowPitch),
+               static_cast<unsigned long long>(expected.rowPitch),
+               static_cast<unsigned long long>(resource.size),
+               static_cast<unsigned long long>(expected.size));
+        failures += pass ? 0 : 1;
+    }
+    Check(manifest.GetTotalSize() == EXPECTED_TOTAL, "total size");
+    Check(CheckAlignment(manifest), "offsets aligned to 512 bytes, row pitches to 256, padded no more than that");
+
+    // The padding the render module logs
+    TSRLayoutReport report = manifest.GetLayoutReport();
+    printf("     %llu bytes, %llu of texels, %llu of row padding, %llu of placement padding\n",
+           static_cast<unsigned long long>(report.totalBytes),
+           static_cast<unsigned long long>(report.texelBytes),
+           static_cast<unsigned long long>(report.rowPaddingBytes),
+           static_cast<unsigned long long>(report.placementPaddingBytes));
+    Check(report.texelBytes == EXPECTED_TEXEL_BYTES && report.rowPaddingBytes == EXPECTED_ROW_PADDING &&
+              report.placementPaddingBytes == EXPECTED_PLACEMENT_PADDING && !report.tileMapBytes,
+          "layout report");
+    Check(report.WastedBytes() + report.texelBytes == report.totalBytes, "the padding and the texels add up to the total");
+
+    // The tile map of delta transfers goes after the resources, where the tail padding was
+    TSRManifest tiled    = BuildManifest(16);
+    uint64_t    mapBytes = TSRTileMap::GetBitmapSize(WIDTH, HEIGHT, 16);
+    Check(tiled.GetTileMapOffset() == EXPECTED_TOTAL && tiled.GetTotalSize() == TSRAlignUp(EXPECTED_TOTAL + mapBytes, TSR_PLACEMENT_ALIGNMENT) &&
+              CheckAlignment(tiled),
+          "tile map placed after the resources");
+    Check(tiled.GetLayoutReport().tileMapBytes == mapBytes && tiled.GetHash() != manifest.GetHash(), "tile map in the report and the hash");
+
+    // Edges of the footprint: rows already aligned take no padding, a base offset rounds up to the next placement
+    TSRFootprint aligned = TSRGetCopyableFootprint(0, 64, 2, 4);
+    TSRFootprint placed  = TSRGetCopyableFootprint(1, 1, 1, 1);
+    Check(aligned.rowPitch == 256 && aligned.size == 512, "aligned rows are not padded");
+    Check(placed.offset == 512 && placed.rowPitch == 256 && placed.size == 1, "offsets round up, the last row is not padded");
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+// tsr-metadata-check: feeds TSRMetadataChecker the slot headers of streams gone wrong (another manifest, no
+// metadata, camera data of another frame, frame ids skipped, repeated or going back) and checks what each one counts
+// and which frames it flags
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr, "usage: tsr-metadata-check\n");
+        return 2;
+    }
+
+    int failures = 0;
+
+    void Check(bool pass, const char* pWhat)
+    {
+        printf("%-4s %s\n", pass ? "ok" : "FAIL", pWhat);
+        failures += pass ? 0 : 1;
+    }
+
+    constexpr uint64_t MANIFEST_HASH = 0x6d616e6966657374ull;
+    constexpr uint64_t OLD_MANIFEST  = 0x6f6c646d616e6966ull;
+    constexpr uint64_t NO_SIDE_DATA  = TSRMetadataChecker::NO_SIDE_DATA;
+    constexpr uint64_t NO_METADATA   = UINT64_MAX;
+
+    // A consumed slot: the frame id the producer wrote (NO_METADATA for none), the manifest it laid the slot out with,
+    // the frame id of the camera data the consumer got on the side, and whether the checker should flag it
+    struct Slot
+    {
+        uint64_t frameId;
+        uint64_t manifestHash;
+        uint64_t sideFrameId;
+        bool     consistent;
+    };
+
+    TSRSlotHeader Header(const Slot& slot)
+    {
+        TSRSlotHeader header         = {};
+        header.manifestHash          = slot.manifestHash;
+        header.metadata.frameId      = slot.frameId == NO_METADATA ? 0 : slot.frameId;
+        header.metadata.renderTimeNs = slot.frameId == NO_METADATA ? 0 : 1000 + slot.frameId;
+        return header;
+    }
+
+    // Feed the slots the way the upscaler does, returns whether every slot was flagged as expected
+    bool Feed(TSRMetadataChecker& checker, const std::vector<Slot>& slots)
+    {
+        bool expected = true;
+        for (const Slot& slot : slots)
+        {
+            TSRSlotHeader header     = Header(slot);
+            bool          consistent = checker.CheckManifest(header.manifestHash, MANIFEST_HASH);
+            consistent               = checker.Check(header.metadata, slot.sideFrameId) && consistent;
+            expected                 = expected && consistent == slot.consistent;
+        }
+        return expected;
+    }
+
+    bool StatsAre(const TSRMetadataStats& stats, const TSRMetadataStats& expected)
+    {
+        return stats.frames == expected.frames && stats.missing == expected.missing && stats.manifests == expected.manifests &&
+               stats.mismatches == expected.mismatches && stats.gaps == expected.gaps && stats.repeats == expected.repeats &&
+               stats.reversals == expected.reversals;
+    }
+
+    TSRMetadataStats Stats(uint64_t frames, uint64_t missing, uint64_t manifests, uint64_t mismatches, uint64_t gaps, uint64_t repeats, uint64_t reversals)
+    {
+        TSRMetadataStats stats;
+        stats.frames     = frames;
+        stats.missing    = missing;
+        stats.manifests  = manifests;
+        stats.mismatches = mismatches;
+        stats.gaps       = gaps;
+        stats.repeats    = repeats;
+        stats.reversals  = reversals;
+        return stats;
+    }
+
+    void PrintStats(const TSRMetadataStats& stats)
+    {
+        printf("     %llu frames, %llu missing, %llu manifest mismatches, %llu camera mismatches, %llu frames skipped, %llu repeats, %llu reversals\n",
+               static_cast<unsigned long long>(stats.frames),
+               static_cast<unsigned long long>(stats.missing),
+               static_cast<unsigned long long>(stats.manifests),
+               static_cast<unsigned long long>(stats.mismatches),
+               static_cast<unsigned long long>(stats.gaps),
+               static_cast<unsigned long long>(stats.repeats),
+               static_cast<unsigned long long>(stats.reversals));
+    }
+
+    void Run(const char* pWhat, const std::vector<Slot>& slots, const TSRMetadataStats& expected)
+    {
+        TSRMetadataChecker checker;
+        bool               flagged = Feed(checker, slots);
+        Check(flagged && StatsAre(checker.GetStats(), expected), pWhat);
+        if (!flagged || !StatsAre(checker.GetStats(), expected))
+            PrintStats(checker.GetStats());
+    }
+}  // namespace
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+        return Usage();
+
+    // Every frame in order, with and without camera data on the side
+    Run("frames in order",
+        {{1, MANIFEST_HASH, NO_SIDE_DATA, true}, {2, MANIFEST_HASH, 2, true}, {3, MANIFEST_HASH, 3, true}, {4, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(4, 0, 0, 0, 0, 0, 0));
+
+    // A producer that never filled the metadata: nothing else can be checked
+    Run("slots without metadata",
+        {{NO_METADATA, MANIFEST_HASH, NO_SIDE_DATA, false}, {1, MANIFEST_HASH, NO_SIDE_DATA, true}, {NO_METADATA, MANIFEST_HASH, 2, false}},
+        Stats(3, 2, 0, 0, 0, 0, 0));
+
+    // A producer still writing the layout of the previous generation
+    Run("slots laid out with another manifest",
+        {{1, OLD_MANIFEST, NO_SIDE_DATA, false}, {2, OLD_MANIFEST, NO_SIDE_DATA, false}, {3, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(3, 0, 2, 0, 0, 0, 0));
+
+    // The shared camera data running ahead of (or behind) the textures
+    Run("camera data of another frame",
+        {{1, MANIFEST_HASH, 2, false}, {2, MANIFEST_HASH, 2, true}, {3, MANIFEST_HASH, 1, false}},
+        Stats(3, 0, 0, 2, 0, 0, 0));
+
+    // Dropped frames are counted, but don't make the frame after them inconsistent
+    Run("frame ids skipped",
+        {{1, MANIFEST_HASH, NO_SIDE_DATA, true}, {4, MANIFEST_HASH, NO_SIDE_DATA, true}, {5, MANIFEST_HASH, NO_SIDE_DATA, true}, {9, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(4, 0, 0, 0, 5, 0, 0));
+
+    // The same frame read twice, and a frame older than the last one
+    Run("frame ids repeated",
+        {{1, MANIFEST_HASH, NO_SIDE_DATA, true}, {1, MANIFEST_HASH, NO_SIDE_DATA, false}, {2, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(3, 0, 0, 0, 0, 1, 0));
+    Run("frame ids going back",
+        {{5, MANIFEST_HASH, NO_SIDE_DATA, true}, {3, MANIFEST_HASH, NO_SIDE_DATA, false}, {4, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(3, 0, 0, 0, 0, 0, 1));
+
+    // A slot without metadata does not break the frame id sequence around it
+    Run("missing metadata keeps the last frame id",
+        {{1, MANIFEST_HASH, NO_SIDE_DATA, true}, {NO_METADATA, MANIFEST_HASH, NO_SIDE_DATA, false}, {2, MANIFEST_HASH, NO_SIDE_DATA, true}},
+        Stats(3, 1, 0, 0, 0, 0, 0));
+
+    // Everything at once, each slot counted by every check it fails
+    std::vector<Slot> mixed = {
+        {1, MANIFEST_HASH, 1, true},
+        {3, OLD_MANIFEST, 2, false},               // Another manifest, another camera frame, one frame skipped
+        {3, MANIFEST_HASH, NO_SIDE_DATA, false},   // Repeated
+        {NO_METADATA, OLD_MANIFEST, 4, false},     // No metadata, another manifest
+        {2, MANIFEST_HASH, 2, false},              // Going back
+        {7, MANIFEST_HASH, 7, true},               // Four frames skipped
+    };
+    TSRMetadataChecker checker;
+    bool               flagged = Feed(checker, mixed);
+    PrintStats(checker.GetStats());
+    Check(flagged, "every slot flagged as expected");
+    Check(StatsAre(checker.GetStats(), Stats(6, 1, 2, 1, 5, 1, 1)), "every counter counts its own failures");
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+// tsr-negotiation-sim: runs the renderer and upscaler sides of TSRNegotiator over a real control channel, with hooks
+// standing in for the shared buffers, and checks where every exchange ends up: accepted offers, slot and resolution
+// counters, rejected manifests, counters that go nowhere, resizes on either side and a lost renderer. Then it drives
+// TSRPeerSupervisor over the heartbeats of a host transport on a simulated clock and checks the renderer falls back
+// once every upscaler is lost, and the upscaler notices a lost renderer once.
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-negotiation-sim [options]\n"
+                "  --verbose <0|1>       print what the negotiators and supervisors log (0)\n");
+        return 2;
+    }
+
+    constexpr uint32_t FORMAT_COLOR = 10;
+    constexpr uint32_t FORMAT_DEPTH = 40;
+    constexpr uint32_t MAX_UPDATES  = 64;  // Per exchange, a negotiation that goes somewhere ends way before
+
+    int  failures = 0;
+    bool verbose  = false;
+
+    void Check(bool pass, const char* pWhat)
+    {
+        printf("%-4s %s\n", pass ? "ok" : "FAIL", pWhat);
+        failures += pass ? 0 : 1;
+    }
+
+    TSRLogFunction Logger(const std::string& side)
+    {
+        return [side](TSRLogLevel level, const std::string& message) {
+            const char* pLevel = level == TSRLogLevel::Error ? "error" : level == TSRLogLevel::Warning ? "warning" : "info";
+            if (verbose)
+                printf("     %-10s %-7s %s\n", side.c_str(), pLevel, message.c_str());
+        };
+    }
+
+    std::string UniqueName(const char* pPrefix)
+    {
+        static uint32_t names = 0;
+        return pPrefix + std::to_string(tsr_now_ns()) + "_" + std::to_string(names++);
+    }
+
+    // One process: its render resolution and what the hooks were asked to do, the shared buffers are only counted
+    struct Side
+    {
+        std::string                    name;
+        uint32_t                       renderWidth  = 1280;
+        uint32_t                       renderHeight = 720;
+        uint32_t                       depthFormat  = FORMAT_DEPTH;
+        TSRCapabilities                capabilities;
+        bool                           shrinking   = false;  // Takes one shared buffer less on every offer
+        uint64_t                       generation  = 0;      // Of the shared buffers allocated
+        uint64_t                       slotCount   = 0;
+        uint32_t                       allocations = 0;
+        uint32_t                       drops       = 0;
+        uint32_t                       resizes     = 0;
+        std::unique_ptr<TSRNegotiator> negotiator;
+
+        TSRNegotiationHooks Hooks()
+        {
+            TSRNegotiationHooks hooks;
+            hooks.buildManifest = [this]() {
+                TSRManifest manifest;
+                manifest.AddResource("color", renderWidth, renderHeight, FORMAT_COLOR, 8);
+                manifest.AddResource("depth", renderWidth, renderHeight, depthFormat, 4);
+                manifest.Finalize();
+                return manifest;
+            };
+            hooks.resize = [this](uint32_t width, uint32_t height) {
+                renderWidth  = width;
+                renderHeight = height;
+                resizes++;
+            };
+            hooks.capabilities = [this]() {
+                if (shrinking && capabilities.maxSlots > 1)
+                    capabilities.maxSlots--;
+                return capabilities;
+            };
+            hooks.allocate = [this](uint64_t allocated, uint64_t slots, const TSRManifest&) {
+                generation = allocated;
+                slotCount  = slots;
+                allocations++;
+            };
+            hooks.install = []() { return true; };
+            hooks.drop    = [this]() { drops++; };
+            hooks.log     = Logger(name);
+            return hooks;
+        }
+    };
+
+    // A renderer and its upscalers over a control channel of their own. The limits of the upscalers are set before
+    // Connect, like a process knows them before it starts.
+    struct Exchange
+    {
+        std::string       sharedName;
+        Side              renderer;
+        std::vector<Side> upscalers;
+
+        Exchange(const char* pWhat, uint32_t upscalerCount, uint64_t slotCount, uint64_t maxSlots)
+            : sharedName(UniqueName("TSR_NEGOTIATION_SIM_"))
+            , upscalers(upscalerCount)
+        {
+            if (verbose)
+                printf("     -- %s\n", pWhat);
+
+            renderer.name       = "renderer";
+            renderer.negotiator = std::make_unique<TSRNegotiator>(sharedName, upscalerCount, 0, true, renderer.Hooks());
+            if (!renderer.negotiator->Start(slotCount, maxSlots, renderer.renderWidth, renderer.renderHeight))
+                Check(false, "create the control channel");
+
+            for (uint32_t i = 0; i < upscalerCount; i++)
+            {
+                Side& upscaler                        = upscalers[i];
+                upscaler.name                         = "upscaler" + std::to_string(i);
+                upscaler.capabilities.maxSlots        = maxSlots;
+                upscaler.capabilities.maxRenderWidth  = 1920;
+                upscaler.capabilities.maxRenderHeight = 1080;
+            }
+        }
+
+        void Connect()
+        {
+            for (uint32_t i = 0; i < upscalers.size(); i++)
+            {
+                Side& upscaler      = upscalers[i];
+                upscaler.negotiator = std::make_unique<TSRNegotiator>(sharedName, static_cast<uint32_t>(upscalers.size()), i, false, upscaler.Hooks());
+                upscaler.negotiator->Start(upscaler.renderWidth, upscaler.renderHeight);
+            }
+        }
+
+        // Update every side in turn until they all run the same generation, or one of them gave up
+        bool Settle()
+        {
+            for (uint32_t update = 0; update < MAX_UPDATES; update++)
+            {
+                bool all    = renderer.negotiator->Update();
+                bool failed = renderer.negotiator->GetState() == TSRNegotiationState::Failed;
+                for (Side& upscaler : upscalers)
+                {
+                    all    = upscaler.negotiator->Update() && upscaler.generation == renderer.generation && all;
+                    failed = failed || upscaler.negotiator->GetState() == TSRNegotiationState::Failed;
+                }
+                if (all)
+                    return true;
+
+                // The renderer waits for the answer of a failed upscaler, let it get there
+                if (failed && renderer.negotiator->GetState() == TSRNegotiationState::Failed)
+                    return false;
+            }
+            return false;
+        }
+
+        // Every side allocated the same shared buffers at the same resolution
+        bool Agree(uint64_t slotCount, uint32_t renderWidth, uint32_t renderHeight) const
+        {
+            bool agree = renderer.slotCount == slotCount && renderer.renderWidth == renderWidth && renderer.renderHeight == renderHeight;
+            for (const Side& upscaler : upscalers)
+            {
+                agree = agree && upscaler.generation == renderer.generation && upscaler.slotCount == slotCount &&
+                        upscaler.renderWidth == renderWidth && upscaler.renderHeight == renderHeight;
+            }
+            return agree;
+        }
+    };
+
+    void CheckNegotiation()
+    {
+        {
+            Exchange exchange("accepted", 2, 3, 3);
+            exchange.Connect();
+            Check(exchange.Settle() && exchange.Agree(3, 1280, 720) && exchange.renderer.allocations == 1, "an offer both upscalers take runs the first generation");
+        }
+
+        // The smallest limits of all upscalers win
+        {
+            Exchange exchange("slot counter", 2, 3, 3);
+            exchange.upscalers[1].capabilities.maxSlots = 2;
+            exchange.Connect();
+            Check(exchange.Settle() && exchange.Agree(2, 1280, 720) && exchange.renderer.allocations == 1, "an upscaler taking fewer shared buffers gets them on the next generation");
+        }
+        {
+            Exchange exchange("resolution counter", 2, 3, 3);
+            exchange.upscalers[0].capabilities.maxRenderWidth  = 960;
+            exchange.upscalers[0].capabilities.maxRenderHeight = 960;
+            exchange.upscalers[1].capabilities.maxRenderWidth  = 1920;
+            exchange.upscalers[1].capabilities.maxRenderHeight = 540;
+            exchange.Connect();
+            Check(exchange.Settle() && exchange.Agree(3, 960, 540) && exchange.renderer.resizes == 1, "the renderer renders at the resolution every upscaler takes");
+        }
+
+        // The upscaler would lay the resources out otherwise, nothing to counter
+        {
+            Exchange exchange("rejected", 2, 3, 3);
+            exchange.upscalers[1].depthFormat = FORMAT_DEPTH + 1;
+            exchange.Connect();
+            bool settled = exchange.Settle();
+            Check(!settled && exchange.renderer.negotiator->GetState() == TSRNegotiationState::Failed &&
+                      exchange.upscalers[1].negotiator->GetState() == TSRNegotiationState::Failed && !exchange.renderer.allocations,
+                  "an upscaler with another manifest rejects the offer and both sides give up");
+        }
+
+        // Limits that shrink on every offer would be countered forever
+        {
+            Exchange exchange("endless counters", 1, 8, 8);
+            exchange.upscalers[0].shrinking = true;
+            exchange.Connect();
+            bool settled = exchange.Settle();
+            Check(!settled && exchange.renderer.negotiator->GetState() == TSRNegotiationState::Failed && !exchange.renderer.allocations,
+                  "the renderer gives up on counters that go nowhere");
+        }
+
+        // Either side resizing starts a new generation at its resolution
+        {
+            Exchange exchange("renderer resize", 2, 3, 3);
+            exchange.Connect();
+            bool     settled = exchange.Settle();
+            uint32_t drops   = exchange.upscalers[0].drops;
+            exchange.renderer.renderWidth  = 1600;
+            exchange.renderer.renderHeight = 900;
+            exchange.renderer.negotiator->Resize(1600, 900);
+            settled = exchange.Settle() && settled;
+            Check(settled && exchange.Agree(3, 1600, 900) && exchange.renderer.allocations == 2 && exchange.upscalers[0].drops > drops && exchange.upscalers[1].resizes == 1,
+                  "a resized renderer offers a new generation the upscalers follow");
+        }
+        {
+            Exchange exchange("upscaler resize", 2, 3, 3);
+            exchange.Connect();
+            bool settled = exchange.Settle();
+            exchange.upscalers[1].renderWidth  = 1024;
+            exchange.upscalers[1].renderHeight = 576;
+            exchange.upscalers[1].negotiator->Resize(1024, 576);
+            settled = exchange.Settle() && settled;
+            Check(settled && exchange.Agree(3, 1024, 576) && exchange.renderer.resizes == 1 && exchange.upscalers[0].resizes == 1,
+                  "a resized upscaler counters and the renderer offers its resolution");
+        }
+
+        // The renderer may come back (a successor would create the channel anew) and offers the next generation
+        {
+            Exchange exchange("lost renderer", 1, 3, 3);
+            exchange.Connect();
+            bool  settled  = exchange.Settle();
+            Side& upscaler = exchange.upscalers[0];
+            uint32_t drops   = upscaler.drops;
+            upscaler.negotiator->PeerLost();
+            bool waiting = upscaler.negotiator->GetState() == TSRNegotiationState::Negotiating && !upscaler.negotiator->Update() && upscaler.drops > drops;
+            exchange.renderer.negotiator->Resize(exchange.renderer.renderWidth, exchange.renderer.renderHeight);
+            settled = exchange.Settle() && settled;
+            Check(waiting && settled && exchange.Agree(3, 1280, 720) && upscaler.allocations == 2, "an upscaler that lost the renderer waits for its next generation");
+        }
+    }
+
+    // The renderer and two upscalers over the heartbeats of one ring, updated on a simulated clock
+    void CheckLiveness()
+    {
+        constexpr uint64_t TIMEOUT_US = 1000;
+        constexpr uint64_t STEP_NS    = 100000;
+
+        TSRHostTransport transport(UniqueName("TSR_LIVENESS_SIM_"), 3, 2);
+        transport.CreateSlots(64, 0, true);
+        TSRSlotRing                                     producerRing(&transport);
+        std::vector<std::unique_ptr<TSRSlotRing>>       consumerRings;
+        TSRPeerSupervisor                               renderer(TIMEOUT_US, Logger("renderer"));
+        std::vector<std::unique_ptr<TSRPeerSupervisor>> upscalers;
+        renderer.Watch(&producerRing, true);
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            consumerRings.push_back(std::make_unique<TSRSlotRing>(&transport, i));
+            consumerRings[i]->RegisterConsumer();
+            upscalers.push_back(std::make_unique<TSRPeerSupervisor>(TIMEOUT_US, Logger("upscaler" + std::to_string(i))));
+            upscalers[i]->Watch(consumerRings[i].get(), false);
+        }
+
+        // Only the sides that run count their heartbeat, counts the updates telling an upscaler it lost the renderer
+        uint64_t              nowNs = 0;
+        std::vector<uint32_t> lostRenderer(upscalers.size(), 0);
+        auto                  run   = [&](uint32_t steps, bool rendererRuns, bool upscaler0Runs, bool upscaler1Runs) {
+            for (uint32_t step = 0; step < steps; step++)
+            {
+                nowNs += STEP_NS;
+                if (rendererRuns)
+                    renderer.Update(nowNs);
+                for (uint32_t i = 0; i < upscalers.size(); i++)
+                    lostRenderer[i] += (i ? upscaler1Runs : upscaler0Runs) && upscalers[i]->Update(nowNs) ? 1 : 0;
+            }
+        };
+        auto lost = [&]() { return renderer.GetWatch()->GetConsumers(TSRPeerState::Lost); };
+
+        if (verbose)
+            printf("     -- liveness\n");
+        run(20, true, true, true);
+        Check(!renderer.IsFallbackActive() && !lost() && !lostRenderer[0] && !lostRenderer[1], "peers that keep beating stay alive");
+
+        run(20, true, false, true);
+        Check(lost() == 1 && !renderer.IsFallbackActive(), "the renderer reclaims a lost upscaler and keeps sending to the other");
+
+        run(20, true, false, false);
+        Check(lost() == 3 && renderer.IsFallbackActive(), "the renderer falls back once every upscaler is lost");
+
+        run(20, true, false, true);
+        Check(lost() == 1 && !renderer.IsFallbackActive(), "the renderer sends the frames again once an upscaler is back");
+
+        run(20, false, true, true);
+        Check(lostRenderer[0] == 1 && lostRenderer[1] == 1, "an upscaler notices a lost renderer once");
+
+        run(20, true, true, true);
+        Check(!lost() && lostRenderer[0] == 1 && lostRenderer[1] == 1, "the renderer coming back is not lost again");
+
+        renderer.Stop();
+        Check(!renderer.GetWatch() && !renderer.IsFallbackActive(), "stopping the watch ends the fallback");
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--verbose")
+            verbose = std::string(value) != "0";
+        else
+            return Usage();
+    }
+
+    CheckNegotiation();
+    CheckLiveness();
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
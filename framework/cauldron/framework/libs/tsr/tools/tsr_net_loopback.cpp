@@ -0,0 +1,93 @@
+// tsr-net-loopback: runs a network transport producer and consumer on the loopback interface, see TSRRunNetLoopback,
+// and checks every frame that arrived is the one that was sent
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-net-loopback [options]\n"
+                "  --protocol <tcp|udp>  how the payloads travel (tcp)\n"
+                "  --port <n>            control port, and the payload port over UDP (47000)\n"
+                "  --datagram-size <n>   payload bytes per datagram (1200)\n"
+                "  --drop-every <n>      skip every nth datagram, 0 to send them all (0)\n"
+                "  --slots <n>           shared buffers (3)\n"
+                "  --width <n>           frame width (640)\n"
+                "  --height <n>          frame height (360)\n"
+                "  --frames <n>          frames to send (60)\n");
+        return 2;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    TSRNetLoopbackParams params;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--protocol")
+        {
+            std::string protocol = value;
+            if (protocol == "tcp")
+                params.config.protocol = TSRNetProtocol::Tcp;
+            else if (protocol == "udp")
+                params.config.protocol = TSRNetProtocol::Udp;
+            else
+                return Usage();
+        }
+        else if (arg == "--port")
+            params.config.port = static_cast<uint16_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--datagram-size")
+            params.config.datagramSize = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--drop-every")
+            params.config.dropEveryNthDatagram = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--slots")
+            params.slotCount = strtoull(value, nullptr, 10);
+        else if (arg == "--width")
+            params.width = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--height")
+            params.height = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--frames")
+            params.frames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else
+            return Usage();
+    }
+    if (!params.slotCount || !params.width || !params.height || !params.frames || !params.config.datagramSize)
+        return Usage();
+
+    bool                 udp    = params.config.protocol == TSRNetProtocol::Udp;
+    TSRNetLoopbackResult result = TSRRunNetLoopback(params);
+
+    printf("%s, %ux%u, %llu slots, %u frames\n", udp ? "udp" : "tcp", params.width, params.height, static_cast<unsigned long long>(params.slotCount), params.frames);
+    printf("consumed %llu  dropped %llu  corrupt %llu  %.1f MB/s\n",
+           static_cast<unsigned long long>(result.framesConsumed),
+           static_cast<unsigned long long>(result.framesDropped),
+           static_cast<unsigned long long>(result.framesCorrupt),
+           result.megabytesPerSecond);
+    printf("producer sent %llu frames in %llu datagrams, consumer received %llu, discarded %llu (%llu datagrams lost)\n",
+           static_cast<unsigned long long>(result.producerStats.framesSent),
+           static_cast<unsigned long long>(result.producerStats.datagramsSent),
+           static_cast<unsigned long long>(result.consumerStats.framesReceived),
+           static_cast<unsigned long long>(result.consumerStats.framesDiscarded),
+           static_cast<unsigned long long>(result.consumerStats.datagramsLost));
+
+    // Frames only go missing over UDP, and never arrive torn
+    bool lost = !udp && result.framesConsumed != params.frames;
+    if (result.framesCorrupt || lost || !result.framesConsumed)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
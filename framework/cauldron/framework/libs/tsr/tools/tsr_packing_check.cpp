@@ -0,0 +1,139 @@
+// tsr-packing-check: runs every payload packing over representative data through TSRMeasurePackingError and checks the
+// round trip stays within what the encoding can hold, so a packing change is validated without a GPU
+
+#include "tsr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-packing-check [options]\n"
+                "  --texels <n>          texels per data set (1000000)\n"
+                "  --scale <s>           motion vector range (64)\n");
+        return 2;
+    }
+
+    struct DataSet
+    {
+        const char*        pName;
+        TSRPacking         packing;
+        uint32_t           components;  // Floats per source texel, as the renderer's resource has them
+        std::vector<float> texels;
+        double             maxAbsError;  // Bounds of the encoding, 0 to not check
+        double             maxRelError;
+    };
+
+    std::vector<DataSet> MakeDataSets(uint32_t count, float scale)
+    {
+        std::mt19937                          random(1234);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> motion(-scale, scale);
+        std::uniform_real_distribution<float> exponent(-14.0f, 15.9f);
+        const float                           smallestNormal = std::exp2(-14.0f);
+
+        std::vector<DataSet> sets;
+
+        // Depth of a reversed or a linear buffer in [0, 1], 0 and 1 included. Half a step
+        // of 24 bits: 2^-25.
+        DataSet depth = {"depth", TSRPacking::Depth24Unorm, 1, {}, 6e-8, 0.0};
+        for (uint32_t i = 0; i < count; i++)
+            depth.texels.push_back(i == 0 ? 0.0f : i == 1 ? 1.0f : unit(random));
+        sets.push_back(std::move(depth));
+
+        // Motion vectors over the whole range, the ends included. Half a step of 16 bits over [-scale, scale], and the
+        // rounding of the scaling in single precision.
+        DataSet vectors = {"motion vectors", TSRPacking::MotionRG16Snorm, 2, {}, scale * (0.5 / 32767.0 + std::exp2(-23.0)), 0.0};
+        for (uint32_t i = 0; i < count * 2; i++)
+            vectors.texels.push_back(i < 4 ? (i % 2 ? scale : -scale) : motion(random));
+        sets.push_back(std::move(vectors));
+
+        // HDR color, log-uniform over the normal range of the small floats, with alpha. Half a step of the 5 bit
+        // mantissa of blue: 2^-6 relative.
+        DataSet color = {"hdr color", TSRPacking::ColorR11G11B10, 4, {}, 0.0, 0.016};
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+                color.texels.push_back(std::exp2(exponent(random)));
+            color.texels.push_back(unit(random));
+        }
+        sets.push_back(std::move(color));
+
+        // LDR color, where most of a scene's pixels are, down to the smallest normal value
+        DataSet ldr = {"ldr color", TSRPacking::ColorR11G11B10, 4, {}, 0.0, 0.016};
+        for (uint32_t i = 0; i < count * 3; i++)
+        {
+            ldr.texels.push_back(std::max(unit(random), smallestNormal));
+            if (i % 3 == 2)
+                ldr.texels.push_back(1.0f);
+        }
+        sets.push_back(std::move(ldr));
+
+        // Near black the small floats are denormal and hold an absolute step instead: half of blue's 2^-19
+        DataSet dark = {"near black", TSRPacking::ColorR11G11B10, 4, {}, std::exp2(-20.0), 0.0};
+        for (uint32_t i = 0; i < count * 3; i++)
+        {
+            dark.texels.push_back(i < 3 ? 0.0f : unit(random) * smallestNormal);
+            if (i % 3 == 2)
+                dark.texels.push_back(1.0f);
+        }
+        sets.push_back(std::move(dark));
+        return sets;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t count = 1000000;
+    float    scale = 64.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--texels")
+            count = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--scale")
+            scale = strtof(value, nullptr);
+        else
+            return Usage();
+    }
+    if (count < 4 || !(scale > 0.0f))
+        return Usage();
+
+    int failures = 0;
+    for (const DataSet& set : MakeDataSets(count, scale))
+    {
+        TSRPackingError error = TSRMeasurePackingError(set.packing, set.texels.data(), set.components, count, scale);
+
+        bool pass = (!set.maxAbsError || error.maxAbsError <= set.maxAbsError) && (!set.maxRelError || error.maxRelError <= set.maxRelError);
+
+        printf("%-4s %-15s %-16s %2llu B/texel  max abs %.3g  max rel %.3g  rmse %.3g",
+               pass ? "ok" : "FAIL",
+               set.pName,
+               TSRGetPackingName(set.packing),
+               static_cast<unsigned long long>(TSRGetPackedStride(set.packing)),
+               error.maxAbsError,
+               error.maxRelError,
+               error.rmse);
+        if (set.maxAbsError)
+            printf("  (abs bound %.3g)", set.maxAbsError);
+        if (set.maxRelError)
+            printf("  (rel bound %.3g)", set.maxRelError);
+        printf("\n");
+        failures += pass ? 0 : 1;
+    }
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+// tsr-placed-slots: drives TSRPlacedSlots through TSRMockAllocator the way the renderer and the upscaler do, one
+// creating the slot heaps and the other opening them, and checks the layout, the rotation and that a creation failing
+// at any point leaves nothing behind
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-placed-slots [options]\n"
+                "  --slots <n>           slot heaps (3)\n"
+                "  --width <n>           render target width (1920)\n"
+                "  --height <n>          render target height (1080)\n");
+        return 2;
+    }
+
+    const char* SHARED_NAME = "TSR_PLACED_SLOTS_CHECK";
+
+    int failures = 0;
+
+    void Check(bool pass, const char* pWhat)
+    {
+        printf("%-4s %s\n", pass ? "ok" : "FAIL", pWhat);
+        failures += pass ? 0 : 1;
+    }
+
+    // Color, depth and motion vectors, as the renderer places them
+    void AddResources(TSRPlacedSlots& slots, uint32_t width, uint32_t height)
+    {
+        TSRPlacedResourceDesc color;
+        color.name   = "color";
+        color.width  = width;
+        color.height = height;
+        color.stride = 8;
+        slots.AddResource(0, color);
+
+        TSRPlacedResourceDesc depth = color;
+        depth.name                  = "depth";
+        depth.stride                = 4;
+        depth.depthStencil          = true;
+        slots.AddResource(1, depth);
+
+        TSRPlacedResourceDesc motion = color;
+        motion.name                  = "motion vectors";
+        motion.stride                = 4;
+        motion.allowUAV              = true;
+        slots.AddResource(3, motion);
+    }
+
+    bool CheckLayout(const TSRPlacedSlots& slots)
+    {
+        for (size_t r = 0; r < slots.GetResourceCount(); r++)
+        {
+            uint64_t offset = slots.GetOffset(r);
+            if (offset % TSR_HEAP_ALIGNMENT)
+                return false;
+
+            for (uint64_t slot = 0; slot < slots.GetSlotCount(); slot++)
+            {
+                const TSRMockAllocator::Resource* pResource = TSRMockAllocator::Describe(slots.GetResource(slot, r));
+                if (pResource->pHeap != slots.GetHeap(slot) || pResource->offset != offset || offset + pResource->size > slots.GetHeapSize())
+                    return false;
+
+                // Back to back: the next resource starts past this one
+                if (r + 1 < slots.GetResourceCount() && slots.GetOffset(r + 1) < offset + pResource->size)
+                    return false;
+            }
+        }
+        return slots.GetHeapSize() % TSR_HEAP_ALIGNMENT == 0;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    uint64_t slotCount = 3;
+    uint32_t width     = 1920;
+    uint32_t height    = 1080;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--slots")
+            slotCount = strtoull(value, nullptr, 10);
+        else if (arg == "--width")
+            width = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--height")
+            height = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else
+            return Usage();
+    }
+    if (!slotCount || !width || !height)
+        return Usage();
+
+    TSRMockAllocator allocator;
+    {
+        // The renderer creates the heaps, the upscaler opens them
+        TSRPlacedSlots producer(&allocator);
+        TSRPlacedSlots consumer(&allocator);
+        AddResources(producer, width, height);
+        AddResources(consumer, width, height);
+        size_t resourceCount = producer.GetResourceCount();
+
+        Check(!consumer.Create(SHARED_NAME, slotCount, false) && !consumer.IsCreated(), "opening heaps nobody created fails");
+        Check(producer.Create(SHARED_NAME, slotCount, true), "create");
+        printf("     %llu slots, %zu resources, %llu bytes per heap\n",
+               static_cast<unsigned long long>(slotCount),
+               resourceCount,
+               static_cast<unsigned long long>(producer.GetHeapSize()));
+        Check(producer.GetSlotCount() == slotCount && allocator.GetHeapCount() == slotCount && allocator.GetResourceCount() == slotCount * resourceCount,
+              "a heap per slot with every resource in it");
+        Check(CheckLayout(producer), "resources aligned, in the heap and not overlapping");
+        Check(producer.GetAliasedMask() == 0xb, "aliased mask");
+
+        // Another renderer can't take over the names
+        TSRPlacedSlots second(&allocator);
+        AddResources(second, width, height);
+        Check(!second.Create(SHARED_NAME, slotCount, true) && allocator.GetResourceCount() == slotCount * resourceCount, "creating taken heaps fails");
+
+        Check(consumer.Create(SHARED_NAME, slotCount, false), "open");
+        bool shared = consumer.GetHeapSize() == producer.GetHeapSize();
+        for (uint64_t slot = 0; slot < slotCount; slot++)
+        {
+            shared = shared && consumer.GetHeap(slot) == producer.GetHeap(slot);
+            shared = shared && static_cast<const TSRMockAllocator::Heap*>(consumer.GetHeap(slot))->references == 2;
+            for (size_t r = 0; r < resourceCount; r++)
+                shared = shared && TSRMockAllocator::Describe(consumer.GetResource(slot, r))->offset == producer.GetOffset(r);
+        }
+        Check(shared && CheckLayout(consumer), "both sides share the heaps and place the resources alike");
+
+        // The two sides disagreeing on the layout can't open the heaps
+        TSRPlacedSlots mismatched(&allocator);
+        AddResources(mismatched, width + 64, height);
+        Check(!mismatched.Create(SHARED_NAME, slotCount, false) && allocator.GetResourceCount() == 2 * slotCount * resourceCount,
+              "opening with another layout fails");
+
+        // Rotation: only a change of slot needs the views rebound
+        bool     rotates   = consumer.SetCurrentSlot(0) && !consumer.SetCurrentSlot(0);
+        uint64_t rotations = 1;
+        for (uint64_t frame = 1; frame <= 4 * slotCount; frame++)
+        {
+            rotates = rotates && consumer.SetCurrentSlot(frame % slotCount) == (slotCount > 1);
+            rotations += slotCount > 1 ? 1 : 0;
+        }
+        Check(rotates && consumer.GetRotationCount() == rotations && consumer.GetCurrentSlot() == (4 * slotCount) % slotCount, "rotation");
+
+        // The upscaler leaving keeps the renderer's heaps
+        consumer.Destroy();
+        Check(!consumer.IsCreated() && allocator.GetHeapCount() == slotCount && allocator.GetResourceCount() == slotCount * resourceCount,
+              "closing keeps the creator's heaps");
+
+        // Opening failing at any heap or resource leaves the creator's
+        uint64_t creations = slotCount * (1 + resourceCount);
+        bool     clean     = true;
+        for (uint64_t count = 0; count < creations; count++)
+        {
+            allocator.FailAfter(count);
+            clean = clean && !consumer.Create(SHARED_NAME, slotCount, false) && !consumer.IsCreated();
+            clean = clean && allocator.GetHeapCount() == slotCount && allocator.GetResourceCount() == slotCount * resourceCount;
+        }
+        allocator.FailAfter(UINT64_MAX);
+        Check(clean, "opening failing at any point leaves nothing behind");
+
+        producer.Destroy();
+        Check(!producer.IsCreated() && !allocator.GetHeapCount() && !allocator.GetResourceCount(), "destroy releases everything");
+
+        // Creating failing at any heap or resource leaves nothing
+        clean = true;
+        for (uint64_t count = 0; count < creations; count++)
+        {
+            allocator.FailAfter(count);
+            clean = clean && !producer.Create(SHARED_NAME, slotCount, true) && !producer.IsCreated();
+            clean = clean && !allocator.GetHeapCount() && !allocator.GetResourceCount();
+        }
+        allocator.FailAfter(UINT64_MAX);
+        Check(clean, "creating failing at any point leaves nothing behind");
+
+        // And the names are free again
+        Check(producer.Create(SHARED_NAME, slotCount, true) && consumer.Create(SHARED_NAME, slotCount, false), "create and open again");
+    }
+    Check(!allocator.GetHeapCount() && !allocator.GetResourceCount(), "going away releases everything");
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+// tsr-posix-bench: runs a producer and a consumer process over TSRPosixTransport and TSRSlotRing, the consumer in a
+// forked child, and measures the frames per second and the latency from the producer publishing a frame to the
+// consumer acquiring it, polling and sleeping on the futex
+
+#include "tsr.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-posix-bench [options]\n"
+                "  --frames <n>          frames sent, the first 1%% left out of the latencies (20000)\n"
+                "  --slots <n>           shared buffers (3)\n"
+                "  --payload <bytes>     bytes copied into and out of every slot (1048576)\n"
+                "  --producer-us <us>    producer work per frame (0)\n"
+                "  --consumer-us <us>    consumer work per frame (0)\n"
+                "  --mode <name>         poll, event or both (both)\n");
+        return 2;
+    }
+
+    constexpr uint64_t MANIFEST_HASH  = 0x7473722d62656e63ull;
+    constexpr uint64_t WAIT_US        = 1000000;
+    constexpr uint32_t MAX_WAIT_FAILS = 5;  // A peer gone for this many waits ends the run
+
+    struct BenchParams
+    {
+        uint64_t    frames     = 20000;
+        uint64_t    slotCount  = 3;
+        uint64_t    payload    = 1 << 20;
+        uint64_t    producerUs = 0;
+        uint64_t    consumerUs = 0;
+        TSRWaitMode mode       = TSRWaitMode::Event;
+    };
+
+    // What the consumer hands back to the producer process
+    struct ConsumerResult
+    {
+        uint64_t frames;
+        uint64_t torn;  // Frames whose payload did not carry their sequence number at both ends
+        uint64_t dropped;
+        uint64_t latencyNs[5];  // p50, p90, p99, p99.9 and max
+        uint64_t cpuNsPerFrame;
+        uint64_t waitFails;
+    };
+
+    // Burn the CPU for the frame work, sleeping would hand the core back
+    void Work(uint64_t us)
+    {
+        uint64_t endNs = tsr_now_ns() + us * 1000;
+        while (us && tsr_now_ns() < endNs)
+        {
+        }
+    }
+
+    std::string SharedName()
+    {
+        return "TSR_POSIX_BENCH_" + std::to_string(getpid());
+    }
+
+    void RunConsumer(const BenchParams& params, const std::string& sharedName, int readyFd, int resultFd)
+    {
+        TSRPosixTransport transport(sharedName, params.slotCount);
+        transport.CreateSlots(params.payload, MANIFEST_HASH, false);
+        TSRSlotRing ring(&transport);
+        ring.RegisterConsumer();
+
+        char ready = 1;
+        if (write(readyFd, &ready, 1) != 1)
+            _exit(1);
+
+        std::vector<uint8_t>  frame(params.payload);
+        std::vector<uint64_t> latencyNs;
+        latencyNs.reserve(params.frames);
+        ConsumerResult result = {};
+        uint64_t       warmup = params.frames / 100;
+        uint64_t       cpuNs  = tsr_thread_cpu_ns();
+        while (result.frames < params.frames && result.waitFails < MAX_WAIT_FAILS)
+        {
+            uint64_t slotIndex, sequence;
+            if (!ring.WaitAcquireRead(slotIndex, sequence, params.mode, WAIT_US))
+            {
+                result.waitFails++;
+                continue;
+            }
+            uint64_t acquireNs = tsr_now_ns();
+            uint64_t publishNs = transport.GetSlotHeader(slotIndex)->metadata.renderTimeNs;
+
+            const uint8_t* pSlot = transport.MapSlot(slotIndex);
+            memcpy(frame.data(), pSlot, params.payload);
+            uint64_t first, last;
+            memcpy(&first, frame.data(), sizeof(first));
+            memcpy(&last, frame.data() + params.payload - sizeof(last), sizeof(last));
+            result.torn += first == sequence && last == sequence ? 0 : 1;
+
+            Work(params.consumerUs);
+            ring.Release();
+
+            if (result.frames++ >= warmup)
+                latencyNs.push_back(acquireNs - publishNs);
+        }
+        result.dropped       = ring.GetStats().dropped;
+        result.cpuNsPerFrame = result.frames ? (tsr_thread_cpu_ns() - cpuNs) / result.frames : 0;
+
+        std::sort(latencyNs.begin(), latencyNs.end());
+        const double percentiles[4] = {0.5, 0.9, 0.99, 0.999};
+        for (int i = 0; i < 4 && !latencyNs.empty(); i++)
+            result.latencyNs[i] = latencyNs[std::min(latencyNs.size() - 1, static_cast<size_t>(percentiles[i] * latencyNs.size()))];
+        result.latencyNs[4] = latencyNs.empty() ? 0 : latencyNs.back();
+
+        ring.UnregisterConsumer();
+        _exit(write(resultFd, &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+    }
+
+    bool Run(const BenchParams& params)
+    {
+        // The child opens the slots once they exist, and the producer starts once the child registered
+        int createdPipe[2], readyPipe[2], resultPipe[2];
+        if (pipe(createdPipe) || pipe(readyPipe) || pipe(resultPipe))
+            return false;
+
+        std::string sharedName = SharedName();
+        pid_t       child      = fork();
+        if (child < 0)
+            return false;
+        if (child == 0)
+        {
+            char created = 0;
+            if (read(createdPipe[0], &created, 1) != 1)
+                _exit(1);
+            RunConsumer(params, sharedName, readyPipe[1], resultPipe[1]);
+        }
+
+        uint64_t waitFails = 0;
+        uint64_t stalls    = 0;
+        {
+            TSRPosixTransport transport(sharedName, params.slotCount);
+            transport.CreateSlots(params.payload, MANIFEST_HASH, true);
+            TSRSlotRing ring(&transport);
+
+            char byte = 1;
+            if (write(createdPipe[1], &byte, 1) != 1 || read(readyPipe[0], &byte, 1) != 1)
+            {
+                waitpid(child, nullptr, 0);
+                return false;
+            }
+
+            std::vector<uint8_t> frame(params.payload);
+            uint64_t             startNs = tsr_now_ns();
+            uint64_t             sent    = 0;
+            while (sent < params.frames && waitFails < MAX_WAIT_FAILS)
+            {
+                uint64_t slotIndex, sequence;
+                if (!ring.WaitAcquireWrite(slotIndex, sequence, params.mode, WAIT_US))
+                {
+                    waitFails++;
+                    continue;
+                }
+                stalls += ring.WasLastAcquireStalled() ? 1 : 0;
+
+                // The sequence number at both ends of the payload, a torn read shows as a mismatch
+                Work(params.producerUs);
+                memcpy(frame.data(), &sequence, sizeof(sequence));
+                memcpy(frame.data() + params.payload - sizeof(sequence), &sequence, sizeof(sequence));
+                memcpy(transport.MapSlot(slotIndex), frame.data(), params.payload);
+
+                transport.GetSlotHeader(slotIndex)->metadata.renderTimeNs = tsr_now_ns();
+                ring.Publish();
+                sent++;
+            }
+
+            // Wait for the consumer before the slots go away
+            ConsumerResult result = {};
+            bool           got    = read(resultPipe[0], &result, sizeof(result)) == sizeof(result);
+            double         elapsed = (tsr_now_ns() - startNs) / 1e9;
+            int            status  = 0;
+            waitpid(child, &status, 0);
+            if (!got || !WIFEXITED(status) || WEXITSTATUS(status))
+            {
+                fprintf(stderr, "tsr-posix-bench: the consumer process failed\n");
+                return false;
+            }
+
+            printf("%-6s %7.0f frames/s %7.2f GB/s  latency us p50 %6.1f p90 %6.1f p99 %6.1f p99.9 %7.1f max %7.1f  consumer cpu %5.1f us/frame  %llu stalls %llu torn %llu dropped\n",
+                   params.mode == TSRWaitMode::Poll ? "poll" : "event",
+                   elapsed > 0.0 ? result.frames / elapsed : 0.0,
+                   elapsed > 0.0 ? 2.0 * result.frames * params.payload / elapsed / 1e9 : 0.0,
+                   result.latencyNs[0] / 1000.0,
+                   result.latencyNs[1] / 1000.0,
+                   result.latencyNs[2] / 1000.0,
+                   result.latencyNs[3] / 1000.0,
+                   result.latencyNs[4] / 1000.0,
+                   result.cpuNsPerFrame / 1000.0,
+                   static_cast<unsigned long long>(stalls),
+                   static_cast<unsigned long long>(result.torn),
+                   static_cast<unsigned long long>(result.dropped));
+
+            waitFails += result.waitFails;
+            if (result.frames != params.frames || result.torn || result.dropped)
+                waitFails++;
+        }
+
+        for (int fd : {createdPipe[0], createdPipe[1], readyPipe[0], readyPipe[1], resultPipe[0], resultPipe[1]})
+            close(fd);
+        return waitFails == 0;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    BenchParams params;
+    std::string mode = "both";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--frames")
+            params.frames = strtoull(value, nullptr, 10);
+        else if (arg == "--slots")
+            params.slotCount = strtoull(value, nullptr, 10);
+        else if (arg == "--payload")
+            params.payload = strtoull(value, nullptr, 10);
+        else if (arg == "--producer-us")
+            params.producerUs = strtoull(value, nullptr, 10);
+        else if (arg == "--consumer-us")
+            params.consumerUs = strtoull(value, nullptr, 10);
+        else if (arg == "--mode")
+            mode = value;
+        else
+            return Usage();
+    }
+    if (!params.frames || !params.slotCount || params.payload < 2 * sizeof(uint64_t) || (mode != "poll" && mode != "event" && mode != "both"))
+        return Usage();
+
+    printf("%llu frames, %llu slots, %llu byte payload, producer %llu us, consumer %llu us\n",
+           static_cast<unsigned long long>(params.frames),
+           static_cast<unsigned long long>(params.slotCount),
+           static_cast<unsigned long long>(params.payload),
+           static_cast<unsigned long long>(params.producerUs),
+           static_cast<unsigned long long>(params.consumerUs));
+
+    bool pass = true;
+    for (TSRWaitMode m : {TSRWaitMode::Poll, TSRWaitMode::Event})
+    {
+        if (mode != "both" && (m == TSRWaitMode::Poll) != (mode == "poll"))
+            continue;
+        params.mode = m;
+        pass        = Run(params) && pass;
+    }
+
+    printf(pass ? "OK\n" : "FAILED\n");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// tsr-replay: feeds a capture to upscalers in place of the renderer, see TSRReplayCapture
+
+#include "tsr.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    std::atomic<bool> s_Stop{false};
+
+    void OnSignal(int)
+    {
+        s_Stop.store(true);
+    }
+
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-replay --name <shared name> --input <file> [options]\n"
+                "  --consumers <n>       upscalers to feed (1)\n"
+                "  --slots <n>           shared buffers to offer (3)\n"
+                "  --fps <rate>          frames per second, 0 as fast as the upscalers go (0)\n"
+                "  --loops <n>           times to play the capture (1)\n"
+                "  --poll                spin on the shared buffers instead of sleeping\n"
+                "  --timeout <ms>        wait this long for the upscalers to accept (10000)\n"
+                "  --peer-timeout <ms>   take an upscaler for gone after this long (1000)\n"
+                "  --info                print what the capture holds and exit\n");
+        return 2;
+    }
+
+    int PrintInfo(const std::string& path)
+    {
+        TSRCaptureReader reader;
+        if (!reader.Open(path))
+        {
+            fprintf(stderr, "tsr-replay: %s\n", reader.GetError().c_str());
+            return 1;
+        }
+
+        const TSRManifest& manifest = reader.GetManifest();
+        printf("%llu frames%s, %llu bytes per slot, tile size %u\n",
+               static_cast<unsigned long long>(reader.GetFrameCount()),
+               reader.IsComplete() ? "" : " (recovered, the capture was not closed)",
+               static_cast<unsigned long long>(manifest.GetTotalSize()),
+               manifest.GetTileSize());
+        for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+        {
+            const TSRResourceDesc& resource = manifest.GetResource(i);
+            printf("  %-24s %ux%u format %u, %llu bytes per texel%s\n",
+                   resource.name.c_str(),
+                   resource.width,
+                   resource.height,
+                   resource.format,
+                   static_cast<unsigned long long>(resource.stride),
+                   resource.optional ? ", optional" : "");
+        }
+
+        if (reader.GetFrameCount() > 1)
+        {
+            uint64_t spanNs = reader.GetFrame(reader.GetFrameCount() - 1).captureTimeNs - reader.GetFrame(0).captureTimeNs;
+            printf("captured at %.1f frames per second\n", spanNs ? (reader.GetFrameCount() - 1) * 1e9 / spanNs : 0.0);
+        }
+        return 0;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    TSRReplayParams params;
+    bool            info = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--poll")
+        {
+            params.waitMode = TSRWaitMode::Poll;
+            continue;
+        }
+        if (arg == "--info")
+        {
+            info = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--name")
+            params.sharedName = value;
+        else if (arg == "--input")
+            params.path = value;
+        else if (arg == "--consumers")
+            params.consumerCount = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--slots")
+            params.slotCount = strtoull(value, nullptr, 10);
+        else if (arg == "--fps")
+            params.fps = strtod(value, nullptr);
+        else if (arg == "--loops")
+            params.loops = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--timeout")
+            params.timeoutUs = strtoull(value, nullptr, 10) * 1000;
+        else if (arg == "--peer-timeout")
+            params.peerTimeoutUs = strtoull(value, nullptr, 10) * 1000;
+        else
+            return Usage();
+    }
+
+    if (params.path.empty())
+        return Usage();
+    if (info)
+        return PrintInfo(params.path);
+    if (params.sharedName.empty() || params.slotCount == 0 || params.consumerCount == 0 || params.consumerCount > TSR_MAX_CONSUMERS)
+        return Usage();
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    TSRReplayResult result = TSRReplayCapture(params, &s_Stop);
+    printf("%llu frames in %.2f s, %.1f frames per second\n",
+           static_cast<unsigned long long>(result.frames),
+           result.seconds,
+           result.framesPerSecond);
+    if (params.fps > 0.0)
+    {
+        printf("%llu late, lateness mean %.0f us, p99 %llu us, max %llu us\n",
+               static_cast<unsigned long long>(result.late),
+               result.lateUs.Mean(),
+               static_cast<unsigned long long>(result.lateUs.Percentile(0.99)),
+               static_cast<unsigned long long>(result.lateUs.max));
+    }
+
+    if (!result.error.empty())
+    {
+        fprintf(stderr, "tsr-replay: %s\n", result.error.c_str());
+        return 1;
+    }
+    return 0;
+}
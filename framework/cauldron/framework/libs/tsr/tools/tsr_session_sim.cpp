@@ -0,0 +1,147 @@
+// tsr-session-sim: serves renderer sessions of mixed frame rates from one consumer through TSRSimulateSessions with
+// round robin and with deadline scheduling, prints what every session got and checks what either policy promises: round
+// robin starves no session, and with the consumer not overloaded every session keeps up, deadline scheduling keeps
+// every session within its deadlines and misses no more of them than round robin
+//
+// A session missing more deadlines than --max-missed allows shows as "late", which fails it under deadline scheduling
+// with the consumer not overloaded. Round robin makes no promise about deadlines, its late sessions don't fail.
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-session-sim [options]\n"
+                "  --session <us>[:<us>] frame interval of a renderer and its deadline, repeated for every session\n"
+                "                        (8333:5000, 16667:20000, 33333:40000, 16667:0)\n"
+                "  --upscale-us <us>     consumer work per frame (3000)\n"
+                "  --slots <n>           slots per session (3)\n"
+                "  --duration-ms <ms>    length of either run (2000)\n"
+                "  --max-missed <f>      fraction of a session's frames allowed to miss the deadline, timer noise (0.02)\n");
+        return 2;
+    }
+
+    struct PolicyRun
+    {
+        TSRSchedulePolicy   policy;
+        TSRSessionSimResult result;
+        uint64_t            missedDeadlines = 0;  // Over the sessions with a deadline
+        uint64_t            deadlineFrames  = 0;
+    };
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    TSRSessionSimParams params;
+    params.upscaleUs = 3000.0;
+    double maxMissed = 0.02;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--session")
+        {
+            char*                pEnd    = nullptr;
+            TSRSessionSimSession session = {};
+            session.frameUs              = strtod(value, &pEnd);
+            session.deadlineUs           = *pEnd == ':' ? strtoull(pEnd + 1, nullptr, 10) : 0;
+            params.sessions.push_back(session);
+        }
+        else if (arg == "--upscale-us")
+            params.upscaleUs = strtod(value, nullptr);
+        else if (arg == "--slots")
+            params.slots = strtoull(value, nullptr, 10);
+        else if (arg == "--duration-ms")
+            params.durationMs = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--max-missed")
+            maxMissed = strtod(value, nullptr);
+        else
+            return Usage();
+    }
+    if (params.sessions.empty())
+        params.sessions = {{8333.0, 5000}, {16667.0, 20000}, {33333.0, 40000}, {16667.0, 0}};
+    if (params.sessions.size() > TSR_MAX_SESSIONS || !params.slots || !params.durationMs || maxMissed < 0.0)
+        return Usage();
+
+    // Share of the consumer's time the sessions ask for
+    double load = 0.0;
+    for (const TSRSessionSimSession& session : params.sessions)
+    {
+        if (!(session.frameUs > 0.0))
+            return Usage();
+        load += params.upscaleUs / session.frameUs;
+    }
+    printf("%zu sessions, upscale %.0f us, %llu slots, %u ms, consumer load %.0f%%\n",
+           params.sessions.size(),
+           params.upscaleUs,
+           static_cast<unsigned long long>(params.slots),
+           params.durationMs,
+           load * 100.0);
+
+    int       failures = 0;
+    PolicyRun runs[]   = {{TSRSchedulePolicy::RoundRobin, {}}, {TSRSchedulePolicy::Deadline, {}}};
+    for (PolicyRun& run : runs)
+    {
+        params.policy = run.policy;
+        run.result    = TSRSimulateSessions(params);
+        printf("%s: %.1f frames/s\n", run.policy == TSRSchedulePolicy::RoundRobin ? "round robin" : "deadline", run.result.framesPerSecond);
+
+        for (size_t i = 0; i < run.result.sessions.size(); i++)
+        {
+            const TSRSessionSimResult::Session& session  = run.result.sessions[i];
+            const TSRSessionSimSession&         settings = params.sessions[i];
+            if (settings.deadlineUs)
+            {
+                run.missedDeadlines += session.stats.missedDeadlines;
+                run.deadlineFrames += session.stats.served;
+            }
+
+            // Never more frames than the renderer made. Round robin serves every session, deadline scheduling leaves
+            // the sessions without a deadline to an overloaded consumer's spare time, which there is none of. With time
+            // to spare the consumer serves every frame but the ones still in the slots at the end, and a few lost to
+            // the timer.
+            bool     overloaded = load >= 0.9;
+            uint64_t inFlight   = params.slots + session.produced / 20;
+            bool     starved    = session.stats.served == 0 && (run.policy == TSRSchedulePolicy::RoundRobin || settings.deadlineUs || !overloaded);
+            bool     behind     = !overloaded && session.stats.served + inFlight < session.produced;
+            bool     late       = settings.deadlineUs && session.stats.missedDeadlines > maxMissed * session.stats.served;
+            bool     missing    = late && !overloaded && run.policy == TSRSchedulePolicy::Deadline;
+            bool     pass       = !starved && !behind && !missing && session.stats.served <= session.produced;
+
+            printf("  %-4s session %zu  every %7.0f us  deadline %6llu us  produced %5llu  served %5llu  missed %5llu  wait mean %7.1f us  p99 %6llu us\n",
+                   !pass ? "FAIL" : late ? "late" : "ok",
+                   i,
+                   settings.frameUs,
+                   static_cast<unsigned long long>(settings.deadlineUs),
+                   static_cast<unsigned long long>(session.produced),
+                   static_cast<unsigned long long>(session.stats.served),
+                   static_cast<unsigned long long>(session.stats.missedDeadlines),
+                   session.stats.waitUs.Mean(),
+                   static_cast<unsigned long long>(session.stats.waitUs.Percentile(0.99)));
+            failures += pass ? 0 : 1;
+        }
+    }
+
+    // While the consumer has the time, picking the frame closest to its deadline misses no more of them than taking
+    // turns, beyond timer noise. Overloaded it can miss more: every frame waits behind ones which are already late.
+    const PolicyRun& roundRobin = runs[0];
+    const PolicyRun& deadline   = runs[1];
+    double           rrMissed   = roundRobin.deadlineFrames ? static_cast<double>(roundRobin.missedDeadlines) / roundRobin.deadlineFrames : 0.0;
+    double           dlMissed   = deadline.deadlineFrames ? static_cast<double>(deadline.missedDeadlines) / deadline.deadlineFrames : 0.0;
+    bool             pass       = load >= 0.9 || dlMissed <= rrMissed + 0.02;
+    printf("%-4s missed deadlines: round robin %.2f%%, deadline %.2f%%\n", pass ? "ok" : "FAIL", rrMissed * 100.0, dlMissed * 100.0);
+    failures += pass ? 0 : 1;
+
+    printf(failures ? "FAILED\n" : "OK\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// tsr-slot-sim: runs the producer/consumer frame loop through TSRSimulateSlots with every slot active and with the
+// adaptive slot controller, and prints the parameters next to the slots, queue latency and frame rate of both
+
+#include "tsr.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-slot-sim [options]\n"
+                "  --frames <n>          frames simulated (4000)\n"
+                "  --producer-us <us>    mean frame work of the producer (8000)\n"
+                "  --consumer-us <us>    mean frame work of the consumer (9000)\n"
+                "  --jitter <f>          frame work varies uniformly by this fraction on both sides (0.25)\n"
+                "  --slots <n>           slots of the ring (10)\n"
+                "  --min-slots <n>       fewest slots the controller goes down to (2)\n"
+                "  --shrink-frames <n>   frames a slot stays unused before it is taken away (240)\n"
+                "  --seed <n>            seed of the jitter (1)\n"
+                "  --decisions <0|1>     print the controller's decisions (0)\n");
+        return 2;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    TSRSlotSimParams params;
+    bool             decisions = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--frames")
+            params.frames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--producer-us")
+            params.producerUs = strtod(value, nullptr);
+        else if (arg == "--consumer-us")
+            params.consumerUs = strtod(value, nullptr);
+        else if (arg == "--jitter")
+            params.producerJitter = params.consumerJitter = strtod(value, nullptr);
+        else if (arg == "--slots")
+            params.slots = strtoull(value, nullptr, 10);
+        else if (arg == "--min-slots")
+            params.controller.minSlots = strtoull(value, nullptr, 10);
+        else if (arg == "--shrink-frames")
+            params.controller.shrinkWindowFrames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--seed")
+            params.seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--decisions")
+            decisions = strtoul(value, nullptr, 10) != 0;
+        else
+            return Usage();
+    }
+    if (params.frames < 2 || !params.slots || params.producerJitter < 0.0 || params.producerJitter >= 1.0)
+        return Usage();
+
+    printf("%u frames, producer %.0f us, consumer %.0f us, jitter %.0f%%, %llu slots (min %llu), shrink after %u frames, seed %u\n",
+           params.frames,
+           params.producerUs,
+           params.consumerUs,
+           params.producerJitter * 100.0,
+           static_cast<unsigned long long>(params.slots),
+           static_cast<unsigned long long>(params.controller.minSlots),
+           params.controller.shrinkWindowFrames,
+           params.seed);
+
+    for (bool adaptive : {false, true})
+    {
+        params.adaptive         = adaptive;
+        TSRSlotSimResult result = TSRSimulateSlots(params);
+        printf("%-8s slots %5.2f  latency %8.1f us  frame %8.1f us  stall %8.1f us  grows %llu  shrinks %llu\n",
+               adaptive ? "adaptive" : "fixed",
+               result.averageSlots,
+               result.latencyUs,
+               result.producerFrameUs,
+               result.stallUs,
+               static_cast<unsigned long long>(result.stats.grows),
+               static_cast<unsigned long long>(result.stats.shrinks));
+
+        if (adaptive && decisions)
+        {
+            for (const TSRSlotDecision& decision : result.decisions)
+            {
+                printf("  frame %6llu  %llu -> %llu  %-14s producer %8.1f us  consumer %8.1f us  peak %llu\n",
+                       static_cast<unsigned long long>(decision.frame),
+                       static_cast<unsigned long long>(decision.fromSlots),
+                       static_cast<unsigned long long>(decision.toSlots),
+                       TSRSlotReasonName(decision.reason),
+                       decision.producerFrameUs,
+                       decision.consumerFrameUs,
+                       static_cast<unsigned long long>(decision.peakOccupancy));
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,372 @@
+// tsr-synth-capture: writes a capture of synthetic frames laid out like the render module's default resources (color,
+// depth, motion vectors), for tsr-replay where no renderer can capture, and checks a capture recorded from its replay
+// (tsr-capture) against the frames it generated
+
+#include "tsr.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-synth-capture (--output <file> | --check <file>) [options]\n"
+                "  --output <file>       capture to write\n"
+                "  --check <file>        capture to compare with the frames the same options generate\n"
+                "  --frames <n>          frames (60)\n"
+                "  --size <w>x<h>        render size (1280x720)\n"
+                "  --fps <rate>          frame rate stamped on the frames (60)\n"
+                "  --zstd [level]        compress the planes with zstd (level 3)\n");
+        return 2;
+    }
+
+    // DXGI formats of the render module's default resources, the capture carries them as they are
+    constexpr uint32_t FORMAT_R16G16B16A16_FLOAT = 10;
+    constexpr uint32_t FORMAT_D32_FLOAT          = 40;
+    constexpr uint32_t FORMAT_R16G16_FLOAT       = 34;
+
+    // Round to nearest even, for the values the frames hold: finite and no larger than a half holds
+    uint16_t ToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign     = (bits >> 16) & 0x8000;
+        int32_t  exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        uint32_t mantissa = bits & 0x7fffff;
+        if (exponent <= 0)
+        {
+            // Denormal or zero
+            if (exponent < -10)
+                return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000;
+            uint32_t shift   = static_cast<uint32_t>(14 - exponent);
+            uint32_t half    = mantissa >> shift;
+            uint32_t rest    = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            half += (rest > halfway || (rest == halfway && (half & 1))) ? 1 : 0;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        uint32_t rest = mantissa & 0x1fff;
+        half += (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ? 1 : 0;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    struct Sequence
+    {
+        uint32_t width  = 1280;
+        uint32_t height = 720;
+        uint64_t frames = 60;
+        double   fps    = 60.0;
+    };
+
+    TSRManifest BuildManifest(const Sequence& sequence)
+    {
+        TSRManifest manifest;
+        manifest.AddResource("Color", sequence.width, sequence.height, FORMAT_R16G16B16A16_FLOAT, 4 * sizeof(uint16_t));
+        manifest.AddResource("Depth", sequence.width, sequence.height, FORMAT_D32_FLOAT, sizeof(float));
+        manifest.AddResource("MotionVectors", sequence.width, sequence.height, FORMAT_R16G16_FLOAT, 2 * sizeof(uint16_t));
+        manifest.Finalize();
+        return manifest;
+    }
+
+    // The camera pans right by PAN_TEXELS a frame over a scene of HDR bands in front of a tilted plane
+    constexpr float PAN_TEXELS = 2.0f;
+
+    void Perspective(float* pMatrix, float aspect, float jitterX, float jitterY)
+    {
+        // Column major, reversed depth with an infinite far plane like the samples use
+        const float nearZ = 0.1f;
+        const float f     = 1.0f / std::tan(0.5f * 1.0471976f);
+        memset(pMatrix, 0, 16 * sizeof(float));
+        pMatrix[0]  = f / aspect;
+        pMatrix[5]  = f;
+        pMatrix[8]  = jitterX;
+        pMatrix[9]  = jitterY;
+        pMatrix[11] = -1.0f;
+        pMatrix[14] = nearZ;
+    }
+
+    void View(float* pMatrix, uint64_t frame, const Sequence& sequence)
+    {
+        memset(pMatrix, 0, 16 * sizeof(float));
+        pMatrix[0] = pMatrix[5] = pMatrix[10] = pMatrix[15] = 1.0f;
+        pMatrix[12] = -static_cast<float>(frame) * PAN_TEXELS / sequence.width;
+    }
+
+    void Multiply(const float* pA, const float* pB, float* pResult)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; k++)
+                    sum += pA[k * 4 + row] * pB[column * 4 + k];
+                pResult[column * 4 + row] = sum;
+            }
+        }
+    }
+
+    float Halton(uint64_t index, uint32_t base)
+    {
+        float f      = 1.0f;
+        float result = 0.0f;
+        for (uint64_t i = index; i; i /= base)
+        {
+            f /= base;
+            result += f * (i % base);
+        }
+        return result;
+    }
+
+    TSRFrameMetadata MakeMetadata(uint64_t frame, const Sequence& sequence)
+    {
+        TSRFrameMetadata metadata = {};
+        metadata.frameId          = frame;
+        metadata.jitter[0]        = Halton(frame % 8 + 1, 2) - 0.5f;
+        metadata.jitter[1]        = Halton(frame % 8 + 1, 3) - 0.5f;
+        metadata.reset            = frame == 0 ? 1 : 0;
+        metadata.deltaTimeMs      = static_cast<float>(1000.0 / sequence.fps);
+        metadata.exposure         = 1.0f;
+        metadata.renderWidth      = sequence.width;
+        metadata.renderHeight     = sequence.height;
+
+        float aspect = static_cast<float>(sequence.width) / sequence.height;
+        View(metadata.viewMatrix, frame, sequence);
+        Perspective(metadata.projectionMatrix, aspect, 0.0f, 0.0f);
+        Perspective(metadata.jitteredProjectionMatrix,
+                    aspect,
+                    2.0f * metadata.jitter[0] / sequence.width,
+                    -2.0f * metadata.jitter[1] / sequence.height);
+
+        // The first frame has no previous one, it is its own
+        uint64_t previous = frame ? frame - 1 : 0;
+        float    prevProjection[16];
+        View(metadata.prevViewMatrix, previous, sequence);
+        Perspective(prevProjection, aspect, 0.0f, 0.0f);
+        Multiply(prevProjection, metadata.prevViewMatrix, metadata.prevViewProjectionMatrix);
+        Perspective(metadata.prevJitteredProjectionMatrix,
+                    aspect,
+                    2.0f * (Halton(previous % 8 + 1, 2) - 0.5f) / sequence.width,
+                    -2.0f * (Halton(previous % 8 + 1, 3) - 0.5f) / sequence.height);
+        return metadata;
+    }
+
+    // Fill a slot laid out by the manifest with the frame
+    void FillSlot(std::vector<uint8_t>& slot, const TSRManifest& manifest, uint64_t frame, const Sequence& sequence)
+    {
+        const TSRResourceDesc& color  = manifest.GetResource(0);
+        const TSRResourceDesc& depth  = manifest.GetResource(1);
+        const TSRResourceDesc& motion = manifest.GetResource(2);
+
+        // Motion vectors point from this frame's texel back to the previous one's, in UV
+        uint16_t motionX = ToHalf(frame ? PAN_TEXELS / sequence.width : 0.0f);
+        uint16_t motionY = ToHalf(0.0f);
+
+        float scroll = static_cast<float>(frame) * PAN_TEXELS;
+        for (uint32_t y = 0; y < sequence.height; y++)
+        {
+            uint16_t* pColor  = reinterpret_cast<uint16_t*>(slot.data() + color.offset + y * color.rowPitch);
+            float*    pDepth  = reinterpret_cast<float*>(slot.data() + depth.offset + y * depth.rowPitch);
+            uint16_t* pMotion = reinterpret_cast<uint16_t*>(slot.data() + motion.offset + y * motion.rowPitch);
+            for (uint32_t x = 0; x < sequence.width; x++)
+            {
+                // Bands up to 16, so the upscaler sees HDR values and edges that move
+                float u    = (x + scroll) / 64.0f;
+                float band = std::floor(u);
+                float v    = static_cast<float>(y) / sequence.height;
+                pColor[x * 4 + 0] = ToHalf(std::fmod(band, 4.0f) * 4.0f * (u - band));
+                pColor[x * 4 + 1] = ToHalf(v);
+                pColor[x * 4 + 2] = ToHalf(std::fmod(band, 3.0f) * 0.5f);
+                pColor[x * 4 + 3] = ToHalf(1.0f);
+
+                // Reversed depth, the plane comes closer toward the bottom
+                pDepth[x] = 0.05f + 0.9f * v;
+
+                pMotion[x * 2 + 0] = motionX;
+                pMotion[x * 2 + 1] = motionY;
+            }
+        }
+    }
+
+    int Write(const std::string& path, const Sequence& sequence, const TSRCaptureOptions& options)
+    {
+        TSRManifest      manifest = BuildManifest(sequence);
+        TSRCaptureWriter writer;
+        if (!writer.Open(path, manifest, options))
+        {
+            fprintf(stderr, "tsr-synth-capture: %s\n", writer.GetError().c_str());
+            return 1;
+        }
+
+        std::vector<uint8_t> slot(manifest.GetTotalSize());
+        uint64_t             periodNs = static_cast<uint64_t>(1e9 / sequence.fps);
+        for (uint64_t frame = 0; frame < sequence.frames; frame++)
+        {
+            FillSlot(slot, manifest, frame, sequence);
+
+            TSRCaptureFrame captureFrame = {};
+            captureFrame.sequence        = frame;
+            captureFrame.captureTimeNs   = frame * periodNs;
+            captureFrame.resourceMask    = manifest.GetAllMask();
+            captureFrame.metadata        = MakeMetadata(frame, sequence);
+            if (!writer.WriteFrame(captureFrame, slot.data()))
+            {
+                fprintf(stderr, "tsr-synth-capture: %s\n", writer.GetError().c_str());
+                return 1;
+            }
+        }
+
+        TSRCaptureStats stats = writer.GetStats();
+        if (!writer.Close())
+        {
+            fprintf(stderr, "tsr-synth-capture: %s\n", writer.GetError().c_str());
+            return 1;
+        }
+        printf("%llu frames of %ux%u, %.1f MB of planes stored in %.1f MB\n",
+               static_cast<unsigned long long>(stats.frames),
+               sequence.width,
+               sequence.height,
+               stats.rawBytes / (1024.0 * 1024.0),
+               stats.storedBytes / (1024.0 * 1024.0));
+        return 0;
+    }
+
+    // Whether the texels of a resource match, row by row: the padding of a slot is not carried
+    bool SamePlane(const TSRResourceDesc& resource, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual)
+    {
+        for (uint32_t y = 0; y < resource.height; y++)
+        {
+            uint64_t offset = resource.offset + y * resource.rowPitch;
+            if (memcmp(expected.data() + offset, actual.data() + offset, resource.width * resource.stride))
+                return false;
+        }
+        return true;
+    }
+
+    // The frame ids and render times are the replay's, the rest has to be what was generated
+    bool SameMetadata(const TSRFrameMetadata& expected, const TSRFrameMetadata& actual)
+    {
+        TSRFrameMetadata a = expected;
+        TSRFrameMetadata b = actual;
+        a.renderTimeNs = b.renderTimeNs = 0;
+        return memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    int Check(const std::string& path, const Sequence& sequence)
+    {
+        TSRCaptureReader reader;
+        if (!reader.Open(path))
+        {
+            fprintf(stderr, "tsr-synth-capture: %s\n", reader.GetError().c_str());
+            return 1;
+        }
+
+        int                failures = 0;
+        const TSRManifest& manifest = reader.GetManifest();
+        TSRManifest        expected = BuildManifest(sequence);
+        bool               layout   = manifest.GetHash() == expected.GetHash();
+        printf("%-4s manifest\n", layout ? "ok" : "FAIL");
+        printf("%-4s %llu of %llu frames\n",
+               reader.GetFrameCount() == sequence.frames ? "ok" : "FAIL",
+               static_cast<unsigned long long>(reader.GetFrameCount()),
+               static_cast<unsigned long long>(sequence.frames));
+        failures += layout ? 0 : 1;
+        failures += reader.GetFrameCount() == sequence.frames ? 0 : 1;
+        if (!layout)
+        {
+            printf("FAILED\n");
+            return 1;
+        }
+
+        std::vector<uint8_t> expectedSlot(expected.GetTotalSize());
+        std::vector<uint8_t> actualSlot(manifest.GetTotalSize());
+        uint64_t             planeMismatches    = 0;
+        uint64_t             metadataMismatches = 0;
+        uint64_t             frameIdMismatches  = 0;
+        for (uint64_t frame = 0; frame < reader.GetFrameCount() && frame < sequence.frames; frame++)
+        {
+            if (!reader.ReadFrame(frame, actualSlot.data()))
+            {
+                fprintf(stderr, "tsr-synth-capture: %s\n", reader.GetError().c_str());
+                return 1;
+            }
+            FillSlot(expectedSlot, expected, frame, sequence);
+
+            const TSRCaptureFrame& captured = reader.GetFrame(frame);
+            for (size_t i = 0; i < manifest.GetResourceCount(); i++)
+            {
+                bool stored = (captured.resourceMask & (1ull << i)) != 0;
+                planeMismatches += stored && SamePlane(manifest.GetResource(i), expectedSlot, actualSlot) ? 0 : 1;
+            }
+            metadataMismatches += SameMetadata(MakeMetadata(frame, sequence), captured.metadata) ? 0 : 1;
+            frameIdMismatches += captured.metadata.frameId == frame ? 0 : 1;
+        }
+
+        printf("%-4s %llu planes differ\n", planeMismatches ? "FAIL" : "ok", static_cast<unsigned long long>(planeMismatches));
+        printf("%-4s %llu frames with other metadata\n", metadataMismatches ? "FAIL" : "ok", static_cast<unsigned long long>(metadataMismatches));
+        printf("%-4s %llu frames out of order\n", frameIdMismatches ? "FAIL" : "ok", static_cast<unsigned long long>(frameIdMismatches));
+        failures += (planeMismatches ? 1 : 0) + (metadataMismatches ? 1 : 0) + (frameIdMismatches ? 1 : 0);
+
+        printf(failures ? "FAILED\n" : "OK\n");
+        return failures ? 1 : 0;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    Sequence          sequence;
+    TSRCaptureOptions options;
+    std::string       output;
+    std::string       check;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg   = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--zstd")
+        {
+            options.codec = TSRCaptureCodec::Zstd;
+            if (value && value[0] != '-')
+                options.level = atoi(argv[++i]);
+            continue;
+        }
+
+        if (!value)
+            return Usage();
+        i++;
+
+        if (arg == "--output")
+            output = value;
+        else if (arg == "--check")
+            check = value;
+        else if (arg == "--frames")
+            sequence.frames = strtoull(value, nullptr, 10);
+        else if (arg == "--size")
+        {
+            if (sscanf(value, "%ux%u", &sequence.width, &sequence.height) != 2)
+                return Usage();
+        }
+        else if (arg == "--fps")
+            sequence.fps = strtod(value, nullptr);
+        else
+            return Usage();
+    }
+
+    if (output.empty() == check.empty() || !sequence.frames || !sequence.width || !sequence.height || sequence.fps <= 0.0)
+        return Usage();
+    if (options.codec == TSRCaptureCodec::Zstd && !TSRCaptureSupportsZstd())
+    {
+        fprintf(stderr, "tsr-synth-capture: this build has no zstd support\n");
+        return 1;
+    }
+
+    return output.empty() ? Check(check, sequence) : Write(output, sequence, options);
+}
@@ -0,0 +1,292 @@
+// tsr-tile-delta: runs a capture, or a synthetic sequence, through the tile classifier and counts what delta transfers
+// save (see TSRMeasureTileDelta), then sends every frame as a delta through WriteSlotTiles and ReadSlotTiles and checks
+// the consumer planes come out as the frames that went in
+
+#include "tsr.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int Usage()
+    {
+        fprintf(stderr,
+                "usage: tsr-tile-delta [--input <file>] [options]\n"
+                "  --input <file>        capture to classify, a synthetic sequence without one\n"
+                "  --color <name>        resource of the capture holding the color (Color)\n"
+                "  --motion <name>       resource of the capture holding the motion vectors, if float (MotionVectors)\n"
+                "  --frames <n>          frames to classify, at most (120)\n"
+                "  --width <n>           synthetic frame width (643)\n"
+                "  --height <n>          synthetic frame height (361)\n"
+                "  --tile-size <n>       tile size (16)\n"
+                "  --motion-threshold <f> motion vector length above which a tile is always dirty (0)\n");
+        return 2;
+    }
+
+    // The frames as the producer hands them over: color texels, and two floats of motion per texel if there are any
+    struct Sequence
+    {
+        uint32_t                          width       = 0;
+        uint32_t                          height      = 0;
+        uint64_t                          colorStride = 0;
+        bool                              hasMotion   = false;
+        std::vector<std::vector<uint8_t>> color;
+        std::vector<std::vector<float>>   motion;
+
+        TSRHostPlane ColorPlane(size_t frame) { return {color[frame].data(), width, height, colorStride, width * colorStride}; }
+
+        TSRHostPlane MotionPlane(size_t frame)
+        {
+            return {reinterpret_cast<uint8_t*>(motion[frame].data()), width, height, 2 * sizeof(float), width * 2 * sizeof(float)};
+        }
+    };
+
+    // A static gradient with a box moving across it and a counter in the corner, the way a HUD ticks over
+    Sequence MakeSyntheticSequence(uint32_t width, uint32_t height, uint32_t frames)
+    {
+        Sequence sequence;
+        sequence.width       = width;
+        sequence.height      = height;
+        sequence.colorStride = sizeof(uint32_t);
+        sequence.hasMotion   = true;
+
+        const uint32_t boxSize  = std::min(48u, std::min(width, height) / 4);
+        const int32_t  boxSpeed = 5;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            std::vector<uint8_t> color(static_cast<size_t>(width) * height * sizeof(uint32_t));
+            std::vector<float>   motion(static_cast<size_t>(width) * height * 2, 0.0f);
+            uint32_t*            pTexels = reinterpret_cast<uint32_t*>(color.data());
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                    pTexels[y * width + x] = 0xff000000u | ((x * 255 / width) << 16) | ((y * 255 / height) << 8) | 0x40;
+            }
+
+            // The box bounces between the edges
+            uint32_t span = width - boxSize;
+            uint32_t step = frame * boxSpeed % (2 * span);
+            uint32_t boxX = step < span ? step : 2 * span - step;
+            uint32_t boxY = (height - boxSize) / 2;
+            float    dx   = step < span ? static_cast<float>(boxSpeed) : -static_cast<float>(boxSpeed);
+            for (uint32_t y = boxY; y < boxY + boxSize; y++)
+            {
+                for (uint32_t x = boxX; x < boxX + boxSize; x++)
+                {
+                    pTexels[y * width + x]        = 0xff2080e0u;
+                    motion[(y * width + x) * 2]   = dx;
+                    motion[(y * width + x) * 2 + 1] = 0.0f;
+                }
+            }
+
+            // 16 cells of 6x10 texels, lit for the set bits of the frame number
+            for (uint32_t bit = 0; bit < 16 && 4 + (bit + 1) * 8 <= width && height >= 14; bit++)
+            {
+                uint32_t lit = (frame >> (15 - bit)) & 1 ? 0xffffffffu : 0xff202020u;
+                for (uint32_t y = 4; y < 14; y++)
+                {
+                    for (uint32_t x = 4 + bit * 8; x < 10 + bit * 8; x++)
+                        pTexels[y * width + x] = lit;
+                }
+            }
+
+            sequence.color.push_back(std::move(color));
+            sequence.motion.push_back(std::move(motion));
+        }
+        return sequence;
+    }
+
+    // Decode the capture frames in order, delta frames apply onto the slot the frames before them left behind
+    bool ReadCaptureSequence(const std::string& path, const std::string& colorName, const std::string& motionName, uint32_t frames, Sequence& sequence)
+    {
+        TSRCaptureReader reader;
+        if (!reader.Open(path))
+        {
+            fprintf(stderr, "tsr-tile-delta: %s\n", reader.GetError().c_str());
+            return false;
+        }
+
+        const TSRManifest& manifest   = reader.GetManifest();
+        size_t             colorIndex = manifest.FindResource(colorName);
+        if (colorIndex == TSRManifest::INVALID_RESOURCE)
+        {
+            fprintf(stderr, "tsr-tile-delta: the capture has no %s resource\n", colorName.c_str());
+            return false;
+        }
+
+        const TSRResourceDesc& color = manifest.GetResource(colorIndex);
+        sequence.width               = color.width;
+        sequence.height              = color.height;
+        sequence.colorStride         = color.stride;
+
+        // The classifier reads motion vectors as floats, which leaves out the half float textures of the GPU
+        size_t motionIndex = manifest.FindResource(motionName);
+        if (motionIndex != TSRManifest::INVALID_RESOURCE)
+        {
+            const TSRResourceDesc& motion = manifest.GetResource(motionIndex);
+            bool                   sized  = motion.width == color.width && motion.height == color.height;
+            bool                   floats = motion.packing == TSRPacking::MotionRG16Snorm || (motion.packing == TSRPacking::None && motion.stride >= 2 * sizeof(float));
+            sequence.hasMotion            = sized && floats;
+            if (!sequence.hasMotion)
+                printf("%s is not float or not the size of %s, classifying by color only\n", motionName.c_str(), colorName.c_str());
+        }
+
+        std::vector<uint8_t> slot(manifest.GetTotalSize());
+        uint64_t             count = std::min<uint64_t>(reader.GetFrameCount(), frames);
+        for (uint64_t frame = 0; frame < count; frame++)
+        {
+            if (!reader.ReadFrame(frame, slot.data()))
+            {
+                fprintf(stderr, "tsr-tile-delta: %s\n", reader.GetError().c_str());
+                return false;
+            }
+
+            std::vector<uint8_t> texels(static_cast<size_t>(color.width) * color.height * color.stride);
+            for (uint32_t y = 0; y < color.height; y++)
+                memcpy(texels.data() + y * color.width * color.stride, slot.data() + color.offset + y * color.rowPitch, color.width * color.stride);
+            sequence.color.push_back(std::move(texels));
+
+            if (!sequence.hasMotion)
+                continue;
+
+            const TSRResourceDesc& motion = manifest.GetResource(motionIndex);
+            std::vector<float>     vectors(static_cast<size_t>(color.width) * color.height * 2);
+            for (uint32_t y = 0; y < motion.height; y++)
+            {
+                const uint8_t* pRow = slot.data() + motion.offset + y * motion.rowPitch;
+                float*         pDst = vectors.data() + static_cast<size_t>(y) * motion.width * 2;
+                if (motion.packing == TSRPacking::MotionRG16Snorm)
+                    TSRUnpackRow(motion.packing, pRow, pDst, 2, motion.width, motion.packingScale);
+                else
+                {
+                    for (uint32_t x = 0; x < motion.width; x++)
+                        memcpy(pDst + x * 2, pRow + x * motion.stride, 2 * sizeof(float));
+                }
+            }
+            sequence.motion.push_back(std::move(vectors));
+        }
+        return true;
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    std::string input;
+    std::string colorName       = "Color";
+    std::string motionName      = "MotionVectors";
+    uint32_t    frames          = 120;
+    uint32_t    width           = 643;
+    uint32_t    height          = 361;
+    uint32_t    tileSize        = 16;
+    float       motionThreshold = 0.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+            return Usage();
+        const char* value = argv[++i];
+
+        if (arg == "--input")
+            input = value;
+        else if (arg == "--color")
+            colorName = value;
+        else if (arg == "--motion")
+            motionName = value;
+        else if (arg == "--frames")
+            frames = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--width")
+            width = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--height")
+            height = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--tile-size")
+            tileSize = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+        else if (arg == "--motion-threshold")
+            motionThreshold = strtof(value, nullptr);
+        else
+            return Usage();
+    }
+    if (!frames || !tileSize || (input.empty() && (width < 2 || height < 2)))
+        return Usage();
+
+    Sequence sequence;
+    if (input.empty())
+        sequence = MakeSyntheticSequence(width, height, frames);
+    else if (!ReadCaptureSequence(input, colorName, motionName, frames, sequence))
+        return 1;
+    if (sequence.color.empty())
+    {
+        fprintf(stderr, "tsr-tile-delta: no frames\n");
+        return 1;
+    }
+
+    size_t                    frameCount = sequence.color.size();
+    std::vector<TSRHostPlane> colorPlanes;
+    std::vector<TSRHostPlane> motionPlanes;
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        colorPlanes.push_back(sequence.ColorPlane(frame));
+        if (sequence.hasMotion)
+            motionPlanes.push_back(sequence.MotionPlane(frame));
+    }
+
+    TSRTileDeltaStats stats =
+        TSRMeasureTileDelta(colorPlanes.data(), sequence.hasMotion ? motionPlanes.data() : nullptr, frameCount, tileSize, motionThreshold);
+
+    printf("%s, %zu frames of %ux%u, %llu bytes of color%s per texel, tile size %u\n",
+           input.empty() ? "synthetic" : input.c_str(),
+           frameCount,
+           sequence.width,
+           sequence.height,
+           static_cast<unsigned long long>(sequence.colorStride),
+           sequence.hasMotion ? " and 8 of motion" : "",
+           tileSize);
+    printf("dirty tiles %.1f%%  full %llu bytes  delta %llu bytes  saved %.1f%%\n",
+           stats.tiles ? 100.0 * stats.dirtyTiles / stats.tiles : 0.0,
+           static_cast<unsigned long long>(stats.fullBytes),
+           static_cast<unsigned long long>(stats.deltaBytes),
+           stats.SavedRatio() * 100.0);
+
+    // Send the frames through a ring of slots as the producer would, the consumer planes keep the previous frame
+    TSRManifest manifest;
+    manifest.AddResource("Color", sequence.width, sequence.height, 0, sequence.colorStride);
+    if (sequence.hasMotion)
+        manifest.AddResource("MotionVectors", sequence.width, sequence.height, 0, 2 * sizeof(float));
+    manifest.SetTileSize(tileSize);
+    manifest.Finalize();
+
+    const uint64_t   slotCount = 3;
+    TSRHostTransport transport("TSRTileDelta_" + std::to_string(tsr_now_ns()), slotCount);
+    transport.CreateSlots(manifest.GetTotalSize(), manifest.GetHash(), true);
+
+    std::vector<uint8_t> consumerColor(sequence.color[0].size());
+    std::vector<float>   consumerMotion(sequence.hasMotion ? sequence.motion[0].size() : 0);
+    TSRHostPlane         consumerPlanes[2] = {
+        {consumerColor.data(), sequence.width, sequence.height, sequence.colorStride, sequence.width * sequence.colorStride},
+        {reinterpret_cast<uint8_t*>(consumerMotion.data()), sequence.width, sequence.height, 2 * sizeof(float), sequence.width * 2 * sizeof(float)}};
+
+    TSRTileClassifier classifier(sequence.width, sequence.height, tileSize, motionThreshold);
+    TSRTileMap        readTiles;
+    uint64_t          mismatches = 0;
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        TSRHostPlane      planes[2] = {colorPlanes[frame], sequence.hasMotion ? motionPlanes[frame] : TSRHostPlane()};
+        const TSRTileMap& tiles     = classifier.Classify(planes[0], sequence.hasMotion ? &planes[1] : nullptr);
+
+        uint64_t slotIndex = frame % slotCount;
+        transport.WriteSlotTiles(manifest, planes, manifest.GetAllMask(), &tiles, slotIndex);
+        transport.ReadSlotTiles(manifest, consumerPlanes, manifest.GetAllMask(), &readTiles, slotIndex);
+
+        bool matches = consumerColor == sequence.color[frame] && (!sequence.hasMotion || consumerMotion == sequence.motion[frame]);
+        if (!matches && mismatches++ < 10)
+            printf("FAIL frame %zu does not match after the delta of %llu dirty tiles\n", frame, static_cast<unsigned long long>(readTiles.CountDirty()));
+    }
+
+    printf("%s reconstructed %zu of %zu frames\n", mismatches ? "FAIL" : "ok  ", frameCount - mismatches, frameCount);
+    return mismatches ? 1 : 0;
+}
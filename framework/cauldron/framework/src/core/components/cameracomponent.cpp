@@ -123,7 +123,7 @@ namespace cauldron
         m_PrevProjJittered         = m_ProjJittered;
 
         // Get the safe process name
-        std::wstring processName = GetFramework()->GetName();
+        std::wstring processName = GetFramework()->GetSharedName();
         processName.replace(processName.find(L' '), 1, L"_");
         std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
         std::string                                      processNameA = converter.to_bytes(processName);
@@ -139,6 +139,110 @@ namespace cauldron
 
     }
 
+    static void StoreMatrix(const Mat4& matrix, float (&values)[16])
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            Vec4 column = matrix.getCol(col);
+            values[col * 4 + 0] = column.getX();
+            values[col * 4 + 1] = column.getY();
+            values[col * 4 + 2] = column.getZ();
+            values[col * 4 + 3] = column.getW();
+        }
+    }
+
+    static Mat4 LoadMatrix(const float* values)
+    {
+        return Mat4(Vec4(values[0], values[1], values[2], values[3]),
+                    Vec4(values[4], values[5], values[6], values[7]),
+                    Vec4(values[8], values[9], values[10], values[11]),
+                    Vec4(values[12], values[13], values[14], values[15]));
+    }
+
+    const ShareableCameraData CameraComponent::GetShareableData() const
+    {
+        ShareableCameraData data = {};
+        data.m_FrameId             = GetFramework()->GetFrameID();
+        data.m_Type                = static_cast<uint32_t>(m_pData->Type);
+        data.m_Znear               = m_pData->Znear;
+        data.m_Zfar                = m_pData->Zfar;
+        data.m_ProjectionParams[0] = m_pData->Perspective.Yfov;
+        data.m_ProjectionParams[1] = m_pData->Perspective.AspectRatio;
+
+        data.m_Distance = m_Distance;
+        data.m_Yaw      = m_Yaw;
+        data.m_Pitch    = m_Pitch;
+
+        StoreMatrix(m_pOwner->GetTransform(), data.m_OwnerTransform);
+        StoreMatrix(m_ViewMatrix, data.m_ViewMatrix);
+        StoreMatrix(m_ProjectionMatrix, data.m_ProjectionMatrix);
+        StoreMatrix(m_ViewProjectionMatrix, data.m_ViewProjectionMatrix);
+        StoreMatrix(m_InvViewMatrix, data.m_InvViewMatrix);
+        StoreMatrix(m_InvProjectionMatrix, data.m_InvProjectionMatrix);
+        StoreMatrix(m_InvViewProjectionMatrix, data.m_InvViewProjectionMatrix);
+        StoreMatrix(m_PrevViewMatrix, data.m_PrevViewMatrix);
+        StoreMatrix(m_PrevViewProjectionMatrix, data.m_PrevViewProjectionMatrix);
+
+        data.m_Speed           = m_Speed;
+        data.m_Dirty           = m_Dirty ? 1 : 0;
+        data.m_ArcBallMode     = m_ArcBallMode ? 1 : 0;
+        data.m_JitterValues[0] = m_jitterValues.getX();
+        data.m_JitterValues[1] = m_jitterValues.getY();
+        StoreMatrix(m_ProjJittered, data.m_ProjJittered);
+        StoreMatrix(m_PrevProjJittered, data.m_PrevProjJittered);
+        return data;
+    }
+
+    void CameraComponent::SetShareableData(const ShareableCameraData& data)
+    {
+        // Only the projection parameters, the rest of the initialization data (like the name) stays ours
+        m_pData->Type                    = static_cast<CameraType>(data.m_Type);
+        m_pData->Znear                   = data.m_Znear;
+        m_pData->Zfar                    = data.m_Zfar;
+        m_pData->Perspective.Yfov        = data.m_ProjectionParams[0];
+        m_pData->Perspective.AspectRatio = data.m_ProjectionParams[1];
+
+        m_Distance = data.m_Distance;
+        m_Yaw      = data.m_Yaw;
+        m_Pitch    = data.m_Pitch;
+        m_pOwner->SetTransform(LoadMatrix(data.m_OwnerTransform));
+        m_ViewMatrix               = LoadMatrix(data.m_ViewMatrix);
+        m_ProjectionMatrix         = LoadMatrix(data.m_ProjectionMatrix);
+        m_ViewProjectionMatrix     = LoadMatrix(data.m_ViewProjectionMatrix);
+        m_InvViewMatrix            = LoadMatrix(data.m_InvViewMatrix);
+        m_InvProjectionMatrix      = LoadMatrix(data.m_InvProjectionMatrix);
+        m_InvViewProjectionMatrix  = LoadMatrix(data.m_InvViewProjectionMatrix);
+        m_PrevViewMatrix           = LoadMatrix(data.m_PrevViewMatrix);
+        m_PrevViewProjectionMatrix = LoadMatrix(data.m_PrevViewProjectionMatrix);
+        m_Speed                    = data.m_Speed;
+        m_Dirty                    = data.m_Dirty != 0;
+        m_ArcBallMode              = data.m_ArcBallMode != 0;
+        m_jitterValues             = Vec2(data.m_JitterValues[0], data.m_JitterValues[1]);
+        m_ProjJittered             = LoadMatrix(data.m_ProjJittered);
+        m_PrevProjJittered         = LoadMatrix(data.m_PrevProjJittered);
+        m_SharedFrameID            = data.m_FrameId;
+    }
+
+    void CameraComponent::SetFrameMatrices(const float* pView,
+                                           const float* pProjection,
+                                           const float* pProjJittered,
+                                           const float* pPrevView,
+                                           const float* pPrevViewProjection,
+                                           const float* pPrevProjJittered,
+                                           const Vec2&  jitterValues)
+    {
+        m_ViewMatrix               = LoadMatrix(pView);
+        m_InvViewMatrix            = InverseMatrix(m_ViewMatrix);
+        m_ProjectionMatrix         = LoadMatrix(pProjection);
+        m_ProjJittered             = LoadMatrix(pProjJittered);
+        m_PrevViewMatrix           = LoadMatrix(pPrevView);
+        m_PrevViewProjectionMatrix = LoadMatrix(pPrevViewProjection);
+        m_PrevProjJittered         = LoadMatrix(pPrevProjJittered);
+        m_jitterValues             = jitterValues;
+
+        SetViewBasedMatrices();
+    }
+
     void CameraComponent::ResetCamera()
     {
         // Reset owner's transform
@@ -245,27 +349,23 @@ namespace cauldron
         // If this camera is the currently active camera for the scene, check for input
         if (GetScene()->GetCurrentCamera() == this)
         {
-            // If we are not in default mode, map shared data
-            if (!GetFramework()->HasCapability(FrameworkCapability::Renderer | FrameworkCapability::Upscaler))
+            // If we are not in default mode, map shared data (the renderer creates it, the upscaler opens it)
+            bool sharedData = !GetFramework()->HasCapability(FrameworkCapability::Renderer | FrameworkCapability::Upscaler) && GetFramework()->IsSharedCameraDataEnabled();
+            if (sharedData && !m_SharedData.IsOpen())
             {
-                // Create or open the shared memory file mapping
-                tsr_map_udta(
-                    m_SharedDataName, sizeof(ShareableCameraData), GetFramework()->GetBufferCount(), m_hSharedData, m_pSharedView, (void**)m_pSharedData);
+                bool opened = m_SharedData.Open(m_SharedDataName, GetFramework()->GetBufferCount(), GetFramework()->IsOnlyCapability(FrameworkCapability::Renderer));
+                CauldronAssert(ASSERT_CRITICAL, opened, L"Could not map the shared camera data, or the renderer shares another layout of it.");
             }
 
             // Read the next shared data slot
             if (GetFramework()->IsOnlyCapability(FrameworkCapability::Upscaler))
             {
                 uint64_t bufferIndex = GetFramework()->GetBufferIndex();
-                CauldronAssert(ASSERT_CRITICAL, m_pSharedData[bufferIndex], L"Shared data is not mapped. Cannot read data from shared memory.");
-
-                // Copy the shared data to our local data
-                ShareableCameraData* shareableData = (ShareableCameraData*)malloc(sizeof(ShareableCameraData));
-                memcpy(shareableData, m_pSharedData[bufferIndex], sizeof(ShareableCameraData));
 
-                // Set the shareable data to the owner
-                SetShareableData(*shareableData);
-                free(shareableData);
+                // Copy the shared data to our local data, keeping the last camera if the renderer never got to this slot
+                ShareableCameraData shareableData;
+                if (sharedData && m_SharedData.Read(bufferIndex, shareableData))
+                    SetShareableData(shareableData);
 
                 // Don't update anything else
                 return;
@@ -395,21 +495,19 @@ namespace cauldron
             }
 
             // Transfer the shareable camera data to next slot
-            if (GetFramework()->IsOnlyCapability(FrameworkCapability::Renderer))
+            if (sharedData && GetFramework()->IsOnlyCapability(FrameworkCapability::Renderer))
             {
                 uint64_t bufferIndex = GetFramework()->GetBufferIndex();
-                CauldronAssert(ASSERT_CRITICAL, m_pSharedData[bufferIndex], L"Shared data is not mapped. Cannot write data to shared memory.");
 
                 // Copy the local data to the shared data
-                const ShareableCameraData& shareableData = GetShareableData();
-                memcpy(m_pSharedData[bufferIndex], &shareableData, sizeof(ShareableCameraData));
+                m_SharedData.Write(bufferIndex, GetShareableData());
             }
         }
         else
         {
             // Don't leave shared data mapped if we don't need it
             if (!GetFramework()->HasCapability(FrameworkCapability::Renderer | FrameworkCapability::Upscaler))
-                tsr_unmap_udta(m_pSharedView, m_hSharedData, (void**)m_pSharedData, GetFramework()->GetBufferCount());
+                m_SharedData.Close();
         }
     }
 
@@ -436,3 +534,33 @@ namespace cauldron
      }
 
 } // namespace cauldron
+
+uint64_t tsr::ChannelLayout<cauldron::ShareableCameraData>::Hash()
+{
+    using cauldron::ShareableCameraData;
+    return tsr::LayoutHash(sizeof(ShareableCameraData), alignof(ShareableCameraData))
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_FrameId)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Type)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Znear)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Zfar)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ProjectionParams)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Distance)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Yaw)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Pitch)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_OwnerTransform)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ViewMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ProjectionMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ViewProjectionMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_InvViewMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_InvProjectionMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_InvViewProjectionMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_PrevViewMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_PrevViewProjectionMatrix)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Speed)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_Dirty)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ArcBallMode)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_JitterValues)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_ProjJittered)
+        .TSR_LAYOUT_FIELD(ShareableCameraData, m_PrevProjJittered)
+        .Get();
+}
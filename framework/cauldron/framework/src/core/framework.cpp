@@ -1012,6 +1012,7 @@ namespace cauldron
             m_Config.StreamingInfo.Host = StringToWString(streamConfig.value("Host", WStringToString(m_Config.StreamingInfo.Host)));
             m_Config.StreamingInfo.Port = streamConfig.value("Port", m_Config.StreamingInfo.Port);
             m_Config.StreamingInfo.Name = StringToWString(streamConfig.value("Name", WStringToString(m_Config.StreamingInfo.Name)));
+            m_Config.StreamingInfo.ReadbackDepth = streamConfig.value("ReadbackDepth", m_Config.StreamingInfo.ReadbackDepth);
         }
 
         // Validate that the information are correct
@@ -1065,11 +1066,7 @@ namespace cauldron
         m_pDynamicResourcePool->OnResolutionChanged(m_ResolutionInfo);
 
         // Notify that the swapchain has been recreated and other resources have been resized
-        {
-            std::lock_guard<std::mutex> lock(m_ResourceResizeMutex);
-            for (auto pListener : m_ResourceResizedListeners)
-                pListener->OnResourceResized();
-        }
+        RebindResizableResources();
 
         // Handle any render module resize callbacks
         for (auto& rm : m_RenderModules)
@@ -1361,6 +1358,17 @@ namespace cauldron
                 continue;
             }
 
+            // TSR session of the renderer
+            if (command == L"-session")
+            {
+                CauldronAssert(ASSERT_CRITICAL, argCount - currentArg > 1 && pArgList[currentArg + 1][0] != L'-', L"No session name provided when -session requested!");
+
+                m_Config.SessionName = pArgList[currentArg + 1];
+
+                ++currentArg;
+                continue;
+            }
+
             // perf dump
             if (command == L"-benchmark")
             {
@@ -1765,14 +1773,14 @@ namespace cauldron
     {
         std::vector<CommandList*> CmdLists     = {};
         uint64_t                  CompletionID = 0;
-        uint8_t                   CurrentBackBufferIndex = 0;
         int64_t                   FrameID = 0;
+        uint64_t                  RenderFrameID = 0;
 
-        GPUExecutionPacket(std::vector<CommandList*>& cmdLists, uint64_t completionID, uint8_t currentBackBufferIndex, int64_t frameID)
+        GPUExecutionPacket(std::vector<CommandList*>& cmdLists, uint64_t completionID, int64_t frameID, uint64_t renderFrameID)
             : CmdLists(std::move(cmdLists))
             , CompletionID(completionID)
-            , CurrentBackBufferIndex(currentBackBufferIndex)
             , FrameID(frameID)
+            , RenderFrameID(renderFrameID)
         {
         }
         GPUExecutionPacket() = delete;
@@ -1785,7 +1793,7 @@ namespace cauldron
         m_pDevice->WaitOnQueue(pInflightPacket->CompletionID, CommandQueue::Graphics);
 
         // Encode the frame
-        m_pStreamer->Encode(pInflightPacket->CurrentBackBufferIndex, pInflightPacket->FrameID);
+        m_pStreamer->Encode(pInflightPacket->RenderFrameID, pInflightPacket->FrameID);
 
         // Delete them to release the allocators
         for (auto cmdListIter = pInflightPacket->CmdLists.begin(); cmdListIter != pInflightPacket->CmdLists.end(); ++cmdListIter)
@@ -1809,8 +1817,12 @@ namespace cauldron
             {
                 // Asynchronously delete the active command list in the background once it's cleared the graphics queue
                 uint64_t                      signalValue     = m_pDevice->ExecuteCommandLists(m_vecCmdListsForFrame, CommandQueue::Graphics, false);
-                cauldron::GPUExecutionPacket* pInflightPacket = new GPUExecutionPacket(m_vecCmdListsForFrame, signalValue, m_pSwapChain->GetBackBufferIndex(), m_PerfFrameCount);
+                cauldron::GPUExecutionPacket* pInflightPacket = new GPUExecutionPacket(m_vecCmdListsForFrame, signalValue, m_PerfFrameCount, m_FrameID);
                 GetTaskManager()->AddTask(Task(std::bind(&Framework::DeleteCommandListAsync, this, std::placeholders::_1), reinterpret_cast<void*>(pInflightPacket)));
+
+                // Queue work that has to run after the frame on the GPU
+                if (m_PostSubmitFn)
+                    m_PostSubmitFn();
             }
 
             // End the frame of the profiler
@@ -1826,6 +1838,8 @@ namespace cauldron
             {
                 lastTime = currentTime;
                 json data = json::object({{"delta_ms", m_DeltaTime * 1000.0}});
+                if (m_TelemetryFn)
+                    m_TelemetryFn(data);
 
                 std::wstringstream ss;
                 ss << L"<TELEMETRY>";
@@ -2167,6 +2181,35 @@ namespace cauldron
         return m_pDynamicResourcePool->GetTexture(name);
     }
 
+    void Framework::SetRenderResourceSharing(const Texture* pTexture, std::vector<GPUResource*>& resources)
+    {
+        CauldronAssert(ASSERT_CRITICAL, m_Config.RenderResources.find(pTexture->GetDesc().Name) != m_Config.RenderResources.end(),
+                       L"Only render resources can be shared, %ls is not one", pTexture->GetDesc().Name.c_str());
+
+        // The resource being replaced may still be in use
+        GetDevice()->FlushQueue(CommandQueue::Graphics);
+        m_pDynamicResourcePool->SetSharedResources(pTexture, resources);
+        RebindResizableResources();
+    }
+
+    void Framework::RotateRenderResources(uint32_t index)
+    {
+        // No flush: parameter sets keep the views of every slot and pick the current one when bound, and raster views
+        // are only read when commands are recorded
+        m_pDynamicResourcePool->SetSharedResourceIndex(index);
+
+        std::lock_guard<std::mutex> lock(m_ResourceResizeMutex);
+        for (auto pListener : m_ResourceResizedListeners)
+            pListener->OnResourceRotated();
+    }
+
+    void Framework::RebindResizableResources()
+    {
+        std::lock_guard<std::mutex> lock(m_ResourceResizeMutex);
+        for (auto pListener : m_ResourceResizedListeners)
+            pListener->OnResourceResized();
+    }
+
     RenderModule* Framework::GetRenderModule(uint32_t order)
     {
         auto iter = m_RenderModules.begin() + order;
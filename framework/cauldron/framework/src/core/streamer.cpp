@@ -2,12 +2,23 @@
 #include "render/swapchain.h"
 #include "d3d12.h"
 
+#include <algorithm>
 #include <sstream>
 
-constexpr auto MOQ_PUB_PROCESS      = ".\\moq-pub.exe --name live ";
-constexpr auto FFMPEG_PROCESS_BEGIN = "ffmpeg -fflags nobuffer -y -f rawvideo -pixel_format rgba -video_size ";
-constexpr auto FFMPEG_PROCESS_INPUT = "-i - -c:v libx264 -preset ultrafast -tune zerolatency -pix_fmt yuv420p -vf setpts=N -video_track_timescale 1";
-constexpr auto FFMPEG_PROCESS_END   = "-f mp4 -movflags empty_moov+frag_every_frame+separate_moof+omit_tfhd_offset -";
+#if defined(_WIN32)
+constexpr auto MOQ_PUB_PROCESS = ".\\moq-pub.exe";
+#else
+constexpr auto MOQ_PUB_PROCESS = "./moq-pub";
+#endif
+
+// Frames the encoder does not start reading within this long are dropped instead of stalling the frame
+constexpr uint64_t ENCODER_WRITE_TIMEOUT_US = 100000;
+
+// A readback slot no frame is copied into
+constexpr uint64_t FREE_READBACK = UINT64_MAX;
+
+// How long the encoder gets to flush once its input is closed
+constexpr uint64_t PUBLISHER_STOP_TIMEOUT_US = 1000000;
 
 using namespace std::experimental;
 
@@ -15,16 +26,19 @@ namespace cauldron
 {
     void Streamer::Init()
     {
+        // The readback ring, every slot free
+        m_readbackDepth = std::max(GetConfig()->StreamingInfo.ReadbackDepth, 1u);
+        m_readbackSlots = std::make_unique<std::atomic<uint64_t>[]>(m_readbackDepth);
+        for (uint32_t i = 0; i < m_readbackDepth; i++)
+            m_readbackSlots[i] = FREE_READBACK;
+
         CreateEncoderAndPublisher();
     }
 
     void Streamer::Shutdown()
     {
-        if (m_isPipeOpen)
-        {
+        if (m_isStreaming)
             TerminatePublisher();
-            m_bufferCV.notify_all();
-        }
 
         // Dump the timing information
         {
@@ -73,145 +87,134 @@ namespace cauldron
 
     void Streamer::CreateEncoderAndPublisher()
     {
-        SECURITY_ATTRIBUTES saAttr;
-        saAttr.nLength              = sizeof(SECURITY_ATTRIBUTES);
-        saAttr.bInheritHandle       = TRUE;  // Allow the handle to be inherited
-        saAttr.lpSecurityDescriptor = NULL;
-
-        // Create a pipe for the child process's STDIN
-        HANDLE hChildStdinRd, hChildStdinWr;
-        CauldronThrowOnFail(CreatePipe(&hChildStdinRd, &hChildStdinWr, &saAttr, 0));
-        SetHandleInformation(hChildStdinWr, HANDLE_FLAG_INHERIT, 0);  // Ensure the write handle is not inherited
-
-        // Set up the STARTUPINFO structure
-        STARTUPINFO si = {sizeof(si)};
-        si.hStdInput   = hChildStdinRd;  // Redirect STDIN
-        si.dwFlags |= STARTF_USESTDHANDLES;
-
-        // Set up the PROCESS_INFORMATION structure
-        PROCESS_INFORMATION pi;
-        ZeroMemory(&pi, sizeof(PROCESS_INFORMATION));
-
-        // FFmpeg command to run with pipe input in Windows
-        std::stringstream command;
-        command << "cmd.exe /C ";
-        command << FFMPEG_PROCESS_BEGIN;
-        command << GetConfig()->Width << "x" << GetConfig()->Height << " ";
-        command << FFMPEG_PROCESS_INPUT << " " << FFMPEG_PROCESS_END;
-        command << " | " << MOQ_PUB_PROCESS << WStringToString(GetConfig()->StreamingInfo.Host) << ":" << GetConfig()->StreamingInfo.Port;
-
-        // Create the child process
-        if (!CreateProcess(NULL, const_cast<LPSTR>(command.str().c_str()), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
-        {
-            CloseHandle(hChildStdinRd);
-            CloseHandle(hChildStdinWr);
-            CauldronCritical(L"Failed to create FFmpeg process");
-        }
-
-        // Close the read end of the pipe in the parent process
-        CloseHandle(hChildStdinRd);
-
-        // Return the write handle to STDIN and the process information
-        m_isPipeOpen  = true;
-        m_hPipe       = hChildStdinWr;
-        m_piPublisher = pi;
+        std::stringstream relay;
+        relay << WStringToString(GetConfig()->StreamingInfo.Host) << ":" << GetConfig()->StreamingInfo.Port;
+
+        // The encoder makes fragmented MP4 of the frames, which the publisher sends to the relay
+        StreamCommand publisher;
+        publisher.program = MOQ_PUB_PROCESS;
+        publisher.args    = {"--name", "live", relay.str()};
+
+        StreamEncoderParams params;
+        params.width          = GetConfig()->Width;
+        params.height         = GetConfig()->Height;
+        params.publisher      = {publisher};
+        params.writeTimeoutUs = ENCODER_WRITE_TIMEOUT_US;
+
+        std::unique_ptr<StreamEncoder> pEncoder = std::make_unique<StreamPipeEncoder>();
+
+        // A frame in flight per readback slot, each one holds its slot until it is converted
+        StreamPipelineParams pipelineParams;
+        pipelineParams.width       = params.width;
+        pipelineParams.height      = params.height;
+        pipelineParams.maxInFlight = m_readbackDepth;
+
+        uint32_t rowPitch = GetConfig()->Width * GetResourceFormatStride(ResourceFormat::RGBA8_UINT);
+        pipelineParams.readback = [this, rowPitch](StreamPipelineFrame& frame) {
+            uint8_t*              pFrameData = nullptr;
+            std::function<void()> unmap      = GetFramework()->GetSwapChain()->CopyReadbackToMemory(&pFrameData, frame.slot);
+            CauldronAssert(ASSERT_CRITICAL, pFrameData != nullptr, L"Failed to copy encoder target data");
+            frame.pRgba    = pFrameData;
+            frame.rowPitch = rowPitch;
+
+            // Unmap the readback and give the slot back to the ring
+            frame.release = [this, unmap, slot = frame.slot]() {
+                unmap();
+                m_readbackSlots[slot] = FREE_READBACK;
+            };
+            return true;
+        };
+        pipelineParams.encoded = [this](const StreamPipelineFrame& frame, StreamWriteStatus status) {
+            if (status == StreamWriteStatus::Written)
+                ReportTiming(StreamTimingType::EncodeFrame, frame.tag);
+            else
+                Log::Write(LOGLEVEL_TRACE, L"The encoder is not keeping up, dropping frame %lld", frame.tag);
+        };
+
+        if (!m_pipeline.Start(std::move(pEncoder), params, pipelineParams))
+            CauldronCritical(L"Failed to create the stream encoder: %ls", StringToWString(m_pipeline.GetError()).c_str());
+
+        m_isStreaming = true;
     }
 
     void Streamer::TerminatePublisher()
     {
-        // Terminate the process
-        m_isPipeOpen = false;
-        TerminateProcess(m_piPublisher.hProcess, 0);
-        WaitForSingleObject(m_piPublisher.hProcess, INFINITE);
-        CloseHandle(m_piPublisher.hProcess);
-        CloseHandle(m_piPublisher.hThread);
+        // Closing the encoder ends the stream, the processes which don't finish in time are killed
+        m_isStreaming = false;
+        m_pipeline.Stop(PUBLISHER_STOP_TIMEOUT_US);
+
+        StreamPipelineStats stats = m_pipeline.GetStats();
+        Log::Write(LOGLEVEL_INFO,
+                   L"Stream: %llu frames encoded, %llu dropped, %llu not copied, %llu late, %llu encoder restarts",
+                   stats.encoded,
+                   stats.dropped,
+                   stats.skipped,
+                   stats.late,
+                   stats.restarts);
+        Log::Write(LOGLEVEL_INFO,
+                   L"Stream readback ring: %u slots, %.2f in use on average, %llu at most, %llu frames dropped with the ring full, %llu with the pipeline full",
+                   m_readbackDepth,
+                   m_readbackStats.samples ? static_cast<double>(m_readbackStats.occupancySum) / m_readbackStats.samples : 0.0,
+                   m_readbackStats.occupancyMax,
+                   m_readbackStats.ringFull,
+                   stats.reserveTimeouts);
     }
 
-    void Streamer::Encode(uint8_t backbufferIndex, int64_t frameIndex)
+    void Streamer::Encode(uint64_t renderFrameID, int64_t frameIndex)
     {
         // Record when the frame has finished rendering
         ReportTiming(StreamTimingType::EndFrame, frameIndex);
 
-        // Don't waste time if the pipe is closed
-        if (!m_isPipeOpen)
+        // Don't waste time if the stream is closed
+        if (!m_isStreaming)
             return;
 
-        // Wait until the slot is empty and it's our turn
-        // If the frame index is negative, it's a bootstrapping frame and let it pass
-        if (frameIndex >= 0)
-        {
-            std::unique_lock<std::mutex> lock(m_bufferMutex);
-            m_bufferCV.wait(lock, [&] { return m_frameIndex == frameIndex || !m_isPipeOpen; });
-        }
+        // Hand the frame over, the pipeline puts the frames back in order. A frame the renderer did not copy only
+        // tells it not to wait for the frame. Bootstrapping frames only hand their readback back.
+        uint32_t slot = 0;
+        while (slot < m_readbackDepth && m_readbackSlots[slot] != renderFrameID)
+            slot++;
+        if (slot < m_readbackDepth)
+            m_pipeline.Submit(static_cast<int64_t>(renderFrameID), slot, frameIndex >= 0, frameIndex);
+        else
+            m_pipeline.Skip(static_cast<int64_t>(renderFrameID));
+
+        // If the encoder could not be restarted, stop copying frames for it
+        if (!m_pipeline.IsStreaming() && m_isStreaming.exchange(false))
+            CauldronWarning(L"Failed to encode frame data, disabling streaming: %ls", StringToWString(m_pipeline.GetError()).c_str());
+    }
 
-        // Again, don't waste time if the pipe is closed
-        if (!m_isPipeOpen)
+    void Streamer::ExecuteCopyCommand(CommandList* pCmdList)
+    {
+        if (!m_isStreaming)
             return;
 
-        // Copy the encoder target to system memory
-        uint8_t* pFrameData  = nullptr;
-        auto     releaseFunc = GetFramework()->GetSwapChain()->CopyReadbackToMemory(&pFrameData, backbufferIndex);
-        CauldronAssert(ASSERT_CRITICAL, pFrameData != nullptr, L"Failed to copy encoder target data");
-
+        // Find a free readback slot, the frames in flight hold theirs until they are converted
+        uint32_t slot     = m_readbackDepth;
+        uint32_t occupied = 0;
+        for (uint32_t i = 0; i < m_readbackDepth; i++)
         {
-            // Only one thread can pipe data to FFmpeg at a time
-            std::lock_guard<std::mutex> lock(m_encodeMutex);
-
-            // Don't send bootstrapping frames
-            if (frameIndex < 0)
-            {
-                releaseFunc();
-                return;
-            }
-
-            // Backbuffer might've queued up while the pipe was closed
-            if (!m_isPipeOpen || !pFrameData)
-                goto fail;
-
-            int      tries        = 0;
-            uint32_t frameSize    = GetConfig()->Width * GetConfig()->Height * GetResourceFormatStride(ResourceFormat::RGBA8_UINT);
-            DWORD   bytesWritten = 0;
-
-            while (tries < 3)
-            {
-                // Write the frame data to FFmpeg pipe
-                WriteFile(m_hPipe, pFrameData, frameSize, &bytesWritten, NULL);
-
-                // Check if the pipe is still open
-                if (bytesWritten == frameSize)
-                {
-                    FlushFileBuffers(m_hPipe);
-                    ReportTiming(StreamTimingType::EncodeFrame, frameIndex);
-                    goto release;
-                }
-
-                // If the pipe is closed, try to reopen it
-                TerminatePublisher();
-                CreateEncoderAndPublisher();
-                tries++;
-            }
-
-        fail:
-            CauldronWarning(L"Failed to pipe frame data to FFmpeg, disabling streaming...");
-            TerminatePublisher();
-
-        release:
-            // Free the frame data
-            releaseFunc();
-
-            // Update the frame index and notify other threads
-            m_frameIndex++;
-            m_bufferCV.notify_all();
+            if (m_readbackSlots[i] != FREE_READBACK)
+                occupied++;
+            else if (slot == m_readbackDepth)
+                slot = i;
         }
-    }
+        m_readbackStats.occupancySum += occupied;
+        m_readbackStats.occupancyMax = std::max(m_readbackStats.occupancyMax, static_cast<uint64_t>(occupied));
+        m_readbackStats.samples++;
 
-    void Streamer::ExecuteCopyCommand(CommandList* pCmdList)
-    {
-        if (!m_isPipeOpen)
+        // Drop the frame rather than wait when the ring or the pipeline is full, so the encoder never holds up rendering
+        if (slot == m_readbackDepth)
+        {
+            m_readbackStats.ringFull++;
+            return;
+        }
+        if (!m_pipeline.Reserve(0))
             return;
 
-        // Copy the encoder target to the swap chain
-        GetFramework()->GetSwapChain()->CopySwapChainToReadback(pCmdList);
+        // Copy the encoder target into the slot
+        GetFramework()->GetSwapChain()->CopySwapChainToReadback(pCmdList, slot, m_readbackDepth);
+        m_readbackSlots[slot] = GetFramework()->GetFrameID();
     }
 
 }  // namespace cauldron
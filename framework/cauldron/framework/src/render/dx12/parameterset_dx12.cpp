@@ -217,13 +217,13 @@ namespace cauldron
                 if (m_pImmediateResourceViews)
                     SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &m_pImmediateResourceViews->GetViewInfo(desc.BaseShaderRegister + m_ImmediateTypeOffsets[static_cast<uint32_t>(BindingType::TextureSRV)]));
                 else
-                    SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &m_pTextureSRVResourceViews->GetViewInfo(desc.BaseShaderRegister));
+                    SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &GetTextureSRVViews()->GetViewInfo(desc.BaseShaderRegister));
                 break;
             case BindingType::TextureUAV:
                 if (m_pImmediateResourceViews)
                     SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &m_pImmediateResourceViews->GetViewInfo(desc.BaseShaderRegister + m_ImmediateTypeOffsets[static_cast<uint32_t>(BindingType::TextureUAV)]));
                 else
-                    SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &m_pTextureUAVResourceViews->GetViewInfo(desc.BaseShaderRegister));
+                    SetGraphicsRootResourceView(pCmdList, desc.BindingIndex, &GetTextureUAVViews()->GetViewInfo(desc.BaseShaderRegister));
                 break;
             case BindingType::BufferSRV:
                 if (m_pImmediateResourceViews)
@@ -268,13 +268,13 @@ namespace cauldron
                 if (m_pImmediateResourceViews)
                     SetComputeRootResourceView(pCmdList, desc.BindingIndex, &m_pImmediateResourceViews->GetViewInfo(desc.BaseShaderRegister + m_ImmediateTypeOffsets[static_cast<uint32_t>(BindingType::TextureSRV)]));
                 else
-                    SetComputeRootResourceView(pCmdList, desc.BindingIndex, &m_pTextureSRVResourceViews->GetViewInfo(desc.BaseShaderRegister));
+                    SetComputeRootResourceView(pCmdList, desc.BindingIndex, &GetTextureSRVViews()->GetViewInfo(desc.BaseShaderRegister));
                 break;
             case BindingType::TextureUAV:
                 if (m_pImmediateResourceViews)
                     SetComputeRootResourceView(pCmdList, desc.BindingIndex, &m_pImmediateResourceViews->GetViewInfo(desc.BaseShaderRegister + m_ImmediateTypeOffsets[static_cast<uint32_t>(BindingType::TextureUAV)]));
                 else
-                    SetComputeRootResourceView(pCmdList, desc.BindingIndex, &m_pTextureUAVResourceViews->GetViewInfo(desc.BaseShaderRegister));
+                    SetComputeRootResourceView(pCmdList, desc.BindingIndex, &GetTextureUAVViews()->GetViewInfo(desc.BaseShaderRegister));
                 break;
             case BindingType::BufferSRV:
                 if (m_pImmediateResourceViews)
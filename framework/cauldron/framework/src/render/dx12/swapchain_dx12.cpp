@@ -129,12 +129,6 @@ namespace cauldron
             if (readback)
                 readback->Release();
         }
-
-        for (auto fence : m_pSwapChainReadbackFences)
-        {
-            if (fence)
-                fence->Release();
-        }
     }
 
     void SwapChainInternal::OnResize(uint32_t width, uint32_t height)
@@ -184,21 +178,25 @@ namespace cauldron
         }
     }
 
-    void SwapChainInternal::CopySwapChainToReadback(CommandList* pCmdList)
+    void SwapChainInternal::CopySwapChainToReadback(CommandList* pCmdList, uint32_t slot, uint32_t slotCount)
     {
         D3D12_RESOURCE_DESC fromDesc     = m_pRenderTarget->GetCurrentResource()->GetImpl()->DX12Desc();
         size_t              resourceSize = fromDesc.Width * fromDesc.Height * GetResourceFormatStride(m_pRenderTarget->GetFormat());
 
-        // Resize the vectors if needed
-        if (m_pSwapChainReadbackTargets.size() != m_SwapChainDesc.BufferCount)
+        // Resize the ring if needed, the slots past the new count are released
+        CauldronAssert(ASSERT_CRITICAL, slot < slotCount, L"Readback slot out of range");
+        if (m_pSwapChainReadbackTargets.size() != slotCount)
         {
-            m_pSwapChainReadbackTargets.resize(m_SwapChainDesc.BufferCount);
-            m_pSwapChainReadbackFences.resize(m_SwapChainDesc.BufferCount);
+            for (size_t i = slotCount; i < m_pSwapChainReadbackTargets.size(); i++)
+            {
+                if (m_pSwapChainReadbackTargets[i])
+                    m_pSwapChainReadbackTargets[i]->Release();
+            }
+            m_pSwapChainReadbackTargets.resize(slotCount, nullptr);
         }
 
-        // Get the readback resource and fence for the current back buffer
-        ID3D12Resource** pResourceReadback = &m_pSwapChainReadbackTargets[m_CurrentBackBuffer];
-        ID3D12Fence**    pFenceReadback    = &m_pSwapChainReadbackFences[m_CurrentBackBuffer];
+        // Get the readback resource of the slot
+        ID3D12Resource** pResourceReadback = &m_pSwapChainReadbackTargets[slot];
 
         // Create a readback buffer if it doesn't exist or if the size has changed
         if (*pResourceReadback == nullptr || (*pResourceReadback)->GetDesc().Width != resourceSize)
@@ -226,19 +224,6 @@ namespace cauldron
 
             CauldronThrowOnFail(GetDevice()->GetImpl()->DX12Device()->CreateCommittedResource(
                 &readBackHeapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(pResourceReadback)));
-
-            // Create a fence for the readback buffer
-            if (*pFenceReadback == nullptr)
-                CauldronThrowOnFail(GetDevice()->GetImpl()->DX12Device()->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(pFenceReadback)));
-        }
-
-        // Wait for the fence to be signaled
-        if ((*pFenceReadback)->GetCompletedValue() != 0)
-        {
-            HANDLE mHandleFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            CauldronThrowOnFail((*pFenceReadback)->SetEventOnCompletion(0, mHandleFenceEvent));
-            WaitForSingleObject(mHandleFenceEvent, INFINITE);
-            CloseHandle(mHandleFenceEvent);
         }
 
         // Transition the swap chain buffer to a copy source
@@ -261,25 +246,12 @@ namespace cauldron
         barrier = Barrier::Transition(
             m_pRenderTarget->GetCurrentResource(), ResourceState::CopySource, ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource);
         ResourceBarrier(pCmdList, 1, &barrier);
-
-        // Signal the fence
-        CauldronThrowOnFail(GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics)->Signal(*pFenceReadback, 1));
     }
 
-    std::function<void()> SwapChainInternal::CopyReadbackToMemory(uint8_t** ppData, uint8_t at)
+    std::function<void()> SwapChainInternal::CopyReadbackToMemory(uint8_t** ppData, uint32_t slot)
     {
-        // Get the readback resource and fence for the current back buffer
-        ID3D12Resource** pResourceReadback = &m_pSwapChainReadbackTargets[at];
-        ID3D12Fence**    pFenceReadback    = &m_pSwapChainReadbackFences[at];
-
-        // Wait for the fence to be signaled
-        if ((*pFenceReadback)->GetCompletedValue() != 1)
-        {
-            HANDLE mHandleFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            CauldronThrowOnFail((*pFenceReadback)->SetEventOnCompletion(1, mHandleFenceEvent));
-            WaitForSingleObject(mHandleFenceEvent, INFINITE);
-            CloseHandle(mHandleFenceEvent);
-        }
+        // Get the readback resource of the slot, the command list copying into it has completed
+        ID3D12Resource** pResourceReadback = &m_pSwapChainReadbackTargets[slot];
 
         // Get the size of the frame
         D3D12_RESOURCE_DESC fromDesc     = (*pResourceReadback)->GetDesc();
@@ -290,12 +262,10 @@ namespace cauldron
         range.Begin = 0;
         range.End   = resourceSize;
         CauldronThrowOnFail((*pResourceReadback)->Map(0, &range, reinterpret_cast<void**>(ppData)));
-        return [pResourceReadback, pFenceReadback]() {
-            // Unmap the resource
-            (*pResourceReadback)->Unmap(0, NULL);
-            
-            // Signal the fence
-            CauldronThrowOnFail(GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics)->Signal(*pFenceReadback, 0));
+        return [pResourceReadback]() {
+            // Unmap the resource, the owner of the ring may copy into the slot again
+            D3D12_RANGE written = {0, 0};
+            (*pResourceReadback)->Unmap(0, &written);
         };
     }
 
@@ -63,8 +63,8 @@ namespace cauldron
         void WaitForSwapChain() override;
         void Present() override;
         
-        void CopySwapChainToReadback(CommandList* pCmdList) override;
-        std::function<void()> CopyReadbackToMemory(uint8_t** ppData, uint8_t at) override;
+        void CopySwapChainToReadback(CommandList* pCmdList, uint32_t slot, uint32_t slotCount) override;
+        std::function<void()> CopyReadbackToMemory(uint8_t** ppData, uint32_t slot) override;
 
         void DumpSwapChainToFile(std::experimental::filesystem::path filePath) override;
 
@@ -92,9 +92,8 @@ namespace cauldron
         Microsoft::WRL::ComPtr<IDXGISwapChain4> m_pSwapChain = nullptr;
         DXGI_SWAP_CHAIN_DESC1                   m_SwapChainDesc = {};
 
-        // Internal resource ring buffer
+        // Internal resource ring buffer, the slots are handed out by the streamer
         std::vector<ID3D12Resource*> m_pSwapChainReadbackTargets;
-        std::vector<ID3D12Fence*>    m_pSwapChainReadbackFences;
 
         std::vector<Microsoft::WRL::ComPtr<IDXGIOutput6>>       m_pAttachedOutputs;
         Microsoft::WRL::ComPtr<IDXGIOutput6>                    m_pCurrentOutput;
@@ -26,6 +26,8 @@
 #include "render/texture.h"
 #include "render/buffer.h"
 
+#include <algorithm>
+
 namespace cauldron
 {
     DynamicResourcePool::DynamicResourcePool()
@@ -52,6 +54,35 @@ namespace cauldron
             t->OnRenderingResolutionResize(resInfo.DisplayWidth, resInfo.DisplayHeight, resInfo.RenderWidth, resInfo.RenderHeight);
         for (auto b : m_ResizableBuffers)
             b->OnRenderingResolutionResize(resInfo.DisplayWidth, resInfo.DisplayHeight, resInfo.RenderWidth, resInfo.RenderHeight);
+
+        // Resized textures dropped their shared resources
+        m_SharedTextures.erase(std::remove_if(m_SharedTextures.begin(), m_SharedTextures.end(), [](Texture* pTex) { return !pTex->GetSharedResourceCount(); }),
+                               m_SharedTextures.end());
+    }
+
+    void DynamicResourcePool::SetSharedResources(const Texture* pTexture, std::vector<GPUResource*>& resources)
+    {
+        std::lock_guard<std::mutex> lock(m_CriticalSection);
+
+        auto texPairItr = std::find_if(m_Textures.begin(), m_Textures.end(), [pTexture](const std::pair<std::wstring, Texture*>& texEntry) { return texEntry.second == pTexture; });
+        CauldronAssert(ASSERT_CRITICAL, texPairItr != m_Textures.end(), L"DynamicResourcePool: %ls is not a pool texture.", pTexture->GetDesc().Name.c_str());
+
+        Texture* pTex = texPairItr->second;
+        pTex->SetSharedResources(resources);
+
+        auto sharedItr = std::find(m_SharedTextures.begin(), m_SharedTextures.end(), pTex);
+        if (resources.empty() && sharedItr != m_SharedTextures.end())
+            m_SharedTextures.erase(sharedItr);
+        else if (!resources.empty() && sharedItr == m_SharedTextures.end())
+            m_SharedTextures.push_back(pTex);
+    }
+
+    void DynamicResourcePool::SetSharedResourceIndex(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock(m_CriticalSection);
+
+        for (auto t : m_SharedTextures)
+            t->SetSharedResourceIndex(index);
     }
 
     void DynamicResourcePool::DestroyResource(const GPUResource* pResource)
@@ -132,6 +132,7 @@ namespace cauldron
         if (m_Immediate)
             return;
 
+        DestroySharedSlotViews();
         delete m_pTextureSRVResourceViews;
         delete m_pTextureUAVResourceViews;
         delete m_pBufferSRVResourceViews;
@@ -159,6 +160,12 @@ namespace cauldron
         m_BoundTextureSRVs[slotIndex].ArraySize = arraySize;
         m_BoundTextureSRVs[slotIndex].FirstSlice = firstSlice;
 
+        // Keep the views of every shared resource slot up to date
+        if (pTexture->GetSharedResourceCount() > m_SharedSlotCount)
+            CreateSharedSlotViews();
+        else
+            BindSharedSlotViews(m_SharedTextureSRVResourceViews, m_BoundTextureSRVs[slotIndex], ResourceViewType::TextureSRV, slotIndex);
+
         // Check if the set has resizable resources
         CheckResizable();
 
@@ -184,6 +191,12 @@ namespace cauldron
         m_BoundTextureUAVs[slotIndex].ArraySize = arraySize;
         m_BoundTextureUAVs[slotIndex].FirstSlice = firstSlice;
 
+        // Keep the views of every shared resource slot up to date
+        if (pTexture->GetSharedResourceCount() > m_SharedSlotCount)
+            CreateSharedSlotViews();
+        else
+            BindSharedSlotViews(m_SharedTextureUAVResourceViews, m_BoundTextureUAVs[slotIndex], ResourceViewType::TextureUAV, slotIndex);
+
         // Check if the set has resizable resources
         CheckResizable();
 
@@ -320,6 +333,96 @@ namespace cauldron
         }
 
         // Add CBV support when necessary
+
+        // Shared resources came or went
+        CreateSharedSlotViews();
+    }
+
+    ResourceView* ParameterSet::GetTextureSRVViews() const
+    {
+        if (m_SharedTextureSRVResourceViews.empty())
+            return m_pTextureSRVResourceViews;
+        return m_SharedTextureSRVResourceViews[m_pSharedTexture->GetSharedResourceIndex()];
+    }
+
+    ResourceView* ParameterSet::GetTextureUAVViews() const
+    {
+        if (m_SharedTextureUAVResourceViews.empty())
+            return m_pTextureUAVResourceViews;
+        return m_SharedTextureUAVResourceViews[m_pSharedTexture->GetSharedResourceIndex()];
+    }
+
+    void ParameterSet::CreateSharedSlotViews()
+    {
+        if (m_Immediate)
+            return;
+
+        // The bound textures with shared resources all rotate through as many, follow one of them
+        uint32_t       slotCount      = 0;
+        const Texture* pSharedTexture = nullptr;
+        for (const std::vector<BoundResource>* pBound : {&m_BoundTextureSRVs, &m_BoundTextureUAVs})
+        {
+            for (const BoundResource& b : *pBound)
+            {
+                if (b.pTexture != nullptr && b.pTexture->GetSharedResourceCount() > slotCount)
+                {
+                    slotCount      = b.pTexture->GetSharedResourceCount();
+                    pSharedTexture = b.pTexture;
+                }
+            }
+        }
+
+        if (slotCount != m_SharedSlotCount)
+        {
+            DestroySharedSlotViews();
+            for (uint32_t s = 0; s < slotCount; ++s)
+            {
+                if (m_pTextureSRVResourceViews != nullptr)
+                {
+                    m_SharedTextureSRVResourceViews.push_back(nullptr);
+                    GetResourceViewAllocator()->AllocateGPUResourceViews(&m_SharedTextureSRVResourceViews.back(), m_TextureSRVCount * m_BufferedSetCount);
+                }
+                if (m_pTextureUAVResourceViews != nullptr)
+                {
+                    m_SharedTextureUAVResourceViews.push_back(nullptr);
+                    GetResourceViewAllocator()->AllocateGPUResourceViews(&m_SharedTextureUAVResourceViews.back(), m_TextureUAVCount * m_BufferedSetCount);
+                }
+            }
+            m_SharedSlotCount = slotCount;
+        }
+        m_pSharedTexture = pSharedTexture;
+
+        for (uint32_t i = 0; i < m_BoundTextureSRVs.size(); ++i)
+            BindSharedSlotViews(m_SharedTextureSRVResourceViews, m_BoundTextureSRVs[i], ResourceViewType::TextureSRV, i);
+        for (uint32_t i = 0; i < m_BoundTextureUAVs.size(); ++i)
+            BindSharedSlotViews(m_SharedTextureUAVResourceViews, m_BoundTextureUAVs[i], ResourceViewType::TextureUAV, i);
+    }
+
+    void ParameterSet::DestroySharedSlotViews()
+    {
+        for (ResourceView* pViews : m_SharedTextureSRVResourceViews)
+            delete pViews;
+        for (ResourceView* pViews : m_SharedTextureUAVResourceViews)
+            delete pViews;
+        m_SharedTextureSRVResourceViews.clear();
+        m_SharedTextureUAVResourceViews.clear();
+        m_SharedSlotCount = 0;
+        m_pSharedTexture  = nullptr;
+    }
+
+    void ParameterSet::BindSharedSlotViews(std::vector<ResourceView*>& slotViews, const BoundResource& bound, ResourceViewType type, uint32_t index)
+    {
+        if (bound.pTexture == nullptr || slotViews.empty())
+            return;
+
+        // Textures without shared resources look the same in every slot
+        uint32_t sharedCount = bound.pTexture->GetSharedResourceCount();
+        CauldronAssert(ASSERT_CRITICAL, !sharedCount || sharedCount == slotViews.size(), L"Textures with shared resources bound to the same parameter set need as many of them");
+        for (uint32_t s = 0; s < slotViews.size(); ++s)
+        {
+            const GPUResource* pResource = sharedCount ? bound.pTexture->GetSharedResource(s) : bound.pTexture->GetResource();
+            slotViews[s]->BindTextureResource(pResource, bound.pTexture->GetDesc(), type, bound.Dimension, bound.Mip, bound.ArraySize, bound.FirstSlice, index);
+        }
     }
 
     void ParameterSet::CheckResizable()
@@ -21,6 +21,7 @@
 // THE SOFTWARE.
 
 #include "render/texture.h"
+#include "render/gpuresource.h"
 #include "core/framework.h"
 #include "misc/assert.h"
 
@@ -50,6 +51,9 @@ namespace cauldron
 
     Texture::~Texture()
     {
+        std::vector<GPUResource*> noResources;
+        SetSharedResources(noResources);
+
         delete m_pResource;
     }
 
@@ -57,6 +61,10 @@ namespace cauldron
     {
         CauldronAssert(ASSERT_CRITICAL, m_ResizeFn != nullptr, L"There's no method to resize the texture");
 
+        // Shared resources are laid out for the old size, whoever set them sets new ones
+        std::vector<GPUResource*> noResources;
+        SetSharedResources(noResources);
+
         // get the new information
         m_ResizeFn(m_TextureDesc, outputWidth, outputHeight, renderingWidth, renderingHeight);
 
@@ -64,6 +72,41 @@ namespace cauldron
         Recreate();
     }
 
+    void Texture::SetSharedResources(std::vector<GPUResource*>& resources)
+    {
+        // Release the previous ones and go back to our own resource
+        if (m_pOwnResource)
+        {
+            for (GPUResource* pResource : m_SharedResources)
+                delete pResource;
+            m_SharedResources.clear();
+            m_SharedResourceIndex = 0;
+
+            m_pResource    = m_pOwnResource;
+            m_pOwnResource = nullptr;
+        }
+
+        if (resources.empty())
+            return;
+
+        for (GPUResource* pResource : resources)
+        {
+            CauldronAssert(ASSERT_CRITICAL, pResource->IsResizable(), L"Shared resources of %ls have to be resizable for their views to be rebound", m_TextureDesc.Name.c_str());
+            pResource->SetOwner(this);
+        }
+
+        m_SharedResources = resources;
+        m_pOwnResource    = m_pResource;
+        m_pResource       = m_SharedResources[0];
+    }
+
+    void Texture::SetSharedResourceIndex(uint32_t index)
+    {
+        CauldronAssert(ASSERT_CRITICAL, index < m_SharedResources.size(), L"Shared resource index out of bounds.");
+        m_pResource           = m_SharedResources[index];
+        m_SharedResourceIndex = index;
+    }
+
     //////////////////////////////////////////////////////////////////////////
     // SwapChainRenderTarget
 
@@ -541,6 +541,12 @@ namespace cauldron
         }
     }
 
+    void ParameterSetInternal::OnResourceRotated()
+    {
+        // The descriptor sets would have to be rewritten while frames in flight still use them
+        CauldronCritical(L"Shared render resources can't be rotated with Vulkan");
+    }
+
     void ParameterSetInternal::OnResourceResized()
     {
         ParameterSet::OnResourceResized();
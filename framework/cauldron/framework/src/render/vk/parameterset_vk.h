@@ -42,6 +42,8 @@ namespace cauldron
 
         virtual void OnResourceResized() override;
 
+        virtual void OnResourceRotated() override;
+
     private:
         friend class ParameterSet;
         ParameterSetInternal(RootSignature* pRootSignature, ResourceView* pImmediateViews);
@@ -37,7 +37,7 @@ console in JSON format.
 pyautogui.FAILSAFE = False
 SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
 FSR_DIR = os.path.join(SCRIPT_DIR, "bin")
-TSR_SHARED_BUFFER_COUNT = 10
+TSR_SHARED_BUFFER_COUNT = 10  # Allocated shared buffers, with AdaptiveSlots the renderer may use fewer
 
 UPSCALERS = [
     "Native",
@@ -206,6 +206,31 @@ def get_config(mode, opts):
             "DLSSUpscaleRenderModule"
         ]["mode"] = (DLSS_MODES.index(opts.dlssMode) + 1)
 
+    # Apply the fan-out settings, every upscaler reads the frames of one renderer
+    for module_mode in ("Renderer", "Upscaler"):
+        tmp["FidelityFX FSR"]["TSR"]["RenderModuleOverrides"][module_mode][
+            "TSRRenderModule"
+        ]["Consumers"] = opts.consumers
+    tmp["FidelityFX FSR"]["TSR"]["RenderModuleOverrides"]["Upscaler"][
+        "TSRRenderModule"
+    ]["ConsumerIndex"] = opts.consumer_index
+
+    # Apply the fan-in settings, one upscaler serves the renderers started with --session
+    if opts.session_policy:
+        tmp["FidelityFX FSR"]["TSR"]["RenderModuleOverrides"]["Upscaler"][
+            "TSRRenderModule"
+        ]["Sessions"] = {"Policy": opts.session_policy}
+    if opts.session_deadline:
+        tmp["FidelityFX FSR"]["TSR"]["RenderModuleOverrides"]["Renderer"][
+            "TSRRenderModule"
+        ]["SessionDeadlineMs"] = opts.session_deadline
+
+    # Apply the liveness settings, a renderer without upscaler upscales by itself until one comes back
+    for module_mode in ("Renderer", "Upscaler"):
+        tmp["FidelityFX FSR"]["TSR"]["RenderModuleOverrides"][module_mode][
+            "TSRRenderModule"
+        ]["PeerTimeoutMs"] = opts.peer_timeout
+
     # Apply streaming settings
     if opts.stream and mode in ("Default", "Upscaler"):
         tmp["FidelityFX FSR"]["Stream"] = {
@@ -319,6 +344,41 @@ def parse_args():
         default=False,
         help="Skip the upscaler process",
     )
+    parser.add_argument(
+        "--consumers",
+        type=int,
+        default=1,
+        help="Number of upscalers reading the frames of the renderer, the others are launched with --skip-renderer and --consumer-index",
+    )
+    parser.add_argument(
+        "--consumer-index",
+        type=int,
+        default=0,
+        help="Index of the launched upscaler among the --consumers upscalers",
+    )
+    parser.add_argument(
+        "--session",
+        type=str,
+        help="Run the renderer as a session of an upscaler shared with other renderers, the others are launched with --skip-upscaler and their own --session",
+    )
+    parser.add_argument(
+        "--session-policy",
+        type=str,
+        choices=["RoundRobin", "Deadline"],
+        help="Let the upscaler serve the sessions of several renderers, picking their frames with the given policy",
+    )
+    parser.add_argument(
+        "--session-deadline",
+        type=float,
+        default=0.0,
+        help="Time in ms a frame of the session may wait for the upscaler, for the Deadline policy",
+    )
+    parser.add_argument(
+        "--peer-timeout",
+        type=float,
+        default=2000.0,
+        help="Time in ms without a heartbeat after which the other TSR process is taken for dead (0 to wait forever)",
+    )
     parser.add_argument(
         "--use-default",
         action="store_true",
@@ -397,6 +457,11 @@ def parse_args():
         default=False,
         help="Enable cursor jitter",
     )
+    parser.add_argument(
+        "--transfer-chart",
+        type=str,
+        help="Save a chart of where the TSR transfers spend their time to this image, needs --benchmark",
+    )
     return parser.parse_args()
 
 
@@ -432,7 +497,7 @@ def close_by_pid(pid):
 
 
 def get_process_args(
-    mode, screenshot_mode=None, duration=0, has_fg=False, hide_ui=False
+    mode, screenshot_mode=None, duration=0, has_fg=False, hide_ui=False, session=None
 ):
     if screenshot_mode == "video":
         screenshot = "-screenshot-for-video"
@@ -446,6 +511,7 @@ def get_process_args(
             screenshot if mode != "Renderer" else ""
         ),  # Always ignore screenshot for renderer
         "-hide-ui" if hide_ui else "",
+        *(["-session", session] if session and mode == "Renderer" else []),
         "-displaymode",
         "DISPLAYMODE_LDR",
         "-benchmark",
@@ -542,6 +608,7 @@ def main(opts):
                     duration=opts.benchmark * opts.fps,
                     has_fg=opts.upscaler in FRAME_GENERATION,
                     hide_ui=opts.hide_ui,
+                    session=opts.session,
                 ),
             ],
             cwd=FSR_DIR,
@@ -690,6 +757,7 @@ def main(opts):
 
     dots = 0
     start_time = time.time()
+    transfer_samples = {}
     if opts.structured_logs:
         print("TEST_START", utcnow_iso8601())
         sys.stdout.flush()
@@ -747,13 +815,24 @@ def main(opts):
             if not data:
                 continue
 
+            values = json.loads(data.group(1).decode().strip())
+            if "tsr_transfer" in values:
+                transfer_samples.setdefault(p.pid, []).append(
+                    (time.time() - start_time, values["tsr_transfer"])
+                )
+
             if opts.structured_logs:
                 print(f"TELEMETRY_{p.pid}", line.decode().strip())
                 sys.stdout.flush()
             else:
-                values = json.loads(data.group(1).decode().strip())
+                slots = f" slots={values['tsr_active_slots']}" if "tsr_active_slots" in values else ""
+                transfer = (
+                    f" transfer={values['tsr_transfer']['gpu_us']['mean'] / 1000:.3f}ms"
+                    if "tsr_transfer" in values
+                    else ""
+                )
                 print(
-                    f"Got telemetry for {p.pid}: min={values['delta_ms']:.4f}ms{'.' * dots + ' ' * (4 - dots)}",
+                    f"Got telemetry for {p.pid}: min={values['delta_ms']:.4f}ms{slots}{transfer}{'.' * dots + ' ' * (4 - dots)}",
                     end="\r",
                 )
 
@@ -771,11 +850,71 @@ def main(opts):
     else:
         print()
         print("Process(es) finished")
+
+    if opts.transfer_chart:
+        save_transfer_chart(transfer_samples, opts.transfer_chart)
     cleanup(None, None)
 
     return renderer.pid if opts.use_default else upscaler.pid
 
 
+TRANSFER_STAGES = [
+    ("acquire_us", "slot wait"),
+    ("record_us", "recording (CPU)"),
+    ("submit_us", "submit and signal (CPU)"),
+    ("barrier_us", "barriers (GPU)"),
+    ("copy_us", "copies (GPU)"),
+]
+
+
+def save_transfer_chart(samples, path):
+    if not samples:
+        print("No TSR transfer telemetry to chart, was --benchmark set?")
+        return
+
+    # One row per process: the mean of every stage, and the copy time of every plane
+    fig, axes = plt.subplots(
+        len(samples), 2, figsize=(16 * 1.5, 4.5 * len(samples)), squeeze=False
+    )
+    for row, (pid, values) in enumerate(samples.items()):
+        times = [t for t, _ in values]
+        direction = values[-1][1]["direction"]
+
+        stages, planes = axes[row]
+        stages.stackplot(
+            times,
+            [[v[key]["mean"] / 1000 for _, v in values] for key, _ in TRANSFER_STAGES],
+            labels=[label for _, label in TRANSFER_STAGES],
+        )
+        stages.set_title(f"{pid} ({direction}): mean per frame")
+        stages.set_xlabel("s")
+        stages.set_ylabel("ms")
+        stages.legend(loc="upper left")
+
+        names = {plane["name"] for _, v in values for plane in v["planes"]}
+        for name in sorted(names):
+            planes.plot(
+                times,
+                [
+                    next(
+                        (p["copy_us"]["mean"] / 1000 for p in v["planes"] if p["name"] == name),
+                        0,
+                    )
+                    for _, v in values
+                ],
+                label=name,
+            )
+        planes.set_title(f"{pid} ({direction}): GPU copy per plane")
+        planes.set_xlabel("s")
+        planes.set_ylabel("ms")
+        planes.legend(loc="upper left")
+
+    fig.tight_layout()
+    fig.savefig(path)
+    plt.close(fig)
+    print(f"Transfer chart saved to {path}")
+
+
 def load_image_for_pid(pid):
     image_path = glob(os.path.join(FSR_DIR, "benchmark", f"*_{pid}_*.jpg"))
     assert len(image_path) == 1, "Could not find the image"
@@ -793,6 +932,12 @@ if __name__ == "__main__":
     if args.skip_renderer and args.skip_upscaler:
         raise ValueError("Both renderer and upscaler cannot be skipped")
 
+    if not 1 <= args.consumers <= 8 or not 0 <= args.consumer_index < args.consumers:
+        raise ValueError("Invalid upscaler index or count")
+
+    if args.session_policy and not args.session and not args.skip_renderer:
+        raise ValueError("The renderer of a session upscaler needs a --session")
+
     # Run with the requested arguments
     test_pid = main(args)
     sys.stdout.flush()
@@ -119,9 +119,19 @@ void FSRSample::ParseSampleConfig()
     // Get the correct render module overrides
     configData["RenderModuleOverrides"] = tsrConfig["RenderModuleOverrides"][opMode];
 
+    // Both processes have to describe the shared resources the same way, so the manifest is shared by all modes
+    if (tsrConfig.contains("Resources"))
+        configData["RenderModuleOverrides"]["TSRRenderModule"]["Resources"] = tsrConfig["Resources"];
+
     // Set the startup upscaler method
     m_UIMethod = tsrConfig["Upscaler"].get<UpscaleMethod>();
 
+    // A renderer that lost its upscaler can only run the filtering upscalers itself, the others need the upscaler SDKs
+    m_FallbackMethod = tsrConfig.value("FallbackUpscaler", UpscaleMethod::Bicubic);
+    CauldronAssert(ASSERT_CRITICAL,
+                   m_FallbackMethod >= UpscaleMethod::Point && m_FallbackMethod <= UpscaleMethod::Bicubic,
+                   L"The TSR fallback upscaler has to be Point, Bilinear or Bicubic");
+
     // Let the framework parse all the "known" options for us
     ParseConfigData(configData);
 }
@@ -135,6 +145,9 @@ void FSRSample::RegisterSampleModules()
     // Common render modules
     rendermodule::RegisterCommonRenderModules();
 
+    // The upscaler picks it, the renderer falls back on it when the upscaler goes away
+    RenderModuleFactory::RegisterModule<UpscaleRenderModule>("UpscaleRenderModule");
+
     // Register rest of the render modules
     if (HasCapability(FrameworkCapability::Renderer))
     {
@@ -151,7 +164,6 @@ void FSRSample::RegisterSampleModules()
         RenderModuleFactory::RegisterModule<FSR3UpscaleRenderModule>("FSR3UpscaleRenderModule");
         RenderModuleFactory::RegisterModule<FSR2RenderModule>("FSR2RenderModule");
         RenderModuleFactory::RegisterModule<FSR1RenderModule>("FSR1RenderModule");
-        RenderModuleFactory::RegisterModule<UpscaleRenderModule>("UpscaleRenderModule");
 
         // Register required render modules for upscaling
         RenderModuleFactory::RegisterModule<TAARenderModule>("TAARenderModule");
@@ -207,7 +219,13 @@ int32_t FSRSample::DoSampleInit()
 
     // Rest is only needed if we are in Upscaler mode
     if (!HasCapability(FrameworkCapability::Upscaler))
+    {
+        // The renderer upscales by itself while its upscaler is away, if the render modules include an upscaler
+        m_pUpscaleRenderModule = static_cast<UpscaleRenderModule*>(GetFramework()->GetRenderModule("UpscaleRenderModule"));
+        if (m_pUpscaleRenderModule)
+            m_pUpscaleRenderModule->SetFilter(static_cast<UpscaleRM::UpscaleMethod>(m_FallbackMethod));
         return 0;
+    }
 
     // Store pointers to various render modules
     m_pDLSSRenderModule        = static_cast<DLSSRenderModule*>(GetFramework()->GetRenderModule("DLSSRenderModule"));
@@ -334,6 +352,11 @@ void FSRSample::SwitchUpscaler(UpscaleMethod newUpscaler)
     if (m_pCurrentUpscaler)
         CauldronAssert(ASSERT_CRITICAL, !m_pCurrentUpscaler->ModuleNotSupported(), L"Upscaler not supported");
 
+    // Only have the renderer send what the new upscaler consumes
+    static const char* s_UpscalerNames[] = {"Native", "Point", "Bilinear", "Bicubic", "FSR1", "FSR2", "FSR3Upscale", "FSR3", "DLSSUpscale", "DLSS"};
+    static_assert(_countof(s_UpscalerNames) == static_cast<size_t>(UpscaleMethod::Count), "Missing upscaler names");
+    m_pTSRRenderModule->SetActiveUpscaler(s_UpscalerNames[static_cast<uint32_t>(m_Method)]);
+
     // Enable the new one
     if (m_pCurrentUpscaler)
         m_pCurrentUpscaler->EnableModule(true);
@@ -355,7 +378,16 @@ void FSRSample::DoSampleUpdates(double deltaTime)
 
     // Rest is only needed if we are in Upscaler mode
     if (!HasCapability(FrameworkCapability::Upscaler))
+    {
+        // Upscale in process for as long as the renderer has no upscaler, at the resolution the frames are rendered for it
+        bool fallback = m_pTSRRenderModule->IsFallbackActive();
+        if (m_pUpscaleRenderModule && fallback != m_pUpscaleRenderModule->ModuleEnabled())
+        {
+            GetDevice()->FlushAllCommandQueues();
+            m_pUpscaleRenderModule->EnableInPlace(fallback);
+        }
         return;
+    }
 
     // Upscaler changes need to be done before the rest of the frame starts executing
     // as it relies on the upscale method being set for the frame and whatnot
@@ -370,7 +402,12 @@ void FSRSample::DoSampleShutdown()
 {
     // Only needed if we are in Upscaler mode
     if (!HasCapability(FrameworkCapability::Upscaler))
+    {
+        // Don't let the fallback upscaler touch the upscaling state on destruction
+        if (m_pUpscaleRenderModule)
+            m_pUpscaleRenderModule->EnableInPlace(false);
         return;
+    }
 
     if (m_pCurrentUpscaler)
         m_pCurrentUpscaler->EnableModule(false);
@@ -95,6 +95,7 @@ private:
 
     UpscaleMethod           m_Method           = UpscaleMethod::Native;
     UpscaleMethod           m_UIMethod         = UpscaleMethod::Native;
+    UpscaleMethod           m_FallbackMethod   = UpscaleMethod::Bicubic;  // Renderer: what upscales in process while the upscaler is away
     cauldron::RenderModule* m_pCurrentUpscaler = nullptr;
 
     DLSSRenderModule*         m_pDLSSRenderModule        = nullptr;
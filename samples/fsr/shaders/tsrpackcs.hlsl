@@ -0,0 +1,17 @@
+//--------------------------------------------------------------------------------------
+// Typed copy between a render target and its compact TSR counterpart (e.g. RGBA16_FLOAT <-> RG11B10_FLOAT).
+// The UAV store does the format conversion, in both directions.
+//--------------------------------------------------------------------------------------
+Texture2D<float4>   InputTexture  : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+[numthreads(NUM_THREAD_X, NUM_THREAD_Y, 1)]
+void MainCS(uint3 dtID : SV_DispatchThreadID)
+{
+    uint2 size;
+    OutputTexture.GetDimensions(size.x, size.y);
+    if (any(dtID.xy >= size))
+        return;
+
+    OutputTexture[dtID.xy] = InputTexture[dtID.xy];
+}
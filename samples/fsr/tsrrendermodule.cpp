@@ -2,20 +2,39 @@
 #include "validation_remap.h"
 #include "render/device.h"
 #include "render/dynamicresourcepool.h"
+#include "render/parameterset.h"
+#include "render/pipelineobject.h"
 #include "render/profiler.h"
+#include "render/rootsignature.h"
 #include "render/swapchain.h"
 #include "render/uploadheap.h"
 #include "core/scene.h"
+#include "core/components/cameracomponent.h"
+#include "core/taskmanager.h"
 
 // We need to include internal headers to access the DX12 resources
 #include "render/dx12/gpuresource_dx12.h"
 #include "render/renderdefines.h"
 #include "render/texture.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <functional>
+#include <thread>
 
 using namespace cauldron;
 
+static constexpr uint32_t g_PackThreadX = 8;
+static constexpr uint32_t g_PackThreadY = 8;
+
+// What the TSR state machines report goes to the framework log
+static void WriteTSRLog(TSRLogLevel level, const std::string& message)
+{
+    LogLevel logLevel = level == TSRLogLevel::Error ? LOGLEVEL_ERROR : level == TSRLogLevel::Warning ? LOGLEVEL_WARNING : LOGLEVEL_INFO;
+    Log::Write(logLevel, L"%ls", StringToWString(message).c_str());
+}
+
 TSRGraphicsResource TSRRenderModule::getTSRResourceFromTexture(const cauldron::Texture* res) const
 {
     const auto&         impl       = res->GetResource();
@@ -36,16 +55,95 @@ void TSRRenderModule::Init(const json& initData)
     m_RendererModeEnabled = GetFramework()->IsOnlyCapability(FrameworkCapability::Renderer);
     m_OnlyResizing        = GetFramework()->HasCapability(FrameworkCapability::Renderer | FrameworkCapability::Upscaler);
 
-    // Fetch needed resources
+    // How the framework loop waits for the other process
+    m_WaitMode      = initData.value("EventWait", false) ? TSRWaitMode::Event : TSRWaitMode::Poll;
+    m_WaitTimeoutUs = initData.value("WaitTimeoutMs", 0u) * 1000ull;
+
+    // Frames go through D3D12 shared heaps. The host transports (TSRNetTransport, TSRPosixTransport) are library-only,
+    // the render module has no readback stage for them: tsr-net-loopback and tsr-replay drive them instead.
+    std::string transport = initData.value("Transport", std::string("D3D12"));
+    CauldronAssert(ASSERT_CRITICAL,
+                   transport == "D3D12",
+                   L"TSR transport %ls is library-only, the render module transfers through D3D12",
+                   StringToWString(transport).c_str());
+
+    // Delta transfers classify the dirty tiles on the CPU, the D3D12 transfers always copy whole resources
+    uint32_t tileSize = initData.value("TileSize", 0u);
+    CauldronAssert(ASSERT_CRITICAL,
+                   tileSize == 0,
+                   L"TSR TileSize %u: delta transfers are only supported by host transports (see tsr-tile-delta), the render module sends full frames",
+                   tileSize);
+
+    // Render straight into the shared heaps instead of copying (see TSRPlacedSlots), both processes have to opt in
+    m_ZeroCopy = initData.value("ZeroCopy", false) && !m_OnlyResizing;
+
+    // Which frame the upscaler takes when it fell behind. Benchmarks compare every frame, so they always take the oldest.
+    std::string consumePolicy = initData.value("ConsumePolicy", std::string("EveryFrame"));
+    CauldronAssert(ASSERT_CRITICAL,
+                   consumePolicy == "EveryFrame" || consumePolicy == "Latest",
+                   L"Unknown TSR consume policy %ls",
+                   StringToWString(consumePolicy).c_str());
+    if (consumePolicy == "Latest" && !GetConfig()->EnableBenchmark)
+        m_ConsumePolicy = TSRConsumePolicy::Latest;
+
+    // How many upscalers read the renderer's frames (the renderer and every upscaler have to agree), and which of them
+    // this one is. Every upscaler gets every frame, a shared buffer is free once all of them released it.
+    m_ConsumerCount = initData.value("Consumers", 1u);
+    m_ConsumerIndex = initData.value("ConsumerIndex", 0u);
+    CauldronAssert(ASSERT_CRITICAL,
+                   m_ConsumerCount > 0 && m_ConsumerCount <= TSR_MAX_CONSUMERS && m_ConsumerIndex < m_ConsumerCount,
+                   L"Invalid TSR upscaler index %u of %u",
+                   m_ConsumerIndex,
+                   m_ConsumerCount);
+
+    // Fetch needed resources and describe them in the manifest
+    // Entries without a texture name refer to the color target, both processes have to use the same list
     if (!m_OnlyResizing)
     {
-        m_pColorTarget   = GetFramework()->GetColorTargetForCallback(GetName());
-        m_pDepthTarget   = GetFramework()->GetRenderTexture(L"DepthTarget");
-        m_pMotionVectors = GetFramework()->GetRenderTexture(L"GBufferMotionVectorRT");
+        json resources = initData.value("Resources",
+                                        json::array({{{"Name", "Color"}},
+                                                     {{"Name", "Depth"}, {"Texture", "DepthTarget"}},
+                                                     {{"Name", "MotionVectors"}, {"Texture", "GBufferMotionVectorRT"}}}));
+
+        for (const json& resource : resources)
+        {
+            TSRResourceBinding binding;
+            binding.name      = resource["Name"].get<std::string>();
+            binding.consumers = resource.value("Consumers", std::vector<std::string>());
+
+            std::string textureName = resource.value("Texture", std::string());
+            if (textureName.empty())
+                binding.pTexture = GetFramework()->GetColorTargetForCallback(GetName());
+            else
+                binding.pTexture = GetFramework()->GetRenderTexture(StringToWString(textureName).c_str());
+            CauldronAssert(ASSERT_CRITICAL, binding.pTexture, L"Could not get %ls for TSR render module", StringToWString(binding.name).c_str());
+
+            // The GPU transfer copies texels as they are, so packing means going through a compact texture.
+            // Only color has one that saves bytes: depth has no 24 bit format a compute pass can write, and the RG16 snorm
+            // motion vectors take as many bytes as the RG16 float ones. Those two packings are for host transports.
+            TSRPacking  packing     = TSRPacking::None;
+            std::string packingName = resource.value("Packing", std::string("None"));
+            CauldronAssert(ASSERT_CRITICAL, TSRParsePacking(packingName.c_str(), packing), L"Unknown TSR packing %ls", StringToWString(packingName).c_str());
+            CauldronAssert(ASSERT_CRITICAL,
+                           packing == TSRPacking::None || packing == TSRPacking::ColorR11G11B10,
+                           L"TSR packing %ls is only supported by host transports, the D3D12 transport packs ColorR11G11B10",
+                           StringToWString(packingName).c_str());
+            if (packing != TSRPacking::None)
+                InitPackPass(binding);
+
+            binding.optional = resource.value("Optional", false);
+            m_Resources.push_back(binding);
+        }
+
+        BuildManifest();
 
-        CauldronAssert(ASSERT_CRITICAL, m_pColorTarget, L"Could not get color target for FSR render modules");
-        CauldronAssert(ASSERT_CRITICAL, m_pDepthTarget, L"Could not get depth target for FSR render modules");
-        CauldronAssert(ASSERT_CRITICAL, m_pMotionVectors, L"Could not get motion vectors for FSR render modules");
+        // Report what the copy alignment rules cost us per frame
+        TSRLayoutReport layoutReport = m_Manifest.GetLayoutReport();
+        Log::Write(LOGLEVEL_INFO,
+                   L"TSR shared buffer layout: %llu bytes per frame, %llu bytes (%.2f%%) of row and placement padding",
+                   layoutReport.totalBytes,
+                   layoutReport.WastedBytes(),
+                   layoutReport.WastedRatio() * 100.0);
     }
 
     // Upscaler mode is first in line by RenderModules order, but Renderer mode needs to be put in before SwapChainRenderModule explicitly
@@ -57,36 +155,175 @@ void TSRRenderModule::Init(const json& initData)
         GetFramework()->RegisterExecutionCallback(L"SwapChainRenderModule", true, callbackPreSwapTuple);
     }
 
-    if (!m_OnlyResizing)
+    // Renderers started with -session share the upscaler with other renderers
+    m_AnnounceSession   = m_RendererModeEnabled && !GetConfig()->SessionName.empty();
+    m_SessionDeadlineUs = static_cast<uint64_t>(initData.value("SessionDeadlineMs", 0.0) * 1000.0);
+
+    // The renderer and the upscaler agree on the shared buffers before creating them, instead of both assuming the
+    // same configuration. Sessions are matched up by the session directory instead.
+    bool sessions  = m_UpscalerModeEnabled && !m_OnlyResizing && initData.contains("Sessions");
+    bool negotiate = initData.value("Negotiate", true) && !m_OnlyResizing && !m_AnnounceSession && !sessions;
+    m_SlotCount    = GetFramework()->GetBufferCount();
+
+    // An upscaler serving sessions copies the frames of every renderer through the same render targets
+    if (m_ZeroCopy && (sessions || m_AnnounceSession))
     {
-        // Create TSROps
-        m_TSROps = std::make_unique<TSROps>(GetFramework()->GetName(),
-                                            GetDevice()->GetImpl()->DX12Device(),
-                                            GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics),
-                                            GetFramework()->GetBufferCount());
+        Log::Write(LOGLEVEL_WARNING, L"TSR zero copy is not supported with sessions, copying the frames instead");
+        m_ZeroCopy = false;
+    }
+
+    if (m_ZeroCopy)
+        m_pPlacementAllocator = std::make_unique<TSRD3D12Allocator>(GetDevice()->GetImpl()->DX12Device());
+
+    // A peer whose heartbeat stops for this long is taken for dead, 0 to wait for it forever
+    uint64_t peerTimeoutUs = static_cast<uint64_t>(initData.value("PeerTimeoutMs", 2000.0) * 1000.0);
+    m_PeerSupervisor       = std::make_unique<TSRPeerSupervisor>(peerTimeoutUs, WriteTSRLog);
+
+    // The agreed resolution, the upscaler follows the renderer's
+    m_RenderWidth  = GetConfig()->InitialRenderWidth;
+    m_RenderHeight = GetConfig()->InitialRenderHeight;
+
+    if (sessions)
+        InitSessions(initData["Sessions"]);
+    else if (!m_OnlyResizing)
+    {
+        if (negotiate)
+        {
+            // The shared buffers are created once both sides agreed on them, the module only provides the pieces
+            TSRNegotiationHooks hooks;
+            hooks.buildManifest = [this]() { return BuildManifest(); };
+            hooks.resize        = [this](uint32_t renderWidth, uint32_t renderHeight) { ApplyRenderResolution(renderWidth, renderHeight); };
+            hooks.allocate      = [this](uint64_t generation, uint64_t slotCount, const TSRManifest& manifest) { AllocateOps(generation, slotCount, manifest); };
+            hooks.install       = [this]() { return InstallOps(); };
+            hooks.drop          = [this]() { DropOps(); };
+            hooks.log           = WriteTSRLog;
+
+            // We can upscale from up to the display resolution, into as many shared buffers as we were configured with
+            hooks.capabilities = [this]() {
+                const ResolutionInfo& resInfo = GetFramework()->GetResolutionInfo();
+                TSRCapabilities       capabilities;
+                capabilities.maxSlots        = GetFramework()->GetBufferCount();
+                capabilities.maxRenderWidth  = resInfo.DisplayWidth;
+                capabilities.maxRenderHeight = resInfo.DisplayHeight;
+                return capabilities;
+            };
+
+            // The renderer creates the control channel, the upscaler opens it once the renderer runs
+            m_Negotiator = std::make_unique<TSRNegotiator>(WStringToString(GetFramework()->GetSharedName()), m_ConsumerCount, m_ConsumerIndex, m_RendererModeEnabled, hooks);
+            if (m_RendererModeEnabled)
+            {
+                bool created = m_Negotiator->Start(m_SlotCount, GetFramework()->GetBufferCount(), m_RenderWidth, m_RenderHeight);
+                CauldronAssert(ASSERT_CRITICAL, created, L"Could not create the TSR control channel");
+            }
+            else
+                m_Negotiator->Start(m_RenderWidth, m_RenderHeight);
+        }
+        else
+        {
+            // Create TSROps
+            m_TSROps = std::make_unique<TSROps>(GetFramework()->GetSharedName().c_str(),
+                                                GetDevice()->GetImpl()->DX12Device(),
+                                                GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics),
+                                                m_SlotCount,
+                                                TSRCopyMode::Graphics,
+                                                m_ConsumerCount,
+                                                m_ConsumerIndex);
+
+            // Intialize the shared buffers
+            m_TSROps->CreateSharedBuffers(m_Manifest, !m_UpscalerModeEnabled);
+            m_TSROps->SetConsumePolicy(m_ConsumePolicy);
+            WatchPeers();
+
+            if (m_ZeroCopy)
+            {
+                std::unique_ptr<TSRPlacedSlots> pSlots = DescribePlacedSlots();
+                CauldronAssert(ASSERT_CRITICAL,
+                               pSlots->Create(WStringToString(GetFramework()->GetSharedName()), m_SlotCount, !m_UpscalerModeEnabled),
+                               L"Could not place the TSR render targets in shared heaps");
+                InstallPlacedSlots(std::move(pSlots));
+            }
+        }
+        m_pActiveOps             = m_TSROps.get();
+        m_pActiveMetadataChecker = &m_MetadataChecker;
+
+        // The renderer can use fewer shared buffers than it allocated, trading queueing latency against stalls
+        if (m_RendererModeEnabled && initData.contains("AdaptiveSlots"))
+        {
+            const json&             adaptiveSlots = initData["AdaptiveSlots"];
+            TSRSlotControllerParams params;
+            params.minSlots           = adaptiveSlots.value("Min", params.minSlots);
+            params.maxSlots           = std::min(adaptiveSlots.value("Max", GetFramework()->GetBufferCount()), GetFramework()->GetBufferCount());
+            params.growCooldownFrames = adaptiveSlots.value("GrowCooldownFrames", params.growCooldownFrames);
+            params.shrinkWindowFrames = adaptiveSlots.value("ShrinkWindowFrames", params.shrinkWindowFrames);
+            CauldronAssert(ASSERT_CRITICAL, params.minSlots > 0 && params.minSlots <= params.maxSlots, L"Invalid TSR adaptive slot range");
 
-        // Intialize the shared buffers
-        m_TSROps->CreateSharedBuffers(getFSRResources(), !m_UpscalerModeEnabled);
+            m_SlotController = std::make_unique<TSRSlotController>(params, params.maxSlots);
+            if (m_TSROps)
+                m_TSROps->SetActiveBufferCount(m_SlotController->GetActiveSlots());
+        }
 
         // The framework will run MainLoop based on the outcome of this function
+        // Renderer runs ahead into any free shared buffer, upscaler drains the oldest completed one
+        // In event mode the framework loop sleeps on the shared fences (up to the timeout) instead of spinning
         GetFramework()->SetReadyFunction([this]() {
-            uint64_t bufferIndex = GetFramework()->GetBufferIndex();
             if (m_RendererModeEnabled)
-                return m_TSROps->bufferStateMatches(bufferIndex, TSROps::BufferState::IDLE);
+            {
+                AnnounceSession();
+                if (!UpdateNegotiation())
+                    return false;
+
+                // Without an upscaler the frame gets upscaled in process and nothing goes through the shared buffers
+                UpdateLiveness();
+                if (IsFallbackActive())
+                    return true;
+
+                if (!m_TSROps->AcquireBufferForWrite(m_BufferIndex, m_WaitMode, m_WaitTimeoutUs))
+                    return false;
+
+                RotatePlacedSlots();
+                UpdateSlotController();
+                return true;
+            }
             else
-                return m_TSROps->bufferStateMatches(bufferIndex, TSROps::BufferState::READY);
+            {
+                if (!UpdateNegotiation())
+                    return false;
+
+                // Losing the renderer drops the shared buffers
+                UpdateLiveness();
+                if (!m_TSROps || !m_TSROps->AcquireBufferForRead(m_BufferIndex, m_WaitMode, m_WaitTimeoutUs))
+                    return false;
+
+                RotatePlacedSlots();
+                return true;
+            }
+        });
+
+        // Shared camera data follows the shared buffer picked by the ring
+        GetFramework()->SetBufferIndexFunction([this]() { return m_BufferIndex; });
+
+        // Hand the shared buffer over only once the frame doing the transfer is on the graphics queue
+        GetFramework()->SetPostSubmitFunction([this]() {
+            if (m_TSROps && !IsFallbackActive())
+                m_TSROps->Submit();
         });
     }
 
     if (m_RendererModeEnabled)
     {
-        // The framework will only exit if there's no buffer to consume anymore
-        GetFramework()->SetCanExitFunction([this]() { return m_TSROps->bufferStateMatchesAll(TSROps::BufferState::IDLE); });
+        // The framework will only exit if there's no buffer to consume anymore, by any of the upscalers. Upscalers that
+        // stopped responding while we wait get their shared buffers reclaimed.
+        GetFramework()->SetCanExitFunction([this]() {
+            UpdateLiveness();
+            return !m_TSROps || IsFallbackActive() || m_TSROps->IsDrained();
+        });
     }
 
+    // Benchmark runs write the time spent in every stage of the handoff along with the frame times
+    if (!m_OnlyResizing)
+        GetFramework()->SetTelemetryFunction([this](json& data) { WriteTelemetry(data); });
+
     // On Renderer, enable upscaling
-    m_RenderWidth  = GetConfig()->InitialRenderWidth;
-    m_RenderHeight = GetConfig()->InitialRenderHeight;
     if (!m_UpscalerModeEnabled || m_OnlyResizing)
     {
         GetFramework()->EnableUpscaling(true, [&](uint32_t displayWidth, uint32_t displayHeight) {
@@ -108,6 +345,527 @@ TSRRenderModule::~TSRRenderModule()
     // Protection
     if (ModuleEnabled())
         EnableModule(false);
+
+    // The upscaler stops serving our session
+    if (m_SessionEntry != TSRSessionDirectory::INVALID_ENTRY)
+        m_SessionDirectory.Withdraw(m_SessionEntry);
+
+    // Closing the sessions reports their counters
+    m_Sessions.reset();
+
+    // The shared buffers of a generation may still be in the making
+    while (m_pPendingOps && !m_pPendingOps->ready.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    // The shared heaps go before their allocator, and the render resources get their own resources back
+    m_pPendingOps.reset();
+    DropPlacedSlots();
+
+    for (TSRResourceBinding& binding : m_Resources)
+        delete binding.pPackParameters;
+    delete m_pPackPipelineObj;
+    delete m_pPackRootSignature;
+
+    // Report how much the wait on the other process cost us
+    if (m_TSROps)
+    {
+        const TSRWaitStats& stats = m_TSROps->GetRing().GetWaitStats();
+        Log::Write(LOGLEVEL_INFO,
+                   L"TSR %ls wait: %llu waits, %llu timeouts, %llu polls, %.2f ms CPU, wait p50/p99 %llu/%llu us, wake latency p50/p99 %llu/%llu us",
+                   m_WaitMode == TSRWaitMode::Event ? L"event" : L"poll",
+                   stats.waits,
+                   stats.timeouts,
+                   stats.polls,
+                   stats.cpuNs / 1000000.0,
+                   stats.waitUs.Percentile(0.5),
+                   stats.waitUs.Percentile(0.99),
+                   stats.wakeLatencyUs.Percentile(0.5),
+                   stats.wakeLatencyUs.Percentile(0.99));
+
+        // And where the rest of the handoff went
+        m_TransferTotals.Merge(m_TSROps->GetTransferStats());
+        Log::Write(LOGLEVEL_INFO,
+                   L"TSR transfers: %llu frames, %.1f MB copied, slot wait p50/p99 %llu/%llu us, recording p50 %llu us, submit p50 %llu us, GPU barriers/copies p50 %llu/%llu us",
+                   m_TransferTotals.transfers,
+                   m_TransferTotals.bytes / (1024.0 * 1024.0),
+                   m_TransferTotals.acquireUs.Percentile(0.5),
+                   m_TransferTotals.acquireUs.Percentile(0.99),
+                   m_TransferTotals.recordUs.Percentile(0.5),
+                   m_TransferTotals.submitUs.Percentile(0.5),
+                   m_TransferTotals.barrierUs.Percentile(0.5),
+                   m_TransferTotals.copyUs.Percentile(0.5));
+
+        if (m_SlotController)
+        {
+            const TSRSlotControllerStats& slotStats = m_SlotController->GetStats();
+            Log::Write(LOGLEVEL_INFO,
+                       L"TSR adaptive shared buffers: %.2f on average, %llu grows, %llu shrinks, %llu stalls (%llu with the upscaler as the bottleneck)",
+                       slotStats.AverageSlots(),
+                       slotStats.grows,
+                       slotStats.shrinks,
+                       slotStats.stalls,
+                       slotStats.consumerBoundStalls);
+        }
+
+        // What the upscaler skipped to keep up
+        const TSRRingStats& ringStats = m_TSROps->GetRing().GetStats();
+        if (m_ConsumePolicy == TSRConsumePolicy::Latest)
+        {
+            Log::Write(LOGLEVEL_INFO,
+                       L"TSR latest frame policy: %llu frames consumed, %llu skipped in %llu skips, %.2f ms of queueing latency saved",
+                       ringStats.consumed,
+                       ringStats.skipped,
+                       ringStats.skips,
+                       ringStats.savedUs / 1000.0);
+        }
+
+        // And whether the frame state ever got out of step with the textures
+        if (m_UpscalerModeEnabled)
+        {
+            const TSRMetadataStats& metadataStats = m_MetadataChecker.GetStats();
+            Log::Write(LOGLEVEL_INFO,
+                       L"TSR frame metadata: %llu frames, %llu missing, %llu manifest mismatches, %llu camera mismatches, %llu frames skipped, %llu repeats, %llu reversals",
+                       metadataStats.frames,
+                       metadataStats.missing,
+                       metadataStats.manifests,
+                       metadataStats.mismatches,
+                       metadataStats.gaps,
+                       metadataStats.repeats,
+                       metadataStats.reversals);
+        }
+    }
+}
+
+void TSRRenderModule::InitSessions(const json& sessions)
+{
+    std::string policy = sessions.value("Policy", std::string("RoundRobin"));
+    CauldronAssert(ASSERT_CRITICAL, policy == "RoundRobin" || policy == "Deadline", L"Unknown TSR session policy %ls", StringToWString(policy).c_str());
+    m_SessionPollUs = sessions.value("PollUs", m_SessionPollUs);
+
+    // The renderers announce themselves in a directory named after us
+    bool created = m_SessionDirectory.Open(WStringToString(GetFramework()->GetName()), true);
+    CauldronAssert(ASSERT_CRITICAL, created, L"Could not create the TSR session directory");
+
+    // The frame state of every session comes with its frames, there is no shared camera to follow
+    GetFramework()->EnableSharedCameraData(false);
+
+    // The framework loop runs a frame of whichever session the scheduler picks
+    GetFramework()->SetReadyFunction([this]() { return AcquireSessionFrame(); });
+    GetFramework()->SetBufferIndexFunction([this]() { return m_BufferIndex; });
+    GetFramework()->SetPostSubmitFunction([this]() {
+        if (m_pActiveOps)
+            m_pActiveOps->Submit();
+    });
+
+    m_SessionScheduler = std::make_unique<TSRSessionScheduler>(policy == "Deadline" ? TSRSchedulePolicy::Deadline : TSRSchedulePolicy::RoundRobin);
+    m_Sessions         = std::make_unique<TSRSessionRegistry<TSRSession>>(
+        [this](uint32_t id, const TSRSessionInfo& info) {
+            std::wstring name = StringToWString(info.name);
+
+            // The upscaler contexts are shared by the sessions, so every renderer has to send what they were made for
+            if (info.manifestHash != m_Manifest.GetHash() || info.slotCount != GetFramework()->GetBufferCount() ||
+                info.renderWidth != m_RenderWidth || info.renderHeight != m_RenderHeight)
+            {
+                Log::Write(LOGLEVEL_WARNING,
+                           L"TSR session %ls does not match the upscaler (%llu shared buffers at %ux%u), ignoring it",
+                           name.c_str(),
+                           info.slotCount,
+                           info.renderWidth,
+                           info.renderHeight);
+                return std::unique_ptr<TSRSession>();
+            }
+
+            auto pSession  = std::make_unique<TSRSession>();
+            pSession->name = name;
+            pSession->pOps = std::make_unique<TSROps>(name.c_str(),
+                                                      GetDevice()->GetImpl()->DX12Device(),
+                                                      GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics),
+                                                      info.slotCount,
+                                                      TSRCopyMode::Graphics,
+                                                      m_ConsumerCount,
+                                                      m_ConsumerIndex);
+            pSession->pOps->CreateSharedBuffers(m_Manifest);
+            pSession->pOps->SetConsumePolicy(m_ConsumePolicy);
+            pSession->pOps->SetConsumedResources(m_ConsumedResources);
+            m_SessionScheduler->AddSession(id, &pSession->pOps->GetRing(), info.deadlineUs);
+
+            Log::Write(LOGLEVEL_INFO, L"TSR session %ls joined, deadline %.2f ms", name.c_str(), info.deadlineUs / 1000.0);
+            return pSession;
+        },
+        [this](uint32_t id, TSRSession& session) {
+            // Transfers out of the session's shared buffers may still be in flight
+            GetDevice()->FlushAllCommandQueues();
+
+            const TSRSessionStats&  stats         = *m_SessionScheduler->GetStats(id);
+            const TSRMetadataStats& metadataStats = session.metadataChecker.GetStats();
+            Log::Write(LOGLEVEL_INFO,
+                       L"TSR session %ls left: %llu frames, %llu missed deadlines, wait p50/p99 %llu/%llu us, %llu frames with bad metadata",
+                       session.name.c_str(),
+                       stats.served,
+                       stats.missedDeadlines,
+                       stats.waitUs.Percentile(0.5),
+                       stats.waitUs.Percentile(0.99),
+                       metadataStats.missing + metadataStats.manifests + metadataStats.repeats + metadataStats.reversals);
+
+            m_SessionScheduler->RemoveSession(id);
+            if (m_pActiveOps == session.pOps.get())
+            {
+                m_pActiveOps             = nullptr;
+                m_pActiveMetadataChecker = nullptr;
+                m_ActiveSession          = UINT32_MAX;
+            }
+        });
+}
+
+void TSRRenderModule::AnnounceSession()
+{
+    // The upscaler creates the directory, it may not be running yet
+    if (!m_AnnounceSession || m_SessionDirectory.IsOpen() || !m_SessionDirectory.Open(WStringToString(GetFramework()->GetName()), false))
+        return;
+
+    std::string    name = WStringToString(GetFramework()->GetSharedName());
+    TSRSessionInfo info = {};
+    CauldronAssert(ASSERT_CRITICAL, name.size() < sizeof(info.name), L"TSR session name %ls is too long", GetFramework()->GetSharedName().c_str());
+    memcpy(info.name, name.c_str(), name.size());
+    info.slotCount    = GetFramework()->GetBufferCount();
+    info.manifestHash = m_Manifest.GetHash();
+    info.renderWidth  = m_RenderWidth;
+    info.renderHeight = m_RenderHeight;
+    info.deadlineUs   = m_SessionDeadlineUs;
+
+    m_SessionEntry = m_SessionDirectory.Announce(info);
+    CauldronAssert(ASSERT_WARNING, m_SessionEntry != TSRSessionDirectory::INVALID_ENTRY, L"The upscaler serves too many sessions already");
+}
+
+bool TSRRenderModule::AcquireSessionFrame()
+{
+    // Pick up the sessions that came or went since the last frame
+    m_Sessions->Update(m_SessionDirectory);
+
+    // The sessions don't share fences to sleep on, so the wait always polls
+    uint32_t id       = 0;
+    uint64_t sequence = 0;
+    if (!m_SessionScheduler->WaitNext(id, m_BufferIndex, sequence, m_WaitTimeoutUs, m_SessionPollUs))
+        return false;
+
+    TSRSession* pSession     = m_Sessions->Find(id);
+    m_SessionSwitched        = id != m_ActiveSession;
+    m_ActiveSession          = id;
+    m_pActiveOps             = pSession->pOps.get();
+    m_pActiveMetadataChecker = &pSession->metadataChecker;
+    return true;
+}
+
+void TSRRenderModule::UpdateSlotController()
+{
+    if (!m_SlotController)
+        return;
+
+    // Called once per frame, right after the renderer got its shared buffer
+    const TSRSlotRing& ring           = m_TSROps->GetRing();
+    uint64_t           consumerBusyNs = m_TSROps->GetTransport()->GetConsumerBusyNs();
+    uint64_t           activeSlots    = m_SlotController->Update(ring.GetFrameBusyNs(), consumerBusyNs, m_TSROps->GetReadyBufferCount(), ring.WasLastAcquireStalled());
+    m_TSROps->SetActiveBufferCount(activeSlots);
+
+    for (const TSRSlotDecision& decision : m_SlotController->TakeDecisions())
+    {
+        Log::Write(LOGLEVEL_TRACE,
+                   L"TSR shared buffers %llu -> %llu (%ls): renderer %.2f ms, upscaler %.2f ms, peak occupancy %llu",
+                   decision.fromSlots,
+                   decision.toSlots,
+                   StringToWString(TSRSlotReasonName(decision.reason)).c_str(),
+                   decision.producerFrameUs / 1000.0,
+                   decision.consumerFrameUs / 1000.0,
+                   decision.peakOccupancy);
+
+        // Only the benchmark reports telemetry
+        if (GetConfig()->EnableBenchmark)
+            m_SlotDecisions.push_back(decision);
+    }
+}
+
+// Summary of a stage for the telemetry, in microseconds
+static json DescribeHistogram(const TSRHistogram& histogram)
+{
+    return {{"count", histogram.count},
+            {"mean", histogram.Mean()},
+            {"p50", histogram.Percentile(0.5)},
+            {"p99", histogram.Percentile(0.99)},
+            {"max", histogram.max}};
+}
+
+void TSRRenderModule::WriteTelemetry(json& data)
+{
+    if (m_SlotController)
+    {
+        data["tsr_active_slots"] = m_SlotController->GetActiveSlots();
+        data["tsr_renderer_ms"]  = m_SlotController->GetProducerFrameUs() / 1000.0;
+        data["tsr_upscaler_ms"]  = m_SlotController->GetConsumerFrameUs() / 1000.0;
+
+        json decisions = json::array();
+        for (const TSRSlotDecision& decision : m_SlotDecisions)
+        {
+            decisions.push_back({{"frame", decision.frame},
+                                 {"from", decision.fromSlots},
+                                 {"to", decision.toSlots},
+                                 {"reason", TSRSlotReasonName(decision.reason)},
+                                 {"renderer_ms", decision.producerFrameUs / 1000.0},
+                                 {"upscaler_ms", decision.consumerFrameUs / 1000.0},
+                                 {"peak_occupancy", decision.peakOccupancy}});
+        }
+        data["tsr_slot_decisions"] = decisions;
+        m_SlotDecisions.clear();
+    }
+
+    // Where the handoff spent its time since the last line, over every session of an upscaler serving several
+    TSRTransferStats window;
+    bool             gpuTimings = false;
+
+    auto takeStats = [&window, &gpuTimings](TSROps& ops) {
+        window.Merge(ops.GetTransferStats());
+        gpuTimings |= ops.HasGpuTimings();
+        ops.ResetTransferStats();
+    };
+    if (m_TSROps)
+        takeStats(*m_TSROps);
+    if (m_Sessions)
+        m_Sessions->ForEach([&takeStats](uint32_t, TSRSession& session) { takeStats(*session.pOps); });
+    m_TransferTotals.Merge(window);
+
+    if (!window.transfers)
+        return;
+
+    json planes = json::array();
+    for (size_t i = 0; i < window.planes.size() && i < m_Manifest.GetResourceCount(); i++)
+    {
+        const TSRPlaneStats& plane = window.planes[i];
+        planes.push_back({{"name", m_Manifest.GetResource(i).name},
+                          {"copies", plane.copies},
+                          {"aliased", plane.aliased},
+                          {"bytes", plane.bytes},
+                          {"copy_us", DescribeHistogram(plane.copyUs)}});
+    }
+
+    data["tsr_transfer"] = {{"direction", m_RendererModeEnabled ? "write" : "read"},
+                            {"transfers", window.transfers},
+                            {"bytes", window.bytes},
+                            {"gpu_timings", gpuTimings},
+                            {"acquire_us", DescribeHistogram(window.acquireUs)},
+                            {"record_us", DescribeHistogram(window.recordUs)},
+                            {"submit_us", DescribeHistogram(window.submitUs)},
+                            {"barrier_us", DescribeHistogram(window.barrierUs)},
+                            {"copy_us", DescribeHistogram(window.copyUs)},
+                            {"gpu_us", DescribeHistogram(window.gpuUs)},
+                            {"planes", planes}};
+}
+
+const TSRManifest& TSRRenderModule::BuildManifest()
+{
+    // The resources as they are sized now
+    m_Manifest = TSRManifest();
+    for (const TSRResourceBinding& binding : m_Resources)
+    {
+        TSRGraphicsResource graphicsResource = getTSRResourceFromTexture(binding.pTexture);
+        m_Manifest.AddResource(binding.name,
+                               static_cast<uint32_t>(graphicsResource.desc.Width),
+                               graphicsResource.desc.Height,
+                               graphicsResource.format,
+                               graphicsResource.stride,
+                               binding.optional);
+    }
+
+    // No tile size: the D3D12 transfers always send full frames, delta transfers are for host transports
+    m_Manifest.Finalize();
+    return m_Manifest;
+}
+
+std::wstring TSRRenderModule::GetGenerationName(uint64_t generation) const
+{
+    return GetFramework()->GetSharedName() + L"_" + std::to_wstring(generation);
+}
+
+bool TSRRenderModule::UpdateNegotiation()
+{
+    return !m_Negotiator || m_Negotiator->Update();
+}
+
+void TSRRenderModule::AllocateOps(uint64_t generation, uint64_t slotCount, const TSRManifest& manifest)
+{
+    // Everything the worker needs is copied, the module may be resized (or destroyed) meanwhile
+    std::shared_ptr<PendingOps> pPending = std::make_shared<PendingOps>();
+    pPending->generation                 = generation;
+    m_pPendingOps                        = pPending;
+
+    std::wstring        name          = GetGenerationName(generation);
+    ID3D12Device*       pDevice       = GetDevice()->GetImpl()->DX12Device();
+    ID3D12CommandQueue* pQueue        = GetDevice()->GetImpl()->DX12CmdQueue(CommandQueue::Graphics);
+    uint32_t            consumerCount = m_ConsumerCount;
+    uint32_t            consumerIndex = m_ConsumerIndex;
+    bool                isRenderer    = m_RendererModeEnabled;
+
+    // The render targets are described here, the worker only creates the heaps
+    if (m_ZeroCopy)
+        pPending->pSlots = DescribePlacedSlots();
+
+    Task allocateTask([=](void*) {
+        pPending->pOps = std::make_unique<TSROps>(name.c_str(), pDevice, pQueue, slotCount, TSRCopyMode::Graphics, consumerCount, consumerIndex);
+        pPending->pOps->CreateSharedBuffers(manifest, isRenderer);
+        if (pPending->pSlots)
+        {
+            CauldronAssert(ASSERT_CRITICAL,
+                           pPending->pSlots->Create(WStringToString(name), slotCount, isRenderer),
+                           L"Could not place the TSR render targets in shared heaps");
+        }
+        pPending->ready.store(true, std::memory_order_release);
+    });
+    GetTaskManager()->AddTask(allocateTask);
+}
+
+bool TSRRenderModule::InstallOps()
+{
+    if (!m_pPendingOps || !m_pPendingOps->ready.load(std::memory_order_acquire))
+        return false;
+
+    // The previous generation may still be in flight on the GPU
+    DropOps();
+    m_TSROps = std::move(m_pPendingOps->pOps);
+    std::unique_ptr<TSRPlacedSlots> pSlots = std::move(m_pPendingOps->pSlots);
+    m_pPendingOps.reset();
+
+    if (pSlots)
+        InstallPlacedSlots(std::move(pSlots));
+
+    m_TSROps->SetConsumePolicy(m_ConsumePolicy);
+    if (m_UpscalerModeEnabled)
+        m_TSROps->SetConsumedResources(m_ConsumedResources);
+    if (m_SlotController)
+        m_TSROps->SetActiveBufferCount(m_SlotController->GetActiveSlots());
+
+    m_pActiveOps      = m_TSROps.get();
+    m_GenerationReset = true;
+    WatchPeers();
+    return true;
+}
+
+void TSRRenderModule::DropOps()
+{
+    if (!m_TSROps)
+        return;
+
+    GetDevice()->FlushAllCommandQueues();
+    DropPlacedSlots();
+    m_PeerSupervisor->Stop();
+    m_TransferTotals.Merge(m_TSROps->GetTransferStats());
+    m_TSROps.reset();
+    m_pActiveOps = nullptr;
+}
+
+std::unique_ptr<TSRPlacedSlots> TSRRenderModule::DescribePlacedSlots() const
+{
+    // Only the render resources of the framework can rotate through the slots, packed resources go through their
+    // compact copy which is copied as before
+    std::unique_ptr<TSRPlacedSlots> pSlots = std::make_unique<TSRPlacedSlots>(m_pPlacementAllocator.get());
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        const TSRResourceBinding& binding = m_Resources[i];
+        const TextureDesc&        desc    = binding.pTexture->GetDesc();
+        if (binding.pPackParameters || GetConfig()->RenderResources.find(desc.Name) == GetConfig()->RenderResources.end())
+            continue;
+
+        const TSRResourceDesc& layout = m_Manifest.GetResource(i);
+        TSRPlacedResourceDesc  placed;
+        placed.name         = binding.name;
+        placed.width        = layout.width;
+        placed.height       = layout.height;
+        placed.format       = layout.format;
+        placed.stride       = layout.stride;
+        placed.depthStencil = static_cast<bool>(desc.Flags & ResourceFlags::AllowDepthStencil);
+        placed.allowUAV     = static_cast<bool>(desc.Flags & ResourceFlags::AllowUnorderedAccess);
+        pSlots->AddResource(i, placed);
+    }
+
+    CauldronAssert(ASSERT_CRITICAL, pSlots->GetResourceCount(), L"None of the TSR resources can be placed in shared heaps");
+    return pSlots;
+}
+
+void TSRRenderModule::InstallPlacedSlots(std::unique_ptr<TSRPlacedSlots> pSlots)
+{
+    ResourceState state = static_cast<ResourceState>(ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource);
+    for (size_t r = 0; r < pSlots->GetResourceCount(); r++)
+    {
+        const Texture* pTexture = m_Resources[pSlots->GetManifestIndex(r)].pTexture;
+
+        // The texture takes a reference on the placed resource of every slot, resizable so its views get rebound
+        std::vector<GPUResource*> resources;
+        for (uint64_t slot = 0; slot < pSlots->GetSlotCount(); slot++)
+        {
+            ID3D12Resource* pResource = static_cast<ID3D12Resource*>(pSlots->GetResource(slot, r));
+            pResource->AddRef();
+
+            GPUResourceInitParams initParams = {};
+            initParams.pResource             = pResource;
+            initParams.type                  = GPUResourceType::Swapchain;  // Externally allocated
+            std::wstring name                = pTexture->GetDesc().Name + L"_TSR" + std::to_wstring(slot);
+            resources.push_back(GPUResource::CreateGPUResource(name.c_str(), nullptr, state, &initParams, true));
+        }
+        GetFramework()->SetRenderResourceSharing(pTexture, resources);
+    }
+
+    m_TSROps->SetAliasedResources(pSlots->GetAliasedMask());
+    Log::Write(LOGLEVEL_INFO,
+               L"TSR zero copy: %llu render targets placed in %llu shared heaps of %llu bytes",
+               static_cast<uint64_t>(pSlots->GetResourceCount()),
+               pSlots->GetSlotCount(),
+               pSlots->GetHeapSize());
+    m_PlacedSlots = std::move(pSlots);
+}
+
+void TSRRenderModule::DropPlacedSlots()
+{
+    if (!m_PlacedSlots)
+        return;
+
+    // Resized render resources already went back to their own resources
+    std::vector<GPUResource*> noResources;
+    for (size_t r = 0; r < m_PlacedSlots->GetResourceCount(); r++)
+        GetFramework()->SetRenderResourceSharing(m_Resources[m_PlacedSlots->GetManifestIndex(r)].pTexture, noResources);
+
+    m_PlacedSlots.reset();
+}
+
+void TSRRenderModule::RotatePlacedSlots()
+{
+    // The render resources become the placed resources of the slot we acquired
+    if (m_PlacedSlots && m_PlacedSlots->SetCurrentSlot(m_BufferIndex))
+        GetFramework()->RotateRenderResources(static_cast<uint32_t>(m_BufferIndex));
+}
+
+void TSRRenderModule::WatchPeers()
+{
+    m_PeerSupervisor->Watch(&m_TSROps->GetRing(), m_RendererModeEnabled);
+}
+
+void TSRRenderModule::UpdateLiveness()
+{
+    // Without negotiation the upscaler can only wait for the renderer it had to resume
+    if (m_PeerSupervisor->Update() && m_Negotiator)
+        m_Negotiator->PeerLost();
+}
+
+void TSRRenderModule::ApplyRenderResolution(uint32_t renderWidth, uint32_t renderHeight)
+{
+    // Set first, so OnResize finds nothing left to do
+    m_RenderWidth  = renderWidth;
+    m_RenderHeight = renderHeight;
+    GetFramework()->EnableUpscaling(true, [&](uint32_t displayWidth, uint32_t displayHeight) {
+        return ResolutionInfo{
+            m_RenderWidth,
+            m_RenderHeight,
+            displayWidth,
+            displayHeight,
+        };
+    });
+    RebindPackPasses();
 }
 
 void TSRRenderModule::OnResize(const ResolutionInfo& resInfo)
@@ -115,6 +873,17 @@ void TSRRenderModule::OnResize(const ResolutionInfo& resInfo)
     if (!ModuleEnabled() || resInfo.RenderWidth == m_RenderWidth && resInfo.RenderHeight == m_RenderHeight)
         return;
 
+    // The shared buffers no longer fit the resized textures, agree on new ones. The renderer offers them, the upscaler
+    // asks the renderer for the resolution its upscaler picked.
+    if (m_Negotiator && !GetConfig()->EnableBenchmark)
+    {
+        m_RenderWidth  = resInfo.RenderWidth;
+        m_RenderHeight = resInfo.RenderHeight;
+        RebindPackPasses();
+        m_Negotiator->Resize(m_RenderWidth, m_RenderHeight);
+        return;
+    }
+
     // If we are not in benchmark mode, we don't need to force the resolution
     if (!GetConfig()->EnableBenchmark)
         return;
@@ -130,6 +899,127 @@ void TSRRenderModule::OnResize(const ResolutionInfo& resInfo)
     });
 }
 
+void TSRRenderModule::InitPackPass(TSRResourceBinding& binding)
+{
+    // Shared by all packed resources
+    if (!m_pPackRootSignature)
+    {
+        RootSignatureDesc signatureDesc;
+        signatureDesc.AddTextureSRVSet(0, ShaderBindStage::Compute, 1);
+        signatureDesc.AddTextureUAVSet(0, ShaderBindStage::Compute, 1);
+        m_pPackRootSignature = RootSignature::CreateRootSignature(L"TSRPackPass_RootSignature", signatureDesc);
+
+        DefineList defineList;
+        defineList.insert(std::make_pair(L"NUM_THREAD_X", std::to_wstring(g_PackThreadX)));
+        defineList.insert(std::make_pair(L"NUM_THREAD_Y", std::to_wstring(g_PackThreadY)));
+
+        PipelineDesc psoDesc;
+        psoDesc.SetRootSignature(m_pPackRootSignature);
+        psoDesc.AddShaderDesc(ShaderBuildDesc::Compute(L"tsrpackcs.hlsl", L"MainCS", ShaderModel::SM6_0, &defineList));
+        m_pPackPipelineObj = PipelineObject::CreatePipelineObject(L"TSRPackPass_PipelineObj", psoDesc);
+    }
+
+    // Compact copy of the render target that goes through the shared buffers
+    TextureDesc desc = binding.pTexture->GetDesc();
+    desc.Name        = L"TSRPacked" + StringToWString(binding.name);
+    desc.Format      = ResourceFormat::RG11B10_FLOAT;
+    desc.Flags       = ResourceFlags::AllowUnorderedAccess;
+
+    // The compact copy follows the size of the render target, which was created (and is resized) before it
+    const Texture* pSource = binding.pTexture;
+    binding.pSourceTexture = pSource;
+    binding.pTexture       = GetDynamicResourcePool()->CreateRenderTexture(&desc, [pSource](TextureDesc& desc, uint32_t, uint32_t, uint32_t, uint32_t) {
+        desc.Width  = pSource->GetDesc().Width;
+        desc.Height = pSource->GetDesc().Height;
+    });
+    CauldronAssert(ASSERT_CRITICAL, binding.pTexture, L"Could not create the packed texture for %ls", StringToWString(binding.name).c_str());
+
+    // The renderer packs into the compact texture, the upscaler unpacks out of it
+    const Texture* pInput  = m_RendererModeEnabled ? binding.pSourceTexture : binding.pTexture;
+    const Texture* pOutput = m_RendererModeEnabled ? binding.pTexture : binding.pSourceTexture;
+    CauldronAssert(ASSERT_CRITICAL,
+                   static_cast<bool>(pOutput->GetDesc().Flags & ResourceFlags::AllowUnorderedAccess),
+                   L"%ls needs to allow unordered access to be packed",
+                   StringToWString(binding.name).c_str());
+
+    binding.pPackParameters = ParameterSet::CreateParameterSet(m_pPackRootSignature);
+    BindPackPass(binding);
+}
+
+void TSRRenderModule::BindPackPass(TSRResourceBinding& binding)
+{
+    const Texture* pInput  = m_RendererModeEnabled ? binding.pSourceTexture : binding.pTexture;
+    const Texture* pOutput = m_RendererModeEnabled ? binding.pTexture : binding.pSourceTexture;
+    binding.pPackParameters->SetTextureSRV(pInput, ViewDimension::Texture2D, 0);
+    binding.pPackParameters->SetTextureUAV(pOutput, ViewDimension::Texture2D, 0);
+}
+
+void TSRRenderModule::RebindPackPasses()
+{
+    // The views of resized textures have to be created again
+    for (TSRResourceBinding& binding : m_Resources)
+    {
+        if (binding.pPackParameters)
+            BindPackPass(binding);
+    }
+}
+
+void TSRRenderModule::DispatchPackPasses(CommandList* pCmdList, uint64_t resourceMask)
+{
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        const TSRResourceBinding& binding = m_Resources[i];
+        if (!binding.pPackParameters || !binding.enabled || !(resourceMask & (1ull << i)))
+            continue;
+
+        GPUScopedProfileCapture marker(pCmdList, m_RendererModeEnabled ? L"TSR Pack" : L"TSR Unpack");
+
+        const Texture* pOutput = m_RendererModeEnabled ? binding.pTexture : binding.pSourceTexture;
+        Barrier        barrier = Barrier::Transition(
+            pOutput->GetResource(), ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource, ResourceState::UnorderedAccess);
+        ResourceBarrier(pCmdList, 1, &barrier);
+
+        binding.pPackParameters->Bind(pCmdList, m_pPackPipelineObj);
+        SetPipelineState(pCmdList, m_pPackPipelineObj);
+        Dispatch(pCmdList, DivideRoundingUp(pOutput->GetDesc().Width, g_PackThreadX), DivideRoundingUp(pOutput->GetDesc().Height, g_PackThreadY), 1);
+
+        barrier = Barrier::Transition(
+            pOutput->GetResource(), ResourceState::UnorderedAccess, ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource);
+        ResourceBarrier(pCmdList, 1, &barrier);
+    }
+}
+
+void TSRRenderModule::SetActiveUpscaler(const std::string& upscalerName)
+{
+    // Only the upscaler process decides what goes through the shared buffers
+    if (!m_UpscalerModeEnabled || (!m_TSROps && !m_Sessions && !m_Negotiator))
+        return;
+
+    uint64_t resourceMask = 0;
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        const std::vector<std::string>& consumers = m_Resources[i].consumers;
+        if (consumers.empty() || std::find(consumers.begin(), consumers.end(), upscalerName) != consumers.end())
+            resourceMask |= 1ull << i;
+    }
+
+    // Sessions opened later pick the mask up when they join
+    m_ConsumedResources = resourceMask;
+    if (m_TSROps)
+        m_TSROps->SetConsumedResources(resourceMask);
+    if (m_Sessions)
+        m_Sessions->ForEach([resourceMask](uint32_t, TSRSession& session) { session.pOps->SetConsumedResources(resourceMask); });
+}
+
+void TSRRenderModule::EnableResource(const std::string& name, bool enabled)
+{
+    size_t index = m_Manifest.FindResource(name);
+    CauldronAssert(ASSERT_CRITICAL, index != TSRManifest::INVALID_RESOURCE, L"Unknown TSR resource %ls", StringToWString(name).c_str());
+    CauldronAssert(ASSERT_CRITICAL, enabled || m_Manifest.GetResource(index).optional, L"TSR resource %ls is not optional", StringToWString(name).c_str());
+
+    m_Resources[index].enabled = enabled;
+}
+
 void TSRRenderModule::Execute(double deltaTime, CommandList* pCmdList)
 {
     // Skip if we are in only resizing mode
@@ -148,18 +1038,87 @@ void TSRRenderModule::InboundDataTransfer(double deltaTime, CommandList* pCmdLis
 {
     GPUScopedProfileCapture sampleMarker(pCmdList, L"TSR (Inbound)");
 
-    // Main loop never runs if there is no available buffer, so we can assume next buffer is in READY state
+    // Main loop never runs if there is no available buffer, so the ready function already acquired a READY buffer
     // Transfer the resources from the shared buffer to this process
-    uint64_t bufferIndex = GetFramework()->GetBufferIndex();
-    m_TSROps->TransferFromSharedBuffer(getFSRResources(), bufferIndex, pCmdList->GetImpl()->DX12CmdList());
+    m_pActiveOps->TransferFromSharedBuffer(getTSRResources(), m_BufferIndex, pCmdList->GetImpl()->DX12CmdList());
+
+    // Expand packed resources back into the render targets
+    DispatchPackPasses(pCmdList, m_pActiveOps->GetTransferredResources());
+
+    // The frame state in the shared buffer belongs to the textures we just read, it wins over the shared camera data
+    // which can belong to another frame if the renderer got ahead of us. Sessions don't share the camera.
+    const TSRFrameMetadata& metadata    = m_pActiveOps->GetFrameMetadata();
+    CameraComponent*        pCamera     = GetScene()->GetCurrentCamera();
+    uint64_t                sideFrameId = m_Sessions ? TSRMetadataChecker::NO_SIDE_DATA : pCamera->GetSharedFrameID();
+    bool                    consistent  = m_pActiveMetadataChecker->CheckManifest(m_pActiveOps->GetSlotManifestHash(), m_pActiveOps->GetManifest().GetHash());
+    if (!m_pActiveMetadataChecker->Check(metadata, sideFrameId) || !consistent)
+    {
+        const TSRMetadataStats& stats = m_pActiveMetadataChecker->GetStats();
+        if (stats.missing + stats.manifests + stats.mismatches + stats.repeats + stats.reversals == 1)
+            Log::Write(LOGLEVEL_WARNING, L"TSR frame metadata does not match the shared buffer contents (frame %llu), see the counters on exit", metadata.frameId);
+    }
+
+    if (metadata.renderTimeNs)
+    {
+        pCamera->SetFrameMatrices(metadata.viewMatrix,
+                                  metadata.projectionMatrix,
+                                  metadata.jitteredProjectionMatrix,
+                                  metadata.prevViewMatrix,
+                                  metadata.prevViewProjectionMatrix,
+                                  metadata.prevJitteredProjectionMatrix,
+                                  Vec2(metadata.jitter[0], metadata.jitter[1]));
+    }
+
+    // The upscaler history is invalid when the renderer says so, when we skipped the frames it was built from, or when
+    // it was built from another session's frames. The flag stays set for this frame only, unless someone else set it.
+    bool reset = (metadata.renderTimeNs && metadata.reset) || m_pActiveOps->GetRing().GetLastSkipCount() > 0 || m_SessionSwitched || m_GenerationReset;
+    m_GenerationReset = false;
+    if (reset)
+    {
+        m_ForcedReset = m_ForcedReset || !GetFramework()->GetResetFlag();
+        GetFramework()->SetResetFlag(true);
+    }
+    else if (m_ForcedReset)
+    {
+        m_ForcedReset = false;
+        GetFramework()->SetResetFlag(false);
+    }
 }
 
 void TSRRenderModule::OutboundDataTransfer(double deltaTime, CommandList* pCmdList)
 {
+    // Upscaled in process, see IsFallbackActive
+    if (IsFallbackActive())
+        return;
+
     GPUScopedProfileCapture sampleMarker(pCmdList, L"TSR (Outbound)");
 
-    // Main loop never runs if there is no available buffer, so we can assume next buffer is in IDLE state
-    // Transfer the resources from this process to the shared buffer
-    uint64_t bufferIndex = GetFramework()->GetBufferIndex();
-    m_TSROps->TransferToSharedBuffer(getFSRResources(), bufferIndex, pCmdList->GetImpl()->DX12CmdList());
+    // Main loop never runs if there is no available buffer, so the ready function already acquired an IDLE buffer
+    // Pack what the upscaler will read, then transfer the resources from this process to the shared buffer
+    DispatchPackPasses(pCmdList, m_TSROps->GetTransport()->GetConsumedResources());
+
+    // Frame state goes into the same shared buffer as the textures
+    const ResolutionInfo&     resInfo    = GetFramework()->GetResolutionInfo();
+    const ShareableCameraData cameraData = GetScene()->GetCurrentCamera()->GetShareableData();
+
+    TSRFrameMetadata metadata = {};
+    metadata.frameId          = GetFramework()->GetFrameID();
+    metadata.renderTimeNs     = tsr_now_ns();
+    metadata.jitter[0]        = cameraData.m_JitterValues[0];
+    metadata.jitter[1]        = cameraData.m_JitterValues[1];
+    metadata.reset            = (GetFramework()->GetResetFlag() || m_GenerationReset) ? 1 : 0;
+    metadata.deltaTimeMs      = static_cast<float>(deltaTime * 1000.0);
+    metadata.exposure         = GetScene()->GetSceneExposure();
+    metadata.renderWidth      = resInfo.RenderWidth;
+    metadata.renderHeight     = resInfo.RenderHeight;
+    memcpy(metadata.viewMatrix, cameraData.m_ViewMatrix, sizeof(metadata.viewMatrix));
+    memcpy(metadata.projectionMatrix, cameraData.m_ProjectionMatrix, sizeof(metadata.projectionMatrix));
+    memcpy(metadata.jitteredProjectionMatrix, cameraData.m_ProjJittered, sizeof(metadata.jitteredProjectionMatrix));
+    memcpy(metadata.prevViewMatrix, cameraData.m_PrevViewMatrix, sizeof(metadata.prevViewMatrix));
+    memcpy(metadata.prevViewProjectionMatrix, cameraData.m_PrevViewProjectionMatrix, sizeof(metadata.prevViewProjectionMatrix));
+    memcpy(metadata.prevJitteredProjectionMatrix, cameraData.m_PrevProjJittered, sizeof(metadata.prevJitteredProjectionMatrix));
+    m_TSROps->SetFrameMetadata(metadata);
+    m_GenerationReset = false;
+
+    m_TSROps->TransferToSharedBuffer(getTSRResources(), m_BufferIndex, pCmdList->GetImpl()->DX12CmdList());
 }
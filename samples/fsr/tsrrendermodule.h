@@ -4,9 +4,21 @@
 #include "core/framework.h"
 #include "core/uimanager.h"
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 #include <tsr.h>
 
+namespace cauldron
+{
+    class ParameterSet;
+    class PipelineObject;
+    class RootSignature;
+    class Texture;
+}  // namespace cauldron
+
 /**
  * @class TSRRenderModule
  *
@@ -44,6 +56,21 @@ public:
      */
     void OnResize(const cauldron::ResolutionInfo& resInfo) override;
 
+    /**
+     * @brief   Let the renderer know which upscaler is active, so it only sends the resources that upscaler consumes.
+     */
+    void SetActiveUpscaler(const std::string& upscalerName);
+
+    /**
+     * @brief   Enable or disable an optional resource of the manifest, disabled resources are left out of the frames.
+     */
+    void EnableResource(const std::string& name, bool enabled);
+
+    /**
+     * @brief   Renderer: whether every upscaler stopped responding, the frames have to be upscaled in process until one comes back.
+     */
+    bool IsFallbackActive() const { return m_PeerSupervisor && m_PeerSupervisor->IsFallbackActive(); }
+
 private:
     // Resolution info
     uint32_t m_RenderWidth  = 2560;
@@ -56,25 +83,141 @@ private:
 
     // TSROps
     std::unique_ptr<TSROps> m_TSROps;
+    uint64_t                m_BufferIndex   = 0;  // Shared buffer acquired for the current frame
+    TSRWaitMode             m_WaitMode      = TSRWaitMode::Poll;
+    uint64_t                m_WaitTimeoutUs = 0;
+    TSRConsumePolicy        m_ConsumePolicy = TSRConsumePolicy::EveryFrame;
+    uint32_t                m_ConsumerCount = 1;      // Upscalers reading the renderer's frames
+    uint32_t                m_ConsumerIndex = 0;      // Upscaler: which of them we are
+    bool                    m_ForcedReset   = false;  // We set the framework reset flag for the current frame
+
+    // Upscaler: checks the frame state carried by every consumed shared buffer
+    TSRMetadataChecker m_MetadataChecker;
+
+    // Upscaler: shared buffers and checker of the frame being upscaled, m_TSROps unless serving sessions
+    TSROps*             m_pActiveOps             = nullptr;
+    TSRMetadataChecker* m_pActiveMetadataChecker = nullptr;
+    uint64_t            m_ConsumedResources      = UINT64_MAX;
+
+    // Renderers sharing one upscaler announce their session (the -session name) in the upscaler's directory, the
+    // upscaler opens the shared buffers of every announced session and schedules their frames
+    struct TSRSession
+    {
+        std::unique_ptr<TSROps> pOps;
+        TSRMetadataChecker      metadataChecker;
+        std::wstring            name;
+    };
+
+    TSRSessionDirectory                              m_SessionDirectory;
+    uint32_t                                         m_SessionEntry      = TSRSessionDirectory::INVALID_ENTRY;  // Renderer: our entry
+    bool                                             m_AnnounceSession   = false;
+    uint64_t                                         m_SessionDeadlineUs = 0;
+    std::unique_ptr<TSRSessionScheduler>             m_SessionScheduler;
+    std::unique_ptr<TSRSessionRegistry<TSRSession>>  m_Sessions;
+    uint64_t                                         m_SessionPollUs     = 100;
+    uint32_t                                         m_ActiveSession     = UINT32_MAX;
+    bool                                             m_SessionSwitched   = false;  // The frame belongs to another session than the last one
+
+    void InitSessions(const json& sessions);
+    void AnnounceSession();
+    bool AcquireSessionFrame();
+
+    // Renderer: optional controller of the shared buffers in use, and its decisions not reported yet
+    std::unique_ptr<TSRSlotController> m_SlotController;
+    std::vector<TSRSlotDecision>       m_SlotDecisions;
+
+    void UpdateSlotController();
+
+    // Benchmark telemetry: the slot controller's state and the transfer counters since the last line. The counters
+    // taken out of the TSROps add up to the totals reported on exit.
+    TSRTransferStats m_TransferTotals;
+
+    void WriteTelemetry(json& data);
+
+    // Heartbeats of the peer processes, see TSRPeerSupervisor. The upscaler waits for the next generation of a renderer
+    // that stopped responding.
+    std::unique_ptr<TSRPeerSupervisor> m_PeerSupervisor;
+
+    void UpdateLiveness();
+
+    // Shared buffers of a generation, created off the main thread
+    struct PendingOps
+    {
+        std::unique_ptr<TSROps>         pOps;
+        std::unique_ptr<TSRPlacedSlots> pSlots;  // Zero copy only
+        std::atomic<bool>               ready{false};
+        uint64_t                        generation = 0;
+    };
+
+    // Agrees on the shared buffers with the other side before creating them, see TSRNegotiator. Null if both sides
+    // assume the same configuration.
+    std::unique_ptr<TSRNegotiator> m_Negotiator;
+    uint64_t                       m_SlotCount       = 0;      // Shared buffers, the first offer when negotiating
+    bool                           m_GenerationReset = false;  // The history does not survive a new generation
+    std::shared_ptr<PendingOps>    m_pPendingOps;
+
+    bool               UpdateNegotiation();
+    void               AllocateOps(uint64_t generation, uint64_t slotCount, const TSRManifest& manifest);
+    bool               InstallOps();
+    void               DropOps();
+    void               WatchPeers();
+    void               ApplyRenderResolution(uint32_t renderWidth, uint32_t renderHeight);
+    const TSRManifest& BuildManifest();
+    std::wstring       GetGenerationName(uint64_t generation) const;
+
+    // Zero copy: the render targets of every slot are placed in a heap shared with the other process and the render
+    // resources rotate through the slots, instead of being copied in and out of the shared buffers
+    bool                               m_ZeroCopy = false;
+    std::unique_ptr<TSRD3D12Allocator> m_pPlacementAllocator;
+    std::unique_ptr<TSRPlacedSlots>    m_PlacedSlots;
+
+    std::unique_ptr<TSRPlacedSlots> DescribePlacedSlots() const;
+    void                            InstallPlacedSlots(std::unique_ptr<TSRPlacedSlots> pSlots);
+    void                            DropPlacedSlots();
+    void                            RotatePlacedSlots();
 
     // TSR GPU Transfer functions
     void OutboundDataTransfer(double deltaTime, cauldron::CommandList* pCmdList);
     void InboundDataTransfer(double deltaTime, cauldron::CommandList* pCmdList);
 
-    // FidelityFX Super Resolution resources
-    const cauldron::Texture* m_pColorTarget   = nullptr;
-    const cauldron::Texture* m_pDepthTarget   = nullptr;
-    const cauldron::Texture* m_pMotionVectors = nullptr;
+    // Resources sent to the upscaler, indexed like the manifest
+    struct TSRResourceBinding
+    {
+        std::string              name;
+        const cauldron::Texture* pTexture = nullptr;
+        bool                     enabled  = true;
+        bool                     optional = false;
+        std::vector<std::string> consumers;  // Upscalers reading the resource, empty if all of them do
+
+        // Packed resources: pTexture is a compact copy of pSourceTexture, packed before and unpacked after the transfer
+        const cauldron::Texture* pSourceTexture  = nullptr;
+        cauldron::ParameterSet*  pPackParameters = nullptr;
+    };
+
+    std::vector<TSRResourceBinding> m_Resources;
+    TSRManifest                     m_Manifest;
+
+    // Pack/unpack pass
+    cauldron::RootSignature*  m_pPackRootSignature = nullptr;
+    cauldron::PipelineObject* m_pPackPipelineObj   = nullptr;
+
+    void InitPackPass(TSRResourceBinding& binding);
+    void BindPackPass(TSRResourceBinding& binding);
+    void RebindPackPasses();
+    void DispatchPackPasses(cauldron::CommandList* pCmdList, uint64_t resourceMask);
 
     TSRGraphicsResource getTSRResourceFromTexture(const cauldron::Texture* res) const;
 
-    // Function to get FSR resources from the texture objects
-    FSRResources getFSRResources() const
+    // Function to get the manifest resources from the texture objects, disabled resources are left null
+    TSRResources getTSRResources() const
     {
-        TSRGraphicsResource colorTarget   = getTSRResourceFromTexture(m_pColorTarget);
-        TSRGraphicsResource depthTarget   = getTSRResourceFromTexture(m_pDepthTarget);
-        TSRGraphicsResource motionVectors = getTSRResourceFromTexture(m_pMotionVectors);
+        TSRResources resources(m_Resources.size(), TSRGraphicsResource{});
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            if (m_Resources[i].enabled)
+                resources[i] = getTSRResourceFromTexture(m_Resources[i].pTexture);
+        }
 
-        return {&colorTarget, &depthTarget, &motionVectors};
+        return resources;
     }
 };
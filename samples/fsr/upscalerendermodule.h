@@ -95,6 +95,12 @@ public:
      */
     void SetFilter(UpscaleRM::UpscaleMethod method) { m_UpscaleMethod = method; }
 
+    /**
+     * @brief   Run the upscaling pass at the resolution already set up by someone else, leaving the framework upscaling
+     *          state and the UI alone. Used by a TSR renderer that upscales by itself while its upscaler is away.
+     */
+    void EnableInPlace(bool enabled) { SetModuleEnabled(enabled); }
+
 private:
     cauldron::ResolutionInfo UpdateResolution(uint32_t displayWidth, uint32_t displayHeight);
 